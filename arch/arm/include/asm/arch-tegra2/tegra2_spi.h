@@ -70,6 +70,17 @@ struct spi_tegra {
 #define SPI_STAT_SEL_TXRX_N	(1 << 16)
 #define SPI_STAT_CUR_BLKCNT	(1 << 15)
 
+/* The block count also applies to PIO transfers started with DMA_EN */
+#define SPI_DMA_EN		(1 << 31)
+#define SPI_DMA_IE_RXC		(1 << 27)
+#define SPI_DMA_IE_TXC		(1 << 26)
+#define SPI_DMA_PACKED		(1 << 20)
+#define SPI_DMA_RX_TRIG_4W	(1 << 18)
+#define SPI_DMA_TX_TRIG_4W	(1 << 16)
+#define SPI_DMA_BLK_COUNT_MASK	0x0000FFFF	/* words - 1 */
+
+#define SPI_FIFO_DEPTH		4	/* words in each of the TX/RX FIFOs */
+
 #define GMD_SEL_SFLASH_RANGE	31 : 30
 #define GMC_SEL_SFLASH_RANGE	3 : 2
 
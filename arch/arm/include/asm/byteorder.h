@@ -23,6 +23,32 @@
 #  define __SWAB_64_THRU_32__
 #endif
 
+#if defined(__GNUC__) && !defined(__thumb__)
+#if defined(__ARM_ARCH_6__) || defined(__ARM_ARCH_6K__) || \
+	defined(__ARM_ARCH_6Z__) || defined(__ARM_ARCH_6ZK__) || \
+	defined(__ARM_ARCH_7A__)
+static __inline__ __attribute__((const)) __u32 ___arch__swab32(__u32 x)
+{
+	__asm__ ("rev %0, %1" : "=r" (x) : "r" (x));
+	return x;
+}
+#else
+/* Four instructions, rather than the seven of the generic C version */
+static __inline__ __attribute__((const)) __u32 ___arch__swab32(__u32 x)
+{
+	__u32 t;
+
+	__asm__ ("eor %0, %1, %1, ror #16" : "=r" (t) : "r" (x));
+	x = (x << 24) | (x >> 8);
+	t &= ~0x00ff0000;
+	x ^= t >> 8;
+
+	return x;
+}
+#endif
+#define __arch__swab32(x) ___arch__swab32(x)
+#endif
+
 #ifdef __ARMEB__
 #include <linux/byteorder/big_endian.h>
 #else
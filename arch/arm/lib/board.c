@@ -50,6 +50,7 @@
 #include <onenand_uboot.h>
 #include <mmc.h>
 #include <fdt_decode.h>
+#include <fdt_index.h>
 
 #ifdef CONFIG_BITBANGMII
 #include <miiphy.h>
@@ -535,6 +536,23 @@ void board_init_r (gd_t *id, ulong dest_addr)
 
 	monitor_flash_len = _end_ofs;
 	debug ("monitor flash len: %08lX\n", monitor_flash_len);
+
+#ifdef CONFIG_OF_INDEX
+	/*
+	 * The Malloc area is immediately below the monitor copy in DRAM.
+	 * Set it up before board_init() so that the device tree index is
+	 * there for the board code.
+	 */
+	malloc_start = dest_addr - TOTAL_MALLOC_LEN;
+	mem_malloc_init (malloc_start, TOTAL_MALLOC_LEN);
+	if (gd->blob) {
+		bootstage_start(BOOTSTAGE_FDT_INDEX, "fdt_index");
+		if (fdt_index_build(gd->blob))
+			debug("Cannot index device tree\n");
+		bootstage_accum(BOOTSTAGE_FDT_INDEX);
+	}
+#endif
+
 	board_init();	/* Setup chipselects */
 
 #ifdef CONFIG_SERIAL_MULTI
@@ -550,9 +568,11 @@ void board_init_r (gd_t *id, ulong dest_addr)
 	post_output_backlog ();
 #endif
 
+#ifndef CONFIG_OF_INDEX
 	/* The Malloc area is immediately below the monitor copy in DRAM */
 	malloc_start = dest_addr - TOTAL_MALLOC_LEN;
 	mem_malloc_init (malloc_start, TOTAL_MALLOC_LEN);
+#endif
 
 #if !defined(CONFIG_SYS_NO_FLASH)
 	puts ("Flash: ");
@@ -225,6 +225,11 @@ static int bootm_linux_fdt(int machid, bootm_headers_t *images)
 
 	fdt_chosen(*of_flat_tree, 1);
 
+#ifdef CONFIG_BOOTSTAGE_FDT
+	if (bootstage_fdt_add_report(*of_flat_tree))
+		puts("WARNING: no room for the bootstage report in the FDT\n");
+#endif
+
 	fixup_memory_node(*of_flat_tree);
 
 	fdt_initrd(*of_flat_tree, *initrd_start, *initrd_end, 1);
@@ -0,0 +1,35 @@
+#
+# Copyright (c) 2011 The Chromium OS Authors.
+# See file CREDITS for list of people who contributed to this
+# project.
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of
+# the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+# MA 02111-1307 USA
+#
+
+
+PLATFORM_CPPFLAGS += -DCONFIG_SANDBOX -D__SANDBOX__ -U_FORTIFY_SOURCE
+PLATFORM_CPPFLAGS += $(call cc-option,-fno-pie,)
+
+# The host's compiler is likely newer than the code: keep the old meaning
+# of 'inline' and of variables defined in more than one file
+PLATFORM_CPPFLAGS += $(call cc-option,-fgnu89-inline,)
+PLATFORM_CPPFLAGS += $(call cc-option,-fcommon,)
+
+# U-Boot keeps addresses in 32-bit variables here and there, so the
+# program itself is kept below 4GB, as its RAM is (see CONFIG_SYS_SDRAM_BASE)
+PLATFORM_LIBS += $(call cc-option,-no-pie,) -lrt
+
+LDSCRIPT := $(SRCTREE)/$(CPUDIR)/u-boot.lds
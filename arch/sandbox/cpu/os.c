@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+
+/*
+ * The host side of the sandbox: everything that needs the C library and
+ * system headers lives here, behind the interface in <os.h>.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <linux/if_tun.h>
+
+#include <os.h>
+
+/* Older C libraries do not know it; the address check below still works */
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE	0
+#endif
+
+ssize_t os_read(int fd, void *buf, size_t count)
+{
+	return read(fd, buf, count);
+}
+
+ssize_t os_write(int fd, const void *buf, size_t count)
+{
+	return write(fd, buf, count);
+}
+
+ssize_t os_pread(int fd, void *buf, size_t count, long long offset)
+{
+	return pread(fd, buf, count, offset);
+}
+
+ssize_t os_pwrite(int fd, const void *buf, size_t count, long long offset)
+{
+	return pwrite(fd, buf, count, offset);
+}
+
+long long os_lseek(int fd, long long offset, int whence)
+{
+	if (whence == OS_SEEK_SET)
+		whence = SEEK_SET;
+	else if (whence == OS_SEEK_CUR)
+		whence = SEEK_CUR;
+	else if (whence == OS_SEEK_END)
+		whence = SEEK_END;
+	else
+		os_exit(1);
+	return lseek(fd, offset, whence);
+}
+
+int os_open(const char *pathname, int os_flags)
+{
+	int flags;
+
+	switch (os_flags & OS_O_MASK) {
+	case OS_O_RDONLY:
+	default:
+		flags = O_RDONLY;
+		break;
+
+	case OS_O_WRONLY:
+		flags = O_WRONLY;
+		break;
+
+	case OS_O_RDWR:
+		flags = O_RDWR;
+		break;
+	}
+
+	if (os_flags & OS_O_CREAT)
+		flags |= O_CREAT;
+
+	return open(pathname, flags, 0644);
+}
+
+int os_close(int fd)
+{
+	return close(fd);
+}
+
+void os_exit(int exit_code)
+{
+	exit(exit_code);
+}
+
+static struct termios orig_term;
+static int term_fd = -1;
+
+static void os_tty_restore(void)
+{
+	if (term_fd >= 0)
+		tcsetattr(term_fd, TCSANOW, &orig_term);
+}
+
+void os_tty_raw(int fd)
+{
+	struct termios term;
+
+	if (term_fd >= 0 || tcgetattr(fd, &orig_term))
+		return;
+
+	/* Keep ^C for ourselves, and let output be processed as usual */
+	term = orig_term;
+	term.c_iflag = IGNBRK | IGNPAR;
+	term.c_cflag = CS8 | CREAD | CLOCAL;
+	term.c_lflag = 0;
+	if (tcsetattr(fd, TCSANOW, &term))
+		return;
+
+	term_fd = fd;
+	atexit(os_tty_restore);
+}
+
+int os_poll(int fd)
+{
+	struct pollfd pfd;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	return poll(&pfd, 1, 0) > 0;
+}
+
+void *os_map_ram(unsigned long addr, size_t size)
+{
+	void *ptr;
+
+	ptr = mmap((void *)addr, size, PROT_READ | PROT_WRITE | PROT_EXEC,
+		   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+	if (ptr == MAP_FAILED)
+		return NULL;
+	if (ptr != (void *)addr) {
+		munmap(ptr, size);
+		return NULL;
+	}
+	return ptr;
+}
+
+unsigned long long os_get_nsec(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+	return tp.tv_sec * 1000000000ULL + tp.tv_nsec;
+}
+
+void os_usleep(unsigned long usec)
+{
+	struct timespec ts;
+
+	ts.tv_sec = usec / 1000000;
+	ts.tv_nsec = usec % 1000000 * 1000;
+	while (nanosleep(&ts, &ts) && errno == EINTR)
+		;
+}
+
+int os_tap_open(const char *ifname, unsigned char mac[6])
+{
+	struct ifreq ifr;
+	int fd;
+
+	fd = open("/dev/net/tun", O_RDWR);
+	if (fd < 0) {
+		perror("/dev/net/tun");
+		return -1;
+	}
+
+	memset(&ifr, 0, sizeof(ifr));
+	ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+	strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+	if (ioctl(fd, TUNSETIFF, &ifr) < 0) {
+		perror(ifname);
+		close(fd);
+		return -1;
+	}
+	if (fcntl(fd, F_SETFL, O_NONBLOCK) < 0) {
+		close(fd);
+		return -1;
+	}
+
+	/*
+	 * The host's end of the tap has its own address; ours is a fixed,
+	 * locally administered one, made different per interface.
+	 */
+	mac[0] = 0x02;
+	mac[1] = 0x00;
+	mac[2] = 0x11;
+	mac[3] = 0x22;
+	mac[4] = 0x33;
+	mac[5] = if_nametoindex(ifname) & 0xff;
+
+	return fd;
+}
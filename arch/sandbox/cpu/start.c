@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+
+#include <common.h>
+#include <os.h>
+#include <asm/state.h>
+
+static struct sandbox_state main_state;
+
+struct sandbox_state *state_get_current(void)
+{
+	return &main_state;
+}
+
+/* The console is not set up yet, so this goes straight to stderr */
+static void usage(const char *prog)
+{
+	static const char opts[] = " [options]\n"
+		"  -c <cmd>\trun <cmd> (';' separated) and exit\n"
+		"  -m <file>\tuse <file> as the SD card (mmc 0)\n"
+		"  -u <file>\tuse <file> as the USB disk (usb 0)\n"
+		"  -b <file>\tadd <file> as the next host device (host 0..3)\n"
+		"  -s <file>\tuse <file> as the SPI flash\n"
+		"  -t <ifname>\tsend and receive Ethernet frames on tap <ifname>\n";
+
+	os_write(2, "Usage: ", 7);
+	os_write(2, prog, strlen(prog));
+	os_write(2, opts, sizeof(opts) - 1);
+}
+
+static int parse_args(struct sandbox_state *state, int argc, char *argv[])
+{
+	const char *opt, *arg;
+	int i;
+
+	state->argc = argc;
+	state->argv = argv;
+	for (i = 1; i < argc; i++) {
+		opt = argv[i];
+		if (opt[0] != '-' || !opt[1] || opt[2] || i + 1 == argc)
+			return -1;
+		arg = argv[++i];
+		switch (opt[1]) {
+		case 'c':
+			state->cmd = arg;
+			break;
+		case 'm':
+			state->mmc_file = arg;
+			break;
+		case 'u':
+			state->usb_file = arg;
+			break;
+		case 'b':
+			if (state->host_count == SANDBOX_MAX_HOST_DEVS)
+				return -1;
+			state->host_file[state->host_count++] = arg;
+			break;
+		case 's':
+			state->spi_file = arg;
+			break;
+		case 't':
+			state->tap_name = arg;
+			break;
+		default:
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	if (parse_args(&main_state, argc, argv)) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	/*
+	 * Do pre- and post-relocation init, then start up U-Boot. This will
+	 * never return.
+	 */
+	board_init_f(0);
+}
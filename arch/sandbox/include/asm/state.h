@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+
+#ifndef __ASM_SANDBOX_STATE_H
+#define __ASM_SANDBOX_STATE_H
+
+#define SANDBOX_MAX_HOST_DEVS	4
+
+/*
+ * What the sandbox was asked to do on its command line. Drivers look here
+ * for the host files and interfaces their devices are backed by.
+ */
+struct sandbox_state {
+	int argc;
+	char **argv;
+	const char *cmd;		/* -c: command to run, then exit */
+	const char *mmc_file;		/* -m: image for the SD card */
+	const char *usb_file;		/* -u: image for the USB disk */
+	const char *spi_file;		/* -s: image for the SPI flash */
+	const char *tap_name;		/* -t: tap interface, like "tap0" */
+	const char *host_file[SANDBOX_MAX_HOST_DEVS];	/* -b: host devices */
+	int host_count;
+	int exit_code;			/* of the -c command */
+};
+
+/* The one and only state, filled in from the command line */
+struct sandbox_state *state_get_current(void);
+
+#endif
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+
+/*
+ * The sandbox's version of the board init sequence. There is no
+ * relocation: U-Boot is an ordinary program which the host has already
+ * loaded, so this simply sets up global data and RAM, then runs
+ * through what arch/arm/lib/board.c does once relocated.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <mmc.h>
+#include <net.h>
+#include <serial.h>
+#include <stdio_dev.h>
+#include <timestamp.h>
+#include <version.h>
+#include <os.h>
+#include <asm/state.h>
+#ifdef CONFIG_SYS_HUSH_PARSER
+#include <hush.h>
+#endif
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* A process can keep its global data in an ordinary variable */
+gd_t *gd;
+
+static gd_t gd_mem;
+static bd_t bd_mem;
+
+const char version_string[] =
+	U_BOOT_VERSION" (" U_BOOT_DATE " - " U_BOOT_TIME ")";
+
+static int display_banner(void)
+{
+	printf("\n\n%s\n\n", version_string);
+	return 0;
+}
+
+static int init_baudrate(void)
+{
+	gd->baudrate = CONFIG_BAUDRATE;
+	gd->bd->bi_baudrate = gd->baudrate;
+	return 0;
+}
+
+/* RAM lives at CONFIG_SYS_SDRAM_BASE, so that addresses are pointers */
+static int init_ram(void)
+{
+	gd->ram_size = CONFIG_SYS_SDRAM_SIZE;
+	gd->ram_buf = os_map_ram(CONFIG_SYS_SDRAM_BASE, gd->ram_size);
+	if (!gd->ram_buf) {
+		printf("Cannot map %ld MiB of RAM at %08x\n",
+		       gd->ram_size >> 20, CONFIG_SYS_SDRAM_BASE);
+		return -1;
+	}
+	return 0;
+}
+
+typedef int (init_fnc_t) (void);
+
+init_fnc_t *init_sequence[] = {
+	timer_init,		/* initialize timer */
+	env_init,		/* initialize environment */
+	init_baudrate,		/* initialze baudrate settings */
+	serial_init,		/* serial communications setup */
+	console_init_f,		/* stage 1 init of console */
+	display_banner,		/* say that we are here */
+	init_ram,		/* map the RAM */
+	dram_init,		/* configure available RAM banks */
+	NULL,
+};
+
+void board_init_f(ulong bootflag)
+{
+	init_fnc_t **init_fnc_ptr;
+
+	gd = &gd_mem;
+	gd->bd = &bd_mem;
+
+	for (init_fnc_ptr = init_sequence; *init_fnc_ptr; ++init_fnc_ptr) {
+		if ((*init_fnc_ptr)() != 0)
+			hang();
+	}
+
+	gd->flags |= GD_FLG_RELOC;
+	board_init_r(gd, 0);
+}
+
+/* Run the -c command, as the shell would; the exit code is its result */
+static int run_cmd(const char *cmd)
+{
+#ifdef CONFIG_SYS_HUSH_PARSER
+	return parse_string_outer((char *)cmd, FLAG_PARSE_SEMICOLON |
+				  FLAG_EXIT_FROM_LOOP) ? 1 : 0;
+#else
+	return run_command(cmd, 0) < 0 ? 1 : 0;
+#endif
+}
+
+void board_init_r(gd_t *id, ulong dest_addr)
+{
+	struct sandbox_state *state = state_get_current();
+	bd_t *bd = gd->bd;
+	char *s;
+
+	/* The malloc() area is at the top of RAM */
+	mem_malloc_init((ulong)gd->ram_buf + gd->ram_size - TOTAL_MALLOC_LEN,
+			TOTAL_MALLOC_LEN);
+
+	board_init();
+
+#ifdef CONFIG_GENERIC_MMC
+	puts("MMC:   ");
+	mmc_initialize(bd);
+#endif
+
+	env_relocate();
+	bd->bi_ip_addr = getenv_IPaddr("ipaddr");
+
+	stdio_init();	/* get the devices list going. */
+	jumptable_init();
+	console_init_r();	/* fully init console as a device */
+
+	/* Initialize from environment */
+	s = getenv("loadaddr");
+	if (s != NULL)
+		load_addr = simple_strtoul(s, NULL, 16);
+#if defined(CONFIG_CMD_NET)
+	s = getenv("bootfile");
+	if (s != NULL)
+		copy_filename(BootFile, s, sizeof(BootFile));
+
+	puts("Net:   ");
+	eth_initialize(gd->bd);
+#endif
+
+	if (state->cmd)
+		os_exit(run_cmd(state->cmd));
+
+	/* Only a terminal is put into raw mode; a pipe is left as it is */
+	os_tty_raw(0);
+
+	/* main_loop() can return to retry autoboot, if so just run it again. */
+	for (;;)
+		main_loop();
+
+	/* NOTREACHED - no way out of command loop except booting */
+}
+
+void hang(void)
+{
+	puts("### ERROR ### Please RESET the board ###\n");
+	os_exit(1);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+
+/*
+ * Time comes from the host's monotonic clock, so timings taken in the
+ * sandbox (bootstage, time, bench) are real ones.
+ */
+
+#include <common.h>
+#include <os.h>
+
+static unsigned long long base_nsec;
+
+int timer_init(void)
+{
+	base_nsec = os_get_nsec();
+	return 0;
+}
+
+unsigned long timer_get_us(void)
+{
+	return (os_get_nsec() - base_nsec) / 1000;
+}
+
+unsigned long long get_ticks(void)
+{
+	return timer_get_us();
+}
+
+ulong get_tbclk(void)
+{
+	return 1000000;
+}
+
+ulong get_timer(ulong base)
+{
+	return (os_get_nsec() - base_nsec) / 1000000 - base;
+}
+
+ulong get_timer_masked(void)
+{
+	return get_timer(0);
+}
+
+void reset_timer(void)
+{
+}
+
+void __udelay(unsigned long usec)
+{
+	os_usleep(usec);
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+
+/*
+ * The arena is a list of blocks from malloc(), newest first, handed out
+ * front to back. A request too big to share a block gets one of its own.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <arena.h>
+
+#define ARENA_BLOCK_SIZE	4096
+#define ARENA_ALIGN		8
+
+struct arena_block {
+	struct arena_block *next;	/* the block allocated before this */
+	ulong size;			/* bytes available in data[] */
+	ulong used;
+	ulong data[0];			/* aligned to ARENA_ALIGN */
+};
+
+static struct arena_block *arena_head;
+
+void *arena_alloc(size_t size)
+{
+	struct arena_block *block = arena_head;
+	ulong block_size;
+	void *ptr;
+
+	size = ALIGN(size, ARENA_ALIGN);
+	if (!block || block->size - block->used < size) {
+		block_size = max(size, ARENA_BLOCK_SIZE - sizeof(*block));
+		block = malloc(sizeof(*block) + block_size);
+		if (!block)
+			return NULL;
+		block->next = arena_head;
+		block->size = block_size;
+		block->used = 0;
+		arena_head = block;
+	}
+	ptr = (char *)block->data + block->used;
+	block->used += size;
+
+	return ptr;
+}
+
+void *arena_zalloc(size_t size)
+{
+	void *ptr = arena_alloc(size);
+
+	if (ptr)
+		memset(ptr, '\0', size);
+
+	return ptr;
+}
+
+char *arena_strdup(const char *s)
+{
+	size_t len = strlen(s) + 1;
+	char *copy = arena_alloc(len);
+
+	if (copy)
+		memcpy(copy, s, len);
+
+	return copy;
+}
+
+void arena_mark(struct arena_mark *mark)
+{
+	mark->block = arena_head;
+	mark->used = arena_head ? arena_head->used : 0;
+}
+
+void arena_release(const struct arena_mark *mark)
+{
+	struct arena_block *block;
+
+	while (arena_head != mark->block) {
+		block = arena_head;
+		arena_head = block->next;
+		free(block);
+	}
+	if (arena_head)
+		arena_head->used = mark->used;
+}
@@ -23,21 +23,34 @@
 
 /*
  * This module records the progress of boot and arbitrary commands, and
- * permits accurate timestamping of each. The records can optionally be
- * passed to kernel in the ATAGs
+ * permits accurate timestamping of each. It can also accumulate the time
+ * spent in (possibly nested) spans such as device reads. The records can
+ * optionally be passed to the kernel in the device tree.
  */
 
 #include <common.h>
+#include <libfdt.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
 struct bootstage_record {
-	uint32_t time_us;
+	uint32_t time_us;	/* time of mark, or of first span start */
+	uint32_t start_us;	/* start time of the open span */
+	uint32_t accum_us;	/* total time spent inside the span */
+	uint32_t count;		/* number of times the span was entered */
 	const char *name;
+	uint8_t flags;		/* enum bootstage_flags */
+	uint8_t parent;		/* enclosing span, or BOOTSTAGE_NONE */
+	uint8_t depth;		/* nesting depth when first started */
+	uint8_t active;		/* number of times currently entered */
 };
 
 static struct bootstage_record record[BOOTSTAGE_COUNT];
 
+/* Stack of open spans, innermost last */
+static uint8_t span_stack[BOOTSTAGE_MAX_DEPTH];
+static int span_depth;
+
 uint32_t bootstage_mark(enum bootstage_id id, const char *name)
 {
 	struct bootstage_record *rec = &record[id];
@@ -50,6 +63,65 @@ uint32_t bootstage_mark(enum bootstage_id id, const char *name)
 	return rec->time_us;
 }
 
+uint32_t bootstage_start(enum bootstage_id id, const char *name)
+{
+	struct bootstage_record *rec = &record[id];
+	uint32_t now = (uint32_t)timer_get_us();
+
+	if (!rec->name) {
+		rec->time_us = now;
+		rec->name = name;
+		rec->depth = span_depth;
+		rec->parent = span_depth ? span_stack[span_depth - 1] :
+				BOOTSTAGE_NONE;
+	}
+	rec->flags |= BOOTSTAGEF_SPAN;
+	rec->count++;
+
+	/* A recursive entry is timed by the outermost one */
+	if (rec->active++)
+		return now;
+	rec->start_us = now;
+	if (span_depth < BOOTSTAGE_MAX_DEPTH)
+		span_stack[span_depth++] = id;
+	else
+		rec->flags |= BOOTSTAGEF_OVERFLOW;
+
+	return now;
+}
+
+uint32_t bootstage_accum(enum bootstage_id id)
+{
+	struct bootstage_record *rec = &record[id];
+	int i;
+
+	/* Ignore an unbalanced stop */
+	if (!rec->active)
+		return rec->accum_us;
+	if (--rec->active)
+		return rec->accum_us;
+
+	rec->accum_us += (uint32_t)timer_get_us() - rec->start_us;
+
+	/*
+	 * Take the span off the stack even if it is stopped out of order,
+	 * so that it is not left behind as the parent of later spans.
+	 */
+	for (i = span_depth - 1; i >= 0; i--) {
+		if (span_stack[i] == id) {
+			if (i != span_depth - 1)
+				debug("bootstage: span %d stopped out of order\n",
+				      id);
+			memmove(&span_stack[i], &span_stack[i + 1],
+				span_depth - i - 1);
+			span_depth--;
+			break;
+		}
+	}
+
+	return rec->accum_us;
+}
+
 static void print_time(unsigned long us_time)
 {
 	char str[12], *s;
@@ -77,6 +149,23 @@ static uint32_t print_time_record(enum bootstage_id id,
 	return rec->time_us;
 }
 
+/* Print a span and then, indented below it, all of its children */
+static void print_span_tree(int parent, int indent)
+{
+	int id;
+
+	for (id = 0; id < BOOTSTAGE_COUNT; id++) {
+		struct bootstage_record *rec = &record[id];
+
+		if (!(rec->flags & BOOTSTAGEF_SPAN) || rec->parent != parent)
+			continue;
+		print_time(rec->accum_us);
+		printf("%11u  %*s%s%s\n", rec->count, indent, "", rec->name,
+		       rec->active ? " (open)" : "");
+		print_span_tree(id, indent + 2);
+	}
+}
+
 void bootstage_report(void)
 {
 	int id;
@@ -95,10 +184,106 @@ void bootstage_report(void)
 	for (id = 0; id < BOOTSTAGE_COUNT; id++) {
 		struct bootstage_record *rec = &record[id];
 
+		if (rec->flags & BOOTSTAGEF_SPAN)
+			continue;
 		if (id == BOOTSTAGE_AWAKE || rec->time_us != 0)
 			prev = print_time_record(id, rec, prev);
 	}
+
+	puts("\nAccumulated time:\n");
+	printf("%11s%11s  %s\n", "Total", "Count", "Span");
+	print_span_tree(BOOTSTAGE_NONE, 0);
+
 	if (flags & GD_FLG_SILENT)
 		gd->flags |= GD_FLG_SILENT;
 }
 
+int bootstage_export(void *buf, int size)
+{
+	struct bootstage_hdr *hdr = buf;
+	struct bootstage_export_record *out;
+	int id;
+
+	if (size < (int)BOOTSTAGE_EXPORT_SIZE)
+		return -1;
+
+	out = (struct bootstage_export_record *)(hdr + 1);
+	for (id = 0; id < BOOTSTAGE_COUNT; id++) {
+		struct bootstage_record *rec = &record[id];
+
+		if (!rec->name)
+			continue;
+		memset(out, '\0', sizeof(*out));
+		out->time_us = rec->time_us;
+		out->accum_us = rec->accum_us;
+		out->count = rec->count;
+		out->id = id;
+		out->flags = rec->flags;
+		out->parent = rec->parent;
+		out->depth = rec->depth;
+		strncpy(out->name, rec->name, BOOTSTAGE_NAME_LEN - 1);
+		out++;
+	}
+
+	hdr->magic = BOOTSTAGE_MAGIC;
+	hdr->version = BOOTSTAGE_VERSION;
+	hdr->count = out - (struct bootstage_export_record *)(hdr + 1);
+	hdr->size = (void *)out - buf;
+
+	return hdr->size;
+}
+
+#ifdef CONFIG_OF_LIBFDT
+int bootstage_fdt_add_report(void *blob)
+{
+	int chosen, bootstage, node;
+	char node_name[10];
+	int id;
+
+	chosen = fdt_path_offset(blob, "/chosen");
+	if (chosen < 0)
+		chosen = fdt_add_subnode(blob, 0, "chosen");
+	if (chosen < 0)
+		return -1;
+
+	bootstage = fdt_subnode_offset(blob, chosen, "bootstage");
+	if (bootstage >= 0)
+		fdt_del_node(blob, bootstage);
+	bootstage = fdt_add_subnode(blob, chosen, "bootstage");
+	if (bootstage < 0) {
+		debug("bootstage: cannot add node: %s\n",
+		      fdt_strerror(bootstage));
+		return -1;
+	}
+
+	/* Add in reverse so that the records come out in id order */
+	for (id = BOOTSTAGE_COUNT - 1; id >= 0; id--) {
+		struct bootstage_record *rec = &record[id];
+		int err = 0;
+
+		if (!rec->name)
+			continue;
+		sprintf(node_name, "%d", id);
+		node = fdt_add_subnode(blob, bootstage, node_name);
+		if (node < 0)
+			return -1;
+		err |= fdt_setprop_string(blob, node, "name", rec->name);
+		if (rec->flags & BOOTSTAGEF_SPAN) {
+			err |= fdt_setprop_cell(blob, node, "accum",
+						rec->accum_us);
+			err |= fdt_setprop_cell(blob, node, "count",
+						rec->count);
+			if (rec->parent != BOOTSTAGE_NONE)
+				err |= fdt_setprop_cell(blob, node, "parent",
+							rec->parent);
+		} else {
+			err |= fdt_setprop_cell(blob, node, "mark",
+						rec->time_us);
+		}
+		if (err)
+			return -1;
+	}
+
+	return 0;
+}
+#endif
@@ -0,0 +1,634 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * bench - run a set of microbenchmarks and print the timings as a table
+ *
+ * Each benchmark is run a few times to warm up, then timed over a number
+ * of repetitions. The minimum, median and maximum are printed one
+ * benchmark per line, in columns separated by blanks, so that the output
+ * of two builds can be compared with diff or a script. Lines starting
+ * with '#' describe the run.
+ *
+ * Benchmarks that need something from outside (a compressed image, a
+ * block device, a device tree) find it through environment variables and
+ * are reported as "skip" when it is not there:
+ *
+ *	bench_gzip, bench_lzma,		"<addr> <len>" of a compressed image
+ *	bench_lzo, bench_bzip2		(.gz, .lzma, .lzo or .bz2 file)
+ *	bench_dev			"<interface> <dev>", e.g. "mmc 0"
+ *	bench_fdt			address of a device tree; if not set
+ *					the one given to "fdt addr" is used
+ *
+ * Decompressed output is written to $loadaddr, which must not overlap the
+ * images. At most CONFIG_SYS_BOOTM_LEN bytes are written, and never past
+ * the end of RAM or into U-Boot's heap and stack.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <hash.h>
+#include <part.h>
+#include <div64.h>
+#include <image.h>
+#include <decompress.h>
+#ifdef CONFIG_BZIP2
+#include <bzlib.h>
+#endif
+#ifdef CONFIG_OF_LIBFDT
+#include <libfdt.h>
+#endif
+
+#ifndef CONFIG_DECOMPRESS_STREAM
+#error "CONFIG_CMD_BENCH needs CONFIG_DECOMPRESS_STREAM"
+#endif
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Changed whenever the meaning of the columns changes */
+#define BENCH_FORMAT_VERSION	1
+
+#define BENCH_MAX_REPS		100
+#define BENCH_DEF_REPS		5
+#define BENCH_DEF_WARMUP	1
+#define BENCH_DEF_SIZE		(1 << 20)
+
+#define BENCH_ENV_OPS		100	/* getenv/setenv calls per run */
+#define BENCH_BLK_RANDOM	256	/* single-block reads per run */
+#define BENCH_FDT_MAX_NODES	256	/* nodes looked up per run */
+#define BENCH_MALLOC_OPS	1000	/* malloc()/free() pairs per run */
+#define BENCH_MALLOC_LIVE	64	/* blocks allocated at once */
+#define BENCH_STACK_ROOM	0x10000	/* kept free below the stack */
+
+#ifndef CONFIG_SYS_BOOTM_LEN
+#define CONFIG_SYS_BOOTM_LEN	0x800000
+#endif
+
+enum {
+	BENCH_OK,
+	BENCH_SKIP,
+	BENCH_FAIL,
+};
+
+struct bench_ctx {
+	ulong size;		/* bytes for the memory benchmarks */
+	void *src;		/* size bytes, filled with a fixed pattern */
+	void *dst;		/* size bytes */
+
+	/* Set up by a benchmark's prepare() and used by its run() */
+	const void *in;
+	ulong in_len;
+	void *out;
+	ulong out_len;		/* room at out */
+	block_dev_desc_t *dev;
+	lbaint_t blk_count;
+	int *fdt_nodes;
+	int fdt_count;
+	const void *fdt;
+
+	/* Filled in by run(), for the whole of one repetition */
+	ulong bytes;		/* bytes processed */
+	ulong ops;		/* operations done */
+};
+
+/* Flags for struct bench */
+#define BENCH_BUF	(1 << 0)	/* uses the src and dst buffers */
+
+struct bench {
+	const char *name;
+	int flags;
+	/* Returns BENCH_OK, or BENCH_SKIP if the benchmark cannot run */
+	int (*prepare)(struct bench_ctx *ctx, const struct bench *b);
+	/* Runs once; returns 0 if ok, -1 on error */
+	int (*run)(struct bench_ctx *ctx, const struct bench *b);
+	int arg;
+};
+
+static int bench_memcpy(struct bench_ctx *ctx, const struct bench *b)
+{
+	memcpy(ctx->dst, ctx->src, ctx->size);
+	ctx->bytes = ctx->size;
+	ctx->ops = 1;
+
+	return 0;
+}
+
+static int bench_memmove(struct bench_ctx *ctx, const struct bench *b)
+{
+	/* Overlapping, so that the backwards copy is used */
+	memmove(ctx->src + 64, ctx->src, ctx->size - 64);
+	ctx->bytes = ctx->size - 64;
+	ctx->ops = 1;
+
+	return 0;
+}
+
+static int bench_memset(struct bench_ctx *ctx, const struct bench *b)
+{
+	memset(ctx->dst, 0x5a, ctx->size);
+	ctx->bytes = ctx->size;
+	ctx->ops = 1;
+
+	return 0;
+}
+
+static int prepare_hash(struct bench_ctx *ctx, const struct bench *b)
+{
+	return hash_lookup_algo(hash_algo_name(b->arg)) < 0 ?
+		BENCH_SKIP : BENCH_OK;
+}
+
+static int bench_hash(struct bench_ctx *ctx, const struct bench *b)
+{
+	uint8_t digest[HASH_MAX_DIGEST_SIZE];
+
+	if (hash_block(b->arg, ctx->src, ctx->size, digest) < 0)
+		return -1;
+	ctx->bytes = ctx->size;
+	ctx->ops = 1;
+
+	return 0;
+}
+
+/* Parse "<hex addr> <hex len>" from an environment variable */
+static int getenv_region(char *name, const void **addrp, ulong *lenp)
+{
+	char *s = getenv(name);
+	char *end;
+	ulong addr;
+
+	if (!s)
+		return -1;
+	addr = simple_strtoul(s, &end, 16);
+	if (end == s || *end != ' ')
+		return -1;
+	*lenp = simple_strtoul(end + 1, NULL, 16);
+	*addrp = (const void *)addr;
+
+	return *lenp ? 0 : -1;
+}
+
+/*
+ * Return the number of bytes that can be written at addr without running
+ * off the end of RAM or into the heap or the stack. U-Boot itself lives
+ * above the stack when the stack is in RAM.
+ */
+static ulong bench_room(ulong addr)
+{
+	ulong start = CONFIG_SYS_SDRAM_BASE;
+	ulong end = start + gd->ram_size;
+	ulong sp = (ulong)&end;
+
+	if (addr < start || addr >= end)
+		return 0;
+	if (addr >= mem_malloc_start && addr < mem_malloc_end)
+		return 0;
+	if (mem_malloc_start > addr && mem_malloc_start < end)
+		end = mem_malloc_start;
+	if (sp >= start && sp < start + gd->ram_size) {
+		if (sp - start <= BENCH_STACK_ROOM ||
+		    addr >= sp - BENCH_STACK_ROOM)
+			return 0;
+		if (sp - BENCH_STACK_ROOM < end)
+			end = sp - BENCH_STACK_ROOM;
+	}
+
+	return end - addr;
+}
+
+static int prepare_decomp(struct bench_ctx *ctx, const struct bench *b)
+{
+	char name[20];
+	char *s;
+
+	sprintf(name, "bench_%s", b->name);
+	if (getenv_region(name, &ctx->in, &ctx->in_len))
+		return BENCH_SKIP;
+	/* Not load_addr, which the commands that loaded the images moved */
+	s = getenv("loadaddr");
+	ctx->out = (void *)(s ? simple_strtoul(s, NULL, 16) :
+			    CONFIG_SYS_LOAD_ADDR);
+	ctx->out_len = bench_room((ulong)ctx->out);
+	if (ctx->out_len > CONFIG_SYS_BOOTM_LEN)
+		ctx->out_len = CONFIG_SYS_BOOTM_LEN;
+	if (!ctx->out_len) {
+		printf("bench: loadaddr %p is not in free RAM\n", ctx->out);
+		return BENCH_SKIP;
+	}
+
+	switch (b->arg) {
+#ifdef CONFIG_GZIP
+	case IH_COMP_GZIP:
+#endif
+#ifdef CONFIG_LZMA
+	case IH_COMP_LZMA:
+#endif
+#ifdef CONFIG_LZO
+	case IH_COMP_LZO:
+#endif
+#ifdef CONFIG_BZIP2
+	case IH_COMP_BZIP2:
+#endif
+		return BENCH_OK;
+	}
+
+	return BENCH_SKIP;
+}
+
+static int bench_decomp(struct bench_ctx *ctx, const struct bench *b)
+{
+	ulong len = ctx->out_len;
+
+#ifdef CONFIG_BZIP2
+	if (b->arg == IH_COMP_BZIP2) {
+		uint unc_len = len;
+
+		/* Small mode on small heaps, the same as bootm */
+		if (BZ2_bzBuffToBuffDecompress(ctx->out, &unc_len,
+				(char *)ctx->in, ctx->in_len,
+				CONFIG_SYS_MALLOC_LEN < (4096 * 1024), 0) != BZ_OK)
+			return -1;
+		len = unc_len;
+	} else
+#endif
+	if (decomp_buffer(b->arg, ctx->out, len, ctx->in,
+			  ctx->in_len, &len, NULL))
+		return -1;
+	ctx->bytes = len;
+	ctx->ops = 1;
+
+	return 0;
+}
+
+static int prepare_blk(struct bench_ctx *ctx, const struct bench *b)
+{
+	char *s = getenv("bench_dev");
+	char ifname[16];
+	int i;
+
+	if (!s)
+		return BENCH_SKIP;
+	for (i = 0; s[i] && s[i] != ' ' && i < sizeof(ifname) - 1; i++)
+		ifname[i] = s[i];
+	ifname[i] = '\0';
+	if (s[i] != ' ')
+		return BENCH_SKIP;
+
+	ctx->dev = get_dev(ifname, simple_strtoul(s + i + 1, NULL, 16));
+	if (!ctx->dev || !ctx->dev->block_read || !ctx->dev->lba ||
+	    !ctx->dev->blksz)
+		return BENCH_SKIP;
+
+	/* Read as much as the memory benchmarks use, or the whole device */
+	ctx->blk_count = ctx->size / ctx->dev->blksz;
+	if (ctx->blk_count > ctx->dev->lba)
+		ctx->blk_count = ctx->dev->lba;
+
+	return ctx->blk_count ? BENCH_OK : BENCH_SKIP;
+}
+
+static int bench_blk_seq(struct bench_ctx *ctx, const struct bench *b)
+{
+	block_dev_desc_t *dev = ctx->dev;
+
+	if (dev->block_read(dev->dev, 0, ctx->blk_count, ctx->dst) !=
+			ctx->blk_count)
+		return -1;
+	ctx->bytes = ctx->blk_count * dev->blksz;
+	ctx->ops = 1;
+
+	return 0;
+}
+
+static int bench_blk_random(struct bench_ctx *ctx, const struct bench *b)
+{
+	block_dev_desc_t *dev = ctx->dev;
+	u32 seed = 1;	/* the same blocks on every run */
+	int i;
+
+	for (i = 0; i < BENCH_BLK_RANDOM; i++) {
+		seed = seed * 1103515245 + 12345;
+		if (dev->block_read(dev->dev, (seed >> 8) % dev->lba, 1,
+				    ctx->dst) != 1)
+			return -1;
+	}
+	ctx->bytes = BENCH_BLK_RANDOM * dev->blksz;
+	ctx->ops = BENCH_BLK_RANDOM;
+
+	return 0;
+}
+
+#ifdef CONFIG_OF_LIBFDT
+static int prepare_fdt(struct bench_ctx *ctx, const struct bench *b)
+{
+	char *s = getenv("bench_fdt");
+	int offset, depth;
+
+	ctx->fdt = s ? (void *)simple_strtoul(s, NULL, 16) : working_fdt;
+	if (!ctx->fdt || fdt_check_header(ctx->fdt))
+		return BENCH_SKIP;
+
+	ctx->fdt_nodes = malloc(BENCH_FDT_MAX_NODES * sizeof(int));
+	if (!ctx->fdt_nodes)
+		return BENCH_SKIP;
+	ctx->fdt_count = 0;
+	for (offset = 0, depth = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(ctx->fdt, offset, &depth)) {
+		if (ctx->fdt_count == BENCH_FDT_MAX_NODES)
+			break;
+		ctx->fdt_nodes[ctx->fdt_count++] = offset;
+	}
+
+	return BENCH_OK;
+}
+
+/*
+ * Find every node by path and phandle, and read its compatible string,
+ * which is what driver init does over and over.
+ */
+static int bench_fdt(struct bench_ctx *ctx, const struct bench *b)
+{
+	const void *fdt = ctx->fdt;
+	char path[256];
+	uint32_t phandle;
+	int i, offset;
+
+	for (i = 0; i < ctx->fdt_count; i++) {
+		offset = ctx->fdt_nodes[i];
+		if (fdt_get_path(fdt, offset, path, sizeof(path)))
+			return -1;
+		if (fdt_path_offset(fdt, path) != offset)
+			return -1;
+		fdt_getprop(fdt, offset, "compatible", NULL);
+		phandle = fdt_get_phandle(fdt, offset);
+		if (phandle && fdt_node_offset_by_phandle(fdt, phandle) !=
+				offset)
+			return -1;
+	}
+	ctx->bytes = 0;
+	ctx->ops = ctx->fdt_count;
+
+	return 0;
+}
+#endif
+
+static int bench_env(struct bench_ctx *ctx, const struct bench *b)
+{
+	char value[12];
+	int i;
+
+	for (i = 0; i < BENCH_ENV_OPS; i++) {
+		sprintf(value, "%d", i);
+		if (setenv("bench_tmp", value))
+			return -1;
+		if (!getenv("bench_tmp"))
+			return -1;
+	}
+	setenv("bench_tmp", NULL);
+	ctx->bytes = 0;
+	ctx->ops = BENCH_ENV_OPS * 2;
+
+	return 0;
+}
+
+/*
+ * Allocate and free blocks of mixed sizes, mostly small ones as the parser
+ * and the environment use, with a larger buffer now and then
+ */
+static int bench_malloc(struct bench_ctx *ctx, const struct bench *b)
+{
+	void *live[BENCH_MALLOC_LIVE];
+	u32 seed = 1;	/* the same sizes on every run */
+	size_t size;
+	int i, slot, ret = 0;
+
+	memset(live, '\0', sizeof(live));
+	for (i = 0; i < BENCH_MALLOC_OPS; i++) {
+		seed = seed * 1103515245 + 12345;
+		slot = (seed >> 16) % BENCH_MALLOC_LIVE;
+		if ((seed >> 8) & 15)
+			size = 8 + (seed >> 20) % 120;
+		else
+			size = 1024 + (seed >> 20) % 3072;
+		free(live[slot]);
+		live[slot] = malloc(size);
+		if (!live[slot]) {
+			ret = -1;
+			break;
+		}
+	}
+	for (i = 0; i < BENCH_MALLOC_LIVE; i++)
+		free(live[i]);
+	ctx->bytes = 0;
+	ctx->ops = BENCH_MALLOC_OPS * 2;
+
+	return ret;
+}
+
+static const struct bench bench_list[] = {
+	{ "memcpy", BENCH_BUF, NULL, bench_memcpy },
+	{ "memmove", BENCH_BUF, NULL, bench_memmove },
+	{ "memset", BENCH_BUF, NULL, bench_memset },
+	{ "crc32", BENCH_BUF, prepare_hash, bench_hash, HASH_ALGO_CRC32 },
+	{ "md5", BENCH_BUF, prepare_hash, bench_hash, HASH_ALGO_MD5 },
+	{ "sha1", BENCH_BUF, prepare_hash, bench_hash, HASH_ALGO_SHA1 },
+	{ "sha256", BENCH_BUF, prepare_hash, bench_hash, HASH_ALGO_SHA256 },
+	{ "gzip", 0, prepare_decomp, bench_decomp, IH_COMP_GZIP },
+	{ "lzma", 0, prepare_decomp, bench_decomp, IH_COMP_LZMA },
+	{ "lzo", 0, prepare_decomp, bench_decomp, IH_COMP_LZO },
+	{ "bzip2", 0, prepare_decomp, bench_decomp, IH_COMP_BZIP2 },
+	{ "blk_seq", BENCH_BUF, prepare_blk, bench_blk_seq },
+	{ "blk_random", BENCH_BUF, prepare_blk, bench_blk_random },
+#ifdef CONFIG_OF_LIBFDT
+	{ "fdt", 0, prepare_fdt, bench_fdt },
+#endif
+	{ "env", 0, NULL, bench_env },
+	{ "malloc", 0, NULL, bench_malloc },
+};
+
+static int bench_cmp_ulong(const void *a, const void *b)
+{
+	ulong x = *(const ulong *)a, y = *(const ulong *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* Throughput in KiB/s, from bytes done in us microseconds */
+static ulong bench_rate(ulong bytes, ulong us)
+{
+	unsigned long long rate = (unsigned long long)bytes * 1000000;
+
+	if (!us)
+		us = 1;
+	do_div(rate, us);
+
+	return (ulong)(rate >> 10);
+}
+
+static int bench_one(struct bench_ctx *ctx, const struct bench *b,
+		     int warmup, int reps)
+{
+	ulong times[BENCH_MAX_REPS];
+	ulong start, med;
+	int status = BENCH_OK;
+	int i;
+
+	ctx->bytes = 0;
+	ctx->ops = 0;
+	if (b->flags & BENCH_BUF) {
+		/* Only while needed, to leave the heap to the decompressors */
+		ctx->src = malloc(ctx->size);
+		ctx->dst = malloc(ctx->size);
+		if (!ctx->src || !ctx->dst) {
+			printf("bench: cannot allocate 2 x %#lx bytes\n",
+			       ctx->size);
+			status = BENCH_FAIL;
+		}
+		for (i = 0; ctx->src && i < ctx->size / sizeof(u32); i++)
+			((u32 *)ctx->src)[i] = i * 0x9e3779b9;
+	}
+	if (status == BENCH_OK && b->prepare)
+		status = b->prepare(ctx, b);
+
+	for (i = 0; status == BENCH_OK && i < warmup + reps; i++) {
+		start = timer_get_us();
+		if (b->run(ctx, b))
+			status = BENCH_FAIL;
+		if (i >= warmup)
+			times[i - warmup] = timer_get_us() - start;
+		if (ctrlc())
+			status = BENCH_FAIL;
+	}
+
+	printf("%-12s", b->name);
+	if (status != BENCH_OK) {
+		printf(" %10s %6s %10s %10s %10s %10s %s\n", "-", "-", "-",
+		       "-", "-", "-", status == BENCH_SKIP ? "skip" : "fail");
+	} else {
+		qsort(times, reps, sizeof(times[0]), bench_cmp_ulong);
+		med = times[reps / 2];
+		if (!(reps & 1))
+			med = (med + times[reps / 2 - 1]) / 2;
+		printf(" %10lu %6lu %10lu %10lu %10lu %10lu ok\n", ctx->bytes,
+		       ctx->ops, times[0], med, times[reps - 1],
+		       bench_rate(ctx->bytes, med));
+	}
+
+	free(ctx->src);
+	free(ctx->dst);
+	free(ctx->fdt_nodes);
+	ctx->src = NULL;
+	ctx->dst = NULL;
+	ctx->fdt_nodes = NULL;
+
+	return status;
+}
+
+static int bench_selected(const struct bench *b, int argc,
+			  char * const argv[])
+{
+	int i;
+
+	if (!argc)
+		return 1;
+	for (i = 0; i < argc; i++) {
+		if (!strcmp(argv[i], b->name))
+			return 1;
+	}
+
+	return 0;
+}
+
+int do_bench(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	extern char version_string[];
+	struct bench_ctx ctx;
+	int warmup = BENCH_DEF_WARMUP;
+	int reps = BENCH_DEF_REPS;
+	int found = 0, failed = 0;
+	int i;
+
+	memset(&ctx, '\0', sizeof(ctx));
+	ctx.size = BENCH_DEF_SIZE;
+
+	for (argc--, argv++; argc && argv[0][0] == '-'; argc--, argv++) {
+		if (!strcmp(argv[0], "-l")) {
+			for (i = 0; i < ARRAY_SIZE(bench_list); i++)
+				printf("%s\n", bench_list[i].name);
+			return 0;
+		}
+		if (argc < 2 || argv[0][2])
+			return cmd_usage(cmdtp);
+		switch (argv[0][1]) {
+		case 'n':
+			reps = simple_strtoul(argv[1], NULL, 10);
+			break;
+		case 'w':
+			warmup = simple_strtoul(argv[1], NULL, 10);
+			break;
+		case 's':
+			ctx.size = simple_strtoul(argv[1], NULL, 16);
+			break;
+		default:
+			return cmd_usage(cmdtp);
+		}
+		argc--, argv++;
+	}
+	if (reps < 1 || reps > BENCH_MAX_REPS || ctx.size < 4096) {
+		printf("bench: need 1 to %d repetitions and a size of at "
+		       "least 0x1000\n", BENCH_MAX_REPS);
+		return 1;
+	}
+
+	printf("# bench %d\n", BENCH_FORMAT_VERSION);
+	printf("# %s\n", version_string);
+	printf("# warmup %d reps %d size %lu\n", warmup, reps, ctx.size);
+	printf("# %-10s %10s %6s %10s %10s %10s %10s %s\n", "name", "bytes",
+	       "ops", "min_us", "median_us", "max_us", "KiB/s", "result");
+
+	for (i = 0; i < ARRAY_SIZE(bench_list); i++) {
+		if (!bench_selected(&bench_list[i], argc, argv))
+			continue;
+		found++;
+		if (bench_one(&ctx, &bench_list[i], warmup, reps) ==
+				BENCH_FAIL)
+			failed++;
+	}
+
+	if (!found) {
+		printf("bench: no such benchmark\n");
+		return 1;
+	}
+
+	return failed ? 1 : 0;
+}
+
+U_BOOT_CMD(
+	bench,	CONFIG_SYS_MAXARGS,	0,	do_bench,
+	"run microbenchmarks and print their timings",
+	"[-n reps] [-w warmup] [-s size] [name...]\n"
+	"    - run the named benchmarks, or all of them, and print the\n"
+	"      minimum, median and maximum time of reps runs in us\n"
+	"      (default 5 runs after 1 warmup run, 1MB of data)\n"
+	"bench -l\n"
+	"    - list the benchmarks"
+);
@@ -33,6 +33,7 @@
 #include <u-boot/zlib.h>
 #include <bzlib.h>
 #include <environment.h>
+#include <hash.h>
 #include <lmb.h>
 #include <linux/ctype.h>
 #include <asm/byteorder.h>
@@ -158,6 +159,13 @@ static boot_os_fn *boot_os[] = {
 
 static bootm_headers_t images;		/* pointers to os/initrd/fdt images */
 
+/*
+ * Set when the data CRC of a legacy kernel image is to be checked by
+ * bootm_load_os() while it copies the image to its load address, instead
+ * of in a separate pass beforehand.
+ */
+static int os_verify_on_load;
+
 /* Allow for arch specific config before we boot */
 void __arch_preboot_os(void)
 {
@@ -187,6 +195,8 @@ void arch_preboot_os(void) __attribute__((weak, alias("__arch_preboot_os")));
   #define IH_INITRD_ARCH IH_ARCH_SH
 #elif defined(__sparc__)
   #define IH_INITRD_ARCH IH_ARCH_SPARC
+#elif defined(CONFIG_SANDBOX)
+  #define IH_INITRD_ARCH IH_ARCH_SANDBOX
 #else
 # error Unknown CPU type
 #endif
@@ -218,6 +228,7 @@ static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]
 
 	memset ((void *)&images, 0, sizeof (images));
 	images.verify = getenv_yesno ("verify");
+	os_verify_on_load = 0;
 
 	bootm_start_lmb();
 
@@ -329,6 +340,7 @@ static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]
 #define BOOTM_ERR_RESET		-1
 #define BOOTM_ERR_OVERLAP	-2
 #define BOOTM_ERR_UNIMPLEMENTED	-3
+#define BOOTM_ERR_VERIFY	-4
 static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 {
 	uint8_t comp = os.comp;
@@ -348,6 +360,24 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 	case IH_COMP_NONE:
 		if (load == blob_start) {
 			printf ("   XIP %s ... ", type_name);
+		} else if (os_verify_on_load) {
+			struct hash_ctx ctx;
+			uint8_t crc[4];
+
+			printf ("   Loading %s and Verifying Checksum ... ",
+				type_name);
+			hash_init (&ctx, HASH_ALGO_CRC32);
+			hash_memmove (&ctx, (void *)load, (void *)image_start,
+					image_len);
+			hash_finish (&ctx, crc);
+			/* both are big-endian */
+			if (memcmp (crc, &images.legacy_hdr_os_copy.ih_dcrc,
+					sizeof(crc))) {
+				puts ("Bad Data CRC\n");
+				if (boot_progress)
+					show_boot_progress (-3);
+				return BOOTM_ERR_VERIFY;
+			}
 		} else {
 			printf ("   Loading %s ... ", type_name);
 			memmove_wd ((void *)load, (void *)image_start,
@@ -413,12 +443,14 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 	}
 #endif /* CONFIG_LZMA */
 #ifdef CONFIG_LZO
-	case IH_COMP_LZO:
+	case IH_COMP_LZO: {
+		size_t lzo_len = unc_len;
 		printf ("   Uncompressing %s ... ", type_name);
 
 		ret = lzop_decompress((const unsigned char *)image_start,
 					  image_len, (unsigned char *)load,
-					  &unc_len);
+					  &lzo_len);
+		unc_len = lzo_len;
 		if (ret != LZO_E_OK) {
 			printf ("LZO: uncompress or overwrite error %d "
 			      "- must RESET board to recover\n", ret);
@@ -429,6 +461,7 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 
 		*load_end = load + unc_len;
 		break;
+	}
 #endif /* CONFIG_LZO */
 	default:
 		printf ("Unimplemented compression type %d\n", comp);
@@ -461,7 +494,7 @@ static int bootm_start_standalone(ulong iflag, int argc, char * const argv[])
 		setenv("filesize", buf);
 		return 0;
 	}
-	appl = (int (*)(int, char * const []))ntohl(images.ep);
+	appl = (int (*)(int, char * const []))(ulong)ntohl(images.ep);
 	(*appl)(argc-1, &argv[1]);
 
 	return 0;
@@ -494,7 +527,7 @@ int do_bootm_subcommand (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv
 	c = find_cmd_tbl(argv[1], &cmd_bootm_sub[0], ARRAY_SIZE(cmd_bootm_sub));
 
 	if (c) {
-		state = (int)c->cmd;
+		state = (long)c->cmd;
 
 		/* treat start special since it resets the state machine */
 		if (state == BOOTM_STATE_START) {
@@ -666,6 +699,11 @@ int do_bootm (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			show_boot_progress (-7);
 			return 1;
 		}
+		if (ret == BOOTM_ERR_VERIFY) {
+			if (iflag)
+				enable_interrupts();
+			return 1;
+		}
 	}
 
 	lmb_reserve(&images.lmb, images.os.load, (load_end - images.os.load));
@@ -721,6 +759,38 @@ int do_bootm (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
  *     pointer to a legacy image header if valid image was found
  *     otherwise return NULL
  */
+/**
+ * image_can_verify_on_load - check whether the data CRC can be deferred
+ * @hdr: pointer to the legacy kernel image header
+ *
+ * An uncompressed kernel which is not executed in place is copied to its
+ * load address by bootm_load_os(). Its data CRC can be calculated during
+ * that copy, saving a separate pass over the image.
+ *
+ * The trade-off is that a bad image is only reported once the load region
+ * has been written. That is harmless as long as the regions are apart:
+ * bootm fails, and the image is still intact where it was loaded, so it
+ * can be examined or booted again. If they overlap, the copy would also
+ * destroy part of the image, so then the CRC is checked first as before.
+ *
+ * returns:
+ *     1, if the CRC can be checked by bootm_load_os()
+ *     0, otherwise
+ */
+static int image_can_verify_on_load (const image_header_t *hdr)
+{
+	ulong start = (ulong)hdr;
+	ulong end = image_get_data (hdr) + image_get_data_size (hdr);
+	ulong load = image_get_load (hdr);
+
+	if (!image_check_type (hdr, IH_TYPE_KERNEL) ||
+	    image_get_comp (hdr) != IH_COMP_NONE)
+		return 0;
+
+	/* The whole image, header included, must survive a failed check */
+	return load + image_get_data_size (hdr) <= start || load >= end;
+}
+
 static image_header_t *image_get_kernel (ulong img_addr, int verify)
 {
 	image_header_t *hdr = (image_header_t *)img_addr;
@@ -741,7 +811,10 @@ static image_header_t *image_get_kernel (ulong img_addr, int verify)
 	show_boot_progress (3);
 	image_print_contents (hdr);
 
-	if (verify) {
+	os_verify_on_load = 0;
+	if (verify && image_can_verify_on_load (hdr)) {
+		os_verify_on_load = 1;
+	} else if (verify) {
 		puts ("   Verifying Checksum ... ");
 		if (!image_check_dcrc (hdr)) {
 			printf ("Bad Data CRC\n");
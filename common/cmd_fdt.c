@@ -32,6 +32,7 @@
 #include <fdt.h>
 #include <libfdt.h>
 #include <fdt_support.h>
+#include <fdt_index.h>
 
 #define MAX_LEVEL	32		/* how deeply nested we will go */
 #define SCRATCHPAD	1024		/* bytes of scratchpad memory */
@@ -113,6 +114,9 @@ int do_fdt (cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 				}
 			}
 		}
+#ifdef CONFIG_OF_INDEX
+		fdt_index_build(working_fdt);
+#endif
 
 	/*
 	 * Move the working_fdt
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+
+/*
+ * heap - show how the malloc() pool is used
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+
+static int do_heap(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	if (argc < 2)
+		malloc_slab_info();
+	else if (!strcmp(argv[1], "callers"))
+		malloc_slab_callers();
+	else if (!strcmp(argv[1], "reset"))
+		malloc_slab_reset();
+	else
+		return cmd_usage(cmdtp);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	heap,	2,	1,	do_heap,
+	"show malloc() pool usage",
+	"\n"
+	"    - show the pool, its peak use and fragmentation, and the slab\n"
+	"heap callers\n"
+	"    - show the allocations made by each caller, largest first\n"
+	"heap reset\n"
+	"    - restart the peak and the counts from now"
+);
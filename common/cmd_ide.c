@@ -695,6 +695,7 @@ void ide_init (void)
 		ide_dev_desc[i].blksz=0;
 		ide_dev_desc[i].lba=0;
 		ide_dev_desc[i].block_read=ide_read;
+		fat_cache_invalidate(&ide_dev_desc[i]);
 		if (!ide_bus_ok[IDE_BUS(i)])
 			continue;
 		ide_led (led, 1);		/* LED on	*/
@@ -1334,6 +1335,7 @@ ulong ide_write (int device, lbaint_t blknr, ulong blkcnt, void *buffer)
 	}
 #endif
 
+	fat_cache_invalidate(&ide_dev_desc[device]);
 	ide_led (DEVICE_LED(device), 1);	/* LED on	*/
 
 	/* Select device
@@ -938,9 +938,9 @@ int do_mem_mtest (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			WATCHDOG_RESET();
 			readback = *addr;
 			if (readback != val) {
-				printf ("\nMem error @ 0x%08X: "
+				printf ("\nMem error @ 0x%08lX: "
 					"found %08lX, expected %08lX\n",
-					(uint)addr, readback, val);
+					(ulong)addr, readback, val);
 				errs++;
 				if (ctrlc()) {
 					putc ('\n');
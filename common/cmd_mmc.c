@@ -108,6 +108,8 @@ static void print_mmcinfo(struct mmc *mmc)
 	print_size(mmc->capacity, "\n");
 
 	printf("Bus Width: %d-bit\n", mmc->bus_width);
+	printf("DMA in place: %lu bytes, bounced: %lu bytes\n",
+	       mmc->dma_bytes, mmc->bounce_bytes);
 }
 
 int do_mmcinfo (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
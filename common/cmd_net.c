@@ -388,3 +388,59 @@ U_BOOT_CMD(
 );
 
 #endif	/* CONFIG_CMD_DNS */
+
+#if defined(CONFIG_CMD_HTTP)
+int do_httpget(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	char *s;
+	int size;
+
+	/* pre-set load_addr */
+	if ((s = getenv("loadaddr")) != NULL)
+		load_addr = simple_strtoul(s, NULL, 16);
+
+	switch (argc) {
+	case 2:
+		break;
+	case 3:
+		load_addr = simple_strtoul(argv[1], NULL, 16);
+		break;
+	default:
+		return cmd_usage(cmdtp);
+	}
+
+	if (HttpSetURL(argv[argc - 1]) < 0) {
+		printf("httpget: bad URL %s\n", argv[argc - 1]);
+		return 1;
+	}
+
+	if (NetHttpServerIP == 0) {
+#if defined(CONFIG_CMD_DNS)
+		NetDNSResolve = NetHttpHost;
+		NetDNSenvvar = NULL;
+		if (NetLoop(DNS) < 0 || NetDNSResolvedIP == 0) {
+			printf("httpget: cannot resolve %s\n", NetHttpHost);
+			return 1;
+		}
+		NetHttpServerIP = NetDNSResolvedIP;
+#else
+		printf("httpget: %s is not an IP address\n", NetHttpHost);
+		return 1;
+#endif
+	}
+
+	size = NetLoop(HTTP);
+	if (size < 0)
+		return 1;
+
+	if (size > 0)
+		flush_cache(load_addr, size);
+	return 0;
+}
+
+U_BOOT_CMD(
+	httpget,	3,	1,	do_httpget,
+	"load a file via network using HTTP",
+	"[loadAddress] [http://]host[:port]/path"
+);
+#endif	/* CONFIG_CMD_HTTP */
@@ -35,6 +35,7 @@
 #include <command.h>
 #include <image.h>
 #include <malloc.h>
+#include <arena.h>
 #include <asm/byteorder.h>
 #if defined(CONFIG_8xx)
 #include <mpc8xx.h>
@@ -152,7 +153,8 @@ source (ulong addr, const char *fit_uname)
 
 	debug ("** Script length: %ld\n", len);
 
-	if ((cmd = malloc (len + 1)) == NULL) {
+	/* freed by cmd_call() when the source command returns */
+	if ((cmd = arena_alloc (len + 1)) == NULL) {
 		return 1;
 	}
 
@@ -192,7 +194,6 @@ source (ulong addr, const char *fit_uname)
 			rcode = (run_command(line, 0) >= 0);
 	}
 #endif
-	free (cmd);
 	return rcode;
 }
 
@@ -64,7 +64,7 @@ int do_time(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 	/* run the command and report run time */
 	cycles = get_timer_masked();
-	retval = target_cmdtp->cmd(target_cmdtp, 0, target_argc, argv + 1);
+	retval = cmd_call(target_cmdtp, 0, target_argc, argv + 1);
 	cycles = get_timer_masked() - cycles;
 
 	putc('\n');
@@ -186,6 +186,12 @@ void usb_display_desc(struct usb_device *dev)
 			dev->descriptor.idVendor, dev->descriptor.idProduct,
 			(dev->descriptor.bcdDevice>>8) & 0xff,
 			dev->descriptor.bcdDevice & 0xff);
+		/* bytes per millisecond is kB/s */
+		if (dev->bulk_count)
+			printf(" - Bulk: %lu transfers, %lu KiB in %lu ms"
+				" (%lu kB/s)\n", dev->bulk_count,
+				dev->bulk_bytes >> 10, dev->bulk_ms,
+				dev->bulk_bytes / max(dev->bulk_ms, 1UL));
 	}
 
 }
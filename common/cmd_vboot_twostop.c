@@ -79,6 +79,13 @@ DECLARE_GLOBAL_DATA_PTR;
  */
 #define VB_SELECT_ERROR        0xff
 
+/*
+ * The firmware body is read and hashed this many bytes at a time, so that
+ * each piece is hashed while it is still in the cache rather than in a
+ * second pass over the whole body.
+ */
+#define BODY_HASH_CHUNK_SIZE	(64 << 10)
+
 /*
  * A dummy value indicates that VbSelectAndLoadKernel requires U-Boot to show up
  * a command line. This value must be unique to enum VbSelectFirmware_t.
@@ -157,6 +164,7 @@ VbError_t VbExHashFirmwareBody(VbCommonParams* cparams, uint32_t firmware_index)
 	hasher_state_t *s = cparams->caller_context;
 	const int i = (firmware_index == VB_SELECT_FIRMWARE_A ? 0 : 1);
 	firmware_storage_t *file = s->file;
+	uint32_t done, chunk;
 
 	if (firmware_index != VB_SELECT_FIRMWARE_A &&
 			firmware_index != VB_SELECT_FIRMWARE_B) {
@@ -175,12 +183,22 @@ VbError_t VbExHashFirmwareBody(VbCommonParams* cparams, uint32_t firmware_index)
 	 */
 	s->fw[i].size = firmware_body_size((uint32_t)s->fw[i].vblock);
 
-	if (file->read(file, s->fw[i].offset, s->fw[i].size, s->fw[i].cache)) {
-		VBDEBUG(PREFIX "fail to read firmware: %d\n", firmware_index);
-		return 1;
+	bootstage_start(BOOTSTAGE_VBOOT_HASH_BODY, "hash_firmware_body");
+	for (done = 0; done < s->fw[i].size; done += chunk) {
+		chunk = min(s->fw[i].size - done,
+				(uint32_t)BODY_HASH_CHUNK_SIZE);
+		if (file->read(file, s->fw[i].offset + done, chunk,
+				(uint8_t *)s->fw[i].cache + done)) {
+			VBDEBUG(PREFIX "fail to read firmware: %d\n",
+					firmware_index);
+			bootstage_accum(BOOTSTAGE_VBOOT_HASH_BODY);
+			return 1;
+		}
+
+		VbUpdateFirmwareBodyHash(cparams,
+				(uint8_t *)s->fw[i].cache + done, chunk);
 	}
-
-	VbUpdateFirmwareBodyHash(cparams, s->fw[i].cache, s->fw[i].size);
+	bootstage_accum(BOOTSTAGE_VBOOT_HASH_BODY);
 	return 0;
 }
 
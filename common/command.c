@@ -27,6 +27,8 @@
 
 #include <common.h>
 #include <command.h>
+#include <arena.h>
+#include <fdt_index.h>
 
 /*
  * Use puts() instead of printf() to avoid printf buffer overflow
@@ -158,6 +160,27 @@ int cmd_usage(cmd_tbl_t *cmdtp)
 	return 1;
 }
 
+/*
+ * Run a command. Whatever it allocated with arena_alloc() is freed when
+ * it returns, and device tree indexes are checked again before their
+ * next use.
+ */
+int cmd_call(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct arena_mark mark;
+	int ret;
+
+	arena_mark(&mark);
+	ret = (cmdtp->cmd)(cmdtp, flag, argc, argv);
+	arena_release(&mark);
+#ifdef CONFIG_OF_INDEX
+	/* It may have loaded something over an indexed device tree */
+	fdt_index_recheck();
+#endif
+
+	return ret;
+}
+
 #ifdef CONFIG_AUTO_COMPLETE
 
 int var_complete(int argc, char * const argv[], char last_char, int maxv, char *cmdv[])
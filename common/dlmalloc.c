@@ -1526,6 +1526,9 @@ void mem_malloc_init(ulong start, ulong size)
 	mem_malloc_brk = start;
 
 	memset((void *)mem_malloc_start, 0, size);
+#ifdef CONFIG_SYS_MALLOC_SLAB
+	malloc_slab_init();
+#endif
 }
 
 /* field-extraction macros */
@@ -3184,6 +3187,38 @@ struct mallinfo mALLINFo()
 }
 #endif	/* DEBUG */
 
+#ifdef CONFIG_SYS_MALLOC_SLAB
+/*
+ * U-Boot: report on the pool for the heap command. The top chunk and the
+ * part of the pool that sbrk() has not handed out yet form one free block.
+ */
+void malloc_pool_info(struct malloc_pool_info *info)
+{
+	mbinptr b;
+	mchunkptr p;
+	ulong size;
+	int i;
+
+	info->size = mem_malloc_end - mem_malloc_start;
+	info->sbrked = sbrked_mem;
+	info->max_sbrked = max_sbrked_mem;
+	info->largest_free = chunksize(top) + mem_malloc_end - mem_malloc_brk;
+	info->free = info->largest_free;
+	info->free_blocks = 1;
+
+	for (i = 1; i < NAV; ++i) {
+		b = bin_at(i);
+		for (p = last(b); p != b; p = p->bk) {
+			size = chunksize(p);
+			info->free += size;
+			if (size > info->largest_free)
+				info->largest_free = size;
+			info->free_blocks++;
+		}
+	}
+}
+#endif
+
 
 
 
@@ -0,0 +1,592 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * The index is built in two passes over the structure block: the first
+ * counts nodes and properties so that everything fits in one allocation,
+ * the second fills in the tables.
+ *
+ * Nodes go in an open-addressed hash table keyed by parent offset and
+ * name. A node called "name@unit" is also entered as "name", since libfdt
+ * matches it that way, and a key that is already present is not replaced,
+ * so that the first node in the blob wins as it does for libfdt.
+ * Phandles and compatible strings are kept in sorted arrays; aliases are
+ * few, so they are just a list.
+ *
+ * A command can load a different blob of the same size over an indexed
+ * one without going through libfdt. So a CRC32 of the whole blob is kept
+ * with its index, and checked by the first lookup after each command.
+ *
+ * test/fdt_index.c builds this file on the host and checks every lookup
+ * against libfdt's own walk.
+ */
+
+#ifdef USE_HOSTCC		/* HOST build */
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include "libfdt_env.h"
+# include "fdt_host.h"
+
+# define debug(fmt, args...)
+#else				/* U-Boot build */
+# include <common.h>
+# include <malloc.h>
+# include <libfdt.h>
+#endif
+#include <fdt_index.h>
+#include <u-boot/crc.h>
+
+#define FDT_INDEX_MAX		2	/* blobs indexed at once */
+#define FDT_INDEX_MAX_DEPTH	32	/* deepest node we can index */
+
+/* A node, as seen from its parent under one of its names */
+struct index_node {
+	int parent;		/* offset of the parent node */
+	int offset;		/* offset of the node, -1 if slot is free */
+	int len;		/* length of the name it is entered under */
+	uint32_t hash;		/* hash of parent and name */
+};
+
+struct index_phandle {
+	uint32_t phandle;
+	int offset;
+};
+
+struct index_compat {
+	const char *str;	/* one string from a compatible property */
+	int offset;
+};
+
+struct index_alias {
+	const char *name;
+	const char *value;
+};
+
+struct fdt_index {
+	const void *blob;
+	uint32_t totalsize;	/* these tell us if the blob changed */
+	uint32_t size_dt_struct;
+	uint32_t crc;		/* CRC32 of the whole blob */
+	int checked;		/* crc checked since the last command */
+	int node_count;		/* names entered, two per node at most */
+	int node_mask;		/* hash table size less one */
+	int phandle_count;
+	int compat_count;
+	int alias_count;
+	struct index_compat *compats;
+	struct index_alias *aliases;
+	struct index_node *nodes;
+	struct index_phandle *phandles;
+};
+
+/* Most recently built first */
+static struct fdt_index *fdt_index[FDT_INDEX_MAX];
+
+static struct fdt_index *find_index(const void *blob)
+{
+	struct fdt_index *idx;
+	int i;
+
+	for (i = 0; i < FDT_INDEX_MAX; i++) {
+		idx = fdt_index[i];
+		if (idx && idx->blob == blob)
+			break;
+	}
+	if (i == FDT_INDEX_MAX)
+		return NULL;
+
+	if (!idx->checked) {
+		if (fdt_magic(blob) != FDT_MAGIC ||
+		    fdt_totalsize(blob) != idx->totalsize ||
+		    fdt_size_dt_struct(blob) != idx->size_dt_struct ||
+		    crc32(0, blob, idx->totalsize) != idx->crc) {
+			debug("%s: %p has changed, dropping its index\n",
+			      __func__, blob);
+			fdt_index_invalidate(blob);
+			return NULL;
+		}
+		idx->checked = 1;
+	}
+
+	return idx;
+}
+
+static uint32_t name_hash(int parent, const char *name, int len)
+{
+	uint32_t hash = 2166136261u ^ parent;
+
+	while (len--)
+		hash = (hash ^ (unsigned char)*name++) * 16777619;
+
+	return hash;
+}
+
+/* Compare a node name as libfdt's _fdt_nodename_eq() does */
+static int name_eq(const void *blob, int offset, const char *s, int len)
+{
+	const char *p = fdt_offset_ptr(blob, offset + FDT_TAGSIZE, len + 1);
+
+	if (!p || memcmp(p, s, len))
+		return 0;
+
+	return p[len] == '\0' || (p[len] == '@' && !memchr(s, '@', len));
+}
+
+/* Return the slot holding a name, or the free slot where it would go */
+static struct index_node *find_node(struct fdt_index *idx, int parent,
+				    const char *name, int len, uint32_t hash)
+{
+	struct index_node *slot;
+	int i;
+
+	for (i = hash & idx->node_mask;; i = (i + 1) & idx->node_mask) {
+		slot = &idx->nodes[i];
+		if (slot->offset < 0)
+			break;
+		if (slot->hash == hash && slot->parent == parent &&
+		    slot->len == len && name_eq(idx->blob, slot->offset,
+						name, len))
+			break;
+	}
+
+	return slot;
+}
+
+static void add_node(struct fdt_index *idx, int parent, int offset,
+		     const char *name, int len)
+{
+	struct index_node *slot;
+	uint32_t hash;
+
+	if (idx->nodes) {
+		hash = name_hash(parent, name, len);
+		slot = find_node(idx, parent, name, len, hash);
+		if (slot->offset >= 0)
+			return;
+		slot->parent = parent;
+		slot->offset = offset;
+		slot->len = len;
+		slot->hash = hash;
+	}
+	idx->node_count++;
+}
+
+static void add_compat(struct fdt_index *idx, int offset, const char *list,
+		       int len)
+{
+	const char *end = list + len;
+	const char *p;
+
+	for (; list < end; list = p + 1) {
+		p = memchr(list, '\0', end - list);
+		if (!p) {
+			/* libfdt matches a last string ended by padding */
+			if (*end)
+				break;
+			p = end;
+		}
+		if (idx->compats) {
+			idx->compats[idx->compat_count].str = list;
+			idx->compats[idx->compat_count].offset = offset;
+		}
+		idx->compat_count++;
+	}
+}
+
+static void add_prop(struct fdt_index *idx, int node, int is_aliases,
+		     const struct fdt_property *prop, int *seenp)
+{
+	const char *name;
+	int len;
+
+	name = fdt_string(idx->blob, fdt32_to_cpu(prop->nameoff));
+	len = fdt32_to_cpu(prop->len);
+
+	/* libfdt only ever looks at the first property with a name */
+	if (!(*seenp & 1) && !strcmp(name, "compatible")) {
+		*seenp |= 1;
+		add_compat(idx, node, prop->data, len);
+	} else if (!(*seenp & 2) && !strcmp(name, "linux,phandle")) {
+		*seenp |= 2;
+		if (len != sizeof(uint32_t))
+			return;
+		if (idx->phandles) {
+			idx->phandles[idx->phandle_count].phandle =
+				fdt32_to_cpu(*(uint32_t *)prop->data);
+			idx->phandles[idx->phandle_count].offset = node;
+		}
+		idx->phandle_count++;
+	}
+
+	if (is_aliases) {
+		if (idx->aliases) {
+			idx->aliases[idx->alias_count].name = name;
+			idx->aliases[idx->alias_count].value = prop->data;
+		}
+		idx->alias_count++;
+	}
+}
+
+/*
+ * Walk the structure block, counting entries if the tables are not
+ * allocated yet, else filling them in.
+ */
+static int scan_blob(struct fdt_index *idx)
+{
+	const void *blob = idx->blob;
+	const struct fdt_property *prop;
+	int parents[FDT_INDEX_MAX_DEPTH];
+	int offset, nextoffset = 0;
+	int depth = -1;
+	int aliases = -1;
+	int seen = 0;
+	const char *name, *at;
+	uint32_t tag;
+	int len;
+
+	do {
+		offset = nextoffset;
+		tag = fdt_next_tag(blob, offset, &nextoffset);
+		switch (tag) {
+		case FDT_BEGIN_NODE:
+			if (++depth == FDT_INDEX_MAX_DEPTH)
+				return -FDT_ERR_BADSTRUCTURE;
+			parents[depth] = offset;
+			seen = 0;
+			if (!depth)
+				break;
+			name = fdt_get_name(blob, offset, &len);
+			if (!name)
+				return len;
+			if (depth == 1 && aliases < 0 &&
+			    name_eq(blob, offset, "aliases", 7))
+				aliases = offset;
+			add_node(idx, parents[depth - 1], offset, name, len);
+			at = memchr(name, '@', len);
+			if (at)
+				add_node(idx, parents[depth - 1], offset, name,
+					 at - name);
+			break;
+		case FDT_END_NODE:
+			if (--depth < -1)
+				return -FDT_ERR_BADSTRUCTURE;
+			/* libfdt does not see properties after a subnode */
+			seen = -1;
+			break;
+		case FDT_PROP:
+			if (depth < 0)
+				return -FDT_ERR_BADSTRUCTURE;
+			if (seen < 0)
+				break;
+			prop = fdt_offset_ptr(blob, offset, sizeof(*prop));
+			if (!prop)
+				return -FDT_ERR_TRUNCATED;
+			add_prop(idx, parents[depth], parents[depth] == aliases,
+				 prop, &seen);
+			break;
+		}
+		if (nextoffset < 0)
+			return nextoffset;
+	} while (tag != FDT_END);
+
+	return 0;
+}
+
+static int phandle_cmp(const void *a, const void *b)
+{
+	const struct index_phandle *pa = a, *pb = b;
+
+	if (pa->phandle != pb->phandle)
+		return pa->phandle < pb->phandle ? -1 : 1;
+
+	return pa->offset - pb->offset;
+}
+
+static int compat_cmp(const void *a, const void *b)
+{
+	const struct index_compat *ca = a, *cb = b;
+	int ret;
+
+	ret = strcmp(ca->str, cb->str);
+
+	return ret ? ret : ca->offset - cb->offset;
+}
+
+void fdt_index_invalidate(const void *blob)
+{
+	int i;
+
+	for (i = 0; i < FDT_INDEX_MAX; i++) {
+		if (fdt_index[i] && fdt_index[i]->blob == blob) {
+			free(fdt_index[i]);
+			memmove(&fdt_index[i], &fdt_index[i + 1],
+				(FDT_INDEX_MAX - i - 1) * sizeof(fdt_index[0]));
+			fdt_index[FDT_INDEX_MAX - 1] = NULL;
+			return;
+		}
+	}
+}
+
+void fdt_index_recheck(void)
+{
+	int i;
+
+	for (i = 0; i < FDT_INDEX_MAX; i++) {
+		if (fdt_index[i])
+			fdt_index[i]->checked = 0;
+	}
+}
+
+int fdt_index_build(const void *blob)
+{
+	struct fdt_index count, *idx;
+	int slots, i;
+	int ret;
+
+	fdt_index_invalidate(blob);
+	ret = fdt_check_header(blob);
+	if (ret)
+		return ret;
+
+	memset(&count, '\0', sizeof(count));
+	count.blob = blob;
+	ret = scan_blob(&count);
+	if (ret)
+		return ret;
+
+	/* Keep the hash table at most half full */
+	for (slots = 16; slots < count.node_count * 2; slots <<= 1)
+		;
+	idx = malloc(sizeof(*idx) +
+		     count.compat_count * sizeof(struct index_compat) +
+		     count.alias_count * sizeof(struct index_alias) +
+		     slots * sizeof(struct index_node) +
+		     count.phandle_count * sizeof(struct index_phandle));
+	if (!idx)
+		return -FDT_ERR_NOSPACE;
+
+	memset(idx, '\0', sizeof(*idx));
+	idx->blob = blob;
+	idx->totalsize = fdt_totalsize(blob);
+	idx->size_dt_struct = fdt_size_dt_struct(blob);
+	idx->node_mask = slots - 1;
+	idx->compats = (struct index_compat *)(idx + 1);
+	idx->aliases = (struct index_alias *)(idx->compats +
+					      count.compat_count);
+	idx->nodes = (struct index_node *)(idx->aliases + count.alias_count);
+	idx->phandles = (struct index_phandle *)(idx->nodes + slots);
+	for (i = 0; i < slots; i++)
+		idx->nodes[i].offset = -1;
+
+	ret = scan_blob(idx);
+	if (ret) {
+		free(idx);
+		return ret;
+	}
+	qsort(idx->phandles, idx->phandle_count, sizeof(*idx->phandles),
+	      phandle_cmp);
+	qsort(idx->compats, idx->compat_count, sizeof(*idx->compats),
+	      compat_cmp);
+
+	idx->crc = crc32(0, blob, idx->totalsize);
+	idx->checked = 1;
+
+	/* Drop the oldest index to make room */
+	free(fdt_index[FDT_INDEX_MAX - 1]);
+	memmove(&fdt_index[1], &fdt_index[0],
+		(FDT_INDEX_MAX - 1) * sizeof(fdt_index[0]));
+	fdt_index[0] = idx;
+	debug("%s: %p: %d node names, %d phandles, %d compatible, %d aliases\n",
+	      __func__, blob, idx->node_count, idx->phandle_count,
+	      idx->compat_count, idx->alias_count);
+
+	return 0;
+}
+
+/* Check an offset as libfdt does before walking from it */
+static int check_node(const void *blob, int offset)
+{
+	int next;
+
+	if (offset % FDT_TAGSIZE ||
+	    fdt_next_tag(blob, offset, &next) != FDT_BEGIN_NODE)
+		return -FDT_ERR_BADOFFSET;
+
+	return 0;
+}
+
+static int index_subnode(struct fdt_index *idx, int parent,
+			 const char *name, int len)
+{
+	struct index_node *slot;
+
+	if (parent < 0)
+		return parent;
+	slot = find_node(idx, parent, name, len, name_hash(parent, name, len));
+	if (slot->offset >= 0)
+		return slot->offset;
+	if (check_node(idx->blob, parent))
+		return -FDT_ERR_BADOFFSET;
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+static const char *index_alias(struct fdt_index *idx, const char *name,
+			       int len)
+{
+	struct index_alias *alias;
+	int i;
+
+	for (i = 0, alias = idx->aliases; i < idx->alias_count; i++, alias++) {
+		if (!strncmp(alias->name, name, len) && !alias->name[len])
+			return alias->value;
+	}
+
+	return NULL;
+}
+
+static int index_path(struct fdt_index *idx, const char *path)
+{
+	const char *end = path + strlen(path);
+	const char *p = path, *q;
+	int offset = 0;
+
+	if (*path != '/') {
+		q = strchr(path, '/');
+		if (!q)
+			q = end;
+		p = index_alias(idx, path, q - path);
+		if (!p)
+			return -FDT_ERR_BADPATH;
+		offset = index_path(idx, p);
+		p = q;
+	}
+
+	while (*p) {
+		while (*p == '/')
+			p++;
+		if (!*p)
+			return offset;
+		q = strchr(p, '/');
+		if (!q)
+			q = end;
+		offset = index_subnode(idx, offset, p, q - p);
+		if (offset < 0)
+			return offset;
+		p = q;
+	}
+
+	return offset;
+}
+
+int fdt_index_path_offset(const void *blob, const char *path, int *offsetp)
+{
+	struct fdt_index *idx = find_index(blob);
+
+	if (!idx)
+		return 0;
+	*offsetp = index_path(idx, path);
+
+	return 1;
+}
+
+int fdt_index_subnode_offset(const void *blob, int *offsetp,
+			     const char *name, int namelen)
+{
+	struct fdt_index *idx = find_index(blob);
+
+	if (!idx)
+		return 0;
+	*offsetp = index_subnode(idx, *offsetp, name, namelen);
+
+	return 1;
+}
+
+int fdt_index_get_alias(const void *blob, const char *name, int namelen,
+			const char **valuep)
+{
+	struct fdt_index *idx = find_index(blob);
+
+	if (!idx)
+		return 0;
+	*valuep = index_alias(idx, name, namelen);
+
+	return 1;
+}
+
+int fdt_index_node_by_phandle(const void *blob, uint32_t phandle,
+			      int *offsetp)
+{
+	struct fdt_index *idx = find_index(blob);
+	int lo, hi, mid;
+
+	if (!idx)
+		return 0;
+
+	/* Find the first entry for the phandle */
+	for (lo = 0, hi = idx->phandle_count; lo < hi;) {
+		mid = (lo + hi) / 2;
+		if (idx->phandles[mid].phandle < phandle)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo < idx->phandle_count && idx->phandles[lo].phandle == phandle)
+		*offsetp = idx->phandles[lo].offset;
+	else
+		*offsetp = -FDT_ERR_NOTFOUND;
+
+	return 1;
+}
+
+int fdt_index_node_by_compatible(const void *blob, int startoffset,
+				 const char *compatible, int *offsetp)
+{
+	struct fdt_index *idx = find_index(blob);
+	struct index_compat *compat;
+	int lo, hi, mid, ret;
+
+	if (!idx)
+		return 0;
+	if (startoffset >= 0 && check_node(blob, startoffset)) {
+		*offsetp = -FDT_ERR_BADOFFSET;
+		return 1;
+	}
+
+	/* Find the first entry for the string after startoffset */
+	for (lo = 0, hi = idx->compat_count; lo < hi;) {
+		mid = (lo + hi) / 2;
+		compat = &idx->compats[mid];
+		ret = strcmp(compat->str, compatible);
+		if (ret < 0 || (!ret && compat->offset <= startoffset))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	compat = &idx->compats[lo];
+	if (lo < idx->compat_count && !strcmp(compat->str, compatible))
+		*offsetp = compat->offset;
+	else
+		*offsetp = -FDT_ERR_NOTFOUND;
+
+	return 1;
+}
@@ -1697,8 +1697,8 @@ static int run_pipe_real(struct pipe *pi)
 #else
 				/* OK - call function to do the command */
 
-				rcode = (cmdtp->cmd)
-(cmdtp, flag,child->argc-i,&child->argv[i]);
+				rcode = cmd_call(cmdtp, flag, child->argc - i,
+						 &child->argv[i]);
 				if ( !cmdtp->repeatable )
 					flag_repeat = 0;
 
@@ -52,8 +52,7 @@
 #endif
 
 #if defined(CONFIG_FIT)
-#include <u-boot/md5.h>
-#include <sha1.h>
+#include <hash.h>
 
 static int fit_check_ramdisk (const void *fit, int os_noffset,
 		uint8_t arch, int verify);
@@ -69,7 +68,7 @@ static const image_header_t* image_get_ramdisk (ulong rd_addr, uint8_t arch,
 						int verify);
 #else
 #include "mkimage.h"
-#include <u-boot/md5.h>
+#include <hash.h>
 #include <time.h>
 #include <image.h>
 #endif /* !USE_HOSTCC*/
@@ -93,6 +92,7 @@ static const table_entry_t uimage_arch[] = {
 	{	IH_ARCH_SPARC64,	"sparc64",	"SPARC 64 Bit",	},
 	{	IH_ARCH_BLACKFIN,	"blackfin",	"Blackfin",	},
 	{	IH_ARCH_AVR32,		"avr32",	"AVR32",	},
+	{	IH_ARCH_SANDBOX,	"sandbox",	"Sandbox",	},
 	{	-1,			"",		"",		},
 };
 
@@ -2401,22 +2401,15 @@ int fit_set_timestamp (void *fit, int noffset, time_t timestamp)
 static int calculate_hash (const void *data, int data_len, const char *algo,
 			uint8_t *value, int *value_len)
 {
-	if (strcmp (algo, "crc32") == 0 ) {
-		*((uint32_t *)value) = crc32_wd (0, data, data_len,
-							CHUNKSZ_CRC32);
-		*((uint32_t *)value) = cpu_to_uimage (*((uint32_t *)value));
-		*value_len = 4;
-	} else if (strcmp (algo, "sha1") == 0 ) {
-		sha1_csum_wd ((unsigned char *) data, data_len,
-				(unsigned char *) value, CHUNKSZ_SHA1);
-		*value_len = 20;
-	} else if (strcmp (algo, "md5") == 0 ) {
-		md5_wd ((unsigned char *)data, data_len, value, CHUNKSZ_MD5);
-		*value_len = 16;
-	} else {
+	int hash_algo;
+
+	hash_algo = hash_lookup_algo (algo);
+	if (hash_algo < 0) {
 		debug ("Unsupported hash alogrithm\n");
 		return -1;
 	}
+
+	*value_len = hash_block (hash_algo, data, data_len, value);
 	return 0;
 }
 
@@ -0,0 +1,509 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Small-object allocator in front of dlmalloc
+ *
+ * Most allocations are small and short-lived: hush words, environment
+ * keys and values, USB descriptors. Mixed in with large buffers in one
+ * dlmalloc pool they leave holes behind, until a long script can no
+ * longer find room for a large one.
+ *
+ * Requests of up to SLAB_MAX bytes are therefore served from a region
+ * taken from dlmalloc when the pool is set up. The region is divided
+ * into pages of SLAB_PAGE_SIZE bytes, each holding objects of one size
+ * class on a free list of its own. When all the objects in a page are
+ * free the page goes back to a common pool, from which any class can
+ * take it. Larger requests, and small ones when the region is full, go
+ * to dlmalloc.
+ *
+ * Bytes in use, their peak, and the number of allocations made by each
+ * caller are kept for the heap command.
+ *
+ * test/malloc_slab.c builds this file on the host, with the dlmalloc
+ * entry points served by the C library.
+ */
+
+#ifdef USE_HOSTCC		/* HOST build */
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <sys/types.h>
+
+typedef unsigned char uchar;
+
+# define ARRAY_SIZE(x)		(sizeof(x) / sizeof((x)[0]))
+# define debug(fmt, args...)
+# define puts(s)		fputs(s, stdout)
+# define print_size(size, s)	printf("%lu bytes%s", (ulong)(size), s)
+
+struct malloc_pool_info {
+	ulong size;
+	ulong sbrked;
+	ulong max_sbrked;
+	ulong free;
+	ulong largest_free;
+	int free_blocks;
+};
+
+void *dlmalloc(size_t bytes);
+void dlfree(void *mem);
+void *dlrealloc(void *oldmem, size_t bytes);
+void *dlcalloc(size_t n, size_t elem_size);
+void *dlmemalign(size_t alignment, size_t bytes);
+void *dlvalloc(size_t bytes);
+void *dlpvalloc(size_t bytes);
+size_t malloc_usable_size(void *mem);
+void malloc_pool_info(struct malloc_pool_info *info);
+#else				/* U-Boot build */
+# include <common.h>
+# include <malloc.h>
+#endif
+
+#ifdef CONFIG_SYS_MALLOC_SLAB_LEN
+#define SLAB_LEN		CONFIG_SYS_MALLOC_SLAB_LEN
+#else
+#define SLAB_LEN		(256 << 10)
+#endif
+#define SLAB_PAGE_SHIFT		12
+#define SLAB_PAGE_SIZE		(1 << SLAB_PAGE_SHIFT)
+#define SLAB_PAGES		(SLAB_LEN >> SLAB_PAGE_SHIFT)
+#define SLAB_MAX		256	/* largest request served by the slab */
+#define NO_PAGE			(-1)
+
+#define MALLOC_CALLERS		64	/* callers tracked by address */
+
+static const ushort slab_size[] = { 16, 32, 48, 64, 96, 128, 192, 256 };
+
+#define SLAB_CLASSES		ARRAY_SIZE(slab_size)
+
+/* Size class for a request of n bytes, indexed by (n + 15) / 16 */
+static const uchar slab_class_of[SLAB_MAX / 16 + 1] = {
+	0, 0, 1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7,
+};
+
+struct slab_page {
+	void *free;		/* list of free objects */
+	short prev, next;	/* neighbours on a class list or the pool */
+	ushort in_use;		/* objects handed out */
+	uchar class;		/* size class while the page is in use */
+};
+
+struct slab_class {
+	short partial;		/* pages with free objects */
+	ushort pages;		/* pages given to this class */
+	ulong in_use;		/* objects handed out */
+	ulong allocs;		/* objects allocated so far */
+};
+
+struct malloc_caller {
+	void *addr;		/* return address of malloc() and friends */
+	ulong allocs;		/* allocations made */
+	ulong bytes;		/* bytes asked for */
+};
+
+static char *slab_base;		/* NULL until malloc_slab_init() */
+static short slab_pool;		/* pages not given to any class */
+static struct slab_page slab_page[SLAB_PAGES];
+static struct slab_class slab_class[SLAB_CLASSES];
+
+static struct malloc_caller malloc_caller[MALLOC_CALLERS];
+
+static struct {
+	ulong in_use;		/* bytes allocated, as rounded up */
+	ulong peak;		/* the most that have been in use */
+	ulong allocs;
+	ulong frees;
+	ulong failed;		/* requests that could not be met */
+	ulong slab_full;	/* small requests passed to dlmalloc */
+	ulong other_allocs;	/* allocations from untracked callers */
+	ulong other_bytes;
+} heap;
+
+static void page_unlink(short *head, int idx)
+{
+	struct slab_page *page = &slab_page[idx];
+
+	if (page->prev != NO_PAGE)
+		slab_page[page->prev].next = page->next;
+	else
+		*head = page->next;
+	if (page->next != NO_PAGE)
+		slab_page[page->next].prev = page->prev;
+}
+
+static void page_push(short *head, int idx)
+{
+	struct slab_page *page = &slab_page[idx];
+
+	page->prev = NO_PAGE;
+	page->next = *head;
+	if (*head != NO_PAGE)
+		slab_page[*head].prev = idx;
+	*head = idx;
+}
+
+/* Give a page from the pool to a class and put all its objects on its list */
+static void page_init(int idx, int class)
+{
+	struct slab_page *page = &slab_page[idx];
+	char *obj = slab_base + (idx << SLAB_PAGE_SHIFT);
+	char *end = obj + SLAB_PAGE_SIZE - slab_size[class];
+	void **link = &page->free;
+
+	for (; obj <= end; obj += slab_size[class]) {
+		*link = obj;
+		link = (void **)obj;
+	}
+	*link = NULL;
+	page->in_use = 0;
+	page->class = class;
+}
+
+void malloc_slab_init(void)
+{
+	int i;
+
+	slab_base = dlmemalign(SLAB_PAGE_SIZE, SLAB_LEN);
+	if (!slab_base) {
+		debug("%s: no room for the slab\n", __func__);
+		return;
+	}
+	slab_pool = NO_PAGE;
+	for (i = SLAB_PAGES - 1; i >= 0; i--)
+		page_push(&slab_pool, i);
+	for (i = 0; i < SLAB_CLASSES; i++)
+		slab_class[i].partial = NO_PAGE;
+}
+
+static inline int in_slab(const void *ptr)
+{
+	return slab_base && (const char *)ptr >= slab_base &&
+		(const char *)ptr < slab_base + SLAB_LEN;
+}
+
+static inline int page_of(const void *ptr)
+{
+	return ((const char *)ptr - slab_base) >> SLAB_PAGE_SHIFT;
+}
+
+static void *slab_alloc(size_t bytes)
+{
+	int class = slab_class_of[(bytes + 15) >> 4];
+	struct slab_class *cls = &slab_class[class];
+	struct slab_page *page;
+	void *obj;
+	int idx;
+
+	idx = cls->partial;
+	if (idx == NO_PAGE) {
+		idx = slab_pool;
+		if (idx == NO_PAGE)
+			return NULL;
+		page_unlink(&slab_pool, idx);
+		page_init(idx, class);
+		page_push(&cls->partial, idx);
+		cls->pages++;
+	}
+
+	page = &slab_page[idx];
+	obj = page->free;
+	page->free = *(void **)obj;
+	if (!page->free)
+		page_unlink(&cls->partial, idx);
+	page->in_use++;
+	cls->in_use++;
+	cls->allocs++;
+
+	return obj;
+}
+
+static void slab_free(void *obj)
+{
+	int idx = page_of(obj);
+	struct slab_page *page = &slab_page[idx];
+	struct slab_class *cls = &slab_class[page->class];
+
+	if (!page->free)
+		page_push(&cls->partial, idx);
+	*(void **)obj = page->free;
+	page->free = obj;
+	page->in_use--;
+	cls->in_use--;
+
+	/*
+	 * Return an empty page to the pool, unless it is the last one with
+	 * room in its class; otherwise a loop that allocates and frees one
+	 * object would set up a page each time round.
+	 */
+	if (!page->in_use && (cls->partial != idx || page->next != NO_PAGE)) {
+		page_unlink(&cls->partial, idx);
+		page_push(&slab_pool, idx);
+		cls->pages--;
+	}
+}
+
+/* Bytes taken up by an allocation */
+static ulong heap_size(void *ptr)
+{
+	if (in_slab(ptr))
+		return slab_size[slab_page[page_of(ptr)].class];
+
+	return malloc_usable_size(ptr);
+}
+
+static void heap_count(void *ptr, size_t bytes, void *caller)
+{
+	struct malloc_caller *mc;
+	int i, slot;
+
+	heap.allocs++;
+	heap.in_use += heap_size(ptr);
+	if (heap.in_use > heap.peak)
+		heap.peak = heap.in_use;
+
+	slot = ((ulong)caller >> 2) % MALLOC_CALLERS;
+	for (i = 0; i < MALLOC_CALLERS; i++) {
+		mc = &malloc_caller[(slot + i) % MALLOC_CALLERS];
+		if (mc->addr == caller || !mc->addr) {
+			mc->addr = caller;
+			mc->allocs++;
+			mc->bytes += bytes;
+			return;
+		}
+	}
+	heap.other_allocs++;
+	heap.other_bytes += bytes;
+}
+
+static void *heap_alloc(size_t bytes, void *caller)
+{
+	void *ptr = NULL;
+
+	if (bytes <= SLAB_MAX && slab_base) {
+		ptr = slab_alloc(bytes);
+		if (!ptr)
+			heap.slab_full++;
+	}
+	if (!ptr) {
+		ptr = dlmalloc(bytes);
+		if (!ptr) {
+			heap.failed++;
+			return NULL;
+		}
+	}
+	heap_count(ptr, bytes, caller);
+
+	return ptr;
+}
+
+void *malloc(size_t bytes)
+{
+	return heap_alloc(bytes, __builtin_return_address(0));
+}
+
+void free(void *mem)
+{
+	if (!mem)
+		return;
+
+	heap.frees++;
+	if (in_slab(mem)) {
+		heap.in_use -= slab_size[slab_page[page_of(mem)].class];
+		slab_free(mem);
+	} else {
+		heap.in_use -= malloc_usable_size(mem);
+		dlfree(mem);
+	}
+}
+
+/* Count an allocation that dlmalloc made directly */
+static void *heap_dl(void *mem, size_t bytes, void *caller)
+{
+	if (mem)
+		heap_count(mem, bytes, caller);
+	else
+		heap.failed++;
+
+	return mem;
+}
+
+void *calloc(size_t n, size_t elem_size)
+{
+	size_t bytes = n * elem_size;
+	void *mem;
+
+	if (elem_size && bytes / elem_size != n) {
+		heap.failed++;
+		return NULL;
+	}
+
+	/* dlcalloc() knows which of its memory is already clear */
+	if (bytes > SLAB_MAX || !slab_base)
+		return heap_dl(dlcalloc(n, elem_size), bytes,
+			       __builtin_return_address(0));
+
+	mem = heap_alloc(bytes, __builtin_return_address(0));
+	if (mem)
+		memset(mem, '\0', bytes);
+
+	return mem;
+}
+
+void *realloc(void *oldmem, size_t bytes)
+{
+	void *caller = __builtin_return_address(0);
+	ulong old_size;
+	void *mem;
+
+	if (!oldmem)
+		return heap_alloc(bytes, caller);
+
+	old_size = heap_size(oldmem);
+	if (in_slab(oldmem)) {
+		if (bytes <= old_size)
+			return oldmem;
+		mem = heap_alloc(bytes, caller);
+		if (mem) {
+			memcpy(mem, oldmem, old_size);
+			free(oldmem);
+		}
+		return mem;
+	}
+
+	mem = dlrealloc(oldmem, bytes);
+	if (!mem) {
+		heap.failed++;
+		return NULL;
+	}
+	heap.in_use -= old_size;
+	heap_count(mem, bytes, caller);
+	heap.frees++;
+
+	return mem;
+}
+
+void *memalign(size_t alignment, size_t bytes)
+{
+	return heap_dl(dlmemalign(alignment, bytes), bytes,
+		       __builtin_return_address(0));
+}
+
+void *valloc(size_t bytes)
+{
+	return heap_dl(dlvalloc(bytes), bytes, __builtin_return_address(0));
+}
+
+void *pvalloc(size_t bytes)
+{
+	return heap_dl(dlpvalloc(bytes), bytes, __builtin_return_address(0));
+}
+
+static void print_bytes(const char *name, ulong bytes)
+{
+	printf("%-16s%10lu  (", name, bytes);
+	print_size(bytes, ")\n");
+}
+
+/* How much of the free space is not in the largest block, in percent */
+static ulong fragmentation(const struct malloc_pool_info *pool)
+{
+	if (pool->free < 256)
+		return 0;
+
+	return 100 - (pool->largest_free >> 8) * 100 / (pool->free >> 8);
+}
+
+void malloc_slab_info(void)
+{
+	struct malloc_pool_info pool;
+	int i;
+
+	malloc_pool_info(&pool);
+	print_bytes("pool", pool.size);
+	print_bytes("sbrk'd", pool.sbrked);
+	print_bytes("sbrk'd peak", pool.max_sbrked);
+	print_bytes("in use", heap.in_use);
+	print_bytes("in use peak", heap.peak);
+	print_bytes("free", pool.free);
+	print_bytes("largest free", pool.largest_free);
+	printf("%-16s%10d\n", "free blocks", pool.free_blocks);
+	printf("%-16s%9lu%%\n", "fragmentation", fragmentation(&pool));
+	printf("%-16s%10lu\n", "allocs", heap.allocs);
+	printf("%-16s%10lu\n", "frees", heap.frees);
+	printf("%-16s%10lu\n", "failed", heap.failed);
+
+	if (!slab_base)
+		return;
+	printf("\nslab at %p: %d pages of %d bytes, %lu small allocs "
+	       "passed on\n", slab_base, SLAB_PAGES, SLAB_PAGE_SIZE,
+	       heap.slab_full);
+	puts("    size   pages  in use  allocs\n");
+	for (i = 0; i < SLAB_CLASSES; i++) {
+		struct slab_class *cls = &slab_class[i];
+
+		printf("%8u%8u%8lu%8lu\n", slab_size[i], cls->pages,
+		       cls->in_use, cls->allocs);
+	}
+}
+
+static int caller_cmp(const void *a, const void *b)
+{
+	const struct malloc_caller *ca = a, *cb = b;
+
+	if (ca->bytes != cb->bytes)
+		return ca->bytes < cb->bytes ? 1 : -1;
+
+	return 0;
+}
+
+void malloc_slab_callers(void)
+{
+	struct malloc_caller sorted[MALLOC_CALLERS];
+	int i;
+
+	memcpy(sorted, malloc_caller, sizeof(sorted));
+	qsort(sorted, MALLOC_CALLERS, sizeof(sorted[0]), caller_cmp);
+
+	puts("  caller       allocs       bytes\n");
+	for (i = 0; i < MALLOC_CALLERS && sorted[i].addr; i++)
+		printf("%p %10lu  %10lu\n", sorted[i].addr, sorted[i].allocs,
+		       sorted[i].bytes);
+	if (heap.other_allocs)
+		printf("%-8s %10lu  %10lu\n", "other", heap.other_allocs,
+		       heap.other_bytes);
+}
+
+void malloc_slab_reset(void)
+{
+	int i;
+
+	memset(malloc_caller, '\0', sizeof(malloc_caller));
+	heap.peak = heap.in_use;
+	heap.allocs = 0;
+	heap.frees = 0;
+	heap.failed = 0;
+	heap.slab_full = 0;
+	heap.other_allocs = 0;
+	heap.other_bytes = 0;
+	for (i = 0; i < SLAB_CLASSES; i++)
+		slab_class[i].allocs = 0;
+}
@@ -229,8 +229,11 @@ int usb_control_msg(struct usb_device *dev, unsigned int pipe,
 int usb_bulk_msg(struct usb_device *dev, unsigned int pipe,
 			void *data, int len, int *actual_length, int timeout)
 {
+	ulong start;
+
 	if (len < 0)
 		return -1;
+	start = get_timer(0);
 	dev->status = USB_ST_NOT_PROC; /*not yet processed */
 	submit_bulk_msg(dev, pipe, data, len);
 	while (timeout--) {
@@ -239,12 +242,40 @@ int usb_bulk_msg(struct usb_device *dev, unsigned int pipe,
 		wait_ms(1);
 	}
 	*actual_length = dev->act_len;
+	dev->bulk_count++;
+	dev->bulk_bytes += dev->act_len;
+	dev->bulk_ms += get_timer(start);
 	if (dev->status == 0)
 		return 0;
 	else
 		return -1;
 }
 
+#ifdef CONFIG_USB_BULK_QUEUE
+/*-------------------------------------------------------------------
+ * submits a queue of bulk transfers in one go, and waits for all of
+ * them to complete. returns 0 if Ok, -1 if Error (see the status of
+ * each transfer) or 1 if the host controller cannot run this queue,
+ * in which case nothing was sent.
+ * synchronous behavior
+ */
+int usb_bulk_queue(struct usb_device *dev, struct usb_bulk_xfer *xfer,
+			int count, int timeout)
+{
+	ulong start;
+	int result;
+
+	start = get_timer(0);
+	result = submit_bulk_queue(dev, xfer, count, timeout);
+	if (result <= 0) {
+		dev->bulk_count += count;
+		dev->bulk_bytes += dev->act_len;
+		dev->bulk_ms += get_timer(start);
+	}
+	return result;
+}
+#endif
+
 
 /*-------------------------------------------------------------------
  * Max Packet stuff
@@ -760,6 +791,9 @@ struct usb_device *usb_alloc_new_device(void)
 	usb_dev[dev_index].maxchild = 0;
 	for (i = 0; i < USB_MAXCHILDREN; i++)
 		usb_dev[dev_index].children[i] = NULL;
+	usb_dev[dev_index].bulk_count = 0;
+	usb_dev[dev_index].bulk_bytes = 0;
+	usb_dev[dev_index].bulk_ms = 0;
 	usb_dev[dev_index].parent = NULL;
 	dev_index++;
 	return &usb_dev[dev_index - 1];
@@ -123,6 +123,17 @@ typedef struct {
 } umass_bbb_csw_t;
 #define UMASS_BBB_CSW_SIZE	13
 
+#ifdef CONFIG_USB_BULK_QUEUE
+/*
+ * CBW and CSW for the queued transport. The host controller reads and
+ * writes them directly, so each has a cache line to itself.
+ */
+static union {
+	umass_bbb_cbw_t	cbw;
+	umass_bbb_csw_t	csw;
+} usb_stor_wrapper[2] __attribute__((aligned(32)));
+#endif
+
 #ifdef CONFIG_USB_STOR_NO_RETRY
 #define RETRIES(x) 1
 #else
@@ -159,8 +170,16 @@ struct us_data {
 	ccb		*srb;			/* current srb */
 	trans_reset	transport_reset;	/* reset routine */
 	trans_cmnd	transport;		/* transport routine */
+	unsigned short	max_xfer_blk;		/* blocks per read/write */
 };
 
+/*
+ * READ(10) and WRITE(10) start out as large as the host controller takes
+ * in one bulk transfer. A device which fails a large command has its
+ * limit halved, down to the 20 blocks that were always used before.
+ */
+#define USB_MIN_XFER_BLK	20
+
 static struct us_data usb_stor[USB_MAX_STOR_DEV];
 
 
@@ -253,6 +272,7 @@ int usb_stor_scan(int mode)
 		usb_dev_desc[i].type = DEV_TYPE_UNKNOWN;
 		usb_dev_desc[i].block_read = usb_stor_read;
 		usb_dev_desc[i].block_write = usb_stor_write;
+		fat_cache_invalidate(&usb_dev_desc[i]);
 	}
 
 	usb_max_devs = 0;
@@ -493,47 +513,59 @@ static int usb_stor_CB_reset(struct us_data *us)
 }
 
 /*
- * Set up the command for a BBB device. Note that the actual SCSI
- * command is copied into cbw.CBWCDB.
+ * Fill in the CBW for a BBB command, using the next tag. Note that the
+ * actual SCSI command is copied into cbw->CBWCDB.
+ */
+static int usb_stor_BBB_cbw(ccb *srb, umass_bbb_cbw_t *cbw)
+{
+	int dir_in;
+
+	dir_in = US_DIRECTION(srb->cmd[0]);
+
+	/* sanity checks */
+	if (!(srb->cmdlen <= CBWCDBLENGTH)) {
+		USB_STOR_PRINTF("usb_stor_BBB_comdat:cmdlen too large\n");
+		return -1;
+	}
+
+	cbw->dCBWSignature = cpu_to_le32(CBWSIGNATURE);
+	cbw->dCBWTag = cpu_to_le32(CBWTag++);
+	cbw->dCBWDataTransferLength = cpu_to_le32(srb->datalen);
+	cbw->bCBWFlags = (dir_in ? CBWFLAGS_IN : CBWFLAGS_OUT);
+	cbw->bCBWLUN = srb->lun;
+	cbw->bCDBLength = srb->cmdlen;
+	/* copy the command data into the CBW command data buffer */
+	/* DST SRC LEN!!! */
+	memcpy(cbw->CBWCDB, srb->cmd, srb->cmdlen);
+	return 0;
+}
+
+/*
+ * Set up the command for a BBB device and send it.
  */
 int usb_stor_BBB_comdat(ccb *srb, struct us_data *us)
 {
 	int result;
 	int actlen;
-	int dir_in;
 	unsigned int pipe;
 	umass_bbb_cbw_t cbw;
 
-	dir_in = US_DIRECTION(srb->cmd[0]);
-
 #ifdef BBB_COMDAT_TRACE
 	printf("dir %d lun %d cmdlen %d cmd %p datalen %d pdata %p\n",
-		dir_in, srb->lun, srb->cmdlen, srb->cmd, srb->datalen,
-		srb->pdata);
+		US_DIRECTION(srb->cmd[0]), srb->lun, srb->cmdlen, srb->cmd,
+		srb->datalen, srb->pdata);
 	if (srb->cmdlen) {
 		for (result = 0; result < srb->cmdlen; result++)
 			printf("cmd[%d] %#x ", result, srb->cmd[result]);
 		printf("\n");
 	}
 #endif
-	/* sanity checks */
-	if (!(srb->cmdlen <= CBWCDBLENGTH)) {
-		USB_STOR_PRINTF("usb_stor_BBB_comdat:cmdlen too large\n");
+	if (usb_stor_BBB_cbw(srb, &cbw))
 		return -1;
-	}
 
 	/* always OUT to the ep */
 	pipe = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
 
-	cbw.dCBWSignature = cpu_to_le32(CBWSIGNATURE);
-	cbw.dCBWTag = cpu_to_le32(CBWTag++);
-	cbw.dCBWDataTransferLength = cpu_to_le32(srb->datalen);
-	cbw.bCBWFlags = (dir_in ? CBWFLAGS_IN : CBWFLAGS_OUT);
-	cbw.bCBWLUN = srb->lun;
-	cbw.bCDBLength = srb->cmdlen;
-	/* copy the command data into the CBW command data buffer */
-	/* DST SRC LEN!!! */
-	memcpy(cbw.CBWCDB, srb->cmd, srb->cmdlen);
 	result = usb_bulk_msg(us->pusb_dev, pipe, &cbw, UMASS_BBB_CBW_SIZE,
 			      &actlen, USB_CNTL_TIMEOUT * 5);
 	if (result < 0)
@@ -672,6 +704,45 @@ int usb_stor_BBB_clear_endpt_stall(struct us_data *us, __u8 endpt)
 	return result;
 }
 
+#ifdef CONFIG_USB_BULK_QUEUE
+/*
+ * Queue all three phases of a BBB command with the host controller at
+ * once, so that it goes straight from the CBW to the data and on to the
+ * CSW. Returns 1 if the host controller cannot take the queue, else the
+ * result of usb_bulk_queue() with the data phase in xfer[1] if there is
+ * one and the CSW in the last entry.
+ */
+static int usb_stor_BBB_queue(ccb *srb, struct us_data *us,
+			      struct usb_bulk_xfer *xfer, int *count)
+{
+	unsigned int pipein, pipeout;
+	int n = 0;
+
+	if (usb_stor_BBB_cbw(srb, &usb_stor_wrapper[0].cbw))
+		return 1;
+	pipein = usb_rcvbulkpipe(us->pusb_dev, us->ep_in);
+	pipeout = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
+
+	xfer[n].pipe = pipeout;
+	xfer[n].buffer = &usb_stor_wrapper[0].cbw;
+	xfer[n].length = UMASS_BBB_CBW_SIZE;
+	n++;
+	if (srb->datalen != 0) {
+		xfer[n].pipe = US_DIRECTION(srb->cmd[0]) ? pipein : pipeout;
+		xfer[n].buffer = srb->pdata;
+		xfer[n].length = srb->datalen;
+		n++;
+	}
+	xfer[n].pipe = pipein;
+	xfer[n].buffer = &usb_stor_wrapper[1].csw;
+	xfer[n].length = UMASS_BBB_CSW_SIZE;
+	n++;
+
+	*count = n;
+	return usb_bulk_queue(us->pusb_dev, xfer, n, USB_CNTL_TIMEOUT * 5);
+}
+#endif
+
 int usb_stor_BBB_transport(ccb *srb, struct us_data *us)
 {
 	int result, retry;
@@ -679,12 +750,53 @@ int usb_stor_BBB_transport(ccb *srb, struct us_data *us)
 	int actlen, data_actlen;
 	unsigned int pipe, pipein, pipeout;
 	umass_bbb_csw_t csw;
+#ifdef CONFIG_USB_BULK_QUEUE
+	struct usb_bulk_xfer xfer[3];
+	int count;
+#endif
 #ifdef BBB_XPORT_TRACE
 	unsigned char *ptr;
 	int index;
 #endif
 
 	dir_in = US_DIRECTION(srb->cmd[0]);
+	pipein = usb_rcvbulkpipe(us->pusb_dev, us->ep_in);
+	pipeout = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
+	data_actlen = 0;
+
+#ifdef CONFIG_USB_BULK_QUEUE
+	USB_STOR_PRINTF("COMMAND/DATA/STATUS queue\n");
+	result = usb_stor_BBB_queue(srb, us, xfer, &count);
+	if (result <= 0) {
+		if (xfer[0].status) {
+			USB_STOR_PRINTF("failed to send CBW status %ld\n",
+				xfer[0].status);
+			usb_stor_BBB_reset(us);
+			return USB_STOR_TRANSPORT_FAILED;
+		}
+		if (srb->datalen != 0) {
+			data_actlen = xfer[1].act_len;
+			result = xfer[1].status ? -1 : 0;
+			if (xfer[1].status & USB_ST_STALLED) {
+				USB_STOR_PRINTF("DATA:stall\n");
+				/* clear the STALL on the endpoint */
+				result = usb_stor_BBB_clear_endpt_stall(us,
+					dir_in ? us->ep_in : us->ep_out);
+			}
+			if (result < 0) {
+				USB_STOR_PRINTF("usb_bulk_queue error "
+					"status %ld\n", xfer[1].status);
+				usb_stor_BBB_reset(us);
+				return USB_STOR_TRANSPORT_FAILED;
+			}
+		}
+		/* the STATUS phase below sorts out a missing CSW */
+		if (xfer[count - 1].status)
+			goto st;
+		memcpy(&csw, &usb_stor_wrapper[1].csw, UMASS_BBB_CSW_SIZE);
+		goto check;
+	}
+#endif
 
 	/* COMMAND phase */
 	USB_STOR_PRINTF("COMMAND phase\n");
@@ -696,10 +808,7 @@ int usb_stor_BBB_transport(ccb *srb, struct us_data *us)
 		return USB_STOR_TRANSPORT_FAILED;
 	}
 	wait_ms(5);
-	pipein = usb_rcvbulkpipe(us->pusb_dev, us->ep_in);
-	pipeout = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
 	/* DATA phase + error handling */
-	data_actlen = 0;
 	/* no data, go immediately to the STATUS phase */
 	if (srb->datalen == 0)
 		goto st;
@@ -755,6 +864,9 @@ again:
 		usb_stor_BBB_reset(us);
 		return USB_STOR_TRANSPORT_FAILED;
 	}
+#ifdef CONFIG_USB_BULK_QUEUE
+check:
+#endif
 #ifdef BBB_XPORT_TRACE
 	ptr = (unsigned char *)&csw;
 	for (index = 0; index < UMASS_BBB_CSW_SIZE; index++)
@@ -1044,14 +1156,13 @@ static void usb_bin_fixup(struct usb_device_descriptor descriptor,
 }
 #endif /* CONFIG_USB_BIN_FIXUP */
 
-#define USB_MAX_READ_BLK 20
-
 unsigned long usb_stor_read(int device, unsigned long blknr,
 			    unsigned long blkcnt, void *buffer)
 {
 	unsigned long start, blks, buf_addr;
 	unsigned short smallblks;
 	struct usb_device *dev;
+	struct us_data *ss;
 	int retry, i;
 	ccb *srb = &usb_ccb;
 
@@ -1071,11 +1182,12 @@ unsigned long usb_stor_read(int device, unsigned long blknr,
 	}
 
 	usb_disable_asynch(1); /* asynch transfer not allowed */
+	ss = (struct us_data *)dev->privptr;
 	srb->lun = usb_dev_desc[device].lun;
 	buf_addr = (unsigned long)buffer;
 	start = blknr;
 	blks = blkcnt;
-	if (usb_test_unit_ready(srb, (struct us_data *)dev->privptr)) {
+	if (usb_test_unit_ready(srb, ss)) {
 		printf("Device NOT ready\n   Request Sense returned %02X %02X"
 		       " %02X\n", srb->sense_buf[2], srb->sense_buf[12],
 		       srb->sense_buf[13]);
@@ -1089,19 +1201,23 @@ unsigned long usb_stor_read(int device, unsigned long blknr,
 		/* XXX need some comment here */
 		retry = 2;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (blks > USB_MAX_READ_BLK)
-			smallblks = USB_MAX_READ_BLK;
+retry_it:
+		if (blks > ss->max_xfer_blk)
+			smallblks = ss->max_xfer_blk;
 		else
 			smallblks = (unsigned short) blks;
-retry_it:
-		if (smallblks == USB_MAX_READ_BLK)
+		if (smallblks == ss->max_xfer_blk)
 			usb_show_progress();
 		srb->datalen = usb_dev_desc[device].blksz * smallblks;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (usb_read_10(srb, (struct us_data *)dev->privptr, start,
-		    smallblks)) {
+		if (usb_read_10(srb, ss, start, smallblks)) {
 			USB_STOR_PRINTF("Read ERROR\n");
-			usb_request_sense(srb, (struct us_data *)dev->privptr);
+			usb_request_sense(srb, ss);
+			if (smallblks > USB_MIN_XFER_BLK) {
+				ss->max_xfer_blk = max(smallblks / 2,
+						       USB_MIN_XFER_BLK);
+				goto retry_it;
+			}
 			if (retry--)
 				goto retry_it;
 			blkcnt -= blks;
@@ -1116,19 +1232,18 @@ retry_it:
 			start, smallblks, buf_addr);
 
 	usb_disable_asynch(0); /* asynch transfer allowed */
-	if (blkcnt >= USB_MAX_READ_BLK)
+	if (blkcnt >= ss->max_xfer_blk)
 		debug("\n");
 	return blkcnt;
 }
 
-#define USB_MAX_WRITE_BLK 20
-
 unsigned long usb_stor_write(int device, unsigned long blknr,
 				unsigned long blkcnt, const void *buffer)
 {
 	unsigned long start, blks, buf_addr;
 	unsigned short smallblks;
 	struct usb_device *dev;
+	struct us_data *ss;
 	int retry, i;
 	ccb *srb = &usb_ccb;
 
@@ -1136,6 +1251,7 @@ unsigned long usb_stor_write(int device, unsigned long blknr,
 		return 0;
 
 	device &= 0xff;
+	fat_cache_invalidate(&usb_dev_desc[device]);
 	/* Setup  device */
 	USB_STOR_PRINTF("\nusb_write: dev %d \n", device);
 	dev = NULL;
@@ -1148,12 +1264,13 @@ unsigned long usb_stor_write(int device, unsigned long blknr,
 	}
 
 	usb_disable_asynch(1); /* asynch transfer not allowed */
+	ss = (struct us_data *)dev->privptr;
 
 	srb->lun = usb_dev_desc[device].lun;
 	buf_addr = (unsigned long)buffer;
 	start = blknr;
 	blks = blkcnt;
-	if (usb_test_unit_ready(srb, (struct us_data *)dev->privptr)) {
+	if (usb_test_unit_ready(srb, ss)) {
 		printf("Device NOT ready\n   Request Sense returned %02X %02X"
 		       " %02X\n", srb->sense_buf[2], srb->sense_buf[12],
 			srb->sense_buf[13]);
@@ -1169,19 +1286,23 @@ unsigned long usb_stor_write(int device, unsigned long blknr,
 		 */
 		retry = 2;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (blks > USB_MAX_WRITE_BLK)
-			smallblks = USB_MAX_WRITE_BLK;
+retry_it:
+		if (blks > ss->max_xfer_blk)
+			smallblks = ss->max_xfer_blk;
 		else
 			smallblks = (unsigned short) blks;
-retry_it:
-		if (smallblks == USB_MAX_WRITE_BLK)
+		if (smallblks == ss->max_xfer_blk)
 			usb_show_progress();
 		srb->datalen = usb_dev_desc[device].blksz * smallblks;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (usb_write_10(srb, (struct us_data *)dev->privptr, start,
-		    smallblks)) {
+		if (usb_write_10(srb, ss, start, smallblks)) {
 			USB_STOR_PRINTF("Write ERROR\n");
-			usb_request_sense(srb, (struct us_data *)dev->privptr);
+			usb_request_sense(srb, ss);
+			if (smallblks > USB_MIN_XFER_BLK) {
+				ss->max_xfer_blk = max(smallblks / 2,
+						       USB_MIN_XFER_BLK);
+				goto retry_it;
+			}
 			if (retry--)
 				goto retry_it;
 			blkcnt -= blks;
@@ -1196,7 +1317,7 @@ retry_it:
 			start, smallblks, buf_addr);
 
 	usb_disable_asynch(0); /* asynch transfer allowed */
-	if (blkcnt >= USB_MAX_WRITE_BLK)
+	if (blkcnt >= ss->max_xfer_blk)
 		debug("\n");
 	return blkcnt;
 
@@ -1238,6 +1359,7 @@ int usb_storage_probe(struct usb_device *dev, unsigned int ifnum,
 	}
 
 	memset(ss, 0, sizeof(struct us_data));
+	ss->max_xfer_blk = USB_MIN_XFER_BLK;
 
 	/* At this point, we know we've got a live one */
 	USB_STOR_PRINTF("\n\nUSB Mass Storage device detected\n");
@@ -1347,8 +1469,8 @@ int usb_stor_get_info(struct usb_device *dev, struct us_data *ss,
 		      block_dev_desc_t *dev_desc)
 {
 	unsigned char perq, modi;
-	unsigned long cap[2];
-	unsigned long *capacity, *blksz;
+	u32 cap[2];
+	u32 *capacity, *blksz;
 	ccb *pccb = &usb_ccb;
 
 	/* for some reasons a couple of devices would not survive this reset */
@@ -1426,7 +1548,7 @@ int usb_stor_get_info(struct usb_device *dev, struct us_data *ss,
 		cap[0] = 2880;
 		cap[1] = 0x200;
 	}
-	USB_STOR_PRINTF("Read Capacity returns: 0x%lx, 0x%lx\n", cap[0],
+	USB_STOR_PRINTF("Read Capacity returns: 0x%x, 0x%x\n", cap[0],
 			cap[1]);
 #if 0
 	if (cap[0] > (0x200000 * 10)) /* greater than 10 GByte */
@@ -1439,11 +1561,18 @@ int usb_stor_get_info(struct usb_device *dev, struct us_data *ss,
 	cap[0] += 1;
 	capacity = &cap[0];
 	blksz = &cap[1];
-	USB_STOR_PRINTF("Capacity = 0x%lx, blocksz = 0x%lx\n",
+	USB_STOR_PRINTF("Capacity = 0x%x, blocksz = 0x%x\n",
 			*capacity, *blksz);
 	dev_desc->lba = *capacity;
 	dev_desc->blksz = *blksz;
 	dev_desc->type = perq;
+	if (*blksz) {
+		/* READ(10) counts blocks in 16 bits */
+		ss->max_xfer_blk = min(USB_MAX_XFER_SIZE / *blksz, 0xffffUL);
+		if (ss->max_xfer_blk < USB_MIN_XFER_BLK)
+			ss->max_xfer_blk = USB_MIN_XFER_BLK;
+	}
+	USB_STOR_PRINTF("max transfer %d blocks\n", ss->max_xfer_blk);
 	USB_STOR_PRINTF(" address %d\n", dev_desc->target);
 	USB_STOR_PRINTF("partype: %d\n", dev_desc->part_type);
 
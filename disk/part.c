@@ -40,7 +40,8 @@
      defined(CONFIG_CMD_SCSI) || \
      defined(CONFIG_CMD_USB) || \
      defined(CONFIG_MMC) || \
-     defined(CONFIG_SYSTEMACE) )
+     defined(CONFIG_SYSTEMACE) || \
+     defined(CONFIG_SANDBOX) )
 
 struct block_drvr {
 	char *name;
@@ -68,6 +69,9 @@ static const struct block_drvr block_drvr[] = {
 #endif
 #if defined(CONFIG_CMD_MG_DISK)
 	{ .name = "mgd", .get_dev = mg_disk_get_dev, },
+#endif
+#if defined(CONFIG_SANDBOX)
+	{ .name = "host", .get_dev = host_get_dev, },
 #endif
 	{ },
 };
@@ -110,7 +114,8 @@ block_dev_desc_t *get_dev(char* ifname, int dev)
      defined(CONFIG_CMD_SCSI) || \
      defined(CONFIG_CMD_USB) || \
      defined(CONFIG_MMC) || \
-     defined(CONFIG_SYSTEMACE) )
+     defined(CONFIG_SYSTEMACE) || \
+     defined(CONFIG_SANDBOX) )
 
 /* ------------------------------------------------------------------------- */
 /*
@@ -165,6 +170,7 @@ void dev_print (block_dev_desc_t *dev_desc)
 	case IF_TYPE_SD:
 	case IF_TYPE_MMC:
 	case IF_TYPE_USB:
+	case IF_TYPE_HOST:
 		printf ("Vendor: %s Rev: %s Prod: %s\n",
 			dev_desc->vendor,
 			dev_desc->revision,
@@ -246,7 +252,8 @@ void dev_print (block_dev_desc_t *dev_desc)
      defined(CONFIG_CMD_SCSI) || \
      defined(CONFIG_CMD_USB) || \
      defined(CONFIG_MMC)		|| \
-     defined(CONFIG_SYSTEMACE) )
+     defined(CONFIG_SYSTEMACE) || \
+     defined(CONFIG_SANDBOX) )
 
 #if defined(CONFIG_MAC_PARTITION) || \
     defined(CONFIG_DOS_PARTITION) || \
@@ -374,6 +381,9 @@ static void print_part_header (const char *type, block_dev_desc_t * dev_desc)
 	case IF_TYPE_MMC:
 		puts ("MMC");
 		break;
+	case IF_TYPE_HOST:
+		puts ("HOST");
+		break;
 	default:
 		puts ("UNKNOWN");
 		break;
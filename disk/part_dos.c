@@ -41,7 +41,8 @@
     defined(CONFIG_CMD_SCSI) || \
     defined(CONFIG_CMD_USB) || \
     defined(CONFIG_MMC) || \
-    defined(CONFIG_SYSTEMACE)
+    defined(CONFIG_SYSTEMACE) || \
+    defined(CONFIG_SANDBOX)
 
 /* Convert char[4] in little endian format to the host format integer
  */
@@ -31,7 +31,8 @@
     defined(CONFIG_CMD_SATA) || \
     defined(CONFIG_CMD_USB) || \
     defined(CONFIG_MMC) || \
-    defined(CONFIG_SYSTEMACE)
+    defined(CONFIG_SYSTEMACE) || \
+    defined(CONFIG_SANDBOX)
 
 /* #define	ISO_PART_DEBUG */
 
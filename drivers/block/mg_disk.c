@@ -441,6 +441,7 @@ unsigned int mg_disk_write_sects(void *buff, u32 sect_num, u32 sect_cnt)
 unsigned long mg_block_write (int dev, unsigned long start,
 		lbaint_t blkcnt, const void *buffer)
 {
+	fat_cache_invalidate(&mg_disk_dev);
 	start += MG_RES_SEC;
 	if (!mg_disk_write_sects((void *)buffer, start, blkcnt))
 		return blkcnt;
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+
+/*
+ * Block devices backed by files on the host ("host 0" to "host 3"), given
+ * with -b on the command line. They let fatload, ext2load and the partition
+ * code run straight on disk images, with no controller in between.
+ */
+
+#include <common.h>
+#include <part.h>
+#include <os.h>
+#include <asm/state.h>
+
+struct host_block_dev {
+	block_dev_desc_t blk_dev;
+	int fd;
+};
+
+static struct host_block_dev host_devices[SANDBOX_MAX_HOST_DEVS];
+
+static unsigned long host_block_read(int dev, unsigned long start,
+				     lbaint_t blkcnt, void *buffer)
+{
+	struct host_block_dev *host_dev = &host_devices[dev];
+	block_dev_desc_t *blk_dev = &host_dev->blk_dev;
+	ssize_t len;
+
+	len = os_pread(host_dev->fd, buffer, blkcnt * blk_dev->blksz,
+		       (long long)start * blk_dev->blksz);
+	if (len < 0)
+		return 0;
+	return len / blk_dev->blksz;
+}
+
+static unsigned long host_block_write(int dev, unsigned long start,
+				      lbaint_t blkcnt, const void *buffer)
+{
+	struct host_block_dev *host_dev = &host_devices[dev];
+	block_dev_desc_t *blk_dev = &host_dev->blk_dev;
+	ssize_t len;
+
+	fat_cache_invalidate(blk_dev);
+	len = os_pwrite(host_dev->fd, buffer, blkcnt * blk_dev->blksz,
+			(long long)start * blk_dev->blksz);
+	if (len < 0)
+		return 0;
+	return len / blk_dev->blksz;
+}
+
+/* Open the file the first time the device is asked for */
+static int host_dev_bind(int dev, const char *filename)
+{
+	struct host_block_dev *host_dev = &host_devices[dev];
+	block_dev_desc_t *blk_dev = &host_dev->blk_dev;
+	const char *name;
+	long long size;
+	int fd;
+
+	fd = os_open(filename, OS_O_RDWR);
+	if (fd < 0)
+		fd = os_open(filename, OS_O_RDONLY);
+	if (fd < 0) {
+		printf("host %d: cannot open '%s'\n", dev, filename);
+		return -1;
+	}
+	size = os_lseek(fd, 0, OS_SEEK_END);
+
+	host_dev->fd = fd;
+	blk_dev->if_type = IF_TYPE_HOST;
+	blk_dev->dev = dev;
+	blk_dev->part_type = PART_TYPE_UNKNOWN;
+	blk_dev->type = DEV_TYPE_HARDDISK;
+	blk_dev->blksz = 512;
+	blk_dev->lba = size / blk_dev->blksz;
+	blk_dev->block_read = host_block_read;
+	blk_dev->block_write = host_block_write;
+
+	/* The file's name, without its directory, is the product name */
+	name = strrchr(filename, '/');
+	name = name ? name + 1 : filename;
+	strcpy(blk_dev->vendor, "Sandbox");
+	strncpy(blk_dev->product, name, sizeof(blk_dev->product) - 1);
+	strcpy(blk_dev->revision, "1.0");
+
+	init_part(blk_dev);
+	return 0;
+}
+
+block_dev_desc_t *host_get_dev(int dev)
+{
+	struct sandbox_state *state = state_get_current();
+	struct host_block_dev *host_dev;
+
+	if (dev < 0 || dev >= state->host_count)
+		return NULL;
+
+	host_dev = &host_devices[dev];
+	if (host_dev->blk_dev.block_read == NULL &&
+	    host_dev_bind(dev, state->host_file[dev]))
+		return NULL;
+
+	return &host_dev->blk_dev;
+}
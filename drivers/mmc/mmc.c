@@ -139,6 +139,7 @@ mmc_bwrite(int dev_num, ulong start, lbaint_t blkcnt, const void*src)
 	if (!mmc)
 		return 0;
 
+	fat_cache_invalidate(&mmc->block_dev);
 	if (mmc_set_blocklen(mmc, mmc->write_bl_len))
 		return 0;
 
@@ -158,56 +159,121 @@ mmc_bwrite(int dev_num, ulong start, lbaint_t blkcnt, const void*src)
 	return blkcnt;
 }
 
-int mmc_read_blocks(struct mmc *mmc, void *dst, ulong start, lbaint_t blkcnt)
+int mmc_read_submit(struct mmc *mmc, struct mmc_req *req, void *dst,
+		    ulong start, lbaint_t blkcnt)
 {
-	struct mmc_cmd cmd;
-	struct mmc_data data;
+	struct mmc_cmd *cmd = &req->cmd;
+	struct mmc_data *data = &req->data;
+
+	req->blkcnt = blkcnt;
+	req->waited = 0;
+	req->use_cmd23 = blkcnt > 1 && (mmc->card_caps & MMC_MODE_CMD23);
+
+	/*
+	 * An unaligned buffer may go through the host's bounce buffer, which
+	 * cannot be shared by two requests, so do those synchronously.
+	 */
+	req->async = (mmc->host_caps & MMC_MODE_ASYNC) &&
+			!((ulong)dst & (CACHE_LINE_SIZE - 1));
+
+	if (req->use_cmd23) {
+		cmd->cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+		cmd->cmdarg = blkcnt & 0xffff;
+		cmd->resp_type = MMC_RSP_R1;
+		cmd->flags = 0;
+		req->err = mmc_send_cmd(mmc, cmd, NULL);
+		if (req->err)
+			return req->err;
+	}
 
 	if (blkcnt > 1)
-		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
+		cmd->cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
 	else
-		cmd.cmdidx = MMC_CMD_READ_SINGLE_BLOCK;
+		cmd->cmdidx = MMC_CMD_READ_SINGLE_BLOCK;
 
 	if (mmc->high_capacity)
-		cmd.cmdarg = start;
+		cmd->cmdarg = start;
 	else
-		cmd.cmdarg = start * mmc->read_bl_len;
+		cmd->cmdarg = start * mmc->read_bl_len;
 
-	cmd.resp_type = MMC_RSP_R1;
-	cmd.flags = 0;
+	cmd->resp_type = MMC_RSP_R1;
+	cmd->flags = 0;
 
-	data.dest = dst;
-	data.blocks = blkcnt;
-	data.blocksize = mmc->read_bl_len;
-	data.flags = MMC_DATA_READ;
+	data->dest = dst;
+	data->blocks = blkcnt;
+	data->blocksize = mmc->read_bl_len;
+	data->flags = MMC_DATA_READ;
 
-	if (mmc_send_cmd(mmc, &cmd, &data))
-		return 0;
+	if (req->async)
+		req->err = mmc->start_data(mmc, cmd, data);
+	else
+		req->err = mmc_send_cmd(mmc, cmd, data);
 
-	if (blkcnt > 1) {
+	return req->err;
+}
+
+int mmc_read_wait(struct mmc *mmc, struct mmc_req *req)
+{
+	struct mmc_cmd cmd;
+
+	if (req->waited)
+		return req->err;
+	req->waited = 1;
+
+	if (req->err)
+		return req->err;
+
+	if (req->async)
+		req->err = mmc->wait_data(mmc, &req->data);
+	if (req->err)
+		return req->err;
+
+	if (req->blkcnt > 1 && !req->use_cmd23) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
 		cmd.flags = 0;
 		if (mmc_send_cmd(mmc, &cmd, NULL)) {
 			printf("mmc fail to send stop cmd\n");
-			return 0;
+			req->err = -1;
 		}
 	}
 
-	return blkcnt;
+	return req->err;
 }
 
-static ulong mmc_bread(int dev_num, ulong start, lbaint_t blkcnt, void *dst)
+lbaint_t mmc_read_complete(struct mmc *mmc, struct mmc_req *req)
 {
-	lbaint_t cur, blocks_todo = blkcnt;
-
-	if (blkcnt == 0)
+	if (mmc_read_wait(mmc, req))
 		return 0;
 
-	struct mmc *mmc = find_mmc_device(dev_num);
-	if (!mmc)
-		return 0;
+	if (req->async)
+		mmc->finish_data(mmc, &req->data);
+
+	return req->blkcnt;
+}
+
+int mmc_read_blocks(struct mmc *mmc, void *dst, ulong start, lbaint_t blkcnt)
+{
+	struct mmc_req req;
+
+	mmc_read_submit(mmc, &req, dst, start, blkcnt);
+
+	return mmc_read_complete(mmc, &req);
+}
+
+/*
+ * Split large reads into chunks of this many blocks so that the cache
+ * maintenance for one chunk overlaps the transfer of the next.
+ */
+#define MMC_PIPELINE_BLOCKS	1024
+
+static ulong mmc_do_bread(struct mmc *mmc, ulong start, lbaint_t blkcnt,
+			  void *dst)
+{
+	lbaint_t cur, chunk, blocks_todo = blkcnt;
+	struct mmc_req req[2], *prev = NULL, *next;
+	int upto = 0;
 
 	if ((start + blkcnt) > mmc->block_dev.lba) {
 		printf("MMC: block number 0x%lx exceeds max(0x%lx)\n",
@@ -218,22 +284,63 @@ static ulong mmc_bread(int dev_num, ulong start, lbaint_t blkcnt, void *dst)
 	if (mmc_set_blocklen(mmc, mmc->read_bl_len))
 		return 0;
 
+	/*
+	 * The 65535 constraint comes from some hardware has
+	 * only 16 bit width block number counter. Only pipeline when every
+	 * SET_BLOCK_COUNT saves a stop command.
+	 */
+	chunk = 65535;
+	if ((mmc->host_caps & MMC_MODE_ASYNC) &&
+			(mmc->card_caps & MMC_MODE_CMD23))
+		chunk = MMC_PIPELINE_BLOCKS;
+
 	do {
-		/*
-		 * The 65535 constraint comes from some hardware has
-		 * only 16 bit width block number counter
-		 */
-		cur = (blocks_todo > 65535) ? 65535 : blocks_todo;
-		if(mmc_read_blocks(mmc, dst, start, cur) != cur)
+		cur = (blocks_todo > chunk) ? chunk : blocks_todo;
+		next = &req[upto++ & 1];
+
+		/* The host must be idle before the next transfer starts */
+		if (prev && mmc_read_wait(mmc, prev))
 			return 0;
+		if (mmc_read_submit(mmc, next, dst, start, cur)) {
+			if (prev)
+				mmc_read_complete(mmc, prev);
+			mmc_read_complete(mmc, next);
+			return 0;
+		}
+		if (prev)
+			mmc_read_complete(mmc, prev);
+		prev = next;
+
 		blocks_todo -= cur;
 		start += cur;
 		dst += cur * mmc->read_bl_len;
 	} while (blocks_todo > 0);
 
+	if (mmc_read_complete(mmc, prev) != prev->blkcnt)
+		return 0;
+
 	return blkcnt;
 }
 
+static ulong mmc_bread(int dev_num, ulong start, lbaint_t blkcnt, void *dst)
+{
+	struct mmc *mmc;
+	ulong ret;
+
+	if (blkcnt == 0)
+		return 0;
+
+	mmc = find_mmc_device(dev_num);
+	if (!mmc)
+		return 0;
+
+	bootstage_start(BOOTSTAGE_MMC_READ, "mmc_bread");
+	ret = mmc_do_bread(mmc, start, blkcnt, dst);
+	bootstage_accum(BOOTSTAGE_MMC_READ);
+
+	return ret;
+}
+
 int mmc_go_idle(struct mmc* mmc)
 {
 	struct mmc_cmd cmd;
@@ -399,7 +506,8 @@ int mmc_change_freq(struct mmc *mmc)
 	if (mmc->version < MMC_VERSION_4)
 		goto out;
 
-	mmc->card_caps |= MMC_MODE_4BIT;
+	/* All version 4 cards support SET_BLOCK_COUNT */
+	mmc->card_caps |= MMC_MODE_4BIT | MMC_MODE_CMD23;
 
 	err = mmc_send_ext_csd(mmc, ext_csd);
 
@@ -544,6 +652,9 @@ retry_scr:
 	if (mmc->scr[0] & SD_DATA_4BIT)
 		mmc->card_caps |= MMC_MODE_4BIT;
 
+	if (mmc->scr[0] & SD_CMD23_SUPPORT)
+		mmc->card_caps |= MMC_MODE_CMD23;
+
 	/* If high-speed isn't supported, we return */
 	if (!(__be32_to_cpu(buffer[3]) & SD_HIGHSPEED_SUPPORTED))
 		goto out;
@@ -875,6 +986,8 @@ int mmc_register(struct mmc *mmc)
 	mmc->block_dev.removable = 1;
 	mmc->block_dev.block_read = mmc_bread;
 	mmc->block_dev.block_write = mmc_bwrite;
+	mmc->dma_bytes = 0;
+	mmc->bounce_bytes = 0;
 
 	INIT_LIST_HEAD (&mmc->link);
 
@@ -894,6 +1007,8 @@ int mmc_init(struct mmc *mmc)
 {
 	int err;
 
+	/* the card may have been changed */
+	fat_cache_invalidate(&mmc->block_dev);
 	err = mmc->init(mmc);
 
 	if (err)
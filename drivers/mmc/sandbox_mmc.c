@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+
+/*
+ * An SD card for the sandbox, backed by an image file given with -m.
+ *
+ * This answers the commands drivers/mmc/mmc.c sends as a high-capacity
+ * SD 2.0 card would, so that card set-up and the block read path
+ * (including the pipelined requests of hosts with MMC_MODE_ASYNC) run
+ * unchanged. Data moves between the image file and memory at once.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <mmc.h>
+#include <os.h>
+#include <asm/state.h>
+
+#define SD_RCA		0x0001
+
+/* R1 card status: ready for data, in the transfer state */
+#define SD_STATUS_READY	0x00000900
+#define SD_STATUS_APP	0x00000020	/* APP_CMD: next command is an ACMD */
+
+struct sandbox_mmc_host {
+	int fd;
+	u64 size;		/* usable size of the image, in bytes */
+	int app_cmd;		/* the last command was APP_CMD */
+	uint block_count;	/* from SET_BLOCK_COUNT, 0 if none */
+};
+
+static struct mmc sandbox_mmc_dev;
+static struct sandbox_mmc_host sandbox_mmc_host;
+
+/* CID: manufacturer 0, OEM "SB", product "SDBOX", rev 1.0, serial 1 */
+static void sandbox_mmc_cid(uint *resp)
+{
+	resp[0] = 0x00534253;		/* MID, 'S' 'B', 'S' */
+	resp[1] = 0x44424f58;		/* 'D' 'B' 'O' 'X' */
+	resp[2] = 0x10000000;
+	resp[3] = 0x01000000;
+}
+
+/* CSD version 2.0: 512-byte blocks, capacity in 512KB units */
+static void sandbox_mmc_csd(struct sandbox_mmc_host *host, uint *resp)
+{
+	uint c_size = (host->size >> 19) - 1;
+
+	resp[0] = 0x400e0032;		/* 25MHz */
+	resp[1] = 0x5b590000 | ((c_size >> 16) & 0x3f);
+	resp[2] = (c_size & 0xffff) << 16 | 0x7f80;
+	resp[3] = 0x0a400000;
+}
+
+/* SCR: SD 3.0, 1 and 4 bit bus, CMD23 supported (big endian) */
+static void sandbox_mmc_scr(char *buf)
+{
+	static const u8 scr[8] = { 0x02, 0x05, 0x80, 0x02, 0, 0, 0, 0 };
+
+	memcpy(buf, scr, sizeof(scr));
+}
+
+/* SWITCH_FUNC status: high speed supported, selected if asked for */
+static void sandbox_mmc_switch(uint arg, char *buf)
+{
+	memset(buf, '\0', 64);
+	buf[1] = 100;			/* maximum current, mA */
+	buf[13] = 0x03;			/* group 1: default and high speed */
+	buf[16] = arg & 0xf;		/* group 1 function now selected */
+}
+
+static int sandbox_mmc_data(struct sandbox_mmc_host *host,
+			    struct mmc_cmd *cmd, struct mmc_data *data)
+{
+	u64 offset = (u64)cmd->cmdarg * data->blocksize;
+	size_t len = data->blocks * data->blocksize;
+	ssize_t done;
+
+	if (offset + len > host->size)
+		return COMM_ERR;
+	if (data->flags & MMC_DATA_READ)
+		done = os_pread(host->fd, data->dest, len, offset);
+	else
+		done = os_pwrite(host->fd, data->src, len, offset);
+
+	return done == len ? 0 : COMM_ERR;
+}
+
+static int sandbox_mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
+				struct mmc_data *data)
+{
+	struct sandbox_mmc_host *host = mmc->priv;
+	int app_cmd = host->app_cmd;
+	uint *resp = cmd->response;
+
+	host->app_cmd = 0;
+	resp[0] = SD_STATUS_READY;
+
+	if (app_cmd) {
+		switch (cmd->cmdidx) {
+		case SD_CMD_APP_SET_BUS_WIDTH:
+			return 0;
+		case SD_CMD_APP_SEND_OP_COND:
+			resp[0] = OCR_BUSY | OCR_HCS | 0xff8000;
+			return 0;
+		case SD_CMD_APP_SEND_SCR:
+			sandbox_mmc_scr(data->dest);
+			return 0;
+		}
+		return TIMEOUT;
+	}
+
+	switch (cmd->cmdidx) {
+	case MMC_CMD_GO_IDLE_STATE:
+		host->block_count = 0;
+		return 0;
+	case SD_CMD_SEND_IF_COND:
+		resp[0] = cmd->cmdarg & 0xfff;
+		return 0;
+	case MMC_CMD_APP_CMD:
+		host->app_cmd = 1;
+		resp[0] |= SD_STATUS_APP;
+		return 0;
+	case MMC_CMD_ALL_SEND_CID:
+		sandbox_mmc_cid(resp);
+		return 0;
+	case SD_CMD_SEND_RELATIVE_ADDR:
+		resp[0] = SD_RCA << 16;
+		return 0;
+	case MMC_CMD_SEND_CSD:
+		sandbox_mmc_csd(host, resp);
+		return 0;
+	case SD_CMD_SWITCH_FUNC:
+		sandbox_mmc_switch(cmd->cmdarg, data->dest);
+		return 0;
+	case MMC_CMD_SELECT_CARD:
+	case MMC_CMD_SEND_STATUS:
+	case MMC_CMD_SET_BLOCKLEN:
+	case MMC_CMD_STOP_TRANSMISSION:
+		return 0;
+	case MMC_CMD_SET_BLOCK_COUNT:
+		host->block_count = cmd->cmdarg & 0xffff;
+		return 0;
+	case MMC_CMD_READ_SINGLE_BLOCK:
+	case MMC_CMD_READ_MULTIPLE_BLOCK:
+	case MMC_CMD_WRITE_SINGLE_BLOCK:
+	case MMC_CMD_WRITE_MULTIPLE_BLOCK:
+		if (host->block_count && host->block_count != data->blocks)
+			return COMM_ERR;
+		host->block_count = 0;
+		return sandbox_mmc_data(host, cmd, data);
+	}
+
+	/* Anything else, like the MMC-only SEND_OP_COND, gets no answer */
+	return TIMEOUT;
+}
+
+/*
+ * The transfer is over by the time start_data() returns, but going
+ * through these keeps mmc.c on the path a DMA host takes.
+ */
+static int sandbox_mmc_wait_data(struct mmc *mmc, struct mmc_data *data)
+{
+	return 0;
+}
+
+static void sandbox_mmc_finish_data(struct mmc *mmc, struct mmc_data *data)
+{
+}
+
+static void sandbox_mmc_set_ios(struct mmc *mmc)
+{
+}
+
+static int sandbox_mmc_core_init(struct mmc *mmc)
+{
+	struct sandbox_mmc_host *host = mmc->priv;
+
+	host->app_cmd = 0;
+	host->block_count = 0;
+	return 0;
+}
+
+int sandbox_mmc_init(void)
+{
+	struct sandbox_state *state = state_get_current();
+	struct sandbox_mmc_host *host = &sandbox_mmc_host;
+	struct mmc *mmc = &sandbox_mmc_dev;
+	long long size;
+
+	if (!state->mmc_file)
+		return 0;
+
+	host->fd = os_open(state->mmc_file, OS_O_RDWR);
+	if (host->fd < 0)
+		host->fd = os_open(state->mmc_file, OS_O_RDONLY);
+	if (host->fd < 0) {
+		printf("mmc: cannot open '%s'\n", state->mmc_file);
+		return -1;
+	}
+
+	/* The card's capacity comes in 512KB units: round the image down */
+	size = os_lseek(host->fd, 0, OS_SEEK_END);
+	host->size = size & ~((1 << 19) - 1);
+	if (host->size == 0) {
+		printf("mmc: '%s' is smaller than 512KB\n", state->mmc_file);
+		os_close(host->fd);
+		return -1;
+	}
+
+	sprintf(mmc->name, "Sandbox SD");
+	mmc->priv = host;
+	mmc->send_cmd = sandbox_mmc_send_cmd;
+	mmc->start_data = sandbox_mmc_send_cmd;
+	mmc->wait_data = sandbox_mmc_wait_data;
+	mmc->finish_data = sandbox_mmc_finish_data;
+	mmc->set_ios = sandbox_mmc_set_ios;
+	mmc->init = sandbox_mmc_core_init;
+
+	mmc->voltages = MMC_VDD_32_33 | MMC_VDD_33_34;
+	mmc->host_caps = MMC_MODE_4BIT | MMC_MODE_HS | MMC_MODE_CMD23 |
+			MMC_MODE_ASYNC;
+	mmc->f_min = 400000;
+	mmc->f_max = 52000000;
+
+	mmc_register(mmc);
+
+	return 0;
+}
@@ -34,6 +34,18 @@
 
 enum {
 	MAX_HOSTS	= 4,		/* support 4 mmc hosts */
+
+	/* SDMA buffer boundary settings for the block size register */
+	SDMA_BOUNDARY_4K	= 0,
+	SDMA_BOUNDARY_512K	= 7,
+	SDMA_PAGE_SIZE		= 4096,	/* size of a 4K boundary */
+};
+
+/* How the current transfer reaches the caller's buffer */
+enum mmc_xfer_mode {
+	XFER_DIRECT,		/* DMA straight to/from the buffer */
+	XFER_BOUNCE,		/* DMA through the bounce buffer */
+	XFER_SPLIT,		/* only the partial end pages are bounced */
 };
 
 
@@ -48,13 +60,29 @@ struct mmc_host {
 	/*
 	 * We need a per-host bounce buffer that will be optionally used
 	 * when the mmc_send_cmd function is called with an unaligned
-	 * buffer.  The bounce buffer will be allocated in that case and
-	 * a copy to and from it will be used so that DMA destination and
-	 * source pointers can be aligned.
+	 * buffer that we cannot split.  The bounce buffer is allocated in
+	 * that case and a copy to and from it will be used so that DMA
+	 * destination and source pointers can be aligned. It is kept for
+	 * later transfers and only grows, to the size of the largest
+	 * transfer rounded up to a cache line.
 	 */
 	char *          bounce;
 	uint            bounce_size;
 	struct mmc_data bounce_data;
+
+	/*
+	 * Most unaligned reads are split instead: the SDMA stops at each
+	 * 4KB boundary, which lets us send the partial first and last
+	 * pages to these two aligned pages and the rest straight to the
+	 * caller's buffer.
+	 */
+	char *		edge;		/* two SDMA_PAGE_SIZE pages */
+	enum mmc_xfer_mode mode;	/* mode of the current transfer */
+	ulong		head_end;	/* DMA address at end of head page */
+	ulong		mid_start;	/* first in-place address */
+	ulong		tail_start;	/* first address of the tail */
+	uint		head_len;	/* bytes in head page */
+	uint		tail_len;	/* bytes in tail page */
 };
 
 struct mmc mmc_dev[MAX_HOSTS];
@@ -90,7 +118,11 @@ static void mmc_dcache_invalidate(struct mmc_data *data)
  */
 static int mmc_resize_bounce(struct mmc_host *host, struct mmc_data *data)
 {
-	uint	new_bounce_size = data->blocks * data->blocksize;
+	uint	new_bounce_size;
+
+	/* Whole cache lines, so that invalidating it touches nothing else */
+	new_bounce_size = roundup(data->blocks * data->blocksize,
+				  CACHE_LINE_SIZE);
 
 	if (host->bounce)
 	{
@@ -149,40 +181,124 @@ static void mmc_restore_bounce_data(struct mmc_host *host,
 	       data->blocks * data->blocksize);
 }
 
-static int mmc_prepare_data(struct mmc_host *host, struct mmc_data *data)
+/*
+ * Set up a read into an unaligned buffer so that only the partial pages
+ * at each end go through host->edge. Returns the DMA start address, or 0
+ * if the edge pages cannot be allocated.
+ */
+static ulong mmc_setup_split_data(struct mmc_host *host, struct mmc_data *data)
+{
+	ulong start = (ulong)data->dest;
+	ulong end = start + data->blocks * data->blocksize;
+	ulong offset = start & (SDMA_PAGE_SIZE - 1);
+
+	if (!host->edge) {
+		host->edge = memalign(SDMA_PAGE_SIZE, SDMA_PAGE_SIZE * 2);
+		if (!host->edge)
+			return 0;
+	}
+
+	host->head_len = SDMA_PAGE_SIZE - offset;
+	host->head_end = (ulong)host->edge + SDMA_PAGE_SIZE;
+	host->mid_start = start + host->head_len;
+	host->tail_start = end & ~(SDMA_PAGE_SIZE - 1);
+	host->tail_len = end - host->tail_start;
+
+	return (ulong)host->edge + offset;
+}
+
+/*
+ * Pick the next DMA address when the SDMA stops at a 4KB boundary. For a
+ * split transfer we move from the head page to the caller's buffer, and
+ * from there to the tail page.
+ */
+static ulong mmc_next_dma_address(struct mmc_host *host, ulong address)
+{
+	if (host->mode != XFER_SPLIT)
+		return address;
+	if (address == host->head_end)
+		address = host->mid_start;
+	if (address == host->tail_start)
+		address = (ulong)host->edge + SDMA_PAGE_SIZE;
+	return address;
+}
+
+static void mmc_restore_split_data(struct mmc_host *host,
+				   struct mmc_data *data)
 {
+	char *edge = host->edge;
+
+	invalidate_dcache_range(host->mid_start, host->tail_start);
+	invalidate_dcache_range((ulong)edge, (ulong)edge + SDMA_PAGE_SIZE * 2);
+
+	memcpy(data->dest, edge + SDMA_PAGE_SIZE - host->head_len,
+	       host->head_len);
+	if (host->tail_len)
+		memcpy((char *)host->tail_start, edge + SDMA_PAGE_SIZE,
+		       host->tail_len);
+}
+
+static int mmc_prepare_data(struct mmc *mmc, struct mmc_data *data)
+{
+	struct mmc_host *host = (struct mmc_host *)mmc->priv;
+	size_t bytes = data->blocks * data->blocksize;
+	uint boundary = SDMA_BOUNDARY_512K;
+	ulong addr = (ulong)data->dest;
 	unsigned char ctrl;
 
 	debug("data->dest: %08X, data->blocks: %u, data->blocksize: %u\n",
 	(u32)data->dest, data->blocks, data->blocksize);
 
+	host->mode = XFER_DIRECT;
+
 	/*
-	 * If the mmc_data's buffer is not aligned to a cache line boundary.
-	 * We need to use an aligned bounce buffer because the cache
-	 * invalidation code that would give us visibility into the read data
-	 * after the DMA operation completes will flush the first and last few
-	 * bytes of the unaligned buffer out to memory, overwriting the DMA'ed
-	 * data.
+	 * If the mmc_data's buffer is not aligned to a cache line boundary
+	 * the cache invalidation code that would give us visibility into
+	 * the read data after the DMA operation completes will flush the
+	 * first and last few bytes of the unaligned buffer out to memory,
+	 * overwriting the DMA'ed data.
+	 *
+	 * Writes only need a flush, which is safe on a partial line, so
+	 * they can always go in place. Reads of at least two pages are
+	 * split, and anything else uses an aligned bounce buffer. SDMA
+	 * needs word-aligned addresses in all cases.
 	 */
-	if (((uint)data->dest) & (CACHE_LINE_SIZE - 1))
-	{
-		printf("%s: Unaligned data, using slower bounce buffer\n",
-		       __func__);
+	if ((addr & (CACHE_LINE_SIZE - 1)) &&
+	    ((addr & 3) || !(data->flags & MMC_DATA_WRITE))) {
+		if (!(addr & 3) && bytes >= SDMA_PAGE_SIZE * 2)
+			addr = mmc_setup_split_data(host, data);
+		else
+			addr = 0;
 
-		if (mmc_setup_bounce_data(host, data) < 0)
-			return -1;
+		if (addr) {
+			host->mode = XFER_SPLIT;
+			boundary = SDMA_BOUNDARY_4K;
+			mmc->bounce_bytes += host->head_len + host->tail_len;
+			mmc->dma_bytes += host->tail_start - host->mid_start;
+		} else {
+			printf("%s: Unaligned data, using slower bounce "
+			       "buffer\n", __func__);
 
-		data = &host->bounce_data;
+			if (mmc_setup_bounce_data(host, data) < 0)
+				return -1;
+
+			host->mode = XFER_BOUNCE;
+			data = &host->bounce_data;
+			addr = (ulong)data->dest;
+			mmc->bounce_bytes += bytes;
+		}
+	} else {
+		mmc->dma_bytes += bytes;
 	}
 
 	if (data->flags & MMC_DATA_WRITE)
 		mmc_dcache_flush(data);
 
 	/*
-	 * At this point the buffer referenced by data is guaranteed to be
-	 * cache line size aligned.
+	 * At this point addr is word aligned, and either cache line aligned
+	 * or only written by the DMA within whole cache lines.
 	 */
-	writel((u32)data->dest, &host->reg->sysad);
+	writel(addr, &host->reg->sysad);
 
 	/*
 	 * DMASEL[4:3]
@@ -195,8 +311,12 @@ static int mmc_prepare_data(struct mmc_host *host, struct mmc_data *data)
 	ctrl &= ~(3 << 3);			/* SDMA */
 	writeb(ctrl, &host->reg->hostctl);
 
-	/* We do not handle DMA boundaries, so set it to max (512 KiB) */
-	writew((7 << 12) | (data->blocksize & 0xFFF), &host->reg->blksize);
+	/*
+	 * Split transfers need to stop at each 4KB boundary. Otherwise we
+	 * do not handle DMA boundaries, so set it to max (512 KiB)
+	 */
+	writew((boundary << 12) | (data->blocksize & 0xFFF),
+	       &host->reg->blksize);
 	writew(data->blocks, &host->reg->blkcnt);
 
 	return 0;
@@ -207,13 +327,15 @@ static void mmc_restore_data(struct mmc_host *host, struct mmc_data *data)
 	/*
 	 * If we performed a read then we need to invalidate the dcache lines
 	 * that cover the DMA buffer.  This might also require copying data
-	 * back from the bounce buffer if the original mmc_data's buffer is
-	 * unaligned.
+	 * back from the bounce buffer or edge pages if the original
+	 * mmc_data's buffer is unaligned.
 	 */
 	if (data->flags & MMC_DATA_READ)
 	{
-		if (((uint)data->dest) & (CACHE_LINE_SIZE - 1))
+		if (host->mode == XFER_BOUNCE)
 			mmc_restore_bounce_data(host, data);
+		else if (host->mode == XFER_SPLIT)
+			mmc_restore_split_data(host, data);
 		else
 			mmc_dcache_invalidate(data);
 	}
@@ -275,7 +397,11 @@ static int mmc_wait_inhibit(struct mmc_host *host,
 	return 0;
 }
 
-static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
+/*
+ * Send a command and wait for its response. If there is data, the DMA is
+ * left running and mmc_wait_data() must be called to wait for it.
+ */
+static int mmc_start_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			struct mmc_data *data)
 {
 	struct mmc_host *host = (struct mmc_host *)mmc->priv;
@@ -283,13 +409,13 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 	int result;
 	unsigned int mask;
 	unsigned int retry = 0x100000;
-	debug(" mmc_send_cmd called\n");
+	debug(" mmc_start_cmd called\n");
 
 	if ((result = mmc_wait_inhibit(host, cmd, data, 10 /* ms */)) < 0)
 		return result;
 
 	if (data)
-		if ((result = mmc_prepare_data(host, data)) < 0)
+		if ((result = mmc_prepare_data(mmc, data)) < 0)
 			return result;
 
 	debug("cmd->arg: %08x\n", cmd->cmdarg);
@@ -396,53 +522,90 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 		}
 	}
 
-	if (data) {
-		unsigned long	start = get_timer(0);
+	return 0;
+}
 
-		while (1) {
-			mask = readl(&host->reg->norintsts);
+/* Wait for the data transfer started by mmc_start_cmd() to complete */
+static int mmc_wait_data(struct mmc *mmc, struct mmc_data *data)
+{
+	struct mmc_host *host = (struct mmc_host *)mmc->priv;
+	unsigned long start = get_timer(0);
+	unsigned int mask;
 
-			if (mask & (1 << 15)) {
-				/* Error Interrupt */
-				writel(mask, &host->reg->norintsts);
-				printf("%s: error during transfer: 0x%08x\n",
-						__func__, mask);
-				return -1;
-			} else if (mask & (1 << 3)) {
-				/*
-				 * DMA Interrupt, restart the transfer where
-				 * it was interrupted.
-				 */
-				unsigned int address = readl(&host->reg->sysad);
-
-				debug("DMA end\n");
-				writel((1 << 3), &host->reg->norintsts);
-				writel(address, &host->reg->sysad);
-			} else if (mask & (1 << 1)) {
-				/* Transfer Complete */
-				debug("r/w is done\n");
-				break;
-			} else if (get_timer(start) > 2000UL) {
-				writel(mask, &host->reg->norintsts);
-				printf("%s: MMC Timeout\n"
-				       "    Interrupt status        0x%08x\n"
-				       "    Interrupt status enable 0x%08x\n"
-				       "    Interrupt signal enable 0x%08x\n"
-				       "    Present status          0x%08x\n",
-				       __func__, mask,
-				       readl(&host->reg->norintstsen),
-				       readl(&host->reg->norintsigen),
-				       readl(&host->reg->prnsts));
-				return -1;
-			}
+	while (1) {
+		mask = readl(&host->reg->norintsts);
+
+		if (mask & (1 << 15)) {
+			/* Error Interrupt */
+			writel(mask, &host->reg->norintsts);
+			printf("%s: error during transfer: 0x%08x\n",
+					__func__, mask);
+			return -1;
+		} else if (mask & (1 << 3)) {
+			/*
+			 * DMA Interrupt, restart the transfer where
+			 * it was interrupted, or at the next part of a
+			 * split transfer.
+			 */
+			unsigned int address = readl(&host->reg->sysad);
+
+			debug("DMA end\n");
+			writel((1 << 3), &host->reg->norintsts);
+			writel(mmc_next_dma_address(host, address),
+			       &host->reg->sysad);
+		} else if (mask & (1 << 1)) {
+			/* Transfer Complete */
+			debug("r/w is done\n");
+			break;
+		} else if (get_timer(start) > 2000UL) {
+			writel(mask, &host->reg->norintsts);
+			printf("%s: MMC Timeout\n"
+			       "    Interrupt status        0x%08x\n"
+			       "    Interrupt status enable 0x%08x\n"
+			       "    Interrupt signal enable 0x%08x\n"
+			       "    Present status          0x%08x\n",
+			       __func__, mask,
+			       readl(&host->reg->norintstsen),
+			       readl(&host->reg->norintsigen),
+			       readl(&host->reg->prnsts));
+			return -1;
 		}
-		writel(mask, &host->reg->norintsts);
+	}
+	writel(mask, &host->reg->norintsts);
+
+	return 0;
+}
+
+/*
+ * Make the data from a completed read visible to the CPU. This only touches
+ * the cache and the bounce buffer, so it can run while the next transfer is
+ * in progress, provided that transfer does not also use the bounce buffer.
+ */
+static void mmc_finish_data(struct mmc *mmc, struct mmc_data *data)
+{
+	mmc_restore_data((struct mmc_host *)mmc->priv, data);
+}
+
+static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
+			struct mmc_data *data)
+{
+	int result;
+
+	debug(" mmc_send_cmd called\n");
+	result = mmc_start_cmd(mmc, cmd, data);
+	if (result)
+		return result;
+
+	if (data) {
+		result = mmc_wait_data(mmc, data);
+		if (result)
+			return result;
 	}
 
 	udelay(1000);
 
 	if (data)
-		mmc_restore_data(host, data);
+		mmc_finish_data(mmc, data);
 
 	return 0;
 }
@@ -623,11 +786,16 @@ static int init_port(unsigned dev_index, enum periph_id mmc_id,
 	host->mmc_id = mmc_id;
 	host->bounce = NULL;
 	host->bounce_size = 0;
+	host->edge = NULL;
+	host->mode = XFER_DIRECT;
 	host->cd_gpio = cd_gpio;
 	host->wp_gpio = wp_gpio;
 
 	mmc->priv = host;
 	mmc->send_cmd = mmc_send_cmd;
+	mmc->start_data = mmc_start_cmd;
+	mmc->wait_data = mmc_wait_data;
+	mmc->finish_data = mmc_finish_data;
 	mmc->set_ios = mmc_set_ios;
 	mmc->init = mmc_core_init;
 
@@ -636,7 +804,8 @@ static int init_port(unsigned dev_index, enum periph_id mmc_id,
 		mmc->host_caps = MMC_MODE_8BIT;
 	else
 		mmc->host_caps = MMC_MODE_4BIT;
-	mmc->host_caps |= MMC_MODE_HS_52MHz | MMC_MODE_HS;
+	mmc->host_caps |= MMC_MODE_HS_52MHz | MMC_MODE_HS | MMC_MODE_CMD23 |
+			MMC_MODE_ASYNC;
 
 	/*
 	 * min freq is for card identification, and is the highest
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+
+/*
+ * Ethernet for the sandbox, over a Linux tap interface named with -t.
+ * Each read() of the tap returns one whole frame, and each write() sends
+ * one, so there are no descriptors to manage.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <net.h>
+#include <os.h>
+#include <asm/state.h>
+
+struct sandbox_eth {
+	int fd;
+	const char *ifname;
+};
+
+static int sandbox_eth_init(struct eth_device *dev, bd_t *bis)
+{
+	struct sandbox_eth *priv = dev->priv;
+	unsigned char mac[6];
+
+	if (priv->fd >= 0)
+		return 0;
+	priv->fd = os_tap_open(priv->ifname, mac);
+	if (priv->fd < 0) {
+		printf("%s: cannot open tap interface %s\n", dev->name,
+		       priv->ifname);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int sandbox_eth_send(struct eth_device *dev, volatile void *packet,
+			    int length)
+{
+	struct sandbox_eth *priv = dev->priv;
+
+	if (os_write(priv->fd, (void *)packet, length) != length) {
+		debug("%s: failed to send %d bytes\n", dev->name, length);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int sandbox_eth_recv(struct eth_device *dev)
+{
+	struct sandbox_eth *priv = dev->priv;
+	uchar *buf;
+	ssize_t len;
+
+	for (;;) {
+		/* Receive straight into place if the net stack knows where */
+		buf = NetRxFrameBuf(0, PKTSIZE_ALIGN, 1);
+		if (buf == NULL)
+			buf = (uchar *)NetRxPackets[0];
+
+		len = os_read(priv->fd, buf, PKTSIZE_ALIGN);
+		if (len > 0)
+			NetReceive(buf, len);
+		NetRxFrameDone();
+		if (len <= 0)
+			break;
+	}
+
+	return 0;
+}
+
+static void sandbox_eth_halt(struct eth_device *dev)
+{
+	/* The tap stays open: closing it would drop the interface's state */
+}
+
+int sandbox_eth_initialize(bd_t *bis)
+{
+	struct sandbox_state *state = state_get_current();
+	struct sandbox_eth *priv;
+	struct eth_device *dev;
+	unsigned char mac[6];
+	int fd;
+
+	if (!state->tap_name)
+		return 0;
+
+	/* Open now, to find the MAC address; the interface must exist */
+	fd = os_tap_open(state->tap_name, mac);
+	if (fd < 0) {
+		printf("sandbox_eth: cannot open tap interface %s\n",
+		       state->tap_name);
+		return -1;
+	}
+
+	dev = calloc(1, sizeof(*dev));
+	priv = calloc(1, sizeof(*priv));
+	if (!dev || !priv) {
+		free(dev);
+		free(priv);
+		os_close(fd);
+		return -1;
+	}
+	priv->fd = fd;
+	priv->ifname = state->tap_name;
+
+	sprintf(dev->name, "tap");
+	memcpy(dev->enetaddr, mac, sizeof(mac));
+	dev->init = sandbox_eth_init;
+	dev->send = sandbox_eth_send;
+	dev->recv = sandbox_eth_recv;
+	dev->halt = sandbox_eth_halt;
+	dev->priv = priv;
+
+	return eth_register(dev);
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+
+/*
+ * The sandbox's console is the process's stdin and stdout, so a terminal
+ * can be used as the serial port, or a test can pipe commands in and read
+ * the output back.
+ */
+
+#include <common.h>
+#include <os.h>
+
+int serial_init(void)
+{
+	return 0;
+}
+
+void serial_setbrg(void)
+{
+}
+
+void serial_putc(const char ch)
+{
+	os_write(1, &ch, 1);
+}
+
+void serial_puts(const char *str)
+{
+	os_write(1, str, strlen(str));
+}
+
+/*
+ * Input is read a character ahead, so that tstc() can tell the end of a
+ * file or pipe from a character: ctrlc() polls tstc() while commands run,
+ * and must not see the end of input as a key press.
+ */
+static int next_char = -1;
+static int input_ended;
+
+static int read_ahead(void)
+{
+	unsigned char ch;
+
+	if (next_char < 0 && !input_ended && os_poll(0)) {
+		if (os_read(0, &ch, 1) == 1)
+			next_char = ch;
+		else
+			input_ended = 1;
+	}
+	return next_char >= 0;
+}
+
+int serial_getc(void)
+{
+	unsigned char ch;
+
+	if (read_ahead()) {
+		ch = next_char;
+		next_char = -1;
+		return ch;
+	}
+
+	/* When input comes from a file or pipe, its end is ours too */
+	if (input_ended || os_read(0, &ch, 1) != 1)
+		os_exit(0);
+	return ch;
+}
+
+int serial_tstc(void)
+{
+	return read_ahead();
+}
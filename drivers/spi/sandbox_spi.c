@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+
+/*
+ * A SPI bus for the sandbox, with a Winbond W25Q serial flash on chip
+ * select 0 of bus 0, backed by an image file given with -s.
+ *
+ * The flash answers the same commands a real one does, one byte at a
+ * time, so that the spi_flash code and its Winbond driver run unchanged.
+ * Data phases move between the image and memory in one go.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <spi.h>
+#include <os.h>
+#include <asm/state.h>
+
+#define CMD_WRSR		0x01
+#define CMD_PP			0x02
+#define CMD_READ		0x03
+#define CMD_WRDI		0x04
+#define CMD_RDSR		0x05
+#define CMD_WREN		0x06
+#define CMD_FAST_READ		0x0b
+#define CMD_SE			0x20	/* 4KB sector erase */
+#define CMD_READ_ID		0x9f
+#define CMD_CE			0xc7
+#define CMD_BE			0xd8	/* 64KB block erase */
+
+#define STATUS_WEL		0x02	/* write enable latch */
+
+#define SF_PAGE_SIZE		256U
+
+/* Where in a command the flash is */
+enum sandbox_sf_state {
+	SF_CMD,			/* waiting for the command byte */
+	SF_ADDR,		/* taking in the address */
+	SF_DUMMY,		/* the dummy byte of a fast read */
+	SF_READ,		/* sending data */
+	SF_WRITE,		/* taking in data to program */
+	SF_RESP,		/* sending a register or the ID */
+	SF_IGNORE,		/* ignoring the rest */
+};
+
+struct sandbox_spi_flash {
+	int fd;
+	u32 size;		/* of the part; the image may be smaller */
+	u32 file_size;
+	u8 id[3];
+	u8 status;
+
+	enum sandbox_sf_state state;
+	u8 cmd;
+	u32 addr;
+	int addr_bytes;		/* still to come */
+	u8 resp[3];
+	int resp_len;
+	int resp_pos;
+};
+
+/* W25Q16 to W25Q128: the smallest one the image fits in is used */
+static const struct {
+	u16 id;
+	u32 size;
+} sandbox_sf_parts[] = {
+	{ 0x4015, 2 << 20 },
+	{ 0x4016, 4 << 20 },
+	{ 0x4017, 8 << 20 },
+	{ 0x4018, 16 << 20 },
+};
+
+static struct sandbox_spi_flash sandbox_sf;
+
+static int sandbox_sf_open(struct sandbox_spi_flash *sf, const char *file)
+{
+	long long size;
+	int i;
+
+	sf->fd = os_open(file, OS_O_RDWR);
+	if (sf->fd < 0)
+		sf->fd = os_open(file, OS_O_RDONLY);
+	if (sf->fd < 0) {
+		printf("spi: cannot open '%s'\n", file);
+		return -1;
+	}
+	size = os_lseek(sf->fd, 0, OS_SEEK_END);
+
+	for (i = 0; i < ARRAY_SIZE(sandbox_sf_parts); i++) {
+		if (size <= sandbox_sf_parts[i].size)
+			break;
+	}
+	if (i == ARRAY_SIZE(sandbox_sf_parts)) {
+		printf("spi: '%s' is larger than any flash part\n", file);
+		os_close(sf->fd);
+		return -1;
+	}
+
+	sf->file_size = size;
+	sf->size = sandbox_sf_parts[i].size;
+	sf->id[0] = 0xef;
+	sf->id[1] = sandbox_sf_parts[i].id >> 8;
+	sf->id[2] = sandbox_sf_parts[i].id & 0xff;
+	return 0;
+}
+
+/* Read flash contents: past the end of the image, it is erased */
+static void sandbox_sf_read(struct sandbox_spi_flash *sf, u8 *buf, u32 len)
+{
+	u32 addr = sf->addr;
+	ssize_t done = 0;
+
+	if (addr < sf->file_size) {
+		done = os_pread(sf->fd, buf, min(len, sf->file_size - addr),
+				addr);
+		if (done < 0)
+			done = 0;
+	}
+	memset(buf + done, 0xff, len - done);
+	sf->addr += len;
+}
+
+/* Programming can only clear bits, and wraps within the page */
+static void sandbox_sf_program(struct sandbox_spi_flash *sf, const u8 *buf,
+			       u32 len)
+{
+	u8 page[SF_PAGE_SIZE];
+	u32 start = sf->addr & ~(SF_PAGE_SIZE - 1);
+	u32 offset = sf->addr & (SF_PAGE_SIZE - 1);
+	u32 i;
+
+	sf->addr = start;
+	sandbox_sf_read(sf, page, SF_PAGE_SIZE);
+	for (i = 0; i < len; i++)
+		page[(offset + i) % SF_PAGE_SIZE] &= buf[i];
+	if (start < sf->file_size)
+		os_pwrite(sf->fd, page, min(SF_PAGE_SIZE, sf->file_size - start),
+			  start);
+}
+
+static void sandbox_sf_erase(struct sandbox_spi_flash *sf, u32 addr, u32 len)
+{
+	u8 buf[4096];
+	u32 n;
+
+	memset(buf, 0xff, sizeof(buf));
+	addr &= ~(len - 1);
+	for (; len && addr < sf->file_size; addr += n, len -= n) {
+		n = min(min(len, (u32)sizeof(buf)), sf->file_size - addr);
+		os_pwrite(sf->fd, buf, n, addr);
+	}
+}
+
+static void sandbox_sf_start_cmd(struct sandbox_spi_flash *sf, u8 cmd)
+{
+	sf->cmd = cmd;
+	sf->state = SF_IGNORE;
+	switch (cmd) {
+	case CMD_READ_ID:
+		memcpy(sf->resp, sf->id, sizeof(sf->id));
+		sf->resp_len = sizeof(sf->id);
+		sf->resp_pos = 0;
+		sf->state = SF_RESP;
+		break;
+	case CMD_RDSR:
+		sf->state = SF_RESP;
+		break;
+	case CMD_WREN:
+		sf->status |= STATUS_WEL;
+		break;
+	case CMD_WRDI:
+		sf->status &= ~STATUS_WEL;
+		break;
+	case CMD_READ:
+	case CMD_FAST_READ:
+		sf->state = SF_ADDR;
+		break;
+	case CMD_PP:
+	case CMD_SE:
+	case CMD_BE:
+		if (sf->status & STATUS_WEL)
+			sf->state = SF_ADDR;
+		break;
+	case CMD_CE:
+		if (sf->status & STATUS_WEL)
+			sandbox_sf_erase(sf, 0, sf->size);
+		sf->status &= ~STATUS_WEL;
+		break;
+	}
+	sf->addr = 0;
+	sf->addr_bytes = 3;
+}
+
+/* Run one transfer's worth of bytes through the flash */
+static void sandbox_sf_xfer(struct sandbox_spi_flash *sf, const u8 *dout,
+			    u8 *din, u32 len)
+{
+	u32 pos = 0;
+	u8 out, in;
+
+	while (pos < len) {
+		/* Data phases are done a run at a time */
+		if (sf->state == SF_READ) {
+			if (din)
+				sandbox_sf_read(sf, din + pos, len - pos);
+			return;
+		}
+		if (sf->state == SF_WRITE) {
+			if (dout)
+				sandbox_sf_program(sf, dout + pos, len - pos);
+			sf->state = SF_IGNORE;
+			return;
+		}
+
+		out = dout ? dout[pos] : 0;
+		in = 0xff;
+		switch (sf->state) {
+		case SF_CMD:
+			sandbox_sf_start_cmd(sf, out);
+			break;
+		case SF_ADDR:
+			sf->addr = sf->addr << 8 | out;
+			if (--sf->addr_bytes)
+				break;
+			sf->addr %= sf->size;
+			if (sf->cmd == CMD_FAST_READ)
+				sf->state = SF_DUMMY;
+			else if (sf->cmd == CMD_READ)
+				sf->state = SF_READ;
+			else if (sf->cmd == CMD_PP)
+				sf->state = SF_WRITE;
+			else
+				sf->state = SF_IGNORE;
+			break;
+		case SF_DUMMY:
+			sf->state = SF_READ;
+			break;
+		case SF_RESP:
+			/* The status register repeats for as long as it is read */
+			if (sf->cmd == CMD_RDSR)
+				in = sf->status;
+			else if (sf->resp_pos < sf->resp_len)
+				in = sf->resp[sf->resp_pos++];
+			break;
+		default:
+			break;
+		}
+		if (din)
+			din[pos] = in;
+		pos++;
+	}
+}
+
+/* Erases and programming finish when chip select goes away */
+static void sandbox_sf_end(struct sandbox_spi_flash *sf)
+{
+	if (sf->state != SF_CMD && sf->addr_bytes == 0) {
+		if (sf->cmd == CMD_SE)
+			sandbox_sf_erase(sf, sf->addr, 4096);
+		else if (sf->cmd == CMD_BE)
+			sandbox_sf_erase(sf, sf->addr, 65536);
+	}
+	if (sf->cmd == CMD_PP || sf->cmd == CMD_SE || sf->cmd == CMD_BE)
+		sf->status &= ~STATUS_WEL;
+	sf->state = SF_CMD;
+	sf->cmd = 0;
+}
+
+void spi_init(void)
+{
+}
+
+int spi_cs_is_valid(unsigned int bus, unsigned int cs)
+{
+	return bus == 0 && cs == 0;
+}
+
+struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
+		unsigned int max_hz, unsigned int mode)
+{
+	struct sandbox_state *state = state_get_current();
+	struct spi_slave *slave;
+
+	if (!spi_cs_is_valid(bus, cs) || !state->spi_file)
+		return NULL;
+	if (!sandbox_sf.size &&
+	    sandbox_sf_open(&sandbox_sf, state->spi_file))
+		return NULL;
+
+	slave = malloc(sizeof(struct spi_slave));
+	if (!slave)
+		return NULL;
+	slave->bus = bus;
+	slave->cs = cs;
+	return slave;
+}
+
+void spi_free_slave(struct spi_slave *slave)
+{
+	free(slave);
+}
+
+int spi_claim_bus(struct spi_slave *slave)
+{
+	return 0;
+}
+
+void spi_release_bus(struct spi_slave *slave)
+{
+}
+
+void spi_cs_activate(struct spi_slave *slave)
+{
+	sandbox_sf.state = SF_CMD;
+}
+
+void spi_cs_deactivate(struct spi_slave *slave)
+{
+	sandbox_sf_end(&sandbox_sf);
+}
+
+int spi_xfer(struct spi_slave *slave, unsigned int bitlen, const void *dout,
+		void *din, unsigned long flags)
+{
+	if (bitlen % 8)
+		return -1;
+
+	if (flags & SPI_XFER_BEGIN)
+		spi_cs_activate(slave);
+	sandbox_sf_xfer(&sandbox_sf, dout, din, bitlen / 8);
+	if (flags & SPI_XFER_END)
+		spi_cs_deactivate(slave);
+
+	return 0;
+}
@@ -151,19 +151,89 @@ void spi_cs_deactivate(struct spi_slave *slave)
 	writel(val & ~SPI_CMD_CS_VAL, &spi->command);
 }
 
+/* Pack bytes into a FIFO word; the first byte is shifted out first */
+static inline u32 spi_get_word(const u8 *p)
+{
+	return p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static inline void spi_put_word(u8 *p, u32 val)
+{
+	p[0] = val >> 24;
+	p[1] = val >> 16;
+	p[2] = val >> 8;
+	p[3] = val;
+}
+
+/*
+ * Wait for the controller to finish a block transfer.
+ *
+ * @param spi		SPI controller
+ * @param statusp	Returns the final status value
+ * @return 0 if ok, -1 on timeout
+ */
+static int spi_wait_ready(struct spi_tegra *spi, u32 *statusp)
+{
+	u32 status;
+	int tm;
+
+	for (tm = 0; tm < SPI_TIMEOUT; tm++) {
+		status = readl(&spi->status);
+		if ((status & SPI_STAT_RDY) && !(status & SPI_STAT_BSY))
+			break;
+	}
+	*statusp = status;
+
+	return tm == SPI_TIMEOUT ? -1 : 0;
+}
+
+/*
+ * Transfer up to SPI_FIFO_DEPTH 32-bit words as one block. We fill the TX
+ * FIFO, wait once for the whole block and then drain the RX FIFO, instead
+ * of starting and polling the controller for every word.
+ *
+ * The command register must already be set up for 32-bit words.
+ */
+static int spi_xfer_burst(struct spi_tegra *spi, const u8 *dout, u8 *din,
+			  int words)
+{
+	u32 status;
+	int i;
+
+	writel(words - 1, &spi->dma_ctl);
+	for (i = 0; i < words; i++)
+		writel(dout ? spi_get_word(dout + i * 4) : 0, &spi->tx_fifo);
+	writel(SPI_DMA_EN | (words - 1), &spi->dma_ctl);
+
+	if (spi_wait_ready(spi, &status))
+		return -1;
+
+	for (i = 0; i < words; i++) {
+		u32 val = readl(&spi->rx_fifo);
+
+		if (din)
+			spi_put_word(din + i * 4, val);
+	}
+	writel(status, &spi->status);	/* ACK RDY, etc. bits */
+
+	return 0;
+}
+
 int spi_xfer(struct spi_slave *slave, unsigned int bitlen, const void *dout,
 		void *din, unsigned long flags)
 {
 	struct spi_tegra *spi = (struct spi_tegra *)TEGRA2_SPI_BASE;
 	unsigned int status;
 	int num_bytes = (bitlen + 7) / 8;
-	int i, ret, tm, bytes, bits, isRead = 0;
+	int i, ret, tm, bytes, bits, words, isRead = 0;
 	u32 reg, tmpdout, tmpdin = 0;
+	ulong start = get_timer(0);
 
 	debug("spi_xfer: slave %u:%u dout %08X din %08X bitlen %u\n",
 	      slave->bus, slave->cs, *(u8 *)dout, *(u8 *)din, bitlen);
 
 	ret = tm = 0;
+	bootstage_start(BOOTSTAGE_SPI_XFER, "spi_xfer");
 
 	status = readl(&spi->status);
 	writel(status, &spi->status);	/* Clear all SPI events via R/W */
@@ -176,8 +246,30 @@ int spi_xfer(struct spi_slave *slave, unsigned int bitlen, const void *dout,
 	if (flags & SPI_XFER_BEGIN)
 		spi_cs_activate(slave);
 
-	/* handle data in 32-bit chunks */
-	while (num_bytes > 0) {
+	/*
+	 * Handle whole words a FIFO at a time, as long as the transfer is a
+	 * whole number of bytes.
+	 */
+	if (bitlen % 8 == 0 && num_bytes >= 4) {
+		reg = readl(&spi->command);
+		reg &= ~SPI_CMD_BIT_LENGTH_MASK;
+		writel(reg | 31, &spi->command);
+	}
+	while (bitlen % 8 == 0 && num_bytes >= 4 && !ret) {
+		words = min(num_bytes / 4, SPI_FIFO_DEPTH);
+		ret = spi_xfer_burst(spi, dout, din, words);
+
+		num_bytes -= words * 4;
+		bitlen -= words * 32;
+		if (dout)
+			dout += words * 4;
+		if (din)
+			din += words * 4;
+	}
+	writel(0, &spi->dma_ctl);
+
+	/* handle any remaining data in 32-bit chunks */
+	while (num_bytes > 0 && !ret) {
 		tmpdout = 0;
 		bytes = (num_bytes >  4) ?  4 : num_bytes;
 		bits  = (bitlen   > 32) ? 32 : bitlen;
@@ -270,7 +362,9 @@ int spi_xfer(struct spi_slave *slave, unsigned int bitlen, const void *dout,
 	 tmpdin, status);
 
 	if (ret == -1)
-		printf("spi_xfer: timeout during SPI transfer, tm = %d\n", tm);
+		printf("spi_xfer: timeout during SPI transfer after %lu ms\n",
+		       get_timer(start));
 
+	bootstage_accum(BOOTSTAGE_SPI_XFER);
 	return ret;
 }
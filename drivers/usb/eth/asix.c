@@ -96,6 +96,12 @@
 #define USB_BULK_RECV_TIMEOUT 5000
 
 #define AX_RX_URB_SIZE 2048
+/* Receive buffers the host controller would bounce are no use in place */
+#ifdef CONFIG_USB_EHCI_DATA_ALIGN
+#define AX_RX_ALIGN CONFIG_USB_EHCI_DATA_ALIGN
+#else
+#define AX_RX_ALIGN 1
+#endif
 #define PHY_CONNECT_TIMEOUT 5000
 
 /* local vars */
@@ -462,7 +468,9 @@ static int asix_send(struct eth_device *eth, volatile void *packet, int length)
 static int asix_recv(struct eth_device *eth)
 {
 	struct ueth_data *dev = (struct ueth_data *)eth->priv;
-	static unsigned char  recv_buf[AX_RX_URB_SIZE];
+	static unsigned char  recv_buf[AX_RX_URB_SIZE]
+		__attribute__((aligned(AX_RX_ALIGN)));
+	unsigned char *buf;
 	unsigned char *buf_ptr;
 	int err;
 	int actual_len;
@@ -470,9 +478,14 @@ static int asix_recv(struct eth_device *eth)
 
 	debug("** %s()\n", __func__);
 
+	/* Receive straight into place if the net stack knows where */
+	buf = NetRxFrameBuf(sizeof(packet_len), AX_RX_URB_SIZE, AX_RX_ALIGN);
+	if (buf == NULL)
+		buf = recv_buf;
+
 	err = usb_bulk_msg(dev->pusb_dev,
 				usb_rcvbulkpipe(dev->pusb_dev, dev->ep_in),
-				(void *)recv_buf,
+				(void *)buf,
 				AX_RX_URB_SIZE,
 				&actual_len,
 				USB_BULK_RECV_TIMEOUT);
@@ -480,14 +493,16 @@ static int asix_recv(struct eth_device *eth)
 		actual_len, err);
 	if (err != 0) {
 		debug("Rx: failed to receive\n");
+		NetRxFrameDone();
 		return -1;
 	}
 	if (actual_len > AX_RX_URB_SIZE) {
 		debug("Rx: received too many bytes %d\n", actual_len);
+		NetRxFrameDone();
 		return -1;
 	}
 
-	buf_ptr = recv_buf;
+	buf_ptr = buf;
 	while (actual_len > 0) {
 		/*
 		 * 1st 4 bytes contain the length of the actual data as two
@@ -495,7 +510,8 @@ static int asix_recv(struct eth_device *eth)
 		 */
 		if (actual_len < sizeof(packet_len)) {
 			debug("Rx: incomplete packet length\n");
-			return -1;
+			err = -1;
+			break;
 		}
 		memcpy(&packet_len, buf_ptr, sizeof(packet_len));
 		le32_to_cpus(&packet_len);
@@ -503,12 +519,14 @@ static int asix_recv(struct eth_device *eth)
 			debug("Rx: malformed packet length: %#x (%#x:%#x)\n",
 			      packet_len, (packet_len >> 16) ^ 0xffff,
 			      packet_len & 0xffff);
-			return -1;
+			err = -1;
+			break;
 		}
 		packet_len = packet_len & 0xffff;
 		if (packet_len > actual_len - sizeof(packet_len)) {
 			debug("Rx: too large packet: %d\n", packet_len);
-			return -1;
+			err = -1;
+			break;
 		}
 
 		/* Notify net stack */
@@ -520,6 +538,7 @@ static int asix_recv(struct eth_device *eth)
 		actual_len -= sizeof(packet_len) + packet_len;
 		buf_ptr += sizeof(packet_len) + packet_len;
 	}
+	NetRxFrameDone();
 
 	return err;
 }
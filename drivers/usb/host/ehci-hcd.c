@@ -36,6 +36,14 @@ volatile struct ehci_hcor *hcor;
 static uint16_t portreset;
 static struct QH qh_list __attribute__((aligned(32)));
 
+/*
+ * QHs and qTDs handed out by ehci_alloc(). Every transfer runs to
+ * completion before the next one is set up, so they are simply reused.
+ */
+static struct QH qh_pool[EHCI_MAX_QHS] __attribute__((aligned(32)));
+static struct qTD td_pool[EHCI_MAX_QTDS] __attribute__((aligned(32)));
+static int nqhs, ntds;
+
 static struct descriptor {
 	struct usb_hub_descriptor hub;
 	struct usb_device_descriptor device;
@@ -188,6 +196,23 @@ static inline void ehci_invalidate_dcache(struct QH *qh)
 {
 	cache_qh(qh, 0);
 }
+
+/*
+ * A bulk queue links several QHs, which cache_qh() does not follow, so
+ * it handles the whole allocation pools instead.
+ */
+static void ehci_cache_pools(int flush)
+{
+	flush_invalidate((u32)&qh_list, sizeof(qh_list), flush);
+	flush_invalidate((u32)qh_pool, nqhs * sizeof(struct QH), flush);
+	flush_invalidate((u32)td_pool, ntds * sizeof(struct qTD), flush);
+}
+
+static inline void ehci_cache_buffer(void *buf, int len, int flush)
+{
+	if (len)
+		flush_invalidate((u32)buf, len, flush);
+}
 #else /* CONFIG_EHCI_DCACHE */
 /*
  *
@@ -199,6 +224,14 @@ static inline void ehci_flush_dcache(struct QH *qh)
 static inline void ehci_invalidate_dcache(struct QH *qh)
 {
 }
+
+static inline void ehci_cache_pools(int flush)
+{
+}
+
+static inline void ehci_cache_buffer(void *buf, int len, int flush)
+{
+}
 #endif /* CONFIG_EHCI_DCACHE */
 
 static int handshake(uint32_t *ptr, uint32_t mask, uint32_t done, int usec)
@@ -258,24 +291,32 @@ out:
 	return ret;
 }
 
+/* Start a new transfer, handing the whole QH and qTD pools back */
+static void ehci_alloc_reset(void)
+{
+	nqhs = 0;
+	ntds = 0;
+}
+
 static void *ehci_alloc(size_t sz, size_t align)
 {
-	static struct QH qh __attribute__((aligned(32)));
-	static struct qTD td[3] __attribute__((aligned (32)));
-	static int ntds;
 	void *p;
 
 	switch (sz) {
 	case sizeof(struct QH):
-		p = &qh;
-		ntds = 0;
+		if (nqhs == EHCI_MAX_QHS) {
+			debug("out of QHs\n");
+			return NULL;
+		}
+		p = &qh_pool[nqhs];
+		nqhs++;
 		break;
 	case sizeof(struct qTD):
-		if (ntds == 3) {
+		if (ntds == EHCI_MAX_QTDS) {
 			debug("out of TDs\n");
 			return NULL;
 		}
-		p = &td[ntds];
+		p = &td_pool[ntds];
 		ntds++;
 		break;
 	default:
@@ -314,20 +355,169 @@ static int ehci_td_buffer(struct qTD *td, void *buf, size_t sz)
 	return 0;
 }
 
+/*
+ * Fill in the endpoint characteristics of a QH for pipe. With dtc set
+ * each qTD carries its own data toggle, otherwise the controller keeps
+ * the toggle in the QH overlay.
+ */
+static void ehci_init_qh(struct QH *qh, struct usb_device *dev,
+			 unsigned long pipe, int dtc)
+{
+	uint32_t c, endpt;
+
+	c = (usb_pipespeed(pipe) != USB_SPEED_HIGH &&
+	     usb_pipeendpoint(pipe) == 0) ? 1 : 0;
+	endpt = (8 << 28) |
+	    (c << 27) |
+	    (usb_maxpacket(dev, pipe) << 16) |
+	    (0 << 15) |
+	    (dtc << 14) |
+	    (usb_pipespeed(pipe) << 12) |
+	    (usb_pipeendpoint(pipe) << 8) |
+	    (0 << 7) | (usb_pipedevice(pipe) << 0);
+	qh->qh_endpt1 = cpu_to_hc32(endpt);
+	endpt = (1 << 30) |
+	    (dev->portnr << 23) |
+	    (dev->parent->devnum << 16) | (0 << 8) | (0 << 0);
+	qh->qh_endpt2 = cpu_to_hc32(endpt);
+	qh->qh_overlay.qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
+}
+
+/*
+ * Chain as many qTDs as a data stage needs at *tdp, leaving *tdp at the
+ * next pointer of the last one. Each qTD maps at most five pages, and
+ * all but the last must end on a packet boundary so that the device
+ * never sees a short packet before the end of the transfer.
+ *
+ * Returns the number of qTDs used, or -1 on error.
+ */
+static int ehci_queue_data(struct usb_device *dev, unsigned long pipe,
+			   void *buffer, int length, uint32_t *toggle,
+			   int ioc, uint32_t **tdp)
+{
+	uint8_t *buf_ptr = buffer;
+	int left = length;
+	int maxpacket = max(usb_maxpacket(dev, pipe), 1);
+	struct qTD *td;
+	uint32_t token;
+	int xfr, ntd = 0;
+
+	do {
+		xfr = (5 * 4096 - ((uint32_t)buf_ptr & 4095)) & ~4095;
+		if (xfr >= left)
+			xfr = left;
+		else
+			xfr -= xfr % maxpacket;
+
+		td = ehci_alloc(sizeof(struct qTD), 32);
+		if (td == NULL) {
+			debug("unable to allocate DATA td\n");
+			return -1;
+		}
+		td->qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
+		td->qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
+		token = (*toggle << 31) |
+		    (xfr << 16) |
+		    ((ioc && xfr == left ? 1 : 0) << 15) |
+		    (0 << 12) |
+		    (3 << 10) |
+		    ((usb_pipein(pipe) ? 1 : 0) << 8) | (0x80 << 0);
+		td->qt_token = cpu_to_hc32(token);
+		td->qt_length = xfr;
+		if (ehci_td_buffer(td, buf_ptr, xfr) != 0) {
+			debug("unable construct DATA td\n");
+			ehci_free(td, sizeof(*td));
+			return -1;
+		}
+		**tdp = cpu_to_hc32((uint32_t) td);
+		*tdp = &td->qt_next;
+		ntd++;
+
+		/* the next qTD starts with the toggle this one ends on */
+		if ((xfr / maxpacket) & 1)
+			*toggle ^= 1;
+		buf_ptr += xfr;
+		left -= xfr;
+	} while (left > 0);
+
+	return ntd;
+}
+
+/* Return 1 if one of the ntd qTDs at td has retired with a short packet */
+static int ehci_td_short(struct qTD *td, int ntd)
+{
+	uint32_t token;
+	int i;
+
+	for (i = 0; i < ntd; i++) {
+		token = hc32_to_cpu(td[i].qt_token);
+		if (token & 0x80)
+			break;
+		if ((token >> 16) & 0x7fff)
+			return 1;
+	}
+	return 0;
+}
+
+/* Translate the status bits of a retired qTD into USB_ST_* flags */
+static unsigned long ehci_token_status(uint32_t token)
+{
+	unsigned long status;
+
+	switch (token & 0xfc) {
+	case 0:
+		status = 0;
+		break;
+	case 0x40:
+		status = USB_ST_STALLED;
+		break;
+	case 0xa0:
+	case 0x20:
+		status = USB_ST_BUF_ERR;
+		break;
+	case 0x50:
+	case 0x10:
+		status = USB_ST_BABBLE_DET;
+		break;
+	default:
+		status = USB_ST_CRC_ERR;
+		if ((token & 0x40) == 0x40)
+			status |= USB_ST_STALLED;
+		break;
+	}
+	return status;
+}
+
+/* Turn the async schedule on or off and wait until the HC follows */
+static int ehci_async_schedule(int enable)
+{
+	uint32_t cmd;
+
+	cmd = ehci_readl(&hcor->or_usbcmd);
+	if (enable)
+		cmd |= CMD_ASE;
+	else
+		cmd &= ~CMD_ASE;
+	ehci_writel(&hcor->or_usbcmd, cmd);
+
+	return handshake((uint32_t *)&hcor->or_usbsts, STD_ASS,
+			 enable ? STD_ASS : 0, 100 * 1000);
+}
+
 static int
 ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		   int length, struct devrequest *req)
 {
 	struct QH *qh;
-	struct qTD *td;
+	struct qTD *td, *data_td = NULL, *end_td = NULL;
 	volatile struct qTD *vtd;
 	unsigned long ts;
 	uint32_t *tdp;
-	uint32_t endpt, token, usbsts;
-	uint32_t c, toggle;
-	uint32_t cmd;
-	int timeout;
+	uint32_t token, usbsts;
+	uint32_t toggle, halted = 0, short_pkt = 0;
+	int timeout, ndata = 0;
 	int ret = 0;
+	int i;
 
 #ifdef CONFIG_USB_EHCI_DATA_ALIGN
 	/* In case ehci host requires alignment for buffers */
@@ -359,28 +549,14 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		      le16_to_cpu(req->value), le16_to_cpu(req->value),
 		      le16_to_cpu(req->index));
 
+	ehci_alloc_reset();
 	qh = ehci_alloc(sizeof(struct QH), 32);
 	if (qh == NULL) {
 		debug("unable to allocate QH\n");
 		return -1;
 	}
 	qh->qh_link = cpu_to_hc32((uint32_t)&qh_list | QH_LINK_TYPE_QH);
-	c = (usb_pipespeed(pipe) != USB_SPEED_HIGH &&
-	     usb_pipeendpoint(pipe) == 0) ? 1 : 0;
-	endpt = (8 << 28) |
-	    (c << 27) |
-	    (usb_maxpacket(dev, pipe) << 16) |
-	    (0 << 15) |
-	    (1 << 14) |
-	    (usb_pipespeed(pipe) << 12) |
-	    (usb_pipeendpoint(pipe) << 8) |
-	    (0 << 7) | (usb_pipedevice(pipe) << 0);
-	qh->qh_endpt1 = cpu_to_hc32(endpt);
-	endpt = (1 << 30) |
-	    (dev->portnr << 23) |
-	    (dev->parent->devnum << 16) | (0 << 8) | (0 << 0);
-	qh->qh_endpt2 = cpu_to_hc32(endpt);
-	qh->qh_overlay.qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
+	ehci_init_qh(qh, dev, pipe, 1);
 
 	td = NULL;
 	tdp = &qh->qh_overlay.qt_next;
@@ -411,27 +587,12 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 	}
 
 	if (length > 0 || req == NULL) {
-		td = ehci_alloc(sizeof(struct qTD), 32);
-		if (td == NULL) {
-			debug("unable to allocate DATA td\n");
+		data_td = &td_pool[ntds];
+		ndata = ehci_queue_data(dev, pipe, buffer, length, &toggle,
+					req == NULL, &tdp);
+		if (ndata < 0)
 			goto fail;
-		}
-		td->qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
-		td->qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
-		token = (toggle << 31) |
-		    (length << 16) |
-		    ((req == NULL ? 1 : 0) << 15) |
-		    (0 << 12) |
-		    (3 << 10) |
-		    ((usb_pipein(pipe) ? 1 : 0) << 8) | (0x80 << 0);
-		td->qt_token = cpu_to_hc32(token);
-		if (ehci_td_buffer(td, buffer, length) != 0) {
-			debug("unable construct DATA td\n");
-			ehci_free(td, sizeof(*td));
-			goto fail;
-		}
-		*tdp = cpu_to_hc32((uint32_t) td);
-		tdp = &td->qt_next;
+		td = &data_td[ndata - 1];
 	}
 
 	if (req != NULL) {
@@ -442,7 +603,7 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		}
 		td->qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
 		td->qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
-		token = (toggle << 31) |
+		token = (1 << 31) |
 		    (0 << 16) |
 		    (1 << 15) |
 		    (0 << 12) |
@@ -453,21 +614,40 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		tdp = &td->qt_next;
 	}
 
+	/*
+	 * A short packet ends an IN data stage early. Send the controller
+	 * on to the status stage, or for a bulk transfer to an inactive qTD
+	 * which stops the queue, rather than to the next data qTD, which
+	 * would wait for data that never comes.
+	 */
+	if (ndata > 1 && usb_pipein(pipe)) {
+		if (req == NULL) {
+			end_td = ehci_alloc(sizeof(struct qTD), 32);
+			if (end_td == NULL) {
+				debug("unable to allocate END td\n");
+				goto fail;
+			}
+			end_td->qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
+			end_td->qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
+		}
+		for (i = 0; i < ndata; i++)
+			data_td[i].qt_altnext =
+				cpu_to_hc32((uint32_t)(end_td ? end_td : td));
+	}
+
 	qh_list.qh_link = cpu_to_hc32((uint32_t) qh | QH_LINK_TYPE_QH);
 
 	/* Flush dcache */
 	ehci_flush_dcache(&qh_list);
+	/* end_td is not on the qt_next chain that the above follows */
+	if (end_td != NULL)
+		ehci_cache_pools(1);
 
 	usbsts = ehci_readl(&hcor->or_usbsts);
 	ehci_writel(&hcor->or_usbsts, (usbsts & 0x3f));
 
 	/* Enable async. schedule. */
-	cmd = ehci_readl(&hcor->or_usbcmd);
-	cmd |= CMD_ASE;
-	ehci_writel(&hcor->or_usbcmd, cmd);
-
-	ret = handshake((uint32_t *)&hcor->or_usbsts, STD_ASS, STD_ASS,
-			100 * 1000);
+	ret = ehci_async_schedule(1);
 	if (ret < 0) {
 		printf("EHCI fail timeout STD_ASS set\n");
 		goto fail;
@@ -483,22 +663,26 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		token = hc32_to_cpu(vtd->qt_token);
 		if (!(token & 0x80))
 			break;
+		/* after a short bulk IN packet the later qTDs stay active */
+		short_pkt = end_td != NULL && ehci_td_short(data_td, ndata);
+		if (short_pkt)
+			break;
+		/* an error halts the queue before it reaches the last qTD */
+		halted = hc32_to_cpu(qh->qh_overlay.qt_token) & 0x40;
+		if (halted)
+			break;
 		WATCHDOG_RESET();
 	} while (get_timer(ts) < timeout);
 
 	/* Disable async schedule. */
-	cmd = ehci_readl(&hcor->or_usbcmd);
-	cmd &= ~CMD_ASE;
-	ehci_writel(&hcor->or_usbcmd, cmd);
+	ret = ehci_async_schedule(0);
 
 	/* Check that the TD processing happened */
-	if (token & 0x80) {
+	if ((token & 0x80) && !halted && !short_pkt) {
 		printf("EHCI timed out on TD - token=%#x\n", token);
 		goto fail;
 	}
 
-	ret = handshake((uint32_t *)&hcor->or_usbsts, STD_ASS, 0,
-			100 * 1000);
 	if (ret < 0) {
 		printf("EHCI fail timeout STD_ASS reset\n");
 		goto fail;
@@ -509,31 +693,25 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 	token = hc32_to_cpu(qh->qh_overlay.qt_token);
 	if (!(token & 0x80)) {
 		debug("TOKEN=%#x\n", token);
-		switch (token & 0xfc) {
-		case 0:
+		dev->status = ehci_token_status(token);
+		if (dev->status == 0) {
 			toggle = token >> 31;
 			usb_settoggle(dev, usb_pipeendpoint(pipe),
 				       usb_pipeout(pipe), toggle);
-			dev->status = 0;
-			break;
-		case 0x40:
-			dev->status = USB_ST_STALLED;
-			break;
-		case 0xa0:
-		case 0x20:
-			dev->status = USB_ST_BUF_ERR;
-			break;
-		case 0x50:
-		case 0x10:
-			dev->status = USB_ST_BABBLE_DET;
-			break;
-		default:
-			dev->status = USB_ST_CRC_ERR;
-			if ((token & 0x40) == 0x40)
-				dev->status |= USB_ST_STALLED;
-			break;
 		}
-		dev->act_len = length - ((token >> 16) & 0x7fff);
+		/*
+		 * Sum what each data qTD moved before the queue stopped.
+		 * ehci_alloc() hands out qTDs in order, so the data stage
+		 * is the ndata entries from data_td.
+		 */
+		dev->act_len = 0;
+		for (i = 0; i < ndata; i++) {
+			token = hc32_to_cpu(data_td[i].qt_token);
+			if (token & 0x80)
+				break;
+			dev->act_len += data_td[i].qt_length -
+				((token >> 16) & 0x7fff);
+		}
 	} else {
 		dev->act_len = 0;
 		debug("dev=%u, usbsts=%#x, p[1]=%#x, p[2]=%#x\n",
@@ -913,6 +1091,205 @@ submit_bulk_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 	return ehci_submit_async(dev, pipe, buffer, length, NULL);
 }
 
+#ifdef CONFIG_USB_BULK_QUEUE
+/*
+ * Work out how far the ntd qTDs of one queued transfer got. Returns 1
+ * once the transfer is over: all its qTDs retired, or one of them came
+ * back short or with an error.
+ */
+static int ehci_bulk_result(struct usb_bulk_xfer *xfer, struct qTD *td,
+			    int ntd)
+{
+	uint32_t token;
+	int i;
+
+	xfer->act_len = 0;
+	for (i = 0; i < ntd; i++) {
+		token = hc32_to_cpu(td[i].qt_token);
+		if (token & 0x80) {
+			xfer->status = USB_ST_NOT_PROC;
+			return 0;
+		}
+		xfer->act_len += td[i].qt_length - ((token >> 16) & 0x7fff);
+		xfer->status = ehci_token_status(token);
+		if (xfer->status || ((token >> 16) & 0x7fff))
+			break;
+	}
+	return 1;
+}
+
+/*
+ * Run up to USB_MAX_BULK_QUEUE bulk transfers in one pass of the async
+ * schedule. Each pipe gets its own QH, so that, for example, a bulk-only
+ * storage command has its CBW queued on the OUT pipe and its data and
+ * CSW queued on the IN pipe, and the controller moves from one phase to
+ * the next without software turnaround in between.
+ *
+ * Returns 0 if every transfer completed, -1 on error (see each status),
+ * or 1 if the queue cannot be run here and the caller should fall back
+ * to one submit_bulk_msg() at a time.
+ */
+int
+submit_bulk_queue(struct usb_device *dev, struct usb_bulk_xfer *xfer,
+		  int count, int timeout)
+{
+	struct QH *qh[EHCI_MAX_QHS];
+	unsigned long qh_pipe[EHCI_MAX_QHS];
+	uint32_t *tdp[EHCI_MAX_QHS];
+	int first[USB_MAX_BULK_QUEUE], ntd[USB_MAX_BULK_QUEUE];
+	int xqh[USB_MAX_BULK_QUEUE];
+	struct qTD *td, *end_td = NULL;
+	uint32_t token, toggle = 0, usbsts;
+	unsigned long pipe, ts;
+	int nqh = 0, done = 0;
+	int i, j, ret;
+
+	if (count < 1 || count > USB_MAX_BULK_QUEUE)
+		return 1;
+
+	ehci_alloc_reset();
+	for (i = 0; i < count; i++) {
+		pipe = xfer[i].pipe;
+		xfer[i].act_len = 0;
+		xfer[i].status = USB_ST_NOT_PROC;
+		if (usb_pipetype(pipe) != PIPE_BULK)
+			return 1;
+#ifdef CONFIG_USB_EHCI_DATA_ALIGN
+		/* bouncing is left to ehci_submit_async() */
+		if ((int)xfer[i].buffer & (CONFIG_USB_EHCI_DATA_ALIGN - 1))
+			return 1;
+#endif
+		for (j = 0; j < nqh; j++)
+			if (qh_pipe[j] == pipe)
+				break;
+		if (j == nqh) {
+			qh[j] = ehci_alloc(sizeof(struct QH), 32);
+			if (qh[j] == NULL)
+				return 1;
+			ehci_init_qh(qh[j], dev, pipe, 0);
+			/* the overlay carries the toggle from qTD to qTD */
+			toggle = usb_gettoggle(dev, usb_pipeendpoint(pipe),
+					       usb_pipeout(pipe));
+			qh[j]->qh_overlay.qt_token = cpu_to_hc32(toggle << 31);
+			qh[j]->qh_overlay.qt_altnext =
+				cpu_to_hc32(QT_NEXT_TERMINATE);
+			qh_pipe[j] = pipe;
+			tdp[j] = &qh[j]->qh_overlay.qt_next;
+			nqh++;
+		}
+		xqh[i] = j;
+		first[i] = ntds;
+		ntd[i] = ehci_queue_data(dev, pipe, xfer[i].buffer,
+					 xfer[i].length, &toggle, 1, &tdp[j]);
+		if (ntd[i] < 0)
+			return 1;
+	}
+
+	/*
+	 * A short packet ends an IN transfer early. Send the controller on
+	 * to the next transfer on the same pipe rather than to the rest of
+	 * this one, or to an inactive qTD, which stops the queue.
+	 */
+	for (i = 0; i < count; i++) {
+		if (!usb_pipein(xfer[i].pipe))
+			continue;
+		for (j = i + 1; j < count; j++)
+			if (xqh[j] == xqh[i])
+				break;
+		if (j < count) {
+			td = &td_pool[first[j]];
+		} else {
+			if (end_td == NULL) {
+				end_td = ehci_alloc(sizeof(struct qTD), 32);
+				if (end_td == NULL)
+					return 1;
+				end_td->qt_next =
+					cpu_to_hc32(QT_NEXT_TERMINATE);
+				end_td->qt_altnext =
+					cpu_to_hc32(QT_NEXT_TERMINATE);
+			}
+			td = end_td;
+		}
+		for (j = 0; j < ntd[i]; j++)
+			td_pool[first[i] + j].qt_altnext =
+				cpu_to_hc32((uint32_t)td);
+	}
+
+	for (j = 0; j < nqh; j++)
+		qh[j]->qh_link = cpu_to_hc32((j + 1 < nqh ?
+			(uint32_t)qh[j + 1] : (uint32_t)&qh_list) |
+			QH_LINK_TYPE_QH);
+	qh_list.qh_link = cpu_to_hc32((uint32_t)qh[0] | QH_LINK_TYPE_QH);
+
+	for (i = 0; i < count; i++)
+		ehci_cache_buffer(xfer[i].buffer, xfer[i].length, 1);
+	ehci_cache_pools(1);
+
+	usbsts = ehci_readl(&hcor->or_usbsts);
+	ehci_writel(&hcor->or_usbsts, (usbsts & 0x3f));
+
+	ret = ehci_async_schedule(1);
+	if (ret < 0) {
+		printf("EHCI fail timeout STD_ASS set\n");
+		goto out;
+	}
+
+	ts = get_timer(0);
+	do {
+		ehci_cache_pools(0);
+		done = 1;
+		for (i = 0; i < count; i++) {
+			if (ehci_bulk_result(&xfer[i], &td_pool[first[i]],
+					     ntd[i])) {
+				/*
+				 * Later transfers wait on this one, e.g. no
+				 * data or CSW comes once the CBW has stalled
+				 */
+				if (xfer[i].status) {
+					done = 1;
+					break;
+				}
+				continue;
+			}
+			/* an error halts the QH before the rest of its qTDs */
+			token = hc32_to_cpu(qh[xqh[i]]->qh_overlay.qt_token);
+			if (!(token & 0x40))
+				done = 0;
+		}
+		if (done)
+			break;
+		WATCHDOG_RESET();
+	} while (get_timer(ts) < timeout);
+
+	ret = ehci_async_schedule(0);
+	if (!done)
+		printf("EHCI timed out on bulk queue\n");
+	if (ret < 0)
+		printf("EHCI fail timeout STD_ASS reset\n");
+
+	for (j = 0; j < nqh; j++) {
+		token = hc32_to_cpu(qh[j]->qh_overlay.qt_token);
+		if (!(token & 0xc0))
+			usb_settoggle(dev, usb_pipeendpoint(qh_pipe[j]),
+				      usb_pipeout(qh_pipe[j]), token >> 31);
+	}
+	for (i = 0; i < count; i++)
+		if (usb_pipein(xfer[i].pipe))
+			ehci_cache_buffer(xfer[i].buffer, xfer[i].length, 0);
+
+out:
+	qh_list.qh_link = cpu_to_hc32((uint32_t)&qh_list | QH_LINK_TYPE_QH);
+	dev->act_len = 0;
+	dev->status = 0;
+	for (i = 0; i < count; i++) {
+		dev->act_len += xfer[i].act_len;
+		if (xfer[i].status && !dev->status)
+			dev->status = xfer[i].status;
+	}
+	return dev->status ? -1 : 0;
+}
+#endif
+
 int
 submit_control_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 		   int length, struct devrequest *setup)
@@ -177,10 +177,26 @@ struct qTD {
 	uint32_t qt_token;		/* see EHCI 3.5.3 */
 	uint32_t qt_buffer[5];		/* see EHCI 3.5.4 */
 	uint32_t qt_buffer_hi[5];	/* Appendix B */
+	/* software only: bytes queued, as the token counts down */
+	uint32_t qt_length;
 	/* pad struct for 32 byte alignment */
-	uint32_t unused[3];
+	uint32_t unused[2];
 };
 
+/* Bytes one qTD can always map: four pages, whatever the alignment */
+#define QT_MIN_XFER		(4 * 4096)
+
+/*
+ * qTDs available to one transfer: the data stage of the largest bulk
+ * transfer, plus SETUP and status stages for control transfers, or the
+ * short transfers around it in a bulk queue
+ */
+#define EHCI_MAX_QTDS	\
+	((USB_MAX_XFER_SIZE + QT_MIN_XFER - 1) / QT_MIN_XFER + 4)
+
+/* QHs available to one transfer: a bulk queue uses one per pipe */
+#define EHCI_MAX_QHS		2
+
 /* Queue Head (QH). */
 struct QH {
 	uint32_t qh_link;
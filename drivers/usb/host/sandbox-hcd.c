@@ -0,0 +1,466 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+
+/*
+ * A USB host controller for the sandbox, with a disk plugged straight
+ * into it (there is no root hub). The disk is backed by an image file
+ * given with -u and speaks the bulk-only mass storage protocol, as the
+ * Linux file-backed storage gadget does, so that common/usb.c and
+ * common/usb_storage.c run unchanged. Transfers complete at once.
+ */
+
+#include <common.h>
+#include <os.h>
+#include <scsi.h>
+#include <usb.h>
+#include <asm/state.h>
+#include <asm/unaligned.h>
+
+#define UDISK_EP_IN		1
+#define UDISK_EP_OUT		2
+#define UDISK_BLKSZ		512
+
+#define CBW_SIGNATURE		0x43425355	/* "USBC" */
+#define CSW_SIGNATURE		0x53425355	/* "USBS" */
+#define CBW_SIZE		31
+#define CSW_SIZE		13
+
+#define US_BBB_RESET		0xff
+#define US_BBB_GET_MAX_LUN	0xfe
+
+/* Additional sense codes we report */
+#define ASC_WRITE_ERROR		0x0c
+#define ASC_READ_ERROR		0x11
+#define ASC_INVALID_COMMAND	0x20
+#define ASC_LBA_OUT_OF_RANGE	0x21
+
+enum udisk_state {
+	UDISK_CBW,		/* waiting for a command */
+	UDISK_DATA_IN,		/* command has data for the host */
+	UDISK_DATA_OUT,		/* command wants data from the host */
+	UDISK_CSW,		/* status to send */
+};
+
+struct sandbox_udisk {
+	int fd;
+	u32 blocks;			/* capacity in UDISK_BLKSZ blocks */
+	enum udisk_state state;
+	u32 tag;			/* of the current command */
+	u32 residue;			/* data the command did not move */
+	u8 status;			/* CSW status: 0 good, 1 failed */
+	u8 cmd;				/* SCSI opcode */
+	u64 offset;			/* of READ/WRITE data in the image */
+	u8 resp[36];			/* INQUIRY etc. data */
+	int resp_len;
+	u8 sense_key, asc;
+	int halted[3];			/* endpoint stalled, by number */
+};
+
+static struct sandbox_udisk udisk = { .fd = -1 };
+
+static const u8 udisk_device_desc[USB_DT_DEVICE_SIZE] = {
+	USB_DT_DEVICE_SIZE, USB_DT_DEVICE,
+	0x00, 0x02,		/* USB 2.0 */
+	0, 0, 0,		/* class in the interface */
+	64,			/* ep0 max packet */
+	0x25, 0x05,		/* NetChip, as the Linux storage gadget */
+	0xa5, 0xa4,
+	0x00, 0x01,		/* release 1.0 */
+	1, 2, 3,		/* strings */
+	1,			/* configurations */
+};
+
+static const u8 udisk_config_desc[] = {
+	USB_DT_CONFIG_SIZE, USB_DT_CONFIG,
+	32, 0,			/* total length */
+	1, 1, 0,		/* interfaces, value, string */
+	0x80, 50,		/* bus powered, 100mA */
+
+	USB_DT_INTERFACE_SIZE, USB_DT_INTERFACE,
+	0, 0, 2,		/* number, alternate, endpoints */
+	USB_CLASS_MASS_STORAGE, US_SC_SCSI, US_PR_BULK,
+	0,
+
+	USB_DT_ENDPOINT_SIZE, USB_DT_ENDPOINT,
+	USB_DIR_IN | UDISK_EP_IN, USB_ENDPOINT_XFER_BULK,
+	0x00, 0x02, 0,		/* 512 bytes */
+
+	USB_DT_ENDPOINT_SIZE, USB_DT_ENDPOINT,
+	USB_DIR_OUT | UDISK_EP_OUT, USB_ENDPOINT_XFER_BULK,
+	0x00, 0x02, 0,
+};
+
+static const char *const udisk_strings[] = {
+	NULL, "Sandbox", "USB Disk", "0123456789AB",
+};
+
+static int udisk_string(int index, u8 *buf, int len)
+{
+	const char *s;
+	int i, n;
+
+	if (index == 0) {
+		/* Supported languages: US English */
+		static const u8 langs[] = { 4, USB_DT_STRING, 0x09, 0x04 };
+
+		n = min(len, (int)sizeof(langs));
+		memcpy(buf, langs, n);
+		return n;
+	}
+	if (index >= ARRAY_SIZE(udisk_strings))
+		return -1;
+
+	/* UTF-16LE */
+	s = udisk_strings[index];
+	n = 2 + 2 * strlen(s);
+	for (i = 0; i < n && i < len; i++) {
+		if (i == 0)
+			buf[i] = n;
+		else if (i == 1)
+			buf[i] = USB_DT_STRING;
+		else
+			buf[i] = i & 1 ? 0 : s[i / 2 - 1];
+	}
+	return i;
+}
+
+static int udisk_control(struct devrequest *setup, u8 *buf, int len)
+{
+	int value = le16_to_cpu(setup->value);
+	int n = -1;
+
+	switch (setup->requesttype << 8 | setup->request) {
+	case (USB_DIR_IN << 8) | USB_REQ_GET_DESCRIPTOR:
+		switch (value >> 8) {
+		case USB_DT_DEVICE:
+			n = min(len, (int)sizeof(udisk_device_desc));
+			memcpy(buf, udisk_device_desc, n);
+			break;
+		case USB_DT_CONFIG:
+			n = min(len, (int)sizeof(udisk_config_desc));
+			memcpy(buf, udisk_config_desc, n);
+			break;
+		case USB_DT_STRING:
+			n = udisk_string(value & 0xff, buf, len);
+			break;
+		}
+		break;
+	case (USB_DIR_IN << 8) | USB_REQ_GET_STATUS:
+	case ((USB_DIR_IN | USB_RECIP_ENDPOINT) << 8) | USB_REQ_GET_STATUS:
+		n = min(len, 2);
+		memset(buf, '\0', n);
+		if (setup->requesttype & USB_RECIP_ENDPOINT)
+			buf[0] = udisk.halted[le16_to_cpu(setup->index) & 3];
+		break;
+	case USB_REQ_SET_ADDRESS:
+	case USB_REQ_SET_CONFIGURATION:
+	case (USB_RECIP_INTERFACE << 8) | USB_REQ_SET_INTERFACE:
+		n = 0;
+		break;
+	case (USB_RECIP_ENDPOINT << 8) | USB_REQ_CLEAR_FEATURE:
+		udisk.halted[le16_to_cpu(setup->index) & 3] = 0;
+		n = 0;
+		break;
+	case ((USB_DIR_IN | USB_TYPE_CLASS | USB_RECIP_INTERFACE) << 8) |
+			US_BBB_GET_MAX_LUN:
+		n = min(len, 1);
+		memset(buf, '\0', n);
+		break;
+	case ((USB_TYPE_CLASS | USB_RECIP_INTERFACE) << 8) | US_BBB_RESET:
+		udisk.state = UDISK_CBW;
+		n = 0;
+		break;
+	}
+
+	return n;
+}
+
+static void udisk_fail(u8 sense_key, u8 asc)
+{
+	udisk.status = 1;
+	udisk.sense_key = sense_key;
+	udisk.asc = asc;
+}
+
+static void udisk_put_be32(u8 *p, u32 val)
+{
+	p[0] = val >> 24;
+	p[1] = val >> 16;
+	p[2] = val >> 8;
+	p[3] = val;
+}
+
+/* Start a SCSI command; a data phase, if any, follows */
+static void udisk_command(const u8 *cdb)
+{
+	u32 lba, count;
+
+	udisk.cmd = cdb[0];
+	udisk.status = 0;
+	udisk.resp_len = 0;
+	switch (cdb[0]) {
+	case SCSI_INQUIRY:
+		memset(udisk.resp, '\0', 36);
+		udisk.resp[1] = 0x80;		/* removable */
+		udisk.resp[2] = 2;		/* SCSI-2 */
+		udisk.resp[3] = 2;		/* response format */
+		udisk.resp[4] = 31;		/* additional length */
+		memcpy(&udisk.resp[8], "Sandbox USB Disk        1.0 ", 28);
+		udisk.resp_len = 36;
+		break;
+	case SCSI_REQ_SENSE:
+		memset(udisk.resp, '\0', 18);
+		udisk.resp[0] = 0x70;		/* current error */
+		udisk.resp[2] = udisk.sense_key;
+		udisk.resp[7] = 10;		/* additional length */
+		udisk.resp[12] = udisk.asc;
+		udisk.resp_len = 18;
+		udisk.sense_key = 0;
+		udisk.asc = 0;
+		break;
+	case SCSI_RD_CAPAC:
+		udisk_put_be32(&udisk.resp[0], udisk.blocks - 1);
+		udisk_put_be32(&udisk.resp[4], UDISK_BLKSZ);
+		udisk.resp_len = 8;
+		break;
+	case SCSI_TST_U_RDY:
+	case SCSI_MED_REMOVL:
+	case SCSI_START_STP:
+		break;
+	case SCSI_READ10:
+	case SCSI_WRITE10:
+		lba = cdb[2] << 24 | cdb[3] << 16 | cdb[4] << 8 | cdb[5];
+		count = cdb[7] << 8 | cdb[8];
+		if (lba > udisk.blocks || count > udisk.blocks - lba) {
+			udisk_fail(SENSE_ILLEGAL_REQUEST,
+				   ASC_LBA_OUT_OF_RANGE);
+			break;
+		}
+		udisk.offset = (u64)lba * UDISK_BLKSZ;
+		break;
+	default:
+		debug("usb: unsupported SCSI command %02x\n", cdb[0]);
+		udisk_fail(SENSE_ILLEGAL_REQUEST, ASC_INVALID_COMMAND);
+		break;
+	}
+}
+
+static int udisk_cbw(const u8 *buf, int len)
+{
+	if (len != CBW_SIZE || get_unaligned_le32(buf) != CBW_SIGNATURE)
+		return -1;
+
+	udisk.tag = get_unaligned_le32(buf + 4);
+	udisk.residue = get_unaligned_le32(buf + 8);
+	udisk_command(buf + 15);
+	if (!udisk.residue)
+		udisk.state = UDISK_CSW;
+	else if (buf[12] & 0x80)
+		udisk.state = UDISK_DATA_IN;
+	else
+		udisk.state = UDISK_DATA_OUT;
+
+	return 0;
+}
+
+/* Data phase: READ and WRITE go between the image and memory directly */
+static int udisk_data(u8 *buf, int len)
+{
+	int n = min((u32)len, udisk.residue);
+	int in = udisk.state == UDISK_DATA_IN;
+
+	if (udisk.status) {
+		n = 0;
+	} else if (udisk.cmd == SCSI_READ10 && in) {
+		if (os_pread(udisk.fd, buf, n, udisk.offset) != n)
+			udisk_fail(SENSE_MEDIUM_ERROR, ASC_READ_ERROR);
+		udisk.offset += n;
+	} else if (udisk.cmd == SCSI_WRITE10 && !in) {
+		if (os_pwrite(udisk.fd, buf, n, udisk.offset) != n)
+			udisk_fail(SENSE_MEDIUM_ERROR, ASC_WRITE_ERROR);
+		udisk.offset += n;
+	} else if (in) {
+		n = min(n, udisk.resp_len);
+		memcpy(buf, udisk.resp, n);
+	}
+	udisk.residue -= n;
+
+	/* Anything not moved is left to the residue in the status */
+	udisk.state = UDISK_CSW;
+
+	return n;
+}
+
+static int udisk_csw(u8 *buf, int len)
+{
+	if (len < CSW_SIZE)
+		return -1;
+
+	put_unaligned_le32(CSW_SIGNATURE, buf);
+	put_unaligned_le32(udisk.tag, buf + 4);
+	put_unaligned_le32(udisk.residue, buf + 8);
+	buf[12] = udisk.status;
+	udisk.state = UDISK_CBW;
+
+	return CSW_SIZE;
+}
+
+static int udisk_bulk(unsigned long pipe, u8 *buf, int len)
+{
+	int ep = usb_pipeendpoint(pipe);
+	int in = usb_pipein(pipe);
+
+	if (udisk.halted[ep & 3])
+		return -1;
+
+	switch (udisk.state) {
+	case UDISK_CBW:
+		if (!in && ep == UDISK_EP_OUT && udisk_cbw(buf, len) == 0)
+			return len;
+		break;
+	case UDISK_DATA_IN:
+		if (in && ep == UDISK_EP_IN)
+			return udisk_data(buf, len);
+		break;
+	case UDISK_DATA_OUT:
+		if (!in && ep == UDISK_EP_OUT)
+			return udisk_data(buf, len);
+		break;
+	case UDISK_CSW:
+		if (in && ep == UDISK_EP_IN)
+			return udisk_csw(buf, len);
+		break;
+	}
+
+	/* Out of step with the protocol: stall, as a real device would */
+	udisk.halted[ep & 3] = 1;
+	return -1;
+}
+
+int submit_control_msg(struct usb_device *dev, unsigned long pipe,
+		       void *buffer, int transfer_len,
+		       struct devrequest *setup)
+{
+	int n = udisk_control(setup, buffer, transfer_len);
+
+	if (n < 0) {
+		dev->status = USB_ST_STALLED;
+		dev->act_len = 0;
+		return -1;
+	}
+	dev->status = 0;
+	dev->act_len = n;
+
+	return 0;
+}
+
+int submit_bulk_msg(struct usb_device *dev, unsigned long pipe,
+		    void *buffer, int transfer_len)
+{
+	int n = udisk_bulk(pipe, buffer, transfer_len);
+
+	if (n < 0) {
+		dev->status = USB_ST_STALLED;
+		dev->act_len = 0;
+		return -1;
+	}
+	dev->status = 0;
+	dev->act_len = n;
+
+	return 0;
+}
+
+#ifdef CONFIG_USB_BULK_QUEUE
+int submit_bulk_queue(struct usb_device *dev, struct usb_bulk_xfer *xfer,
+		      int count, int timeout)
+{
+	int i, n, total = 0, ret = 0;
+
+	for (i = 0; i < count; i++) {
+		xfer[i].status = USB_ST_NOT_PROC;
+		xfer[i].act_len = 0;
+	}
+	/* as on EHCI, nothing after a failed transfer is processed */
+	for (i = 0; i < count && !ret; i++) {
+		n = udisk_bulk(xfer[i].pipe, xfer[i].buffer, xfer[i].length);
+		xfer[i].status = n < 0 ? USB_ST_STALLED : 0;
+		xfer[i].act_len = n < 0 ? 0 : n;
+		total += xfer[i].act_len;
+		if (n < 0)
+			ret = -1;
+	}
+	dev->status = ret ? USB_ST_STALLED : 0;
+	dev->act_len = total;
+
+	return ret;
+}
+#endif
+
+int submit_int_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
+		   int transfer_len, int interval)
+{
+	/* The disk has no interrupt endpoint */
+	dev->status = USB_ST_STALLED;
+	dev->act_len = 0;
+	return -1;
+}
+
+void usb_event_poll(void)
+{
+}
+
+int usb_lowlevel_init(void)
+{
+	struct sandbox_state *state = state_get_current();
+	long long size;
+
+	if (!state->usb_file) {
+		printf("usb: no disk, use -u <file>\n");
+		return -1;
+	}
+
+	if (udisk.fd < 0) {
+		udisk.fd = os_open(state->usb_file, OS_O_RDWR);
+		if (udisk.fd < 0)
+			udisk.fd = os_open(state->usb_file, OS_O_RDONLY);
+		if (udisk.fd < 0) {
+			printf("usb: cannot open '%s'\n", state->usb_file);
+			return -1;
+		}
+	}
+
+	size = os_lseek(udisk.fd, 0, OS_SEEK_END);
+	udisk.blocks = size / UDISK_BLKSZ;
+	if (udisk.blocks == 0) {
+		printf("usb: '%s' is smaller than a block\n", state->usb_file);
+		return -1;
+	}
+	udisk.state = UDISK_CBW;
+	memset(udisk.halted, '\0', sizeof(udisk.halted));
+
+	return 0;
+}
+
+int usb_lowlevel_stop(void)
+{
+	return 0;
+}
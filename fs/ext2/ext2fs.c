@@ -39,6 +39,17 @@ extern int ext2fs_devread (int sector, int byte_offset, int byte_len,
 #define EXT2_PATH_MAX		4096
 /* Maximum nesting of symlinks, used to prevent a loop.  */
 #define	EXT2_MAX_SYMLINKCNT	8
+/* Levels of indirect blocks or extent tree nodes kept in memory.  */
+#define EXT2_META_LEVELS	5
+
+/* Inode flag of files mapped by an extent tree.  */
+#define EXT4_EXTENTS_FL		0x00080000
+/* Magic value of an extent tree node header.  */
+#define EXT4_EXT_MAGIC		0xF30A
+/* Extents longer than this are allocated but not initialized.  */
+#define EXT4_EXT_INIT_MAX_LEN	32768
+/* Incompatible feature of filesystems with 64 bit group descriptors.  */
+#define EXT4_FEATURE_INCOMPAT_64BIT	0x0080
 
 /* Filetype used in directory entry.  */
 #define	FILETYPE_UNKNOWN	0
@@ -101,6 +112,17 @@ struct ext2_sblock {
 	char volume_name[16];
 	char last_mounted_on[64];
 	uint32_t compression_info;
+	uint8_t prealloc_blocks;
+	uint8_t prealloc_dir_blocks;
+	uint16_t reserved_gdt_blocks;
+	uint8_t journal_uuid[16];
+	uint32_t journal_inode;
+	uint32_t journal_dev;
+	uint32_t last_orphan;
+	uint32_t hash_seed[4];
+	uint8_t default_hash_version;
+	uint8_t journal_backup_type;
+	uint16_t descriptor_size;
 };
 
 /* The ext2 blockgroup.  */
@@ -144,6 +166,32 @@ struct ext2_inode {
 	uint32_t osd2[3];
 };
 
+/* The header of an ext4 extent tree node, the first 12 bytes of the
+   inode block map or of a tree block.  */
+struct ext4_extent_header {
+	uint16_t magic;
+	uint16_t entries;
+	uint16_t max;
+	uint16_t depth;		/* 0 for a leaf */
+	uint32_t generation;
+};
+
+/* An entry of an extent tree leaf.  */
+struct ext4_extent {
+	uint32_t block;		/* First file block */
+	uint16_t len;		/* Number of blocks */
+	uint16_t start_hi;
+	uint32_t start;		/* First filesystem block */
+};
+
+/* An entry of an extent tree index node.  */
+struct ext4_extent_idx {
+	uint32_t block;		/* First file block covered */
+	uint32_t leaf;		/* Filesystem block of the next level */
+	uint16_t leaf_hi;
+	uint16_t unused;
+};
+
 /* The header of an ext2 directory entry.  */
 struct ext2_dirent {
 	uint32_t inode;
@@ -172,13 +220,15 @@ typedef struct ext2fs_node *ext2fs_node_t;
 struct ext2_data *ext2fs_root = NULL;
 ext2fs_node_t ext2fs_file = NULL;
 int symlinknest = 0;
-uint32_t *indir1_block = NULL;
-int indir1_size = 0;
-int indir1_blkno = -1;
-uint32_t *indir2_block = NULL;
-int indir2_size = 0;
-int indir2_blkno = -1;
 static unsigned int inode_size;
+static unsigned int gdesc_size;
+
+/* Indirect blocks or extent tree nodes last read, one per level.  */
+static struct {
+	char *buf;
+	int blkno;
+} ext2fs_meta[EXT2_META_LEVELS];
+static int ext2fs_meta_size;
 
 
 static int ext2fs_blockgroup
@@ -187,11 +237,11 @@ static int ext2fs_blockgroup
 	unsigned int blkoff;
 	unsigned int desc_per_blk;
 
-	desc_per_blk = EXT2_BLOCK_SIZE(data) / sizeof(struct ext2_block_group);
+	desc_per_blk = EXT2_BLOCK_SIZE(data) / gdesc_size;
 
 	blkno = __le32_to_cpu(data->sblock.first_data_block) + 1 +
 	group / desc_per_blk;
-	blkoff = (group % desc_per_blk) * sizeof(struct ext2_block_group);
+	blkoff = (group % desc_per_blk) * gdesc_size;
 #ifdef DEBUG
 	printf ("ext2fs read %d group descriptor (blkno %d blkoff %d)\n",
 		group, blkno, blkoff);
@@ -250,201 +300,289 @@ void ext2fs_free_node (ext2fs_node_t node, ext2fs_node_t currroot) {
 }
 
 
+/* Read filesystem block 'blkno' holding an indirect block or an extent
+   tree node into the buffer of 'level', unless it is already there.  */
+static char *ext2fs_read_meta (struct ext2_data *data, int blkno, int level) {
+	int blksz = EXT2_BLOCK_SIZE (data);
+	int i;
+
+	if (blksz != ext2fs_meta_size) {
+		for (i = 0; i < EXT2_META_LEVELS; i++) {
+			free (ext2fs_meta[i].buf);
+			ext2fs_meta[i].buf = NULL;
+			ext2fs_meta[i].blkno = -1;
+		}
+		ext2fs_meta_size = blksz;
+	}
+	if (ext2fs_meta[level].buf == NULL) {
+		ext2fs_meta[level].buf = malloc (blksz);
+		if (ext2fs_meta[level].buf == NULL) {
+			printf ("** ext2fs read block (level %d) malloc failed. **\n",
+				level);
+			return (NULL);
+		}
+		ext2fs_meta[level].blkno = -1;
+	}
+	if (ext2fs_meta[level].blkno != blkno) {
+		ext2fs_meta[level].blkno = -1;
+		if (ext2fs_devread (blkno << LOG2_EXT2_BLOCK_SIZE (data), 0,
+				    blksz, ext2fs_meta[level].buf) == 0) {
+			printf ("** ext2fs read block (level %d) failed. **\n",
+				level);
+			return (NULL);
+		}
+		ext2fs_meta[level].blkno = blkno;
+	}
+	return (ext2fs_meta[level].buf);
+}
+
+
+static void ext2fs_free_meta (void) {
+	int i;
+
+	for (i = 0; i < EXT2_META_LEVELS; i++) {
+		free (ext2fs_meta[i].buf);
+		ext2fs_meta[i].buf = NULL;
+		ext2fs_meta[i].blkno = -1;
+	}
+	ext2fs_meta_size = 0;
+}
+
+
+/* Map 'fileblock' through the direct and indirect blocks of the inode.
+   Return the filesystem block, 0 for a hole or -1 on error.  */
 static int ext2fs_read_block (ext2fs_node_t node, int fileblock) {
 	struct ext2_data *data = node->data;
 	struct ext2_inode *inode = &node->inode;
-	int blknr;
-	int blksz = EXT2_BLOCK_SIZE (data);
-	int log2_blksz = LOG2_EXT2_BLOCK_SIZE (data);
-	int status;
+	unsigned int perblock = EXT2_BLOCK_SIZE (data) / 4;
+	unsigned int rblock;
+	uint32_t blknr;
+	uint32_t *indir;
+	int levels, level;
 
 	/* Direct blocks.  */
 	if (fileblock < INDIRECT_BLOCKS) {
-		blknr = __le32_to_cpu (inode->b.blocks.dir_blocks[fileblock]);
-	}
-	/* Indirect.  */
-	else if (fileblock < (INDIRECT_BLOCKS + (blksz / 4))) {
-		if (indir1_block == NULL) {
-			indir1_block = (uint32_t *) malloc (blksz);
-			if (indir1_block == NULL) {
-				printf ("** ext2fs read block (indir 1) malloc failed. **\n");
-				return (-1);
-			}
-			indir1_size = blksz;
-			indir1_blkno = -1;
-		}
-		if (blksz != indir1_size) {
-			free (indir1_block);
-			indir1_block = NULL;
-			indir1_size = 0;
-			indir1_blkno = -1;
-			indir1_block = (uint32_t *) malloc (blksz);
-			if (indir1_block == NULL) {
-				printf ("** ext2fs read block (indir 1) malloc failed. **\n");
-				return (-1);
-			}
-			indir1_size = blksz;
+		return (__le32_to_cpu (inode->b.blocks.dir_blocks[fileblock]));
+	}
+
+	/* Find the indirection level and the block index below it.  */
+	rblock = fileblock - INDIRECT_BLOCKS;
+	if (rblock < perblock) {
+		levels = 1;
+		blknr = inode->b.blocks.indir_block;
+	} else if ((rblock -= perblock) < perblock * perblock) {
+		levels = 2;
+		blknr = inode->b.blocks.double_indir_block;
+	} else {
+		rblock -= perblock * perblock;
+		levels = 3;
+		blknr = inode->b.blocks.tripple_indir_block;
+	}
+	blknr = __le32_to_cpu (blknr);
+
+	for (level = levels - 1; level >= 0; level--) {
+		unsigned int shift = 1;
+		int i;
+
+		/* A hole in the indirect blocks.  */
+		if (blknr == 0) {
+			return (0);
 		}
-		if ((__le32_to_cpu (inode->b.blocks.indir_block) <<
-		     log2_blksz) != indir1_blkno) {
-			status = ext2fs_devread (__le32_to_cpu(inode->b.blocks.indir_block) << log2_blksz,
-						 0, blksz,
-						 (char *) indir1_block);
-			if (status == 0) {
-				printf ("** ext2fs read block (indir 1) failed. **\n");
-				return (0);
-			}
-			indir1_blkno =
-				__le32_to_cpu (inode->b.blocks.
-					       indir_block) << log2_blksz;
+		indir = (uint32_t *) ext2fs_read_meta (data, blknr, level);
+		if (indir == NULL) {
+			return (-1);
 		}
-		blknr = __le32_to_cpu (indir1_block
-				       [fileblock - INDIRECT_BLOCKS]);
-	}
-	/* Double indirect.  */
-	else if (fileblock <
-		 (INDIRECT_BLOCKS + (blksz / 4 * (blksz / 4 + 1)))) {
-		unsigned int perblock = blksz / 4;
-		unsigned int rblock = fileblock - (INDIRECT_BLOCKS
-						   + blksz / 4);
-
-		if (indir1_block == NULL) {
-			indir1_block = (uint32_t *) malloc (blksz);
-			if (indir1_block == NULL) {
-				printf ("** ext2fs read block (indir 2 1) malloc failed. **\n");
-				return (-1);
-			}
-			indir1_size = blksz;
-			indir1_blkno = -1;
+		for (i = 0; i < level; i++) {
+			shift *= perblock;
 		}
-		if (blksz != indir1_size) {
-			free (indir1_block);
-			indir1_block = NULL;
-			indir1_size = 0;
-			indir1_blkno = -1;
-			indir1_block = (uint32_t *) malloc (blksz);
-			if (indir1_block == NULL) {
-				printf ("** ext2fs read block (indir 2 1) malloc failed. **\n");
-				return (-1);
-			}
-			indir1_size = blksz;
+		blknr = __le32_to_cpu (indir[(rblock / shift) % perblock]);
+	}
+#ifdef DEBUG
+	printf ("ext2fs_read_block %08x\n", blknr);
+#endif
+	return (blknr);
+}
+
+
+/* Map 'fileblock' through the extent tree of the inode. Return the
+   filesystem block, 0 for a hole or -1 on error, and in 'count' the
+   number of following file blocks mapped the same way, at most 'maxcount'.  */
+static int ext4fs_read_extent
+	(ext2fs_node_t node, unsigned int fileblock, unsigned int maxcount,
+	 unsigned int *count) {
+	struct ext4_extent_header *eh;
+	struct ext4_extent *ext;
+	unsigned int first, len;
+	unsigned int limit = ~0;
+	int unwritten = 0;
+	int level = 0;
+	int entries;
+	int i;
+
+	eh = (struct ext4_extent_header *) node->inode.b.blocks.dir_blocks;
+	for (;;) {
+		if (__le16_to_cpu (eh->magic) != EXT4_EXT_MAGIC) {
+			printf ("** ext4fs bad extent header. **\n");
+			return (-1);
 		}
-		if ((__le32_to_cpu (inode->b.blocks.double_indir_block) <<
-		     log2_blksz) != indir1_blkno) {
-			status = ext2fs_devread (__le32_to_cpu(inode->b.blocks.double_indir_block) << log2_blksz,
-						0, blksz,
-						(char *) indir1_block);
-			if (status == 0) {
-				printf ("** ext2fs read block (indir 2 1) failed. **\n");
-				return (-1);
-			}
-			indir1_blkno =
-				__le32_to_cpu (inode->b.blocks.double_indir_block) << log2_blksz;
+		entries = __le16_to_cpu (eh->entries);
+		if (__le16_to_cpu (eh->depth) == 0) {
+			break;
 		}
 
-		if (indir2_block == NULL) {
-			indir2_block = (uint32_t *) malloc (blksz);
-			if (indir2_block == NULL) {
-				printf ("** ext2fs read block (indir 2 2) malloc failed. **\n");
-				return (-1);
+		/* Descend into the last index starting at or before the block.  */
+		{
+			struct ext4_extent_idx *idx =
+				(struct ext4_extent_idx *) (eh + 1);
+
+			for (i = 0; i < entries; i++) {
+				if (__le32_to_cpu (idx[i].block) > fileblock) {
+					break;
+				}
 			}
-			indir2_size = blksz;
-			indir2_blkno = -1;
-		}
-		if (blksz != indir2_size) {
-			free (indir2_block);
-			indir2_block = NULL;
-			indir2_size = 0;
-			indir2_blkno = -1;
-			indir2_block = (uint32_t *) malloc (blksz);
-			if (indir2_block == NULL) {
-				printf ("** ext2fs read block (indir 2 2) malloc failed. **\n");
+			if (i < entries) {
+				limit = __le32_to_cpu (idx[i].block);
+			}
+			if (i == 0) {
+				goto hole;
+			}
+			if (idx[i - 1].leaf_hi || level == EXT2_META_LEVELS) {
+				printf ("** ext4fs extent tree not supported. **\n");
 				return (-1);
 			}
-			indir2_size = blksz;
-		}
-		if ((__le32_to_cpu (indir1_block[rblock / perblock]) <<
-		     log2_blksz) != indir2_blkno) {
-			status = ext2fs_devread (__le32_to_cpu(indir1_block[rblock / perblock]) << log2_blksz,
-						 0, blksz,
-						 (char *) indir2_block);
-			if (status == 0) {
-				printf ("** ext2fs read block (indir 2 2) failed. **\n");
+			eh = (struct ext4_extent_header *)
+				ext2fs_read_meta (node->data,
+						  __le32_to_cpu (idx[i - 1].leaf),
+						  level++);
+			if (eh == NULL) {
 				return (-1);
 			}
-			indir2_blkno =
-				__le32_to_cpu (indir1_block[rblock / perblock]) << log2_blksz;
 		}
-		blknr = __le32_to_cpu (indir2_block[rblock % perblock]);
 	}
-	/* Tripple indirect.  */
-	else {
-		printf ("** ext2fs doesn't support tripple indirect blocks. **\n");
+
+	ext = (struct ext4_extent *) (eh + 1);
+	for (i = 0; i < entries; i++) {
+		if (__le32_to_cpu (ext[i].block) > fileblock) {
+			break;
+		}
+	}
+	if (i < entries) {
+		limit = __le32_to_cpu (ext[i].block);
+	}
+	if (i == 0) {
+		goto hole;
+	}
+	ext += i - 1;
+
+	first = __le32_to_cpu (ext->block);
+	len = __le16_to_cpu (ext->len);
+	if (len > EXT4_EXT_INIT_MAX_LEN) {
+		len -= EXT4_EXT_INIT_MAX_LEN;
+		unwritten = 1;
+	}
+	if (fileblock - first >= len) {
+		goto hole;
+	}
+	/* Allocated but unwritten blocks read as zeroes.  */
+	if (unwritten) {
+		limit = first + len;
+		goto hole;
+	}
+	if (ext->start_hi) {
+		printf ("** ext4fs extent beyond 32 bit blocks. **\n");
 		return (-1);
 	}
-#ifdef DEBUG
-	printf ("ext2fs_read_block %08x\n", blknr);
-#endif
+	*count = first + len - fileblock;
+	if (*count > maxcount) {
+		*count = maxcount;
+	}
+	return (__le32_to_cpu (ext->start) + fileblock - first);
+
+hole:
+	*count = limit - fileblock;
+	if (*count > maxcount) {
+		*count = maxcount;
+	}
+	return (0);
+}
+
+
+/* Map 'fileblock' and as many of the at most 'maxcount' following file
+   blocks as are contiguous on disk, or all part of the same hole. Return
+   the first filesystem block, 0 for a hole or -1 on error, and the
+   number of blocks of the run in 'count'.  */
+static int ext2fs_read_run
+	(ext2fs_node_t node, unsigned int fileblock, unsigned int maxcount,
+	 unsigned int *count) {
+	int blknr, next;
+
+	if (__le32_to_cpu (node->inode.flags) & EXT4_EXTENTS_FL) {
+		return (ext4fs_read_extent (node, fileblock, maxcount, count));
+	}
+
+	blknr = ext2fs_read_block (node, fileblock);
+	if (blknr < 0) {
+		return (-1);
+	}
+	/* The indirect blocks stay cached, so looking ahead is cheap.  */
+	for (*count = 1; *count < maxcount; (*count)++) {
+		next = ext2fs_read_block (node, fileblock + *count);
+		if (next != (blknr ? blknr + *count : 0)) {
+			break;
+		}
+	}
 	return (blknr);
 }
 
 
 int ext2fs_read_file
 	(ext2fs_node_t node, int pos, unsigned int len, char *buf) {
-	int i;
-	int blockcnt;
 	int log2blocksize = LOG2_EXT2_BLOCK_SIZE (node->data);
 	int blocksize = 1 << (log2blocksize + DISK_SECTOR_BITS);
 	unsigned int filesize = __le32_to_cpu(node->inode.size);
+	unsigned int end;
 
 	/* Adjust len so it we can't read past the end of the file.  */
 	if (len > filesize) {
 		len = filesize;
 	}
-	blockcnt = ((len + pos) + blocksize - 1) / blocksize;
+	end = pos + len;
 
-	for (i = pos / blocksize; i < blockcnt; i++) {
-		int blknr;
+	/* Read a run of contiguous blocks, or clear a hole, at a time.  */
+	while (pos < end) {
+		unsigned int fileblock = pos / blocksize;
+		unsigned int count;
 		int blockoff = pos % blocksize;
-		int blockend = blocksize;
-
-		int skipfirst = 0;
+		int blknr;
+		int bytes;
 
-		blknr = ext2fs_read_block (node, i);
+		blknr = ext2fs_read_run (node, fileblock,
+					 (end - 1) / blocksize - fileblock + 1,
+					 &count);
 		if (blknr < 0) {
 			return (-1);
 		}
-		blknr = blknr << log2blocksize;
-
-		/* Last block.  */
-		if (i == blockcnt - 1) {
-			blockend = (len + pos) % blocksize;
-
-			/* The last portion is exactly blocksize.  */
-			if (!blockend) {
-				blockend = blocksize;
-			}
-		}
 
-		/* First block.  */
-		if (i == pos / blocksize) {
-			skipfirst = blockoff;
-			blockend -= skipfirst;
+		bytes = count * blocksize - blockoff;
+		if (bytes > end - pos) {
+			bytes = end - pos;
 		}
 
-		/* If the block number is 0 this block is not stored on disk but
-		   is zero filled instead.  */
+		/* If the block number is 0 the blocks are not stored on disk
+		   but are zero filled instead.  */
 		if (blknr) {
 			int status;
 
-			status = ext2fs_devread (blknr, skipfirst, blockend, buf);
+			status = ext2fs_devread (blknr << log2blocksize,
+						 blockoff, bytes, buf);
 			if (status == 0) {
 				return (-1);
 			}
 		} else {
-			memset (buf, 0, blocksize - skipfirst);
+			memset (buf, 0, bytes);
 		}
-		buf += blocksize - skipfirst;
+		buf += bytes;
+		pos += bytes;
 	}
 	return (len);
 }
@@ -810,18 +948,7 @@ int ext2fs_close (void
 		free (ext2fs_root);
 		ext2fs_root = NULL;
 	}
-	if (indir1_block != NULL) {
-		free (indir1_block);
-		indir1_block = NULL;
-		indir1_size = 0;
-		indir1_blkno = -1;
-	}
-	if (indir2_block != NULL) {
-		free (indir2_block);
-		indir2_block = NULL;
-		indir2_size = 0;
-		indir2_blkno = -1;
-	}
+	ext2fs_free_meta ();
 	return (0);
 }
 
@@ -865,6 +992,15 @@ int ext2fs_mount (unsigned part_length) {
 	} else {
 		inode_size = __le16_to_cpu(data->sblock.inode_size);
 	}
+	if ((__le32_to_cpu (data->sblock.feature_incompat) &
+	     EXT4_FEATURE_INCOMPAT_64BIT) &&
+	    __le16_to_cpu (data->sblock.descriptor_size)) {
+		gdesc_size = __le16_to_cpu (data->sblock.descriptor_size);
+	} else {
+		gdesc_size = sizeof (struct ext2_block_group);
+	}
+	/* The cached indirect blocks may belong to another filesystem.  */
+	ext2fs_free_meta ();
 #ifdef DEBUG
 	printf("EXT2 rev %d, inode_size %d\n",
 			__le32_to_cpu(data->sblock.revision_level), inode_size);
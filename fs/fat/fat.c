@@ -174,6 +174,144 @@ static void get_name (dir_entry *dirent, char *s_name)
 	downcase(s_name);
 }
 
+/*
+ * Windows of FATBUFBLOCKS sectors of the FAT, kept across reads of the
+ * same filesystem and recycled least recently used first. A FAT which
+ * fits is read in one go, window i then holding the i-th FATBUFSIZE
+ * bytes of it.
+ *
+ * Note: FAT windows have to be 32 bit aligned (see FAT32 accesses)
+ */
+static struct {
+	__u8	buf[FATBUFWINDOWS][FATBUFSIZE];
+	int	bufnum[FATBUFWINDOWS];	/* Window number, -1 if unused */
+	__u32	used[FATBUFWINDOWS];	/* Last use, for LRU */
+	__u32	clock;
+	/* Filesystem the windows belong to */
+	block_dev_desc_t *dev;
+	unsigned long	part_offset;
+	__u8	volume_id[4];
+	__u16	fat_sect;
+	__u16	fatlength;
+} fatcache __attribute__ ((__aligned__ (4)));
+
+/*
+ * Memory for reading directories: the directory cluster being scanned,
+ * the following one for long names that run across the cluster boundary,
+ * and the cache of directory entries already decoded. Directories are
+ * walked one at a time, so the buffers are shared by all the walks.
+ */
+static struct {
+	__u8	block[MAX_CLUSTSIZE];
+	__u8	vfat_block[MAX_CLUSTSIZE];
+	__u32	dirs[FATDCACHE_DIRS];	/* Directories fully indexed */
+	int	ndirs;
+	fat_dcache_ent ents[FATDCACHE_ENTRIES];
+	int	nents;
+	__u16	hash[FATDCACHE_HASH];	/* Entry number + 1, 0 if free */
+	char	names[FATDCACHE_NAMES];
+	int	nnames;
+} fat_arena __attribute__ ((__aligned__ (__alignof__ (dir_entry))));
+
+static void fat_dcache_reset (void)
+{
+	fat_arena.ndirs = 0;
+	fat_arena.nents = 0;
+	fat_arena.nnames = 0;
+	memset(fat_arena.hash, 0, sizeof(fat_arena.hash));
+}
+
+/*
+ * Drop the cached FAT and directory entries unless they belong to the
+ * filesystem described by 'mydata' and 'volinfo'.
+ */
+static void fat_cache_check (fsdata *mydata, volume_info *volinfo)
+{
+	int i;
+
+	if (fatcache.dev == cur_dev &&
+	    fatcache.part_offset == part_offset &&
+	    fatcache.fat_sect == mydata->fat_sect &&
+	    fatcache.fatlength == mydata->fatlength &&
+	    !memcmp(fatcache.volume_id, volinfo->volume_id, 4))
+		return;
+
+	debug("FAT cache: new filesystem\n");
+	fat_dcache_reset();
+	for (i = 0; i < FATBUFWINDOWS; i++) {
+		fatcache.bufnum[i] = -1;
+		fatcache.used[i] = 0;
+	}
+	fatcache.clock = 0;
+	fatcache.dev = cur_dev;
+	fatcache.part_offset = part_offset;
+	fatcache.fat_sect = mydata->fat_sect;
+	fatcache.fatlength = mydata->fatlength;
+	memcpy(fatcache.volume_id, volinfo->volume_id, 4);
+}
+
+/*
+ * Drop the cached FAT and directory entries if they were read from
+ * 'dev_desc', or whatever they were read from if it is NULL. Block
+ * drivers call this when a device is rescanned or written to, since the
+ * filesystem may then have changed under the cache.
+ */
+void fat_cache_invalidate (block_dev_desc_t *dev_desc)
+{
+	if (dev_desc == NULL || fatcache.dev == dev_desc)
+		fatcache.dev = NULL;
+}
+
+/*
+ * Get window 'bufnum' of the FAT from the cache, reading it in if needed.
+ * Return a pointer to the window, or NULL on failure.
+ */
+static __u8 *fat_cache_get (fsdata *mydata, __u32 bufnum)
+{
+	__u32 startblock = bufnum * FATBUFBLOCKS;
+	__u32 getsize;
+	int i, victim = 0;
+
+	if (startblock >= mydata->fatlength) {
+		debug("FAT window %u beyond end of FAT\n", bufnum);
+		return NULL;
+	}
+
+	for (i = 0; i < FATBUFWINDOWS; i++) {
+		if (fatcache.bufnum[i] == (int)bufnum) {
+			fatcache.used[i] = ++fatcache.clock;
+			return fatcache.buf[i];
+		}
+		if (fatcache.used[i] < fatcache.used[victim])
+			victim = i;
+	}
+
+	if (mydata->fatlength <= FATBUFWINDOWS * FATBUFBLOCKS) {
+		debug("FAT cache: reading whole FAT\n");
+		if (disk_read(mydata->fat_sect, mydata->fatlength,
+			      fatcache.buf[0]) < 0) {
+			debug("Error reading FAT blocks\n");
+			return NULL;
+		}
+		for (i = 0; i < FATBUFWINDOWS; i++)
+			fatcache.bufnum[i] = i;
+		return fatcache.buf[bufnum];
+	}
+
+	getsize = mydata->fatlength - startblock;
+	if (getsize > FATBUFBLOCKS)
+		getsize = FATBUFBLOCKS;
+	fatcache.bufnum[victim] = -1;
+	if (disk_read(mydata->fat_sect + startblock, getsize,
+		      fatcache.buf[victim]) < 0) {
+		debug("Error reading FAT blocks\n");
+		return NULL;
+	}
+	fatcache.bufnum[victim] = bufnum;
+	fatcache.used[victim] = ++fatcache.clock;
+	return fatcache.buf[victim];
+}
+
 /*
  * Get the entry at index 'entry' in a FAT (12/16/32) table.
  * On failure 0x00 is returned.
@@ -207,20 +345,11 @@ static __u32 get_fatent (fsdata *mydata, __u32 entry)
 	debug("FAT%d: entry: 0x%04x = %d, offset: 0x%04x = %d\n",
 	       mydata->fatsize, entry, entry, offset, offset);
 
-	/* Read a new block of FAT entries into the cache. */
+	/* Switch to the block of FAT entries holding this one. */
 	if (bufnum != mydata->fatbufnum) {
-		int getsize = FATBUFSIZE / FS_BLOCK_SIZE;
-		__u8 *bufptr = mydata->fatbuf;
-		__u32 fatlength = mydata->fatlength;
-		__u32 startblock = bufnum * FATBUFBLOCKS;
-
-		fatlength *= SECTOR_SIZE;	/* We want it in bytes now */
-		startblock += mydata->fat_sect;	/* Offset from start of disk */
-
-		if (getsize > fatlength)
-			getsize = fatlength;
-		if (disk_read(startblock, getsize, bufptr) < 0) {
-			debug("Error reading FAT blocks\n");
+		mydata->fatbuf = fat_cache_get(mydata, bufnum);
+		if (mydata->fatbuf == NULL) {
+			mydata->fatbufnum = -1;
 			return ret;
 		}
 		mydata->fatbufnum = bufnum;
@@ -312,9 +441,52 @@ get_cluster (fsdata *mydata, __u32 clustnum, __u8 *buffer,
 	return 0;
 }
 
+/*
+ * Map the cluster chain from 'clust' into at most FATRUNS runs of
+ * consecutive clusters, stopping once they hold 'size' bytes. '*next'
+ * is set to the cluster following the last run, which may be an end of
+ * chain or bad cluster marker.
+ * Return the number of runs.
+ */
+static int
+get_runs (fsdata *mydata, __u32 clust, unsigned long size, fat_run *runs,
+	  __u32 *next)
+{
+	unsigned long bytesperclust = mydata->clust_size * SECTOR_SIZE;
+	__u32 newclust;
+	int nruns = 0;
+
+	runs[0].start = clust;
+	runs[0].count = 1;
+	*next = 0;
+
+	while (size > bytesperclust) {
+		newclust = get_fatent(mydata, clust);
+		if (CHECK_CLUST(newclust, mydata->fatsize)) {
+			*next = newclust;
+			break;
+		}
+		size -= bytesperclust;
+		if (newclust == clust + 1) {
+			runs[nruns].count++;
+		} else {
+			if (++nruns == FATRUNS) {
+				*next = newclust;
+				return nruns;
+			}
+			runs[nruns].start = newclust;
+			runs[nruns].count = 1;
+		}
+		clust = newclust;
+	}
+
+	return nruns + 1;
+}
+
 /*
  * Read at most 'maxsize' bytes from the file associated with 'dentptr'
- * into 'buffer'.
+ * into 'buffer'. The cluster chain is mapped into runs first, so that
+ * each run is a single read straight into 'buffer'.
  * Return the number of bytes read or -1 on fatal errors.
  */
 static long
@@ -322,10 +494,11 @@ get_contents (fsdata *mydata, dir_entry *dentptr, __u8 *buffer,
 	      unsigned long maxsize)
 {
 	unsigned long filesize = FAT2CPU32(dentptr->size), gotsize = 0;
-	unsigned int bytesperclust = mydata->clust_size * SECTOR_SIZE;
+	unsigned long bytesperclust = mydata->clust_size * SECTOR_SIZE;
 	__u32 curclust = START(dentptr);
-	__u32 endclust, newclust;
+	fat_run runs[FATRUNS];
 	unsigned long actsize;
+	int nruns, i;
 
 	debug("Filesize: %ld bytes\n", filesize);
 
@@ -334,62 +507,32 @@ get_contents (fsdata *mydata, dir_entry *dentptr, __u8 *buffer,
 
 	debug("%ld bytes\n", filesize);
 
-	actsize = bytesperclust;
-	endclust = curclust;
-
-	do {
-		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = get_fatent(mydata, endclust);
-			if ((newclust - 1) != endclust)
-				goto getit;
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("curclust: 0x%x\n", newclust);
-				debug("Invalid FAT entry\n");
-				return gotsize;
-			}
-			endclust = newclust;
-			actsize += bytesperclust;
-		}
-
-		/* actsize >= file size */
-		actsize -= bytesperclust;
-
-		/* get remaining clusters */
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-
-		/* get remaining bytes */
-		gotsize += (int)actsize;
-		filesize -= actsize;
-		buffer += actsize;
-		actsize = filesize;
-		if (get_cluster(mydata, endclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		gotsize += actsize;
-		return gotsize;
-getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		gotsize += (int)actsize;
-		filesize -= actsize;
-		buffer += actsize;
-
-		curclust = get_fatent(mydata, endclust);
+	while (filesize > 0) {
 		if (CHECK_CLUST(curclust, mydata->fatsize)) {
 			debug("curclust: 0x%x\n", curclust);
 			printf("Invalid FAT entry\n");
 			return gotsize;
 		}
-		actsize = bytesperclust;
-		endclust = curclust;
-	} while (1);
+
+		nruns = get_runs(mydata, curclust, filesize, runs, &curclust);
+		for (i = 0; i < nruns; i++) {
+			actsize = runs[i].count * bytesperclust;
+			if (actsize > filesize)
+				actsize = filesize;
+			debug("run %d: cluster 0x%x, %ld bytes\n", i,
+			      runs[i].start, actsize);
+			if (get_cluster(mydata, runs[i].start, buffer,
+					actsize) != 0) {
+				printf("Error reading cluster\n");
+				return -1;
+			}
+			gotsize += actsize;
+			filesize -= actsize;
+			buffer += actsize;
+		}
+	}
+
+	return gotsize;
 }
 
 #ifdef CONFIG_SUPPORT_VFAT
@@ -430,9 +573,6 @@ static int slot2str (dir_slot *slotptr, char *l_name, int *idx)
  * into 'retdent'
  * Return 0 on success, -1 otherwise.
  */
-__attribute__ ((__aligned__ (__alignof__ (dir_entry))))
-__u8 get_vfatname_block[MAX_CLUSTSIZE];
-
 static int
 get_vfatname (fsdata *mydata, int curclust, __u8 *cluster,
 	      dir_entry *retdent, char *l_name)
@@ -472,13 +612,13 @@ get_vfatname (fsdata *mydata, int curclust, __u8 *cluster,
 			return -1;
 		}
 
-		if (get_cluster(mydata, curclust, get_vfatname_block,
+		if (get_cluster(mydata, curclust, fat_arena.vfat_block,
 				mydata->clust_size * SECTOR_SIZE) != 0) {
 			debug("Error: reading directory block\n");
 			return -1;
 		}
 
-		slotptr2 = (dir_slot *)get_vfatname_block;
+		slotptr2 = (dir_slot *)fat_arena.vfat_block;
 		while (counter > 0) {
 			if (((slotptr2->id & ~LAST_LONG_ENTRY_MASK)
 			    & 0xff) != counter)
@@ -489,7 +629,7 @@ get_vfatname (fsdata *mydata, int curclust, __u8 *cluster,
 
 		/* Save the real directory entry */
 		realdent = (dir_entry *)slotptr2;
-		while ((__u8 *)slotptr2 > get_vfatname_block) {
+		while ((__u8 *)slotptr2 > fat_arena.vfat_block) {
 			slotptr2--;
 			slot2str(slotptr2, l_name, &idx);
 		}
@@ -532,13 +672,256 @@ static __u8 mkcksum (const char *str)
 }
 #endif	/* CONFIG_SUPPORT_VFAT */
 
+/*
+ * Hash a file name in a directory, for the directory cache.
+ */
+static __u32 fat_dcache_hash (__u32 dir, const char *name)
+{
+	__u32 hash = 2166136261u ^ dir;
+
+	while (*name) {
+		hash ^= (__u8)*name++;
+		hash *= 16777619;
+	}
+	return hash ^ (hash >> 16);
+}
+
+static int fat_dcache_addname (const char *name)
+{
+	int len = strlen(name) + 1;
+	int off = fat_arena.nnames;
+
+	if (off + len > FATDCACHE_NAMES)
+		return -1;
+	memcpy(fat_arena.names + off, name, len);
+	fat_arena.nnames += len;
+	return off;
+}
+
+static int fat_dcache_link (int entnum, __u32 dir, const char *name)
+{
+	__u32 slot = fat_dcache_hash(dir, name);
+	int i;
+
+	for (i = 0; i < FATDCACHE_HASH; i++, slot++) {
+		slot &= FATDCACHE_HASH - 1;
+		if (fat_arena.hash[slot] == 0) {
+			fat_arena.hash[slot] = entnum + 1;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/*
+ * Add a directory entry and its names to the directory cache.
+ * Return 0 on success, -1 if the cache is full.
+ */
+static int fat_dcache_add (__u32 dir, dir_entry *dentptr, const char *s_name,
+			   const char *l_name)
+{
+	fat_dcache_ent *ent;
+	int s_off, l_off;
+
+	if (fat_arena.nents == FATDCACHE_ENTRIES)
+		return -1;
+	/* two hash slots per entry, keep the table at most half full */
+	if (2 * (fat_arena.nents + 1) > FATDCACHE_HASH / 2)
+		return -1;
+
+	s_off = fat_dcache_addname(s_name);
+	l_off = *l_name ? fat_dcache_addname(l_name) : s_off;
+	if (s_off < 0 || l_off < 0)
+		return -1;
+
+	ent = &fat_arena.ents[fat_arena.nents];
+	memcpy(&ent->dent, dentptr, sizeof(dir_entry));
+	ent->dir = dir;
+	ent->s_name = s_off;
+	ent->l_name = l_off;
+	if (fat_dcache_link(fat_arena.nents, dir, s_name))
+		return -1;
+	if (l_off != s_off && fat_dcache_link(fat_arena.nents, dir, l_name))
+		return -1;
+	fat_arena.nents++;
+
+	return 0;
+}
+
+/*
+ * Decode every entry of the directory starting at cluster 'dir' (0 for
+ * the FAT12/16 root directory) into the directory cache.
+ * Return 0 on success, -1 if the directory cannot be read or does not
+ * fit in the cache.
+ */
+static int fat_dcache_fill (fsdata *mydata, __u32 dir)
+{
+	unsigned long bytesperclust = mydata->clust_size * SECTOR_SIZE;
+	__u32 curclust = dir;
+	__u32 rootsect = 0, rootsize = 0;
+	char s_name[14], l_name[VFAT_MAXLEN_BYTES];
+	int lfn_next = 0, lfn_done = 0;
+	__u8 lfn_cksum = 0;
+	dir_entry *dentptr;
+	int i, nents;
+
+	if (dir == 0)
+		rootsize = mydata->data_begin + 2 * mydata->clust_size -
+			   mydata->rootdir_sect;
+	l_name[0] = '\0';
+
+	while (1) {
+		if (dir == 0) {
+			if (rootsect >= rootsize)
+				break;
+			nents = rootsize - rootsect;
+			if (nents > MAX_CLUSTSIZE / SECTOR_SIZE)
+				nents = MAX_CLUSTSIZE / SECTOR_SIZE;
+			if (disk_read(mydata->rootdir_sect + rootsect, nents,
+				      fat_arena.block) < 0) {
+				debug("Error: reading rootdir block\n");
+				return -1;
+			}
+			rootsect += nents;
+			nents *= DIRENTSPERBLOCK;
+		} else {
+			if (get_cluster(mydata, curclust, fat_arena.block,
+					bytesperclust) != 0) {
+				debug("Error: reading directory block\n");
+				return -1;
+			}
+			nents = DIRENTSPERCLUST;
+		}
+
+		dentptr = (dir_entry *)fat_arena.block;
+		for (i = 0; i < nents; i++, dentptr++) {
+			if (dentptr->name[0] == 0)
+				goto done;
+			if (dentptr->name[0] == DELETED_FLAG) {
+				lfn_next = 0;
+				lfn_done = 0;
+				continue;
+			}
+#ifdef CONFIG_SUPPORT_VFAT
+			if ((dentptr->attr & ATTR_VFAT) == ATTR_VFAT) {
+				dir_slot *slotptr = (dir_slot *)dentptr;
+				int seq = slotptr->id & ~LAST_LONG_ENTRY_MASK;
+				int idx;
+
+				lfn_done = 0;
+				if (slotptr->id & LAST_LONG_ENTRY_MASK) {
+					if (seq == 0 || seq > VFAT_MAXSEQ) {
+						lfn_next = 0;
+						continue;
+					}
+					lfn_next = seq;
+					lfn_cksum = slotptr->alias_checksum;
+					l_name[seq * 13] = '\0';
+				}
+				if (seq != lfn_next ||
+				    slotptr->alias_checksum != lfn_cksum) {
+					lfn_next = 0;
+					continue;
+				}
+				idx = (seq - 1) * 13;
+				slot2str(slotptr, l_name, &idx);
+				if (--lfn_next == 0)
+					lfn_done = 1;
+				continue;
+			}
+#endif
+			if (dentptr->attr & ATTR_VOLUME) {
+				/* Volume label */
+				lfn_next = 0;
+				lfn_done = 0;
+				continue;
+			}
+
+			get_name(dentptr, s_name);
+#ifdef CONFIG_SUPPORT_VFAT
+			if (lfn_done && mkcksum(dentptr->name) == lfn_cksum) {
+				if (*l_name == DELETED_FLAG)
+					*l_name = '\0';
+				else if (*l_name == aRING)
+					*l_name = DELETED_FLAG;
+				downcase(l_name);
+			} else
+#endif
+				l_name[0] = '\0';
+			lfn_next = 0;
+			lfn_done = 0;
+
+			if (fat_dcache_add(dir, dentptr, s_name, l_name))
+				return -1;
+		}
+
+		if (dir != 0) {
+			curclust = get_fatent(mydata, curclust);
+			if (CHECK_CLUST(curclust, mydata->fatsize))
+				break;
+		}
+	}
+done:
+	fat_arena.dirs[fat_arena.ndirs++] = dir;
+	return 0;
+}
+
+/*
+ * Look up 'filename' in the directory starting at cluster 'dir' through
+ * the directory cache, decoding the directory into it first if needed.
+ * On a match copy the entry into 'retdent'.
+ * Return 1 if found, 0 if not, or -1 if the directory cannot be cached
+ * and has to be scanned instead.
+ */
+static int fat_lookup (fsdata *mydata, __u32 dir, const char *filename,
+		       dir_entry *retdent)
+{
+	fat_dcache_ent *ent;
+	__u32 slot;
+	int i;
+
+	/* ".." of a top level directory points at cluster 0 */
+	if (dir == 0 && mydata->fatsize == 32)
+		dir = mydata->root_cluster;
+
+	for (i = 0; i < fat_arena.ndirs; i++)
+		if (fat_arena.dirs[i] == dir)
+			break;
+	if (i == fat_arena.ndirs) {
+		/* start over when full, a single directory may still fit */
+		if (fat_arena.ndirs == FATDCACHE_DIRS ||
+		    fat_dcache_fill(mydata, dir) != 0) {
+			fat_dcache_reset();
+			if (fat_dcache_fill(mydata, dir) != 0) {
+				debug("FAT dcache: cannot index dir 0x%x\n",
+				      dir);
+				fat_dcache_reset();
+				return -1;
+			}
+		}
+	}
+
+	slot = fat_dcache_hash(dir, filename);
+	for (i = 0; i < FATDCACHE_HASH; i++, slot++) {
+		slot &= FATDCACHE_HASH - 1;
+		if (fat_arena.hash[slot] == 0)
+			break;
+		ent = &fat_arena.ents[fat_arena.hash[slot] - 1];
+		if (ent->dir != dir)
+			continue;
+		if (strcmp(filename, fat_arena.names + ent->s_name) &&
+		    strcmp(filename, fat_arena.names + ent->l_name))
+			continue;
+		memcpy(retdent, &ent->dent, sizeof(dir_entry));
+		return 1;
+	}
+	return 0;
+}
+
 /*
  * Get the directory entry associated with 'filename' from the directory
  * starting at 'startsect'
  */
-__attribute__ ((__aligned__ (__alignof__ (dir_entry))))
-__u8 get_dentfromdir_block[MAX_CLUSTSIZE];
-
 static dir_entry *get_dentfromdir (fsdata *mydata, int startsect,
 				   char *filename, dir_entry *retdent,
 				   int dols)
@@ -549,18 +932,27 @@ static dir_entry *get_dentfromdir (fsdata *mydata, int startsect,
 
 	debug("get_dentfromdir: %s\n", filename);
 
+	if (!dols && *filename) {
+		switch (fat_lookup(mydata, curclust, filename, retdent)) {
+		case 1:
+			return retdent;
+		case 0:
+			return NULL;
+		}
+	}
+
 	while (1) {
 		dir_entry *dentptr;
 
 		int i;
 
-		if (get_cluster(mydata, curclust, get_dentfromdir_block,
+		if (get_cluster(mydata, curclust, fat_arena.block,
 				mydata->clust_size * SECTOR_SIZE) != 0) {
 			debug("Error: reading directory block\n");
 			return NULL;
 		}
 
-		dentptr = (dir_entry *)get_dentfromdir_block;
+		dentptr = (dir_entry *)fat_arena.block;
 
 		for (i = 0; i < DIRENTSPERCLUST; i++) {
 			char s_name[14], l_name[VFAT_MAXLEN_BYTES];
@@ -576,7 +968,7 @@ static dir_entry *get_dentfromdir (fsdata *mydata, int startsect,
 				    (dentptr-> name[0] & LAST_LONG_ENTRY_MASK)) {
 					prevcksum = ((dir_slot *)dentptr)->alias_checksum;
 					get_vfatname(mydata, curclust,
-						     get_dentfromdir_block,
+						     fat_arena.block,
 						     dentptr, l_name);
 					if (dols) {
 						int isdir;
@@ -752,9 +1144,6 @@ read_bootsectandvi (boot_sector *bs, volume_info *volinfo, int *fatsize)
 	return -1;
 }
 
-__attribute__ ((__aligned__ (__alignof__ (dir_entry))))
-__u8 do_fat_read_block[MAX_CLUSTSIZE];
-
 long
 do_fat_read (const char *filename, void *buffer, unsigned long maxsize,
 	     int dols)
@@ -765,6 +1154,7 @@ do_fat_read (const char *filename, void *buffer, unsigned long maxsize,
 	fsdata datablock;
 	fsdata *mydata = &datablock;
 	dir_entry *dentptr;
+	dir_entry rootdent;
 	__u16 prevcksum = 0xffff;
 	char *subname = "";
 	int cursect;
@@ -781,6 +1171,7 @@ do_fat_read (const char *filename, void *buffer, unsigned long maxsize,
 	}
 
 	root_cluster = bs.root_cluster;
+	mydata->root_cluster = root_cluster;
 
 	if (mydata->fatsize == 32)
 		mydata->fatlength = bs.fat32_length;
@@ -810,6 +1201,7 @@ do_fat_read (const char *filename, void *buffer, unsigned long maxsize,
 	}
 
 	mydata->fatbufnum = -1;
+	fat_cache_check(mydata, &volinfo);
 
 #ifdef CONFIG_SUPPORT_VFAT
 	debug("VFAT Support enabled\n");
@@ -848,6 +1240,19 @@ do_fat_read (const char *filename, void *buffer, unsigned long maxsize,
 		isdir = 1;
 	}
 
+	if (dols != LS_ROOT) {
+		switch (fat_lookup(mydata, (mydata->fatsize == 32) ?
+				   root_cluster : 0, fnamecopy, &rootdent)) {
+		case 1:
+			if (isdir && !(rootdent.attr & ATTR_DIR))
+				return -1;
+			dentptr = &rootdent;
+			goto rootdir_done;
+		case 0:
+			return -1;
+		}
+	}
+
 	j = 0;
 	while (1) {
 		int i;
@@ -859,12 +1264,12 @@ do_fat_read (const char *filename, void *buffer, unsigned long maxsize,
 				(mydata->fatsize == 32) ?
 				(mydata->clust_size) :
 				LINEAR_PREFETCH_SIZE / SECTOR_SIZE,
-				do_fat_read_block) < 0) {
+				fat_arena.block) < 0) {
 			debug("Error: reading rootdir block\n");
 			return -1;
 		}
 
-		dentptr = (dir_entry *) do_fat_read_block;
+		dentptr = (dir_entry *) fat_arena.block;
 
 		for (i = 0; i < DIRENTSPERBLOCK; i++) {
 			char s_name[14], l_name[VFAT_MAXLEN_BYTES];
@@ -885,7 +1290,7 @@ do_fat_read (const char *filename, void *buffer, unsigned long maxsize,
 						     (mydata->fatsize == 32) ?
 						     root_cluster :
 						     0,
-						     do_fat_read_block,
+						     fat_arena.block,
 						     dentptr, l_name);
 
 					if (dols == LS_ROOT) {
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef _ARENA_H
+#define _ARENA_H
+
+/*
+ * Scoped allocation for commands
+ *
+ * Memory from arena_alloc() is not freed one block at a time. Instead
+ * arena_mark() notes how far the arena has grown and arena_release()
+ * frees everything allocated since. cmd_call() does this around each
+ * command, so that a command can take what it needs for its own use
+ * without freeing it on every path out. Memory that must outlive the
+ * command has to come from malloc().
+ *
+ * Marks nest: a command that runs other commands keeps what it allocated
+ * before them.
+ */
+
+struct arena_block;
+
+struct arena_mark {
+	struct arena_block *block;	/* newest block when the mark was made */
+	ulong used;			/* bytes used in it then */
+};
+
+/**
+ * Allocate memory that lasts until the current command returns.
+ *
+ * @param size		Number of bytes needed
+ * @return pointer to the memory, aligned for any type, or NULL if there
+ *		is no room
+ */
+void *arena_alloc(size_t size);
+
+/**
+ * Allocate zeroed memory that lasts until the current command returns.
+ *
+ * @param size		Number of bytes needed
+ * @return pointer to the memory, or NULL if there is no room
+ */
+void *arena_zalloc(size_t size);
+
+/**
+ * Copy a string into memory that lasts until the current command returns.
+ *
+ * @param s		String to copy
+ * @return pointer to the copy, or NULL if there is no room
+ */
+char *arena_strdup(const char *s);
+
+/**
+ * Note the current extent of the arena.
+ *
+ * @param mark		Returns the extent, to be passed to arena_release()
+ */
+void arena_mark(struct arena_mark *mark);
+
+/**
+ * Free everything allocated from the arena since a mark was made.
+ *
+ * @param mark		Mark from arena_mark(); later marks are no longer valid
+ */
+void arena_release(const struct arena_mark *mark);
+
+#endif
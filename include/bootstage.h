@@ -26,6 +26,10 @@
 /*
  * These are the things that can be timestamped. There are some pre-defined
  * by U-Boot, and some which are user defined.
+ *
+ * Each id can either be marked once (bootstage_mark()) or used as a span
+ * (bootstage_start() / bootstage_accum()) which may be entered many times
+ * and may nest inside other spans.
  */
 enum bootstage_id {
 	BOOTSTAGE_AWAKE,
@@ -39,6 +43,12 @@ enum bootstage_id {
 	BOOTSTAGE_BOOTM_START,
 	BOOTSTAGE_BOOTM_HANDOFF,
 
+	/* Accumulated spans */
+	BOOTSTAGE_MMC_READ,
+	BOOTSTAGE_SPI_XFER,
+	BOOTSTAGE_VBOOT_HASH_BODY,
+	BOOTSTAGE_FDT_INDEX,
+
 	/* a few spare for the user, from here */
 	BOOTSTAGE_USER,
 
@@ -46,9 +56,51 @@ enum bootstage_id {
 	 * Total number of entries - increase this at the cost of some BSS
 	 * and ATAG space.
 	 */
-	BOOTSTAGE_COUNT = 10
+	BOOTSTAGE_COUNT = BOOTSTAGE_USER + 6,
+
+	/* Used as the parent of a span which is not nested */
+	BOOTSTAGE_NONE = 0xff,
+};
+
+/* Record flags */
+enum bootstage_flags {
+	BOOTSTAGEF_SPAN		= 1 << 0,	/* record is a start/stop span */
+	BOOTSTAGEF_OVERFLOW	= 1 << 1,	/* nested deeper than we track */
 };
 
+/* Maximum span nesting depth that we keep track of */
+#define BOOTSTAGE_MAX_DEPTH	8
+
+/*
+ * Exported binary format, used for the crossystem data blob. All fields
+ * are in CPU byte order.
+ */
+#define BOOTSTAGE_MAGIC		0xb00757a3
+#define BOOTSTAGE_VERSION	1
+#define BOOTSTAGE_NAME_LEN	20
+
+struct bootstage_hdr {
+	uint32_t magic;		/* BOOTSTAGE_MAGIC */
+	uint32_t version;	/* BOOTSTAGE_VERSION */
+	uint32_t count;		/* number of records which follow */
+	uint32_t size;		/* total size of header and records */
+};
+
+struct bootstage_export_record {
+	uint32_t time_us;	/* time of mark, or of first span start */
+	uint32_t accum_us;	/* total time spent inside the span */
+	uint32_t count;		/* number of times the span was entered */
+	uint8_t id;		/* enum bootstage_id */
+	uint8_t flags;		/* enum bootstage_flags */
+	uint8_t parent;		/* enclosing span, or BOOTSTAGE_NONE */
+	uint8_t depth;		/* nesting depth of the span */
+	char name[BOOTSTAGE_NAME_LEN];
+};
+
+/* Space needed to export every record */
+#define BOOTSTAGE_EXPORT_SIZE	(sizeof(struct bootstage_hdr) + \
+		BOOTSTAGE_COUNT * sizeof(struct bootstage_export_record))
+
 #ifdef CONFIG_BOOTSTAGE
 
 /*
@@ -56,15 +108,65 @@ enum bootstage_id {
  */
 uint32_t bootstage_mark(enum bootstage_id id, const char *name);
 
+/**
+ * Start timing a span. Spans may be entered many times; each entry adds
+ * to the total. A span started while another is open is recorded as its
+ * child. Re-entering a span which is already open only bumps its count.
+ *
+ * @param id	Span id
+ * @param name	Name of span (only the first name used is kept)
+ * @return time of the start, in microseconds
+ */
+uint32_t bootstage_start(enum bootstage_id id, const char *name);
+
+/**
+ * Stop timing a span started with bootstage_start() and add the elapsed
+ * time to its total.
+ *
+ * @param id	Span id
+ * @return total time accumulated in this span so far, in microseconds
+ */
+uint32_t bootstage_accum(enum bootstage_id id);
+
 /* Print a report about boot time */
 void bootstage_report(void);
 
+/**
+ * Export all records in the binary format described by struct
+ * bootstage_hdr.
+ *
+ * @param buf	Buffer to write to
+ * @param size	Size of buffer, BOOTSTAGE_EXPORT_SIZE is always enough
+ * @return number of bytes written, or -1 if the buffer is too small
+ */
+int bootstage_export(void *buf, int size);
+
+/**
+ * Add a /chosen/bootstage node to a device tree, with one subnode per
+ * record. The tree must already have room for the new nodes.
+ *
+ * @param blob	Device tree to update
+ * @return 0 if ok, -1 on error
+ */
+int bootstage_fdt_add_report(void *blob);
+
 #else
 
 static inline uint32_t bootstage_mark(enum bootstage_id id, const char *name)
 { return 0; }
 
-#endif
+static inline uint32_t bootstage_start(enum bootstage_id id, const char *name)
+{ return 0; }
+
+static inline uint32_t bootstage_accum(enum bootstage_id id)
+{ return 0; }
+
+static inline int bootstage_export(void *buf, int size)
+{ return -1; }
+
+static inline int bootstage_fdt_add_report(void *blob)
+{ return 0; }
 
 #endif
 
+#endif
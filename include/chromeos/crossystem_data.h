@@ -50,6 +50,7 @@ typedef struct {
 	char		frid[ID_LEN];
 	uint32_t	fmap_base;
 	uint8_t		vbshared_data[VB_SHARED_DATA_REC_SIZE];
+	uint8_t		bootstage[BOOTSTAGE_EXPORT_SIZE];
 } crossystem_data_t;
 
 /**
@@ -112,7 +112,7 @@ typedef unsigned int uint;
 #include <asm/byteorder.h>
 
 /* Types for `void *' pointers. */
-#if __WORDSIZE == 64
+#if __WORDSIZE == 64 || defined(__LP64__)
 typedef unsigned long int       uintptr_t;
 #else
 typedef unsigned int            uintptr_t;
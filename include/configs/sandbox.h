@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+
+#ifndef __CONFIG_H
+#define __CONFIG_H
+
+/*
+ * The sandbox runs U-Boot as an ordinary Linux program. Its devices are
+ * backed by files and a tap interface given on the command line (see
+ * arch/sandbox/cpu/start.c), so that the storage, network and verified
+ * boot code can be run, timed and profiled on a workstation.
+ */
+
+#define CONFIG_SYS_NO_FLASH
+
+/* Record boot time, from the host's clock */
+#define CONFIG_BOOTSTAGE
+#define CONFIG_BOOTSTAGE_REPORT
+
+/* RAM, mapped at a fixed address so that addresses can be pointers */
+#define CONFIG_NR_DRAM_BANKS		1
+#define CONFIG_SYS_SDRAM_BASE		0x10000000
+#define CONFIG_SYS_SDRAM_SIZE		(128 << 20)
+#define CONFIG_SYS_MALLOC_LEN		(4 << 20)	/* 4MB  */
+#define CONFIG_SYS_MALLOC_SLAB		/* small objects in their own pages */
+#define CONFIG_SYS_MEMTEST_START	CONFIG_SYS_SDRAM_BASE
+#define CONFIG_SYS_MEMTEST_END		(CONFIG_SYS_SDRAM_BASE + (64 << 20))
+#define CONFIG_SYS_LOAD_ADDR		(CONFIG_SYS_SDRAM_BASE + 0x100000)
+#define CONFIG_LOADADDR			0x10100000
+#define CONFIG_SYS_HZ			1000
+
+/* Console on the process's stdin and stdout */
+#define CONFIG_SANDBOX_SERIAL
+#define CONFIG_BAUDRATE			115200
+#define CONFIG_SYS_BAUDRATE_TABLE	{4800, 9600, 19200, 38400, 57600,\
+					115200}
+
+#define CONFIG_ENV_IS_NOWHERE
+#define CONFIG_ENV_SIZE			8192
+#define CONFIG_ENV_OVERWRITE
+
+#define CONFIG_CMDLINE_EDITING
+#define CONFIG_COMMAND_HISTORY
+#define CONFIG_AUTOCOMPLETE
+#define CONFIG_SYS_HUSH_PARSER
+#define CONFIG_SYS_PROMPT_HUSH_PS2	"> "
+#define CONFIG_SYS_LONGHELP
+#define CONFIG_SYS_PROMPT		"=> "
+#define CONFIG_SYS_CBSIZE		1024
+#define CONFIG_SYS_PBSIZE		(CONFIG_SYS_CBSIZE + \
+					sizeof(CONFIG_SYS_PROMPT) + 16)
+#define CONFIG_SYS_MAXARGS		16
+#define CONFIG_SYS_BARGSIZE		CONFIG_SYS_CBSIZE
+
+#define CONFIG_BOOTDELAY		-1	/* no autoboot */
+
+/* Commands */
+#include <config_cmd_default.h>
+#undef CONFIG_CMD_FPGA
+#undef CONFIG_CMD_IMLS
+#undef CONFIG_CMD_LOADB
+#undef CONFIG_CMD_LOADS
+#undef CONFIG_CMD_NFS
+#undef CONFIG_CMD_SAVEENV
+#undef CONFIG_CMD_FLASH
+#undef CONFIG_CMD_SETGETDCR
+
+#define CONFIG_CMD_TIME
+#define CONFIG_CMD_BENCH
+#define CONFIG_DECOMPRESS_STREAM
+#define CONFIG_CMD_HEAP
+#define CONFIG_CMD_FDT
+#define CONFIG_OF_LIBFDT
+#define CONFIG_OF_INDEX
+
+/* Everything "bench" can time */
+#define CONFIG_LZMA
+#define CONFIG_LZO
+#define CONFIG_BZIP2
+#define CONFIG_MD5
+#define CONFIG_SHA1
+#define CONFIG_SHA256
+
+/* Storage: file systems and partitions on the host, SD and USB devices */
+#define CONFIG_DOS_PARTITION
+#define CONFIG_EFI_PARTITION
+#define CONFIG_CMD_FAT
+#define CONFIG_CMD_EXT2
+
+#define CONFIG_MMC
+#define CONFIG_GENERIC_MMC
+#define CONFIG_SANDBOX_MMC
+#define CONFIG_CMD_MMC
+
+#define CONFIG_USB_SANDBOX
+#define CONFIG_USB_STORAGE
+#define CONFIG_USB_BULK_QUEUE
+#define CONFIG_CMD_USB
+
+/* Network, over a tap interface */
+#define CONFIG_NET_MULTI
+#define CONFIG_SANDBOX_ETH
+#define CONFIG_CMD_PING
+#define CONFIG_CMD_DHCP
+#define CONFIG_CMD_DNS
+#define CONFIG_CMD_HTTP
+#define CONFIG_BOOTP_SUBNETMASK
+#define CONFIG_BOOTP_GATEWAY
+#define CONFIG_BOOTP_DNS
+#define CONFIG_TFTP_WINDOWSIZE		8
+
+/* SPI flash */
+#define CONFIG_SANDBOX_SPI
+#define CONFIG_SPI_FLASH
+#define CONFIG_SPI_FLASH_WINBOND
+#define CONFIG_CMD_SF
+
+#endif
@@ -176,6 +176,7 @@
 #define CONFIG_EFI_PARTITION
 #define CONFIG_CMD_EXT2
 #define CONFIG_CMD_FAT
+#define CONFIG_SYS_FAT_CACHE_WINDOWS	16	/* 192KB, all of a FAT16 */
 
 /* Environment in SPI */
 #define CONFIG_ENV_IS_IN_SPI_FLASH
@@ -36,6 +36,7 @@
 /* FDT support */
 #define CONFIG_OF_LIBFDT	/* Device tree support */
 #define CONFIG_OF_CONTROL	/* Use the device tree to set up U-Boot */
+#define CONFIG_OF_INDEX		/* Index it for faster lookups */
 
 /* Embed the device tree in U-Boot, if not otherwise handled */
 #ifndef CONFIG_OF_SEPARATE
@@ -51,6 +52,7 @@
 #define CONFIG_SYS_NO_L2CACHE		/* No L2 cache */
 #define CONFIG_BOOTSTAGE		/* Record boot time */
 #define CONFIG_BOOTSTAGE_REPORT		/* Print a boot time report */
+#define CONFIG_BOOTSTAGE_FDT		/* Pass boot time to kernel in FDT */
 #define CONFIG_ARCH_CPU_INIT		/* Fire up the A9 core */
 #define CONFIG_ALIGN_LCD_TO_SECTION	/* Align LCD to 1MB boundary */
 #define CONFIG_BOARD_EARLY_INIT_F
@@ -74,6 +76,7 @@
  * Size of malloc() pool
  */
 #define CONFIG_SYS_MALLOC_LEN		(4 << 20)	/* 4MB  */
+#define CONFIG_SYS_MALLOC_SLAB		/* small objects in their own pages */
 
 /*
  * PllX Configuration
@@ -130,6 +133,7 @@
 
 #define CONFIG_EHCI_IS_TDI
 #define CONFIG_EHCI_DCACHE
+
 #define CONFIG_USB_STORAGE
 #define CONFIG_USB_STOR_NO_RETRY
 
@@ -140,7 +144,10 @@
 #define CONFIG_EFI_PARTITION
 #define CONFIG_CMD_EXT2
 
-/* support USB ethernet adapters */
+/*
+ * support USB ethernet adapters. ASIX receives TFTP data in place, but only
+ * when loadaddr is 2 mod 4; see "TFTP Receive In Place" in the README.
+ */
 #define CONFIG_USB_HOST_ETHER
 #define CONFIG_USB_ETHER_ASIX
 
@@ -156,6 +163,9 @@
 
 #define CONFIG_CMD_CACHE
 #define CONFIG_CMD_TIME
+#define CONFIG_CMD_HEAP
+#define CONFIG_CMD_BENCH	/* compare the speed of firmware builds */
+#define CONFIG_DECOMPRESS_STREAM	/* needed by bench */
 
 /*
  * Ethernet support
@@ -174,6 +184,7 @@
 #define CONFIG_BOOTP_BOOTPATH
 #define CONFIG_TFTP_TSIZE
 #define CONFIG_TFTP_SPEED
+#define CONFIG_TFTP_WINDOWSIZE	8
 
 #define CONFIG_IPADDR		10.0.0.2
 #define CONFIG_SERVERIP		10.0.0.1
@@ -471,6 +482,7 @@
 
 /* kernel Device tree booting support */
 #define CONFIG_FIT	1
+#define CONFIG_SHA256		/* FIT images may use sha256 hashes */
 #define CONFIG_CMD_IMI	1
 
 /*
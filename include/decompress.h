@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef _DECOMPRESS_H
+#define _DECOMPRESS_H
+
+/*
+ * Streaming decompression. The caller pushes compressed data in chunks of
+ * any size as it arrives (e.g. from a storage or network read loop) and the
+ * decompressed data is written straight to the output buffer, where
+ * out_len bytes are valid at any time. No copy of the whole compressed
+ * image is needed; only small per-algorithm state is kept on the heap.
+ *
+ * Supported formats are gzip (IH_COMP_GZIP), LZMA 'alone' (IH_COMP_LZMA)
+ * and lzop (IH_COMP_LZO), subject to CONFIG_GZIP, CONFIG_LZMA and
+ * CONFIG_LZO.
+ */
+
+struct decomp_stream {
+	int comp;		/* IH_COMP_... */
+	uint8_t *dst;		/* output buffer */
+	ulong dst_size;		/* size of output buffer */
+	ulong out_len;		/* bytes written to the output so far */
+	ulong in_len;		/* compressed bytes consumed so far */
+	ulong mem_used;		/* heap currently used by the decompressor */
+	ulong mem_peak;		/* most heap used at any one time */
+	int done;		/* end of compressed stream seen */
+	void *priv;		/* per-algorithm state */
+};
+
+/**
+ * Start a new decompression.
+ *
+ * @param s		Stream to set up
+ * @param comp		Compression type (IH_COMP_...)
+ * @param dst		Output buffer
+ * @param dst_size	Size of output buffer
+ * @return 0 if ok, -1 if the compression type is not supported or
+ * there is no memory
+ */
+int decomp_start(struct decomp_stream *s, int comp, void *dst, ulong dst_size);
+
+/**
+ * Push a chunk of compressed data. All of it is consumed unless the end of
+ * the stream is reached part way through.
+ *
+ * @param s		Stream from decomp_start()
+ * @param src		Compressed data
+ * @param len		Number of bytes of compressed data
+ * @return 1 if the end of the stream has been reached, 0 if more data is
+ * needed, -1 on error (bad data or output buffer too small)
+ */
+int decomp_push(struct decomp_stream *s, const void *src, ulong len);
+
+/**
+ * Finish a decompression and free its state. This must be called even if
+ * decomp_push() failed.
+ *
+ * @param s		Stream from decomp_start()
+ * @return 0 if the whole stream was decompressed, -1 if it was cut short
+ */
+int decomp_end(struct decomp_stream *s);
+
+/**
+ * Decompress a buffer which is already in memory, pushing it in chunks
+ * (which also keeps the watchdog happy).
+ *
+ * @param comp		Compression type (IH_COMP_...)
+ * @param dst		Output buffer
+ * @param dst_size	Size of output buffer
+ * @param src		Compressed data
+ * @param src_len	Number of bytes of compressed data
+ * @param out_len	Returns number of bytes written to dst
+ * @param mem_peak	If not NULL, returns the peak heap usage
+ * @return 0 if ok, -1 on error
+ */
+int decomp_buffer(int comp, void *dst, ulong dst_size, const void *src,
+		ulong src_len, ulong *out_len, ulong *mem_peak);
+
+#endif /* _DECOMPRESS_H */
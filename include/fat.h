@@ -47,12 +47,29 @@
 #define DIRENTSPERBLOCK	(FS_BLOCK_SIZE/sizeof(dir_entry))
 #define DIRENTSPERCLUST	((mydata->clust_size*SECTOR_SIZE)/sizeof(dir_entry))
 
-#define FATBUFBLOCKS	6
+/* FAT window size, a multiple of 3 sectors to keep FAT12 entries whole */
+#define FATBUFBLOCKS	24
 #define FATBUFSIZE	(FS_BLOCK_SIZE*FATBUFBLOCKS)
 #define FAT12BUFSIZE	((FATBUFSIZE*2)/3)
 #define FAT16BUFSIZE	(FATBUFSIZE/2)
 #define FAT32BUFSIZE	(FATBUFSIZE/4)
 
+/* Number of FAT windows cached, a whole FAT is kept if it fits */
+#ifdef CONFIG_SYS_FAT_CACHE_WINDOWS
+#define FATBUFWINDOWS	CONFIG_SYS_FAT_CACHE_WINDOWS
+#else
+#define FATBUFWINDOWS	4
+#endif
+
+/* Cluster runs mapped at a time when reading a file */
+#define FATRUNS		32
+
+/* Directory entry cache, see fat_lookup() */
+#define FATDCACHE_DIRS		16	/* Directories indexed */
+#define FATDCACHE_ENTRIES	512	/* Entries in all of them */
+#define FATDCACHE_HASH		2048	/* Hash slots, a power of 2 */
+#define FATDCACHE_NAMES		16384	/* Bytes of short and long names */
+
 
 /* Filesystem identifiers */
 #define FAT12_SIGN	"FAT12   "
@@ -174,20 +191,32 @@ typedef struct dir_slot {
 	__u8	name11_12[4];	/* Last 2 characters in name */
 } dir_slot;
 
+/* A run of consecutive clusters of a file */
+typedef struct {
+	__u32	start;		/* First cluster */
+	__u32	count;		/* Number of clusters */
+} fat_run;
+
+/* A directory entry in the directory cache */
+typedef struct {
+	dir_entry dent;
+	__u32	dir;		/* First cluster of its directory */
+	__u16	s_name;		/* Short name, offset into the name pool */
+	__u16	l_name;		/* Long name, the same if there is none */
+} fat_dcache_ent;
+
 /*
  * Private filesystem parameters
- *
- * Note: FAT buffer has to be 32 bit aligned
- * (see FAT32 accesses)
  */
 typedef struct {
-	__u8	fatbuf[FATBUFSIZE]; /* Current FAT buffer */
+	__u8	*fatbuf;	/* Current FAT window, from the FAT cache */
 	int	fatsize;	/* Size of FAT in bits */
 	__u16	fatlength;	/* Length of FAT in sectors */
 	__u16	fat_sect;	/* Starting sector of the FAT */
 	__u16	rootdir_sect;	/* Start sector of root directory */
 	__u16	clust_size;	/* Size of clusters in sectors */
 	short	data_begin;	/* The sector of the first cluster, can be negative */
+	__u32	root_cluster;	/* First cluster of the root directory (FAT32) */
 	int	fatbufnum;	/* Used by get_fatent, init to -1 */
 } fsdata;
 
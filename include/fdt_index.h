@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef _FDT_INDEX_H
+#define _FDT_INDEX_H
+
+/*
+ * A lookup index for a device tree blob
+ *
+ * libfdt finds a node by path, phandle or compatible string by walking
+ * the structure block from the start. Once an index has been built for a
+ * blob, fdt_path_offset(), fdt_subnode_offset_namelen(),
+ * fdt_get_alias_namelen(), fdt_node_offset_by_phandle() and
+ * fdt_node_offset_by_compatible() answer from the index instead, giving
+ * the same results. Any change made to the blob through fdt_rw or
+ * fdt_wip drops its index. So does loading something else over the blob,
+ * which the first lookup after the next command finds from its CRC32.
+ *
+ * The lookup functions below are called by libfdt. Each returns 0 if
+ * the blob has no index, in which case libfdt does the walk itself.
+ */
+
+/**
+ * Build an index for a device tree blob.
+ *
+ * The blob must not move while the index is in use. Only a couple of
+ * blobs are indexed at once; building another drops the oldest index.
+ *
+ * @param blob		Device tree blob
+ * @return 0 if ok, -FDT_ERR_... on error, in which case lookups in the
+ *			blob are not indexed
+ */
+int fdt_index_build(const void *blob);
+
+/**
+ * Drop the index for a blob, if there is one.
+ *
+ * @param blob		Device tree blob
+ */
+void fdt_index_invalidate(const void *blob);
+
+/**
+ * Have the next lookup in each indexed blob check that the blob has not
+ * changed, and drop its index if it has. This is called after each
+ * command, since a command can load over a blob without using libfdt.
+ */
+void fdt_index_recheck(void);
+
+/**
+ * Look up a path, as fdt_path_offset() does.
+ *
+ * @param blob		Device tree blob
+ * @param path		Path, or alias followed by an optional path
+ * @param offsetp	Returns the node offset or -FDT_ERR_... error
+ * @return 1 if the blob is indexed, else 0
+ */
+int fdt_index_path_offset(const void *blob, const char *path, int *offsetp);
+
+/**
+ * Look up a subnode by name, as fdt_subnode_offset_namelen() does.
+ *
+ * @param blob		Device tree blob
+ * @param offsetp	Offset of the parent node; returns the subnode
+ *			offset or -FDT_ERR_... error
+ * @param name		Name of the subnode
+ * @param namelen	Length of name
+ * @return 1 if the blob is indexed, else 0
+ */
+int fdt_index_subnode_offset(const void *blob, int *offsetp,
+			     const char *name, int namelen);
+
+/**
+ * Look up an alias, as fdt_get_alias_namelen() does.
+ *
+ * @param blob		Device tree blob
+ * @param name		Alias name
+ * @param namelen	Length of name
+ * @param valuep	Returns the path the alias stands for, or NULL
+ * @return 1 if the blob is indexed, else 0
+ */
+int fdt_index_get_alias(const void *blob, const char *name, int namelen,
+			const char **valuep);
+
+/**
+ * Find the node with a phandle, as fdt_node_offset_by_phandle() does.
+ *
+ * @param blob		Device tree blob
+ * @param phandle	Phandle, not 0 or -1
+ * @param offsetp	Returns the node offset or -FDT_ERR_NOTFOUND
+ * @return 1 if the blob is indexed, else 0
+ */
+int fdt_index_node_by_phandle(const void *blob, uint32_t phandle,
+			      int *offsetp);
+
+/**
+ * Find the next node with a compatible string, as
+ * fdt_node_offset_by_compatible() does.
+ *
+ * @param blob		Device tree blob
+ * @param startoffset	Only find nodes after this one; -1 for all
+ * @param compatible	String to find in the node's compatible property
+ * @param offsetp	Returns the node offset or -FDT_ERR_NOTFOUND
+ * @return 1 if the blob is indexed, else 0
+ */
+int fdt_index_node_by_compatible(const void *blob, int startoffset,
+				 const char *compatible, int *offsetp);
+
+#endif
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef _HASH_H
+#define _HASH_H
+
+#include <compiler.h>
+#include <sha1.h>
+#include <sha256.h>
+#include <u-boot/md5.h>
+
+/*
+ * A common streaming interface to the hash algorithms in lib/. A caller
+ * initialises a context for one algorithm, feeds it data with hash_update()
+ * as it becomes available (e.g. one block at a time as it is read from
+ * storage) and then collects the digest with hash_finish().
+ *
+ * Digests are written in the byte order used in FIT images, so a CRC32 is
+ * stored big-endian.
+ */
+
+enum hash_algo {
+	HASH_ALGO_CRC32,
+	HASH_ALGO_MD5,
+	HASH_ALGO_SHA1,
+	HASH_ALGO_SHA256,
+
+	HASH_ALGO_COUNT,
+};
+
+/* Largest digest produced by any algorithm (SHA-256) */
+#define HASH_MAX_DIGEST_SIZE	32
+
+/* Amount of data hashed between watchdog resets */
+#define HASH_CHUNK_SIZE		(64 * 1024)
+
+struct hash_ctx {
+	enum hash_algo algo;
+	union {
+		uint32_t crc;
+		struct MD5Context md5;
+		sha1_context sha1;
+		sha256_context sha256;
+	} u;
+};
+
+/**
+ * Look up a hash algorithm by name.
+ *
+ * @param name		Algorithm name as used in FIT images ("crc32", "md5",
+ *			"sha1" or "sha256")
+ * @return algorithm, or -1 if unknown or not compiled in
+ */
+int hash_lookup_algo(const char *name);
+
+/**
+ * Return the name of a hash algorithm.
+ *
+ * @param algo		Algorithm
+ * @return name, or NULL if invalid
+ */
+const char *hash_algo_name(enum hash_algo algo);
+
+/**
+ * Return the size of the digest produced by a hash algorithm.
+ *
+ * @param algo		Algorithm
+ * @return digest size in bytes, or -1 if invalid
+ */
+int hash_digest_size(enum hash_algo algo);
+
+/**
+ * Start a new hash calculation.
+ *
+ * @param ctx		Context to initialise
+ * @param algo		Algorithm to use
+ * @return 0 if ok, -1 if the algorithm is not supported
+ */
+int hash_init(struct hash_ctx *ctx, enum hash_algo algo);
+
+/**
+ * Add data to a hash calculation. The watchdog is reset every
+ * HASH_CHUNK_SIZE bytes.
+ *
+ * @param ctx		Context from hash_init()
+ * @param buf		Data to add
+ * @param len		Number of bytes to add
+ */
+void hash_update(struct hash_ctx *ctx, const void *buf, unsigned int len);
+
+/**
+ * Finish a hash calculation and write out the digest. The context must be
+ * initialised again before it can be reused.
+ *
+ * @param ctx		Context from hash_init()
+ * @param digest	Place to put digest (HASH_MAX_DIGEST_SIZE bytes is
+ *			always enough)
+ * @return digest size in bytes
+ */
+int hash_finish(struct hash_ctx *ctx, uint8_t *digest);
+
+/**
+ * Calculate the hash of a single buffer.
+ *
+ * @param algo		Algorithm to use
+ * @param buf		Data to hash
+ * @param len		Number of bytes to hash
+ * @param digest	Place to put digest
+ * @return digest size in bytes, or -1 if the algorithm is not supported
+ */
+int hash_block(enum hash_algo algo, const void *buf, unsigned int len,
+		uint8_t *digest);
+
+/**
+ * Copy a buffer and add it to a hash calculation in the same pass, so that
+ * each chunk is hashed while it is still in the cache. Chunks are copied in
+ * ascending address order, so the regions may only overlap if @to is below
+ * @from.
+ *
+ * @param ctx		Context from hash_init()
+ * @param to		Destination address
+ * @param from		Source address
+ * @param len		Number of bytes to copy and hash
+ */
+void hash_memmove(struct hash_ctx *ctx, void *to, const void *from,
+		unsigned int len);
+
+#endif /* _HASH_H */
@@ -106,6 +106,7 @@
 #define IH_ARCH_BLACKFIN	16	/* Blackfin	*/
 #define IH_ARCH_AVR32		17	/* AVR32	*/
 #define IH_ARCH_ST200	        18	/* STMicroelectronics ST200  */
+#define IH_ARCH_SANDBOX		19	/* Sandbox architecture (test only) */
 
 /*
  * Image Types
@@ -504,6 +505,8 @@ static inline int image_check_target_arch (const image_header_t *hdr)
 	if (!image_check_arch (hdr, IH_ARCH_SH))
 #elif defined(__sparc__)
 	if (!image_check_arch (hdr, IH_ARCH_SPARC))
+#elif defined(CONFIG_SANDBOX)
+	if (!image_check_arch (hdr, IH_ARCH_SANDBOX))
 #else
 # error Unknown CPU type
 #endif
@@ -543,7 +546,7 @@ static inline int image_check_target_arch (const image_header_t *hdr)
 #define FIT_FDT_PROP		"fdt"
 #define FIT_DEFAULT_PROP	"default"
 
-#define FIT_MAX_HASH_LEN	20	/* max(crc32_len(4), sha1_len(20)) */
+#define FIT_MAX_HASH_LEN	32	/* max(crc32_len(4), sha256_len(32)) */
 
 /* cmdline argument format parsing */
 inline int fit_parse_conf (const char *spec, ulong addr_curr,
@@ -656,6 +659,8 @@ static inline int fit_image_check_target_arch (const void *fdt, int node)
 	if (!fit_image_check_arch (fdt, node, IH_ARCH_SH))
 #elif defined(__sparc__)
 	if (!fit_image_check_arch (fdt, node, IH_ARCH_SPARC))
+#elif defined(CONFIG_SANDBOX)
+	if (!fit_image_check_arch (fdt, node, IH_ARCH_SANDBOX))
 #else
 # error Unknown CPU type
 #endif
@@ -22,6 +22,9 @@
 #define _LIBFDT_ENV_H
 
 #include "compiler.h"
+#ifndef USE_HOSTCC
+#include <config.h>
+#endif
 
 extern struct fdt_header *working_fdt;  /* Pointer to the working fdt */
 
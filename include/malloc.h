@@ -882,6 +882,17 @@ extern Void_t*     sbrk();
 #define pvALLOc		dlpvalloc
 #define mALLINFo	dlmallinfo
 #define mALLOPt		dlmallopt
+#elif defined(CONFIG_SYS_MALLOC_SLAB)
+/* common/malloc_slab.c provides these and passes on what it cannot serve */
+#define cALLOc		dlcalloc
+#define fREe		dlfree
+#define mALLOc		dlmalloc
+#define mEMALIGn	dlmemalign
+#define rEALLOc		dlrealloc
+#define vALLOc		dlvalloc
+#define pvALLOc		dlpvalloc
+#define mALLINFo	mallinfo
+#define mALLOPt		mallopt
 #else /* USE_DL_PREFIX */
 #define cALLOc		calloc
 #define fREe		free
@@ -938,6 +949,32 @@ extern ulong mem_malloc_brk;
 
 void mem_malloc_init(ulong start, ulong size);
 
+#ifdef CONFIG_SYS_MALLOC_SLAB
+void *malloc(size_t bytes);
+void free(void *mem);
+void *realloc(void *oldmem, size_t bytes);
+void *calloc(size_t n, size_t elem_size);
+void *memalign(size_t alignment, size_t bytes);
+void *valloc(size_t bytes);
+void *pvalloc(size_t bytes);
+
+/* The dlmalloc pool, as reported by malloc_pool_info() */
+struct malloc_pool_info {
+	ulong size;		/* bytes in the pool */
+	ulong sbrked;		/* bytes handed to dlmalloc by sbrk() */
+	ulong max_sbrked;	/* the most that sbrk() has handed out */
+	ulong free;		/* free bytes, including those not sbrk'd */
+	ulong largest_free;	/* largest free block */
+	int free_blocks;	/* number of free blocks */
+};
+
+void malloc_pool_info(struct malloc_pool_info *info);
+void malloc_slab_init(void);
+void malloc_slab_info(void);
+void malloc_slab_callers(void);
+void malloc_slab_reset(void);
+#endif
+
 #ifdef __cplusplus
 };  /* end of extern "C" */
 #endif
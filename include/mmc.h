@@ -44,8 +44,11 @@
 #define MMC_MODE_HS_52MHz	0x010
 #define MMC_MODE_4BIT		0x100
 #define MMC_MODE_8BIT		0x200
+#define MMC_MODE_CMD23		0x1000	/* SET_BLOCK_COUNT supported */
+#define MMC_MODE_ASYNC		0x2000	/* host has start/wait/finish_data */
 
 #define SD_DATA_4BIT	0x00040000
+#define SD_CMD23_SUPPORT	0x00000002	/* in SCR CMD_SUPPORT field */
 
 #define IS_SD(x) (x->version & SD_VERSION_SD)
 
@@ -72,6 +75,7 @@
 #define MMC_CMD_SET_BLOCKLEN		16
 #define MMC_CMD_READ_SINGLE_BLOCK	17
 #define MMC_CMD_READ_MULTIPLE_BLOCK	18
+#define MMC_CMD_SET_BLOCK_COUNT		23
 #define MMC_CMD_WRITE_SINGLE_BLOCK	24
 #define MMC_CMD_WRITE_MULTIPLE_BLOCK	25
 #define MMC_CMD_APP_CMD			55
@@ -247,6 +251,17 @@ struct mmc_data {
 	uint blocksize;
 };
 
+/* A read request which may be left running on the host */
+struct mmc_req {
+	struct mmc_cmd cmd;
+	struct mmc_data data;
+	lbaint_t blkcnt;
+	int err;
+	int async;		/* transfer was started with start_data() */
+	int use_cmd23;		/* block count was set, no stop needed */
+	int waited;		/* mmc_read_wait() has been called */
+};
+
 struct mmc {
 	struct list_head link;
 	char name[32];
@@ -274,6 +289,20 @@ struct mmc {
 			struct mmc_cmd *cmd, struct mmc_data *data);
 	void (*set_ios)(struct mmc *mmc);
 	int (*init)(struct mmc *mmc);
+	/*
+	 * Optional, used if host_caps has MMC_MODE_ASYNC. start_data()
+	 * sends a command and returns with its data transfer still running.
+	 * wait_data() waits for that transfer to end. finish_data() does the
+	 * cache maintenance needed before the CPU reads the data; it may be
+	 * called while the next transfer is running.
+	 */
+	int (*start_data)(struct mmc *mmc,
+			struct mmc_cmd *cmd, struct mmc_data *data);
+	int (*wait_data)(struct mmc *mmc, struct mmc_data *data);
+	void (*finish_data)(struct mmc *mmc, struct mmc_data *data);
+	/* Transfer statistics, kept by hosts which use bounce buffers */
+	ulong dma_bytes;	/* bytes transferred in place */
+	ulong bounce_bytes;	/* bytes copied through a bounce buffer */
 #ifdef CONFIG_MMC_MBLOCK
 	uint b_max;
 #endif
@@ -283,6 +312,38 @@ int mmc_register(struct mmc *mmc);
 int mmc_initialize(bd_t *bis);
 int mmc_init(struct mmc *mmc);
 int mmc_read(struct mmc *mmc, u64 src, uchar *dst, int size);
+
+/**
+ * Start reading blocks from the card. If the host supports it the
+ * transfer is left running, so the caller can work on a previous buffer.
+ * Every request must be completed before another command is sent.
+ *
+ * @param mmc		MMC device
+ * @param req		Request to fill in and start
+ * @param dst		Destination buffer
+ * @param start		First block to read
+ * @param blkcnt	Number of blocks to read (at most 65535)
+ * @return 0 if ok, -ve on error (the request still needs completing)
+ */
+int mmc_read_submit(struct mmc *mmc, struct mmc_req *req, void *dst,
+		    ulong start, lbaint_t blkcnt);
+
+/**
+ * Wait for the transfer of a request to end on the host, and stop the
+ * card if needed. After this a new request may be submitted, but the
+ * data is not yet visible to the CPU.
+ *
+ * @return 0 if ok, -ve on error
+ */
+int mmc_read_wait(struct mmc *mmc, struct mmc_req *req);
+
+/**
+ * Complete a request, waiting for it if needed, so that its data can be
+ * used.
+ *
+ * @return number of blocks read, or 0 on error
+ */
+lbaint_t mmc_read_complete(struct mmc *mmc, struct mmc_req *req);
 void mmc_set_clock(struct mmc *mmc, uint clock);
 struct mmc *find_mmc_device(int dev_num);
 int mmc_set_dev(int dev_num);
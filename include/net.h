@@ -69,7 +69,7 @@
 
 #define PKTALIGN	32
 
-typedef ulong		IPaddr_t;
+typedef u32		IPaddr_t;
 
 
 /*
@@ -185,6 +185,7 @@ typedef struct {
 #define PROT_VLAN	0x8100		/* IEEE 802.1q protocol		*/
 
 #define IPPROTO_ICMP	 1	/* Internet Control Message Protocol	*/
+#define IPPROTO_TCP	 6	/* Transmission Control Protocol	*/
 #define IPPROTO_UDP	17	/* User Datagram Protocol		*/
 
 /*
@@ -270,7 +271,7 @@ typedef struct icmphdr {
 			ushort	id;
 			ushort	sequence;
 		} echo;
-		ulong	gateway;
+		u32	gateway;
 		struct {
 			ushort	__unused;
 			ushort	mtu;
@@ -359,7 +360,8 @@ extern int		NetState;		/* Network loop state		*/
 extern int		NetRestartWrap;		/* Tried all network devices	*/
 #endif
 
-typedef enum { BOOTP, RARP, ARP, TFTP, DHCP, PING, DNS, NFS, CDP, NETCONS, SNTP } proto_t;
+typedef enum { BOOTP, RARP, ARP, TFTP, DHCP, PING, DNS, NFS, CDP, NETCONS, SNTP,
+	HTTP } proto_t;
 
 /* from net/net.c */
 extern char	BootFile[128];			/* Boot File name		*/
@@ -367,6 +369,13 @@ extern char	BootFile[128];			/* Boot File name		*/
 #if defined(CONFIG_CMD_DNS)
 extern char *NetDNSResolve;		/* The host to resolve  */
 extern char *NetDNSenvvar;		/* the env var to put the ip into */
+extern IPaddr_t NetDNSResolvedIP;	/* the answer, 0 if none */
+#endif
+
+#if defined(CONFIG_CMD_HTTP)
+extern IPaddr_t	NetHttpServerIP;		/* HTTP server, 0 if not resolved */
+extern char	NetHttpHost[64];		/* its name, from the URL	*/
+extern int	HttpSetURL(const char *url);	/* Set the URL to get	*/
 #endif
 
 #if defined(CONFIG_CMD_PING)
@@ -401,6 +410,7 @@ extern int	NetSetEther(volatile uchar *, uchar *, uint);
 
 /* Set IP header */
 extern void	NetSetIP(volatile uchar *, IPaddr_t, int, int, int);
+extern void	NetSetIPHdr(volatile uchar *, IPaddr_t, int, int);
 
 /* Checksum */
 extern int	NetCksumOk(uchar *, int);	/* Return true if cksum OK	*/
@@ -416,9 +426,32 @@ extern void	NetSendPacket(volatile uchar *, int);
 /* Transmit UDP packet, performing ARP request if needed */
 extern int	NetSendUDPPacket(uchar *ether, IPaddr_t dest, int dport, int sport, int len);
 
+/* Transmit the TCP segment behind a 20 byte IP header, likewise */
+extern int	NetSendTCPPacket(uchar *ether, IPaddr_t dest, int len);
+
 /* Processes a received packet */
 extern void	NetReceive(volatile uchar *, int);
 
+/*
+ * Zero-copy receive. A protocol that knows where the payload of the next
+ * UDP packet it expects belongs tells the stack with NetSetRxDest(): the
+ * address, the size of its own header in front of the payload and how
+ * many bytes from that address may be overwritten. A driver able to
+ * receive anywhere asks NetRxFrameBuf() for a buffer of 'size' bytes
+ * whose first 'prefix' bytes are its own header, receives there, calls
+ * NetReceive() and then NetRxFrameDone(). The payload is then already in
+ * place. NetSetHandler() cancels the destination.
+ *
+ * The buffer starts a fixed distance in front of the payload, so it only
+ * meets the driver's DMA alignment 'align' (a power of two) for some
+ * load addresses; e.g. TFTP with a 4-byte aligned DMA buffer needs a
+ * load address 2 bytes past a multiple of 4. Otherwise NetRxFrameBuf()
+ * returns NULL and the driver receives into its own buffer as usual.
+ */
+extern void	NetSetRxDest(void *dest, int hdrlen, int room);
+extern uchar	*NetRxFrameBuf(int prefix, int size, int align);
+extern void	NetRxFrameDone(void);
+
 /*
  * The following functions are a bit ugly, but necessary to deal with
  * alignment restrictions on ARM.
@@ -434,10 +467,10 @@ static inline IPaddr_t NetReadIP(volatile void *from)
 	return ip;
 }
 
-/* return ulong *in network byteorder* */
-static inline ulong NetReadLong(ulong *from)
+/* return a 32-bit word *in network byteorder* */
+static inline u32 NetReadLong(u32 *from)
 {
-	ulong l;
+	u32 l;
 	memcpy((void*)&l, (void*)from, sizeof(l));
 	return l;
 }
@@ -454,10 +487,10 @@ static inline void NetCopyIP(volatile void *to, void *from)
 	memcpy((void*)to, from, sizeof(IPaddr_t));
 }
 
-/* copy ulong */
-static inline void NetCopyLong(ulong *to, ulong *from)
+/* copy a 32-bit word */
+static inline void NetCopyLong(u32 *to, u32 *from)
 {
-	memcpy((void*)to, (void*)from, sizeof(ulong));
+	memcpy((void*)to, (void*)from, sizeof(u32));
 }
 
 /**
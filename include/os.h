@@ -0,0 +1,165 @@
+/*
+ * Operating System Interface
+ *
+ * This provides access to useful OS routines from the sandbox architecture.
+ * They are kept in a separate file so we can include system headers.
+ *
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef __OS_H__
+#define __OS_H__
+
+/*
+ * U-Boot cannot include the host's <fcntl.h> and <unistd.h>, so the flags
+ * it passes have their own values; os.c translates them.
+ */
+#define OS_O_RDONLY	0
+#define OS_O_WRONLY	1
+#define OS_O_RDWR	2
+#define OS_O_MASK	3	/* Mask for read/write flags */
+#define OS_O_CREAT	0100
+
+#define OS_SEEK_SET	0
+#define OS_SEEK_CUR	1
+#define OS_SEEK_END	2
+
+/**
+ * Access to the OS read() system call
+ *
+ * @param fd	File descriptor as returned by os_open()
+ * @param buf	Buffer to place data
+ * @param count	Number of bytes to read
+ * @return number of bytes read, or -1 on error
+ */
+ssize_t os_read(int fd, void *buf, size_t count);
+
+/**
+ * Access to the OS write() system call
+ *
+ * @param fd	File descriptor as returned by os_open()
+ * @param buf	Buffer containing data to write
+ * @param count	Number of bytes to write
+ * @return number of bytes written, or -1 on error
+ */
+ssize_t os_write(int fd, const void *buf, size_t count);
+
+/**
+ * Access to the OS pread()/pwrite() system calls, for block devices
+ *
+ * @param fd	File descriptor as returned by os_open()
+ * @param buf	Buffer for the data
+ * @param count	Number of bytes to transfer
+ * @param offset Offset in the file to transfer at
+ * @return number of bytes transferred, or -1 on error
+ */
+ssize_t os_pread(int fd, void *buf, size_t count, long long offset);
+ssize_t os_pwrite(int fd, const void *buf, size_t count, long long offset);
+
+/**
+ * Access to the OS lseek() system call
+ *
+ * @param fd	File descriptor as returned by os_open()
+ * @param offset File offset (based on whence)
+ * @param whence Position offset is relative to (OS_SEEK_...)
+ * @return new file offset, or -1 on error
+ */
+long long os_lseek(int fd, long long offset, int whence);
+
+/**
+ * Access to the OS open() system call
+ *
+ * @param pathname	Pathname of file to open
+ * @param flags		Flags, like OS_O_RDONLY, OS_O_RDWR
+ * @return file descriptor, or -1 on error
+ */
+int os_open(const char *pathname, int flags);
+
+/**
+ * Access to the OS close() system call
+ *
+ * @param fd	File descriptor to close
+ * @return 0 on success, -1 on error
+ */
+int os_close(int fd);
+
+/**
+ * Access to the OS exit() system call
+ *
+ * This exits with the supplied return code, which should be 0 to indicate
+ * success.
+ *
+ * @param exit_code	exit code for U-Boot
+ */
+void os_exit(int exit_code) __attribute__((noreturn));
+
+/**
+ * Put the terminal into raw mode, so that each key is passed on as it is
+ * typed. The terminal is restored when U-Boot exits.
+ */
+void os_tty_raw(int fd);
+
+/**
+ * Check whether a file descriptor has data to read, without blocking
+ *
+ * @param fd	File descriptor to check
+ * @return 1 if a read() would not block, 0 if not
+ */
+int os_poll(int fd);
+
+/**
+ * Map a zeroed area of host memory at a fixed address
+ *
+ * The sandbox's RAM sits at the address U-Boot sees it at, so that
+ * load_addr and friends can be used as pointers.
+ *
+ * @param addr	Address to map at
+ * @param size	Number of bytes to map
+ * @return pointer to the memory, or NULL if it could not be mapped there
+ */
+void *os_map_ram(unsigned long addr, size_t size);
+
+/**
+ * Get a monotonic time in nanoseconds
+ *
+ * @return time since an arbitrary fixed point, in nanoseconds
+ */
+unsigned long long os_get_nsec(void);
+
+/**
+ * Sleep for a while
+ *
+ * @param usec	Number of microseconds to sleep
+ */
+void os_usleep(unsigned long usec);
+
+/**
+ * Open a Linux tap interface for sending and receiving Ethernet frames
+ *
+ * The interface must exist and be usable by the user running U-Boot, as
+ * created by "ip tuntap add dev tap0 mode tap user $USER".
+ *
+ * @param ifname	Interface name, like "tap0"
+ * @param mac		Filled in with a MAC address for the sandbox's end
+ * @return file descriptor, or -1 on error
+ */
+int os_tap_open(const char *ifname, unsigned char mac[6]);
+
+#endif
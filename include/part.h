@@ -62,7 +62,8 @@ typedef struct block_dev_desc {
 #define IF_TYPE_MMC		6
 #define IF_TYPE_SD		7
 #define IF_TYPE_SATA		8
-#define IF_TYPE_MAX		9	/* Max number of IF_TYPE_* supported */
+#define IF_TYPE_HOST		9	/* file on the host, for the sandbox */
+#define IF_TYPE_MAX		10	/* Max number of IF_TYPE_* supported */
 
 /* Part types */
 #define PART_TYPE_UNKNOWN	0x00
@@ -102,6 +103,7 @@ block_dev_desc_t* usb_stor_get_dev(int dev);
 block_dev_desc_t* mmc_get_dev(int dev);
 block_dev_desc_t* systemace_get_dev(int dev);
 block_dev_desc_t* mg_disk_get_dev(int dev);
+block_dev_desc_t *host_get_dev(int dev);
 
 /* disk/part.c */
 int get_partition_info (block_dev_desc_t * dev_desc, int part, disk_partition_t *info);
@@ -109,6 +111,13 @@ void print_part (block_dev_desc_t *dev_desc);
 void  init_part (block_dev_desc_t *dev_desc);
 void dev_print(block_dev_desc_t *dev_desc);
 
+/* fs/fat/fat.c */
+#ifdef CONFIG_CMD_FAT
+void fat_cache_invalidate(block_dev_desc_t *dev_desc);
+#else
+static inline void fat_cache_invalidate(block_dev_desc_t *dev_desc) {}
+#endif
+
 
 #ifdef CONFIG_MAC_PARTITION
 /* disk/part_mac.c */
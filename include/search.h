@@ -57,9 +57,13 @@ struct hsearch_data {
 	struct _ENTRY *table;
 	unsigned int size;
 	unsigned int filled;
+	unsigned int deleted;	/* slots of deleted entries */
 };
 
-/* Create a new hashing table which will at most contain NEL elements.  */
+/*
+ * Create a new hashing table, sized for NEL elements.  It grows as
+ * needed when more are entered.
+ */
 extern int hcreate_r(size_t __nel, struct hsearch_data *__htab);
 
 /* Destroy current internal hashing table.  */
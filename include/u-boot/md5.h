@@ -14,6 +14,15 @@ struct MD5Context {
 	unsigned char in[64];
 };
 
+/*
+ * Streaming interface: initialise 'ctx', feed it any number of buffers with
+ * MD5Update() and write the 16-byte digest to 'digest' with MD5Final().
+ */
+void MD5Init(struct MD5Context *ctx);
+void MD5Update(struct MD5Context *ctx, unsigned char const *buf,
+		unsigned len);
+void MD5Final(unsigned char digest[16], struct MD5Context *ctx);
+
 /*
  * Calculate and store in 'output' the MD5 digest of 'len' bytes at
  * 'input'. 'output' must have enough space to hold 16 bytes.
@@ -48,6 +48,17 @@
  */
 #define USB_TIMEOUT_MS(pipe) (usb_pipebulk(pipe) ? 5000 : 100)
 
+/*
+ * Largest bulk transfer the host controller driver accepts in one call.
+ * With CONFIG_USB_EHCI_LARGE_XFER, EHCI chains qTDs to reach 1MB; all
+ * other set-ups keep the old 10KB limit.
+ */
+#if defined(CONFIG_USB_EHCI) && defined(CONFIG_USB_EHCI_LARGE_XFER)
+#define USB_MAX_XFER_SIZE	(1024 * 1024)
+#else
+#define USB_MAX_XFER_SIZE	(20 * 512)
+#endif
+
 /* device request (setup) */
 struct devrequest {
 	unsigned char	requesttype;
@@ -128,6 +139,11 @@ struct usb_device {
 	int portnr;
 	struct usb_device *parent;
 	struct usb_device *children[USB_MAXCHILDREN];
+
+	/* bulk transfer totals, shown by 'usb info' */
+	unsigned long bulk_count;	/* transfers */
+	unsigned long bulk_bytes;	/* bytes moved */
+	unsigned long bulk_ms;		/* time taken */
 };
 
 /**********************************************************************
@@ -139,7 +155,8 @@ struct usb_device {
 	defined(CONFIG_USB_SL811HS) || defined(CONFIG_USB_ISP116X_HCD) || \
 	defined(CONFIG_USB_R8A66597_HCD) || defined(CONFIG_USB_DAVINCI) || \
 	defined(CONFIG_USB_OMAP3) || defined(CONFIG_USB_DA8XX) || \
-	defined(CONFIG_USB_BLACKFIN) || defined(CONFIG_USB_AM35X)
+	defined(CONFIG_USB_BLACKFIN) || defined(CONFIG_USB_AM35X) || \
+	defined(CONFIG_USB_SANDBOX)
 
 int usb_lowlevel_init(void);
 int usb_lowlevel_stop(void);
@@ -149,6 +166,11 @@ int submit_control_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 			int transfer_len, struct devrequest *setup);
 int submit_int_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 			int transfer_len, int interval);
+#ifdef CONFIG_USB_BULK_QUEUE
+struct usb_bulk_xfer;
+int submit_bulk_queue(struct usb_device *dev, struct usb_bulk_xfer *xfer,
+			int count, int timeout);
+#endif
 void usb_event_poll(void);
 
 /* Defines */
@@ -196,6 +218,25 @@ int usb_control_msg(struct usb_device *dev, unsigned int pipe,
 			void *data, unsigned short size, int timeout);
 int usb_bulk_msg(struct usb_device *dev, unsigned int pipe,
 			void *data, int len, int *actual_length, int timeout);
+#ifdef CONFIG_USB_BULK_QUEUE
+/*
+ * One bulk transfer of a queue handed to the host controller in one go.
+ * Transfers on the same pipe run in order; transfers on different pipes
+ * are only ordered by the device, which NAKs until it is ready for them.
+ */
+struct usb_bulk_xfer {
+	unsigned long	pipe;
+	void		*buffer;
+	int		length;
+	int		act_len;	/* bytes moved */
+	unsigned long	status;		/* USB_ST_* flags */
+};
+
+#define USB_MAX_BULK_QUEUE	4
+
+int usb_bulk_queue(struct usb_device *dev, struct usb_bulk_xfer *xfer,
+			int count, int timeout);
+#endif
 int usb_submit_int_msg(struct usb_device *dev, unsigned long pipe,
 			void *buffer, int transfer_len, int interval);
 int usb_disable_asynch(int disable);
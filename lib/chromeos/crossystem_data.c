@@ -16,8 +16,11 @@
 #include <chromeos/crossystem_data.h>
 #include <linux/string.h>
 
-/* This is used to keep u-boot and kernel in sync */
-#define SHARED_MEM_VERSION 1
+/*
+ * This is used to keep u-boot and kernel in sync. Version 2 added the
+ * bootstage records at the end.
+ */
+#define SHARED_MEM_VERSION 2
 
 #define PREFIX "crossystem_data: "
 
@@ -226,6 +229,10 @@ int crossystem_data_embed_into_fdt(crossystem_data_t *cdata, void *fdt,
 	err |= set_scalar_prop("fmap-offset", fmap_base);
 	err |= set_array_prop("vboot-shared-data", vbshared_data);
 
+	/* Take a snapshot of boot timing so far */
+	if (bootstage_export(cdata->bootstage, sizeof(cdata->bootstage)) > 0)
+		err |= set_array_prop("boot-timing", bootstage);
+
 #undef set_scalar_prop
 #undef set_array_prop
 #undef set_string_prop
@@ -24,6 +24,44 @@
 #ifndef CONFIG_SF_DEFAULT_MODE
 # define CONFIG_SF_DEFAULT_MODE		SPI_MODE_3
 #endif
+#if !defined(CACHE_LINE_SIZE) && defined(CONFIG_SYS_CACHELINE_SIZE)
+# define CACHE_LINE_SIZE		CONFIG_SYS_CACHELINE_SIZE
+#endif
+#ifndef CACHE_LINE_SIZE
+# error "The read cache is DMA'd into and needs the cache line size"
+#endif
+
+/*
+ * Small reads are served from a cache of flash blocks. A miss reads the
+ * whole block, so that the many small neighbouring reads done by vboot
+ * (GBB header, keys, vblocks) turn into a few large fast-read commands.
+ * Reads of at least SPI_CACHE_BYPASS bytes go straight to the flash.
+ */
+enum {
+	SPI_CACHE_BLOCK_SIZE	= 0x4000,
+	SPI_CACHE_BLOCKS	= 8,
+	SPI_CACHE_BYPASS	= SPI_CACHE_BLOCK_SIZE,
+	SPI_CACHE_INVALID	= 0xffffffff,
+};
+
+struct spi_cache_block {
+	uint32_t offset;	/* flash offset, or SPI_CACHE_INVALID */
+	uint32_t last_use;	/* for LRU replacement */
+	uint8_t *data;
+};
+
+struct spi_context {
+	struct spi_flash *flash;
+	uint8_t *cache_data;	/* NULL if we have no cache */
+	struct spi_cache_block block[SPI_CACHE_BLOCKS];
+	uint32_t tick;
+
+	/* statistics */
+	uint32_t hits;		/* blocks found in cache */
+	uint32_t misses;	/* blocks read from flash */
+	uint32_t bypassed;	/* large reads sent straight to flash */
+	uint32_t flash_bytes;	/* total bytes read from flash */
+};
 
 /*
  * Check the right-exclusive range [offset:offset+*count_ptr), and adjust
@@ -47,17 +85,93 @@ static int border_check(struct spi_flash *flash, uint32_t offset,
 	return 0;
 }
 
+static int read_flash(struct spi_context *cxt, uint32_t offset,
+		uint32_t count, void *buf)
+{
+	struct spi_flash *flash = cxt->flash;
+
+	cxt->flash_bytes += count;
+	if (flash->read(flash, offset, count, buf)) {
+		VBDEBUG(PREFIX "SPI read fail\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Find the block holding the given block-aligned offset, reading it in */
+static struct spi_cache_block *get_block(struct spi_context *cxt,
+		uint32_t offset)
+{
+	struct spi_cache_block *blk, *victim = NULL;
+	uint32_t size;
+	int i;
+
+	for (i = 0; i < SPI_CACHE_BLOCKS; i++) {
+		blk = &cxt->block[i];
+		if (blk->offset == offset) {
+			cxt->hits++;
+			blk->last_use = ++cxt->tick;
+			return blk;
+		}
+		if (!victim || blk->last_use < victim->last_use)
+			victim = blk;
+	}
+
+	cxt->misses++;
+	size = min(cxt->flash->size - offset, (uint32_t)SPI_CACHE_BLOCK_SIZE);
+	if (read_flash(cxt, offset, size, victim->data)) {
+		victim->offset = SPI_CACHE_INVALID;
+		return NULL;
+	}
+	victim->offset = offset;
+	victim->last_use = ++cxt->tick;
+
+	return victim;
+}
+
+/* Drop any cached blocks which overlap [offset, offset + count) */
+static void invalidate_cache(struct spi_context *cxt, uint32_t offset,
+		uint32_t count)
+{
+	struct spi_cache_block *blk;
+	int i;
+
+	for (i = 0; i < SPI_CACHE_BLOCKS; i++) {
+		blk = &cxt->block[i];
+		if (blk->offset != SPI_CACHE_INVALID &&
+				blk->offset < offset + count &&
+				offset < blk->offset + SPI_CACHE_BLOCK_SIZE)
+			blk->offset = SPI_CACHE_INVALID;
+	}
+}
+
 static int read_spi(firmware_storage_t *file, uint32_t offset, uint32_t count,
 		void *buf)
 {
-	struct spi_flash *flash = file->context;
+	struct spi_context *cxt = file->context;
+	struct spi_cache_block *blk;
+	uint8_t *dest = buf;
+	uint32_t start, n;
 
-	if (border_check(flash, offset, count))
+	if (border_check(cxt->flash, offset, count))
 		return -1;
 
-	if (flash->read(flash, offset, count, buf)) {
-		VBDEBUG(PREFIX "SPI read fail\n");
-		return -1;
+	if (!cxt->cache_data || count >= SPI_CACHE_BYPASS) {
+		cxt->bypassed++;
+		return read_flash(cxt, offset, count, buf);
+	}
+
+	while (count) {
+		start = offset & ~(SPI_CACHE_BLOCK_SIZE - 1);
+		n = min(count, start + SPI_CACHE_BLOCK_SIZE - offset);
+		blk = get_block(cxt, start);
+		if (!blk)
+			return -1;
+		memcpy(dest, blk->data + (offset - start), n);
+		dest += n;
+		offset += n;
+		count -= n;
 	}
 
 	return 0;
@@ -102,7 +216,8 @@ static void align_to_sector(uint32_t *offset_ptr, uint32_t *length_ptr)
 static int write_spi(firmware_storage_t *file, uint32_t offset, uint32_t count,
 		void *buf)
 {
-	struct spi_flash *flash = file->context;
+	struct spi_context *cxt = file->context;
+	struct spi_flash *flash = cxt->flash;
 	uint8_t static_buf[SECTOR_SIZE];
 	uint8_t *backup_buf;
 	uint32_t k, n;
@@ -123,6 +238,9 @@ static int write_spi(firmware_storage_t *file, uint32_t offset, uint32_t count,
 	if (border_check(flash, k, n))
 		return -1;
 
+	/* Whatever happens below, the cached copy can no longer be trusted */
+	invalidate_cache(cxt, k, n);
+
 	backup_buf = n > sizeof(static_buf) ? malloc(n) : static_buf;
 
 	if ((status = flash->read(flash, k, n, backup_buf))) {
@@ -154,8 +272,14 @@ EXIT:
 
 static int close_spi(firmware_storage_t *file)
 {
-	struct spi_flash *flash = file->context;
-	spi_flash_free(flash);
+	struct spi_context *cxt = file->context;
+
+	VBDEBUG(PREFIX "cache: %u hits, %u misses, %u bypassed, "
+			"%u bytes read from flash\n", cxt->hits, cxt->misses,
+			cxt->bypassed, cxt->flash_bytes);
+	spi_flash_free(cxt->flash);
+	free(cxt->cache_data);
+	free(cxt);
 	return 0;
 }
 
@@ -165,17 +289,39 @@ int firmware_storage_open_spi(firmware_storage_t *file)
 	const unsigned int cs = 0;
 	const unsigned int max_hz = CONFIG_SF_DEFAULT_SPEED;
 	const unsigned int spi_mode = CONFIG_SF_DEFAULT_MODE;
+	struct spi_context *cxt;
 	struct spi_flash *flash;
+	int i;
 
 	if (!(flash = spi_flash_probe(bus, cs, max_hz, spi_mode))) {
 		VBDEBUG(PREFIX "fail to init SPI flash at %u:%u\n", bus, cs);
 		return -1;
 	}
 
+	cxt = malloc(sizeof(*cxt));
+	if (!cxt) {
+		VBDEBUG(PREFIX "fail to allocate context\n");
+		spi_flash_free(flash);
+		return -1;
+	}
+	memset(cxt, '\0', sizeof(*cxt));
+	cxt->flash = flash;
+
+	/* Without a cache we still work, just more slowly */
+	cxt->cache_data = memalign(CACHE_LINE_SIZE,
+			SPI_CACHE_BLOCKS * SPI_CACHE_BLOCK_SIZE);
+	if (!cxt->cache_data)
+		VBDEBUG(PREFIX "fail to allocate cache\n");
+	for (i = 0; i < SPI_CACHE_BLOCKS; i++) {
+		cxt->block[i].offset = SPI_CACHE_INVALID;
+		cxt->block[i].data = cxt->cache_data +
+				i * SPI_CACHE_BLOCK_SIZE;
+	}
+
 	file->read = read_spi;
 	file->write = write_spi;
 	file->close = close_spi;
-	file->context = (void *)flash;
+	file->context = (void *)cxt;
 
 	return 0;
 }
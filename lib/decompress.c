@@ -0,0 +1,577 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <decompress.h>
+#include <image.h>
+#include <malloc.h>
+#include <watchdog.h>
+#include <asm/unaligned.h>
+
+#ifdef CONFIG_GZIP
+#include <u-boot/zlib.h>
+#endif
+#ifdef CONFIG_LZMA
+#include <lzma/LzmaTypes.h>
+#include <lzma/LzmaDec.h>
+#endif
+#ifdef CONFIG_LZO
+#include <linux/lzo.h>
+#endif
+
+/* decomp_buffer() pushes this much at a time */
+#define DECOMP_CHUNK_SIZE	(64 << 10)
+
+/*
+ * All heap used by a decompressor goes through here, so that its peak can
+ * be reported. Each allocation is prefixed with its size.
+ */
+static void *decomp_alloc(struct decomp_stream *s, ulong size)
+{
+	ulong *p;
+
+	p = malloc(size + sizeof(ulong) * 2);
+	if (!p)
+		return NULL;
+	*p = size;
+	s->mem_used += size;
+	if (s->mem_used > s->mem_peak)
+		s->mem_peak = s->mem_used;
+
+	return p + 2;
+}
+
+static void decomp_free(struct decomp_stream *s, void *ptr)
+{
+	ulong *p = ptr;
+
+	if (!p)
+		return;
+	p -= 2;
+	s->mem_used -= *p;
+	free(p);
+}
+
+#ifdef CONFIG_GZIP
+static void *gzip_zalloc(void *opaque, unsigned items, unsigned size)
+{
+	return decomp_alloc(opaque, (ulong)items * size);
+}
+
+static void gzip_zfree(void *opaque, void *ptr, unsigned size)
+{
+	decomp_free(opaque, ptr);
+}
+
+static int gzip_start(struct decomp_stream *s)
+{
+	z_stream *z;
+
+	z = decomp_alloc(s, sizeof(*z));
+	if (!z)
+		return -1;
+	memset(z, '\0', sizeof(*z));
+	z->zalloc = gzip_zalloc;
+	z->zfree = gzip_zfree;
+	z->opaque = s;
+	s->priv = z;
+
+	/* 16 + MAX_WBITS makes zlib parse the gzip header and trailer */
+	if (inflateInit2(z, 16 + MAX_WBITS) != Z_OK)
+		return -1;
+	z->next_out = s->dst;
+	z->avail_out = s->dst_size;
+
+	return 0;
+}
+
+static int gzip_push(struct decomp_stream *s, const uint8_t *src, ulong len)
+{
+	z_stream *z = s->priv;
+	int ret;
+
+	z->next_in = (uint8_t *)src;
+	z->avail_in = len;
+	ret = inflate(z, Z_NO_FLUSH);
+	s->in_len += len - z->avail_in;
+	s->out_len = z->next_out - s->dst;
+
+	if (ret == Z_STREAM_END)
+		return 1;
+	if (ret != Z_OK && ret != Z_BUF_ERROR) {
+		debug("%s: inflate() returned %d\n", __func__, ret);
+		return -1;
+	}
+	if (z->avail_in) {
+		debug("%s: output buffer full\n", __func__);
+		return -1;
+	}
+
+	return 0;
+}
+
+static void gzip_end(struct decomp_stream *s)
+{
+	z_stream *z = s->priv;
+
+	if (z->state)
+		inflateEnd(z);
+	decomp_free(s, z);
+}
+#endif /* CONFIG_GZIP */
+
+#ifdef CONFIG_LZMA
+/* Properties followed by the 64-bit uncompressed size */
+#define LZMA_HEADER_SIZE	(LZMA_PROPS_SIZE + 8)
+
+struct lzma_state {
+	CLzmaDec dec;
+	ISzAlloc alloc;
+	struct decomp_stream *s;
+	uint8_t header[LZMA_HEADER_SIZE];
+	int header_len;
+	SizeT limit;			/* stop decoding at this output size */
+	int size_known;			/* header gives uncompressed size */
+};
+
+static void *lzma_alloc(void *p, size_t size)
+{
+	struct lzma_state *st = container_of(p, struct lzma_state, alloc);
+
+	return decomp_alloc(st->s, size);
+}
+
+static void lzma_free(void *p, void *address)
+{
+	struct lzma_state *st = container_of(p, struct lzma_state, alloc);
+
+	decomp_free(st->s, address);
+}
+
+static int lzma_start(struct decomp_stream *s)
+{
+	struct lzma_state *st;
+
+	st = decomp_alloc(s, sizeof(*st));
+	if (!st)
+		return -1;
+	memset(st, '\0', sizeof(*st));
+	LzmaDec_Construct(&st->dec);
+	st->alloc.Alloc = lzma_alloc;
+	st->alloc.Free = lzma_free;
+	st->s = s;
+	s->priv = st;
+
+	return 0;
+}
+
+/* Set up the decoder once the header is complete */
+static int lzma_parse_header(struct decomp_stream *s, struct lzma_state *st)
+{
+	uint32_t size_lo, size_hi;
+
+	size_lo = get_unaligned_le32(st->header + LZMA_PROPS_SIZE);
+	size_hi = get_unaligned_le32(st->header + LZMA_PROPS_SIZE + 4);
+	st->limit = s->dst_size;
+	if (size_lo != 0xffffffff || size_hi != 0xffffffff) {
+		if (size_hi || size_lo > s->dst_size) {
+			debug("%s: uncompressed size %#x%08x too large\n",
+			      __func__, size_hi, size_lo);
+			return -1;
+		}
+		st->limit = size_lo;
+		st->size_known = 1;
+	}
+
+	if (LzmaDec_AllocateProbs(&st->dec, st->header, LZMA_PROPS_SIZE,
+				  &st->alloc) != SZ_OK)
+		return -1;
+
+	/* Decode straight into the output buffer, which is the dictionary */
+	st->dec.dic = s->dst;
+	st->dec.dicBufSize = s->dst_size;
+	LzmaDec_Init(&st->dec);
+
+	return 0;
+}
+
+static int lzma_push(struct decomp_stream *s, const uint8_t *src, ulong len)
+{
+	struct lzma_state *st = s->priv;
+	ELzmaStatus status;
+	SizeT in_len;
+	int copy;
+	SRes res;
+
+	if (st->header_len < LZMA_HEADER_SIZE) {
+		copy = min(len, (ulong)(LZMA_HEADER_SIZE - st->header_len));
+		memcpy(st->header + st->header_len, src, copy);
+		st->header_len += copy;
+		s->in_len += copy;
+		src += copy;
+		len -= copy;
+		if (st->header_len < LZMA_HEADER_SIZE)
+			return 0;
+		if (lzma_parse_header(s, st))
+			return -1;
+	}
+
+	in_len = len;
+	res = LzmaDec_DecodeToDic(&st->dec, st->limit, src, &in_len,
+				  LZMA_FINISH_ANY, &status);
+	s->in_len += in_len;
+	s->out_len = st->dec.dicPos;
+	if (res != SZ_OK) {
+		debug("%s: LzmaDec_DecodeToDic() returned %d\n", __func__,
+		      res);
+		return -1;
+	}
+	if (status == LZMA_STATUS_FINISHED_WITH_MARK ||
+	    (st->size_known && st->dec.dicPos == st->limit))
+		return 1;
+	if (st->dec.dicPos == st->limit) {
+		debug("%s: output buffer full\n", __func__);
+		return -1;
+	}
+
+	return 0;
+}
+
+static void lzma_end(struct decomp_stream *s)
+{
+	struct lzma_state *st = s->priv;
+
+	LzmaDec_FreeProbs(&st->dec, &st->alloc);
+	decomp_free(s, st);
+}
+#endif /* CONFIG_LZMA */
+
+#ifdef CONFIG_LZO
+/* Largest possible lzop header: a 255-character file name */
+#define LZOP_MAX_HEADER		(9 + 7 + 1 + 4 + 4 + 12 + 1 + 255 + 4)
+#define LZOP_HAS_FILTER		0x00000800L
+
+static const unsigned char lzop_magic[] = {
+	0x89, 0x4c, 0x5a, 0x4f, 0x00, 0x0d, 0x0a, 0x1a, 0x0a
+};
+
+enum lzop_phase {
+	LZOP_HEADER,		/* file header */
+	LZOP_BLOCK_DLEN,	/* uncompressed block size */
+	LZOP_BLOCK_SLEN,	/* compressed block size and checksum */
+	LZOP_BLOCK_DATA,	/* block data */
+};
+
+struct lzop_state {
+	enum lzop_phase phase;
+	uint32_t dlen;		/* uncompressed size of current block */
+	uint32_t slen;		/* compressed size of current block */
+	uint8_t *stage;		/* gathers data split across pushes */
+	ulong stage_size;
+	ulong stage_len;
+};
+
+/*
+ * Work out the length of the lzop header from its first 'len' bytes.
+ * Returns 0 if more bytes are needed to tell. This follows the layout
+ * accepted by lzop_decompress().
+ */
+static int lzop_header_len(const uint8_t *buf, int len)
+{
+	int need = sizeof(lzop_magic) + 7;
+	int version;
+
+	if (len < need)
+		return 0;
+	version = get_unaligned_be16(buf + sizeof(lzop_magic));
+	if (version >= 0x0940)
+		need++;		/* level */
+	need += 4;		/* flags */
+	if (len < need)
+		return 0;
+	if (get_unaligned_be32(buf + need - 4) & LZOP_HAS_FILTER)
+		need += 4;
+	need += 8;		/* mode, mtime_low */
+	if (version >= 0x0940)
+		need += 4;	/* mtime_high */
+	need++;			/* file name length */
+	if (len < need)
+		return 0;
+
+	return need + buf[need - 1] + 4;
+}
+
+/*
+ * Gather 'need' contiguous bytes of input. If they are all in the current
+ * push they are used in place, otherwise they are copied to the stage.
+ * Returns a pointer to the data, or NULL if more input is needed.
+ */
+static const uint8_t *lzop_gather(struct decomp_stream *s,
+		struct lzop_state *st, const uint8_t **srcp, ulong *lenp,
+		ulong need)
+{
+	const uint8_t *src = *srcp;
+	ulong copy;
+	uint8_t *stage;
+
+	if (!st->stage_len && *lenp >= need) {
+		*srcp += need;
+		*lenp -= need;
+		s->in_len += need;
+		return src;
+	}
+
+	if (st->stage_size < need) {
+		stage = decomp_alloc(s, need);
+		if (!stage)
+			return NULL;
+		memcpy(stage, st->stage, st->stage_len);
+		decomp_free(s, st->stage);
+		st->stage = stage;
+		st->stage_size = need;
+	}
+
+	copy = min(*lenp, need - st->stage_len);
+	memcpy(st->stage + st->stage_len, src, copy);
+	st->stage_len += copy;
+	*srcp += copy;
+	*lenp -= copy;
+	s->in_len += copy;
+	if (st->stage_len < need)
+		return NULL;
+	st->stage_len = 0;
+
+	return st->stage;
+}
+
+static int lzop_start(struct decomp_stream *s)
+{
+	struct lzop_state *st;
+
+	st = decomp_alloc(s, sizeof(*st));
+	if (!st)
+		return -1;
+	memset(st, '\0', sizeof(*st));
+	s->priv = st;
+
+	st->stage = decomp_alloc(s, LZOP_MAX_HEADER);
+	if (!st->stage)
+		return -1;
+	st->stage_size = LZOP_MAX_HEADER;
+
+	return 0;
+}
+
+static int lzop_push(struct decomp_stream *s, const uint8_t *src, ulong len)
+{
+	struct lzop_state *st = s->priv;
+	const uint8_t *p;
+	size_t out_len;
+	int hdr_len, ret;
+
+	while (len) {
+		switch (st->phase) {
+		case LZOP_HEADER:
+			/* The header is small, so just stage it byte by byte */
+			st->stage[st->stage_len++] = *src++;
+			len--;
+			s->in_len++;
+			hdr_len = lzop_header_len(st->stage, st->stage_len);
+			if (st->stage_len == sizeof(lzop_magic) &&
+			    memcmp(st->stage, lzop_magic, sizeof(lzop_magic)))
+				return -1;
+			if (hdr_len && st->stage_len == hdr_len) {
+				st->stage_len = 0;
+				st->phase = LZOP_BLOCK_DLEN;
+			}
+			break;
+		case LZOP_BLOCK_DLEN:
+			p = lzop_gather(s, st, &src, &len, 4);
+			if (!p)
+				break;
+			st->dlen = get_unaligned_be32(p);
+			if (!st->dlen)
+				return 1;	/* last block */
+			st->phase = LZOP_BLOCK_SLEN;
+			break;
+		case LZOP_BLOCK_SLEN:
+			/* compressed size, then the block checksum */
+			p = lzop_gather(s, st, &src, &len, 8);
+			if (!p)
+				break;
+			st->slen = get_unaligned_be32(p);
+			if (!st->slen || st->slen > st->dlen ||
+			    st->dlen > s->dst_size - s->out_len)
+				return -1;
+			st->phase = LZOP_BLOCK_DATA;
+			break;
+		case LZOP_BLOCK_DATA:
+			p = lzop_gather(s, st, &src, &len, st->slen);
+			if (!p)
+				break;
+			if (st->slen == st->dlen) {
+				/* lzop stores incompressible blocks as-is */
+				memcpy(s->dst + s->out_len, p, st->dlen);
+			} else {
+				out_len = st->dlen;
+				ret = lzo1x_decompress_safe(p, st->slen,
+						s->dst + s->out_len, &out_len);
+				if (ret != LZO_E_OK || out_len != st->dlen) {
+					debug("%s: block error %d\n", __func__,
+					      ret);
+					return -1;
+				}
+			}
+			s->out_len += st->dlen;
+			st->phase = LZOP_BLOCK_DLEN;
+			break;
+		}
+	}
+
+	return 0;
+}
+
+static void lzop_end(struct decomp_stream *s)
+{
+	struct lzop_state *st = s->priv;
+
+	decomp_free(s, st->stage);
+	decomp_free(s, st);
+}
+#endif /* CONFIG_LZO */
+
+int decomp_start(struct decomp_stream *s, int comp, void *dst, ulong dst_size)
+{
+	int ret;
+
+	memset(s, '\0', sizeof(*s));
+	s->comp = comp;
+	s->dst = dst;
+	s->dst_size = dst_size;
+
+	switch (comp) {
+#ifdef CONFIG_GZIP
+	case IH_COMP_GZIP:
+		ret = gzip_start(s);
+		break;
+#endif
+#ifdef CONFIG_LZMA
+	case IH_COMP_LZMA:
+		ret = lzma_start(s);
+		break;
+#endif
+#ifdef CONFIG_LZO
+	case IH_COMP_LZO:
+		ret = lzop_start(s);
+		break;
+#endif
+	default:
+		debug("%s: unsupported compression %d\n", __func__, comp);
+		return -1;
+	}
+	if (ret)
+		decomp_end(s);
+
+	return ret;
+}
+
+int decomp_push(struct decomp_stream *s, const void *src, ulong len)
+{
+	int ret = -1;
+
+	if (s->done)
+		return 1;
+	if (!s->priv)
+		return -1;
+
+	switch (s->comp) {
+#ifdef CONFIG_GZIP
+	case IH_COMP_GZIP:
+		ret = gzip_push(s, src, len);
+		break;
+#endif
+#ifdef CONFIG_LZMA
+	case IH_COMP_LZMA:
+		ret = lzma_push(s, src, len);
+		break;
+#endif
+#ifdef CONFIG_LZO
+	case IH_COMP_LZO:
+		ret = lzop_push(s, src, len);
+		break;
+#endif
+	}
+	if (ret == 1)
+		s->done = 1;
+
+	return ret;
+}
+
+int decomp_end(struct decomp_stream *s)
+{
+	if (s->priv) {
+		switch (s->comp) {
+#ifdef CONFIG_GZIP
+		case IH_COMP_GZIP:
+			gzip_end(s);
+			break;
+#endif
+#ifdef CONFIG_LZMA
+		case IH_COMP_LZMA:
+			lzma_end(s);
+			break;
+#endif
+#ifdef CONFIG_LZO
+		case IH_COMP_LZO:
+			lzop_end(s);
+			break;
+#endif
+		}
+		s->priv = NULL;
+	}
+
+	return s->done ? 0 : -1;
+}
+
+int decomp_buffer(int comp, void *dst, ulong dst_size, const void *src,
+		ulong src_len, ulong *out_len, ulong *mem_peak)
+{
+	struct decomp_stream s;
+	const uint8_t *p = src;
+	ulong chunk;
+	int ret = 0;
+
+	if (decomp_start(&s, comp, dst, dst_size))
+		return -1;
+	while (src_len && !ret) {
+		chunk = min(src_len, (ulong)DECOMP_CHUNK_SIZE);
+		ret = decomp_push(&s, p, chunk);
+		p += chunk;
+		src_len -= chunk;
+		WATCHDOG_RESET();
+	}
+	*out_len = s.out_len;
+	ret = decomp_end(&s);
+	if (mem_peak)
+		*mem_peak = s.mem_peak;
+
+	return ret;
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef USE_HOSTCC
+#include <common.h>
+#else
+#include <string.h>
+/* The host tools link in every algorithm (see tools/Makefile) */
+#define CONFIG_MD5
+#define CONFIG_SHA1
+#define CONFIG_SHA256
+#endif
+#include <watchdog.h>
+#include <hash.h>
+#include <u-boot/crc.h>
+
+struct hash_algo_info {
+	const char *name;
+	int digest_size;
+	int supported;
+};
+
+static const struct hash_algo_info hash_algos[HASH_ALGO_COUNT] = {
+	[HASH_ALGO_CRC32] = { "crc32", 4, 1 },
+#ifdef CONFIG_MD5
+	[HASH_ALGO_MD5] = { "md5", 16, 1 },
+#else
+	[HASH_ALGO_MD5] = { "md5", 16, 0 },
+#endif
+#ifdef CONFIG_SHA1
+	[HASH_ALGO_SHA1] = { "sha1", SHA1_SUM_LEN, 1 },
+#else
+	[HASH_ALGO_SHA1] = { "sha1", SHA1_SUM_LEN, 0 },
+#endif
+#ifdef CONFIG_SHA256
+	[HASH_ALGO_SHA256] = { "sha256", SHA256_SUM_LEN, 1 },
+#else
+	[HASH_ALGO_SHA256] = { "sha256", SHA256_SUM_LEN, 0 },
+#endif
+};
+
+int hash_lookup_algo(const char *name)
+{
+	int algo;
+
+	for (algo = 0; algo < HASH_ALGO_COUNT; algo++) {
+		if (hash_algos[algo].supported &&
+				!strcmp(name, hash_algos[algo].name))
+			return algo;
+	}
+
+	return -1;
+}
+
+const char *hash_algo_name(enum hash_algo algo)
+{
+	if ((unsigned)algo >= HASH_ALGO_COUNT)
+		return NULL;
+	return hash_algos[algo].name;
+}
+
+int hash_digest_size(enum hash_algo algo)
+{
+	if ((unsigned)algo >= HASH_ALGO_COUNT)
+		return -1;
+	return hash_algos[algo].digest_size;
+}
+
+int hash_init(struct hash_ctx *ctx, enum hash_algo algo)
+{
+	if ((unsigned)algo >= HASH_ALGO_COUNT || !hash_algos[algo].supported)
+		return -1;
+
+	ctx->algo = algo;
+	switch (algo) {
+	case HASH_ALGO_CRC32:
+		ctx->u.crc = 0;
+		break;
+#ifdef CONFIG_MD5
+	case HASH_ALGO_MD5:
+		MD5Init(&ctx->u.md5);
+		break;
+#endif
+#ifdef CONFIG_SHA1
+	case HASH_ALGO_SHA1:
+		sha1_starts(&ctx->u.sha1);
+		break;
+#endif
+#ifdef CONFIG_SHA256
+	case HASH_ALGO_SHA256:
+		sha256_starts(&ctx->u.sha256);
+		break;
+#endif
+	default:
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Add a chunk of data which is small enough not to upset the watchdog */
+static void hash_update_chunk(struct hash_ctx *ctx, const uint8_t *buf,
+		unsigned int len)
+{
+	switch (ctx->algo) {
+	case HASH_ALGO_CRC32:
+		ctx->u.crc = crc32(ctx->u.crc, buf, len);
+		break;
+#ifdef CONFIG_MD5
+	case HASH_ALGO_MD5:
+		MD5Update(&ctx->u.md5, buf, len);
+		break;
+#endif
+#ifdef CONFIG_SHA1
+	case HASH_ALGO_SHA1:
+		sha1_update(&ctx->u.sha1, (unsigned char *)buf, len);
+		break;
+#endif
+#ifdef CONFIG_SHA256
+	case HASH_ALGO_SHA256:
+		sha256_update(&ctx->u.sha256, (uint8_t *)buf, len);
+		break;
+#endif
+	default:
+		break;
+	}
+}
+
+void hash_update(struct hash_ctx *ctx, const void *buf, unsigned int len)
+{
+	const uint8_t *p = buf;
+	unsigned int chunk;
+
+	while (len) {
+		chunk = len > HASH_CHUNK_SIZE ? HASH_CHUNK_SIZE : len;
+		hash_update_chunk(ctx, p, chunk);
+		p += chunk;
+		len -= chunk;
+		WATCHDOG_RESET();
+	}
+}
+
+void hash_memmove(struct hash_ctx *ctx, void *to, const void *from,
+		unsigned int len)
+{
+	uint8_t *dst = to;
+	const uint8_t *src = from;
+	unsigned int chunk;
+
+	while (len) {
+		chunk = len > HASH_CHUNK_SIZE ? HASH_CHUNK_SIZE : len;
+		hash_update_chunk(ctx, src, chunk);
+		memmove(dst, src, chunk);
+		dst += chunk;
+		src += chunk;
+		len -= chunk;
+		WATCHDOG_RESET();
+	}
+}
+
+int hash_finish(struct hash_ctx *ctx, uint8_t *digest)
+{
+	switch (ctx->algo) {
+	case HASH_ALGO_CRC32:
+		digest[0] = ctx->u.crc >> 24;
+		digest[1] = ctx->u.crc >> 16;
+		digest[2] = ctx->u.crc >> 8;
+		digest[3] = ctx->u.crc;
+		break;
+#ifdef CONFIG_MD5
+	case HASH_ALGO_MD5:
+		MD5Final(digest, &ctx->u.md5);
+		break;
+#endif
+#ifdef CONFIG_SHA1
+	case HASH_ALGO_SHA1:
+		sha1_finish(&ctx->u.sha1, digest);
+		break;
+#endif
+#ifdef CONFIG_SHA256
+	case HASH_ALGO_SHA256:
+		sha256_finish(&ctx->u.sha256, digest);
+		break;
+#endif
+	default:
+		break;
+	}
+
+	return hash_algos[ctx->algo].digest_size;
+}
+
+int hash_block(enum hash_algo algo, const void *buf, unsigned int len,
+		uint8_t *digest)
+{
+	struct hash_ctx ctx;
+
+	if (hash_init(&ctx, algo))
+		return -1;
+	hash_update(&ctx, buf, len);
+
+	return hash_finish(&ctx, digest);
+}
@@ -30,6 +30,7 @@
 #include <malloc.h>
 
 #ifdef USE_HOSTCC		/* HOST build */
+# include <stdlib.h>
 # include <string.h>
 # include <assert.h>
 
@@ -48,9 +49,6 @@
 #ifndef	CONFIG_ENV_MIN_ENTRIES	/* minimum number of entries */
 #define	CONFIG_ENV_MIN_ENTRIES 64
 #endif
-#ifndef	CONFIG_ENV_MAX_ENTRIES	/* maximum number of entries */
-#define	CONFIG_ENV_MAX_ENTRIES 512
-#endif
 
 #include "search.h"
 
@@ -63,42 +61,160 @@
  * The reentrant version has no static variables to maintain the state.
  * Instead the interface of all functions is extended to take an argument
  * which describes the current status.
+ *
+ * The table has a power of two number of slots, numbered from 1 so that
+ * a slot index is never zero. "used" is 0 for a slot never used, -1 for
+ * a deleted one (it must be passed over when searching, but can be
+ * reused), and the key's hash value, which is positive, otherwise.
  */
 typedef struct _ENTRY {
 	int used;
 	ENTRY entry;
 } _ENTRY;
 
+#define HTAB_MIN_SIZE	16
 
 /*
- * hcreate()
+ * Hash of a key: FNV-1a, with the final mixing step of MurmurHash3 so
+ * that the low bits used to index the table depend on all the key bytes.
+ */
+static int hhash(const char *key)
+{
+	unsigned int hval = 2166136261U;
+
+	while (*key) {
+		hval ^= (unsigned char)*key++;
+		hval *= 16777619;
+	}
+	hval ^= hval >> 16;
+	hval *= 0x85ebca6b;
+	hval ^= hval >> 13;
+	hval *= 0xc2b2ae35;
+	hval ^= hval >> 16;
+
+	hval &= 0x7fffffff;
+	return hval ? hval : 1;
+}
+
+/* Smallest table size that holds NEL entries at most 3/4 full */
+static unsigned int hsize(size_t nel)
+{
+	unsigned int size = HTAB_MIN_SIZE;
+
+	while (size * 3 < nel * 4)
+		size <<= 1;
+	return size;
+}
+
+/*
+ * Search for KEY (with hash value HVAL). Probing goes by 1, 2, 3, ...
+ * slots from the home slot, which visits every slot of a power of two
+ * sized table.
+ *
+ * Return the slot holding KEY with *FOUND set, or else the slot it
+ * should go into: the first deleted one passed, else the empty one that
+ * ended the search. Zero means the table is full.
  */
+static unsigned int hfind(struct hsearch_data *htab, const char *key,
+			  int hval, int *found)
+{
+	unsigned int mask = htab->size - 1;
+	unsigned int pos = hval & mask;
+	unsigned int step;
+	unsigned int first_deleted = 0;
+	_ENTRY *ep;
+
+	*found = 0;
+	for (step = 1; step <= htab->size; ++step) {
+		ep = &htab->table[pos + 1];
+		if (ep->used == 0)
+			return first_deleted ? first_deleted : pos + 1;
+		if (ep->used == hval && strcmp(key, ep->entry.key) == 0) {
+			*found = 1;
+			return pos + 1;
+		}
+		if (ep->used == -1 && !first_deleted)
+			first_deleted = pos + 1;
+		pos = (pos + step) & mask;
+	}
+
+	return first_deleted;
+}
 
 /*
- * For the used double hash method the table size has to be a prime. To
- * correct the user given table size we need a prime test.  This trivial
- * algorithm is adequate because
- * a)  the code is (most probably) called a few times per program run and
- * b)  the number is small because the table must fit in the core
- * */
-static int isprime(unsigned int number)
+ * Move all entries to a new table of SIZE slots. The key and data
+ * strings stay where they are; deleted slots are dropped.
+ */
+static int hresize(struct hsearch_data *htab, unsigned int size)
 {
-	/* no even number will be passed */
-	unsigned int div = 3;
+	_ENTRY *old = htab->table;
+	_ENTRY *table;
+	unsigned int i, pos, step;
 
-	while (div * div < number && number % div != 0)
-		div += 2;
+	debug("hresize: %d => %d slots, %d used, %d deleted\n",
+	      htab->size, size, htab->filled, htab->deleted);
+
+	table = calloc(size + 1, sizeof(_ENTRY));
+	if (table == NULL)
+		return 0;
 
-	return number % div != 0;
+	for (i = 1; i <= htab->size; ++i) {
+		if (old[i].used <= 0)
+			continue;
+		pos = old[i].used & (size - 1);
+		for (step = 1; table[pos + 1].used; ++step)
+			pos = (pos + step) & (size - 1);
+		table[pos + 1] = old[i];
+	}
+
+	free(old);
+	htab->table = table;
+	htab->size = size;
+	htab->deleted = 0;
+	return 1;
 }
 
+/*
+ * Make room for N more entries, keeping at least a quarter of the slots
+ * never used so that unsuccessful searches end quickly. If the deleted
+ * slots are what is in the way, rehashing at the same size is enough.
+ */
+static int hreserve(struct hsearch_data *htab, size_t n)
+{
+	size_t want = htab->filled + n;
+
+	if ((want + htab->deleted) * 4 <= htab->size * 3)
+		return 1;
+	return hresize(htab, hsize(want > htab->size / 2 ? want * 2 : want));
+}
+
+/* Free all entries, but keep the table */
+static void hclear(struct hsearch_data *htab)
+{
+	unsigned int i;
+
+	for (i = 1; i <= htab->size; ++i) {
+		if (htab->table[i].used > 0) {
+			free(htab->table[i].entry.key);
+			free(htab->table[i].entry.data);
+		}
+	}
+	memset(htab->table, 0, (htab->size + 1) * sizeof(_ENTRY));
+	htab->filled = 0;
+	htab->deleted = 0;
+}
+
+
+/*
+ * hcreate()
+ */
+
 /*
  * Before using the hash table we must allocate memory for it.
- * Test for an existing table are done. We allocate one element
- * more as the found prime number says. This is done for more effective
- * indexing as explained in the comment for the hsearch function.
- * The contents of the table is zeroed, especially the field used
- * becomes zero.
+ * Test for an existing table are done. NEL is only a hint: the table
+ * grows as entries are added. We allocate one element more than the
+ * table size, as slot zero is not used (see above). The contents of
+ * the table is zeroed, especially the field used becomes zero.
  */
 
 int hcreate_r(size_t nel, struct hsearch_data *htab)
@@ -113,13 +229,9 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 	if (htab->table != NULL)
 		return 0;
 
-	/* Change nel to the first prime number not smaller as nel. */
-	nel |= 1;		/* make odd */
-	while (!isprime(nel))
-		nel += 2;
-
-	htab->size = nel;
+	htab->size = hsize(nel);
 	htab->filled = 0;
+	htab->deleted = 0;
 
 	/* allocate memory and zero out */
 	htab->table = (_ENTRY *) calloc(htab->size + 1, sizeof(_ENTRY));
@@ -142,8 +254,6 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 
 void hdestroy_r(struct hsearch_data *htab)
 {
-	int i;
-
 	/* Test for correct arguments.  */
 	if (htab == NULL) {
 		__set_errno(EINVAL);
@@ -151,18 +261,13 @@ void hdestroy_r(struct hsearch_data *htab)
 	}
 
 	/* free used memory */
-	for (i = 1; i <= htab->size; ++i) {
-		if (htab->table[i].used > 0) {
-			ENTRY *ep = &htab->table[i].entry;
-
-			free(ep->key);
-			free(ep->data);
-		}
-	}
+	if (htab->table)
+		hclear(htab);
 	free(htab->table);
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
+	htab->size = 0;
 }
 
 /*
@@ -170,19 +275,12 @@ void hdestroy_r(struct hsearch_data *htab)
  */
 
 /*
- * This is the search function. It uses double hashing with open addressing.
- * The argument item.key has to be a pointer to an zero terminated, most
- * probably strings of chars. The function for generating a number of the
- * strings is simple but fast. It can be replaced by a more complex function
- * like ajw (see [Aho,Sethi,Ullman]) if the needs are shown.
- *
- * We use an trick to speed up the lookup. The table is created by hcreate
- * with one more element available. This enables us to use the index zero
- * special. This index will never be used because we store the first hash
- * index in the field used where zero means not used. Every other value
- * means used. The used field can be used as a first fast comparison for
- * equality of the stored and the parameter value. This helps to prevent
- * unnecessary expensive calls of strcmp.
+ * This is the search function. It uses open addressing in a table that
+ * grows as needed. The argument item.key has to be a pointer to an zero
+ * terminated, most probably strings of chars. The hash value of the key
+ * is kept in the field used of its slot, which serves as a first fast
+ * comparison for equality of the stored and the parameter value. This
+ * helps to prevent unnecessary expensive calls of strcmp.
  *
  * This implementation differs from the standard library version of
  * this function in a number of ways:
@@ -199,7 +297,8 @@ void hdestroy_r(struct hsearch_data *htab)
  * - Instead of returning 1 on success, we return the index into the
  *   internal hash table, which is also guaranteed to be positive.
  *   This allows us direct access to the found hash table slot for
- *   example for functions like hdelete().
+ *   example for functions like hdelete(). The index of an entry only
+ *   holds until the next entry is added.
  */
 
 int hmatch_r(const char *match, int last_idx, ENTRY ** retval,
@@ -208,8 +307,8 @@ int hmatch_r(const char *match, int last_idx, ENTRY ** retval,
 	unsigned int idx;
 	size_t key_len = strlen(match);
 
-	for (idx = last_idx + 1; idx < htab->size; ++idx) {
-		if (htab->table[idx].used > 0)
+	for (idx = last_idx + 1; idx <= htab->size; ++idx) {
+		if (htab->table[idx].used <= 0)
 			continue;
 		if (!strncmp(match, htab->table[idx].entry.key, key_len)) {
 			*retval = &htab->table[idx].entry;
@@ -222,147 +321,93 @@ int hmatch_r(const char *match, int last_idx, ENTRY ** retval,
 	return 0;
 }
 
-int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
-	      struct hsearch_data *htab)
+/* Replace the data of an entry, in place if the new value fits */
+static int hsetdata(ENTRY *ep, const char *data)
 {
-	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
-	unsigned int idx;
-	unsigned int first_deleted = 0;
+	size_t len = strlen(data);
+	char *s;
 
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
+	if (len <= strlen(ep->data)) {
+		memmove(ep->data, data, len + 1);
+		return 1;
 	}
 
-	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
-	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
-
-	/* The first index tried. */
-	idx = hval;
-
-	if (htab->table[idx].used) {
-		/*
-		 * Further action might be required according to the
-		 * action value.
-		 */
-		unsigned hval2;
-
-		if (htab->table[idx].used == -1
-		    && !first_deleted)
-			first_deleted = idx;
-
-		if (htab->table[idx].used == hval
-		    && strcmp(item.key, htab->table[idx].entry.key) == 0) {
-			/* Overwrite existing value? */
-			if ((action == ENTER) && (item.data != NULL)) {
-				free(htab->table[idx].entry.data);
-				htab->table[idx].entry.data =
-					strdup(item.data);
-				if (!htab->table[idx].entry.data) {
-					__set_errno(ENOMEM);
-					*retval = NULL;
-					return 0;
-				}
-			}
-			/* return found entry */
-			*retval = &htab->table[idx].entry;
-			return idx;
-		}
+	s = malloc(len + 1);
+	if (s == NULL)
+		return 0;
+	memcpy(s, data, len + 1);
+	free(ep->data);
+	ep->data = s;
+	return 1;
+}
 
-		/*
-		 * Second hash function:
-		 * as suggested in [Knuth]
-		 */
-		hval2 = 1 + hval % (htab->size - 2);
-
-		do {
-			/*
-			 * Because SIZE is prime this guarantees to
-			 * step through all available indices.
-			 */
-			if (idx <= hval2)
-				idx = htab->size + idx - hval2;
-			else
-				idx -= hval2;
-
-			/*
-			 * If we visited all entries leave the loop
-			 * unsuccessfully.
-			 */
-			if (idx == hval)
-				break;
-
-			/* If entry is found use it. */
-			if ((htab->table[idx].used == hval)
-			    && strcmp(item.key, htab->table[idx].entry.key) == 0) {
-				/* Overwrite existing value? */
-				if ((action == ENTER) && (item.data != NULL)) {
-					free(htab->table[idx].entry.data);
-					htab->table[idx].entry.data =
-						strdup(item.data);
-					if (!htab->table[idx].entry.data) {
-						__set_errno(ENOMEM);
-						*retval = NULL;
-						return 0;
-					}
-				}
-				/* return found entry */
-				*retval = &htab->table[idx].entry;
-				return idx;
+int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
+	      struct hsearch_data *htab)
+{
+	int hval = hhash(item.key);
+	unsigned int idx;
+	int found;
+	_ENTRY *ep;
+
+	idx = hfind(htab, item.key, hval, &found);
+
+	if (found) {
+		ep = &htab->table[idx];
+		/* Overwrite existing value? */
+		if ((action == ENTER) && (item.data != NULL)) {
+			if (!hsetdata(&ep->entry, item.data)) {
+				__set_errno(ENOMEM);
+				*retval = NULL;
+				return 0;
 			}
 		}
-		while (htab->table[idx].used);
+		/* return found entry */
+		*retval = &ep->entry;
+		return idx;
 	}
 
-	/* An empty bucket has been found. */
-	if (action == ENTER) {
-		/*
-		 * If table is full and another entry should be
-		 * entered return with error.
-		 */
-		if (htab->filled == htab->size) {
-			__set_errno(ENOMEM);
-			*retval = NULL;
-			return 0;
-		}
+	if (action != ENTER) {
+		__set_errno(ESRCH);
+		*retval = NULL;
+		return 0;
+	}
 
-		/*
-		 * Create new entry;
-		 * create copies of item.key and item.data
-		 */
-		if (first_deleted)
-			idx = first_deleted;
-
-		htab->table[idx].used = hval;
-		htab->table[idx].entry.key = strdup(item.key);
-		htab->table[idx].entry.data = strdup(item.data);
-		if (!htab->table[idx].entry.key ||
-		    !htab->table[idx].entry.data) {
+	/*
+	 * Taking a never used slot may leave too few of them: grow the
+	 * table (or clear it of deleted slots) first, and search again.
+	 */
+	if (idx == 0 || htab->table[idx].used == 0) {
+		if (!hreserve(htab, 1)) {
 			__set_errno(ENOMEM);
 			*retval = NULL;
 			return 0;
 		}
+		idx = hfind(htab, item.key, hval, &found);
+	}
+	ep = &htab->table[idx];
 
-		++htab->filled;
-
-		/* return new entry */
-		*retval = &htab->table[idx].entry;
-		return 1;
+	/*
+	 * Create new entry;
+	 * create copies of item.key and item.data
+	 */
+	ep->entry.key = strdup(item.key);
+	ep->entry.data = strdup(item.data);
+	if (!ep->entry.key || !ep->entry.data) {
+		free(ep->entry.key);
+		free(ep->entry.data);
+		__set_errno(ENOMEM);
+		*retval = NULL;
+		return 0;
 	}
 
-	__set_errno(ESRCH);
-	*retval = NULL;
-	return 0;
+	if (ep->used == -1)
+		--htab->deleted;
+	ep->used = hval;
+	++htab->filled;
+
+	/* return new entry */
+	*retval = &ep->entry;
+	return idx;
 }
 
 
@@ -395,9 +440,12 @@ int hdelete_r(const char *key, struct hsearch_data *htab)
 
 	free(ep->key);
 	free(ep->data);
+	ep->key = NULL;
+	ep->data = NULL;
 	htab->table[idx].used = -1;
 
 	--htab->filled;
+	++htab->deleted;
 
 	return 1;
 }
@@ -455,7 +503,7 @@ static int cmpkey(const void *p1, const void *p2)
 ssize_t hexport_r(struct hsearch_data *htab, const char sep,
 		 char **resp, size_t size)
 {
-	ENTRY *list[htab->size];
+	ENTRY *list[htab->filled];
 	char *res, *p;
 	size_t totlen;
 	int i, n;
@@ -579,7 +627,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep,
  * The "flag" argument can be used to control the behaviour: when the
  * H_NOCLEAR bit is set, then an existing hash table will kept, i. e.
  * new data will be added to an existing hash table; otherwise, old
- * data will be discarded and a new hash table will be created.
+ * data will be discarded first.
  *
  * The separator character for the "name=value" pairs can be selected,
  * so we both support importing from externally stored environment
@@ -606,6 +654,7 @@ int himport_r(struct hsearch_data *htab,
 	      const char *env, size_t size, const char sep, int flag)
 {
 	char *data, *sp, *dp, *name, *value;
+	size_t nent;
 
 	/* Test for correct arguments.  */
 	if (htab == NULL) {
@@ -622,37 +671,32 @@ int himport_r(struct hsearch_data *htab,
 	memcpy(data, env, size);
 	dp = data;
 
-	if ((flag & H_NOCLEAR) == 0) {
-		/* Destroy old hash table if one exists */
-		debug("Destroy Hash Table: %p table = %p\n", htab,
+	/*
+	 * Count the entries (as an upper bound: comments and deletions are
+	 * counted too), so that the table is sized once for all of them
+	 * rather than grown along the way.
+	 */
+	for (nent = 0, sp = data; sp < data + size && *sp; ++sp) {
+		++nent;
+		while (sp < data + size - 1 && *sp && *sp != sep)
+			++sp;
+	}
+
+	if ((flag & H_NOCLEAR) == 0 && htab->table) {
+		/* Empty the old hash table, but keep it for the new data */
+		debug("Clear Hash Table: %p table = %p\n", htab,
 		       htab->table);
-		if (htab->table)
-			hdestroy_r(htab);
+		hclear(htab);
 	}
 
 	/*
-	 * Create new hash table (if needed).  The computation of the hash
-	 * table size is based on heuristics: in a sample of some 70+
-	 * existing systems we found an average size of 39+ bytes per entry
-	 * in the environment (for the whole key=value pair). Assuming a
-	 * size of 8 per entry (= safety factor of ~5) should provide enough
-	 * safety margin for any existing environment definitions and still
-	 * allow for more than enough dynamic additions. Note that the
-	 * "size" argument is supposed to give the maximum enviroment size
-	 * (CONFIG_ENV_SIZE).  This heuristics will result in
-	 * unreasonably large numbers (and thus memory footprint) for
-	 * big flash environments (>8,000 entries for 64 KB
-	 * envrionment size), so we clip it to a reasonable value.
-	 * On the other hand we need to add some more entries for free
-	 * space when importing very small buffers. Both boundaries can
-	 * be overwritten in the board config file if needed.
+	 * Create new hash table (if needed), with some room for dynamic
+	 * additions; CONFIG_ENV_MIN_ENTRIES can be overwritten in the
+	 * board config file if needed. The table grows as needed later.
 	 */
-
 	if (!htab->table) {
-		int nent = CONFIG_ENV_MIN_ENTRIES + size / 8;
-
-		if (nent > CONFIG_ENV_MAX_ENTRIES)
-			nent = CONFIG_ENV_MAX_ENTRIES;
+		if (nent < CONFIG_ENV_MIN_ENTRIES)
+			nent = CONFIG_ENV_MIN_ENTRIES;
 
 		debug("Create Hash Table: N=%d\n", nent);
 
@@ -660,6 +704,10 @@ int himport_r(struct hsearch_data *htab,
 			free(data);
 			return 0;
 		}
+	} else if (hreserve(htab, nent) == 0) {
+		free(data);
+		__set_errno(ENOMEM);
+		return 0;
 	}
 
 	/* Parse environment; allow for '\0' and 'sep' as separators */
@@ -715,6 +763,7 @@ int himport_r(struct hsearch_data *htab,
 		if (rv == NULL) {
 			printf("himport_r: can't insert \"%s=%s\" into hash table\n",
 				name, value);
+			free(data);
 			return 0;
 		}
 
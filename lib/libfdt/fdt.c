@@ -53,6 +53,9 @@
 #ifndef USE_HOSTCC
 #include <fdt.h>
 #include <libfdt.h>
+#ifdef CONFIG_OF_INDEX
+#include <fdt_index.h>
+#endif
 #else
 #include "fdt_host.h"
 #endif
@@ -212,6 +215,9 @@ int fdt_move(const void *fdt, void *buf, int bufsize)
 	if (fdt_totalsize(fdt) > bufsize)
 		return -FDT_ERR_NOSPACE;
 
+#ifdef CONFIG_OF_INDEX
+	fdt_index_invalidate(buf);
+#endif
 	memmove(buf, fdt, fdt_totalsize(fdt));
 	return 0;
 }
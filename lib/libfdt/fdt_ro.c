@@ -53,6 +53,9 @@
 #ifndef USE_HOSTCC
 #include <fdt.h>
 #include <libfdt.h>
+#ifdef CONFIG_OF_INDEX
+#include <fdt_index.h>
+#endif
 #else
 #include "fdt_host.h"
 #endif
@@ -116,6 +119,10 @@ int fdt_subnode_offset_namelen(const void *fdt, int offset,
 
 	FDT_CHECK_HEADER(fdt);
 
+#ifdef CONFIG_OF_INDEX
+	if (fdt_index_subnode_offset(fdt, &offset, name, namelen))
+		return offset;
+#endif
 	for (depth = 0;
 	     (offset >= 0) && (depth >= 0);
 	     offset = fdt_next_node(fdt, offset, &depth))
@@ -142,6 +149,10 @@ int fdt_path_offset(const void *fdt, const char *path)
 
 	FDT_CHECK_HEADER(fdt);
 
+#ifdef CONFIG_OF_INDEX
+	if (fdt_index_path_offset(fdt, path, &offset))
+		return offset;
+#endif
 	/* see if we have an alias */
 	if (*path != '/') {
 		const char *q = strchr(path, '/');
@@ -290,6 +301,12 @@ const char *fdt_get_alias_namelen(const void *fdt,
 {
 	int aliasoffset;
 
+#ifdef CONFIG_OF_INDEX
+	const char *value;
+
+	if (fdt_index_get_alias(fdt, name, namelen, &value))
+		return value;
+#endif
 	aliasoffset = fdt_path_offset(fdt, "/aliases");
 	if (aliasoffset < 0)
 		return NULL;
@@ -440,8 +457,16 @@ int fdt_node_offset_by_prop_value(const void *fdt, int startoffset,
 
 int fdt_node_offset_by_phandle(const void *fdt, uint32_t phandle)
 {
+#ifdef CONFIG_OF_INDEX
+	int offset;
+#endif
+
 	if ((phandle == 0) || (phandle == -1))
 		return -FDT_ERR_BADPHANDLE;
+#ifdef CONFIG_OF_INDEX
+	if (fdt_index_node_by_phandle(fdt, phandle, &offset))
+		return offset;
+#endif
 	phandle = cpu_to_fdt32(phandle);
 	return fdt_node_offset_by_prop_value(fdt, -1, "linux,phandle",
 					     &phandle, sizeof(phandle));
@@ -487,6 +512,11 @@ int fdt_node_offset_by_compatible(const void *fdt, int startoffset,
 
 	FDT_CHECK_HEADER(fdt);
 
+#ifdef CONFIG_OF_INDEX
+	if (fdt_index_node_by_compatible(fdt, startoffset, compatible,
+					 &offset))
+		return offset;
+#endif
 	/* FIXME: The algorithm here is pretty horrible: we scan each
 	 * property of a node in fdt_node_check_compatible(), then if
 	 * that didn't find what we want, we scan over them again
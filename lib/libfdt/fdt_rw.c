@@ -53,6 +53,9 @@
 #ifndef USE_HOSTCC
 #include <fdt.h>
 #include <libfdt.h>
+#ifdef CONFIG_OF_INDEX
+#include <fdt_index.h>
+#endif
 #else
 #include "fdt_host.h"
 #endif
@@ -75,6 +78,9 @@ static int _fdt_rw_check_header(void *fdt)
 {
 	FDT_CHECK_HEADER(fdt);
 
+#ifdef CONFIG_OF_INDEX
+	fdt_index_invalidate(fdt);
+#endif
 	if (fdt_version(fdt) < 17)
 		return -FDT_ERR_BADVERSION;
 	if (_fdt_blocks_misordered(fdt, sizeof(struct fdt_reserve_entry),
@@ -430,6 +436,9 @@ int fdt_open_into(const void *fdt, void *buf, int bufsize)
 
 	FDT_CHECK_HEADER(fdt);
 
+#ifdef CONFIG_OF_INDEX
+	fdt_index_invalidate(buf);
+#endif
 	mem_rsv_size = (fdt_num_mem_rsv(fdt)+1)
 		* sizeof(struct fdt_reserve_entry);
 
@@ -52,6 +52,9 @@
 
 #include <fdt.h>
 #include <libfdt.h>
+#ifdef CONFIG_OF_INDEX
+#include <fdt_index.h>
+#endif
 
 #include "libfdt_internal.h"
 
@@ -92,6 +95,9 @@ int fdt_create(void *buf, int bufsize)
 	if (bufsize < sizeof(struct fdt_header))
 		return -FDT_ERR_NOSPACE;
 
+#ifdef CONFIG_OF_INDEX
+	fdt_index_invalidate(buf);
+#endif
 	memset(buf, 0, bufsize);
 
 	fdt_set_magic(fdt, FDT_SW_MAGIC);
@@ -53,6 +53,9 @@
 #ifndef USE_HOSTCC
 #include <fdt.h>
 #include <libfdt.h>
+#ifdef CONFIG_OF_INDEX
+#include <fdt_index.h>
+#endif
 #else
 #include "fdt_host.h"
 #endif
@@ -69,6 +72,9 @@ int fdt_setprop_inplace(void *fdt, int nodeoffset, const char *name,
 	if (! propval)
 		return proplen;
 
+#ifdef CONFIG_OF_INDEX
+	fdt_index_invalidate(fdt);
+#endif
 	if (proplen != len)
 		return -FDT_ERR_NOSPACE;
 
@@ -93,6 +99,9 @@ int fdt_nop_property(void *fdt, int nodeoffset, const char *name)
 	if (! prop)
 		return len;
 
+#ifdef CONFIG_OF_INDEX
+	fdt_index_invalidate(fdt);
+#endif
 	_fdt_nop_region(prop, len + sizeof(*prop));
 
 	return 0;
@@ -116,6 +125,9 @@ int fdt_nop_node(void *fdt, int nodeoffset)
 	if (endoffset < 0)
 		return endoffset;
 
+#ifdef CONFIG_OF_INDEX
+	fdt_index_invalidate(fdt);
+#endif
 	_fdt_nop_region(fdt_offset_ptr_w(fdt, nodeoffset, 0),
 			endoffset - nodeoffset);
 	return 0;
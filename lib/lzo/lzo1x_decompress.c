@@ -11,18 +11,55 @@
  *  Richard Purdie <rpurdie@openedhand.com>
  */
 
+#ifndef USE_HOSTCC
 #include <common.h>
-#include <linux/lzo.h>
 #include <asm/byteorder.h>
 #include <asm/unaligned.h>
+#else
+#include "compiler.h"
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+#include <linux/unaligned/le_byteshift.h>
+#include <linux/unaligned/be_byteshift.h>
+#include <linux/unaligned/generic.h>
+#define get_unaligned	__get_unaligned_le
+#define put_unaligned	__put_unaligned_le
+#define ARRAY_SIZE(x)	(sizeof(x) / sizeof((x)[0]))
+#endif
+#include <linux/lzo.h>
 #include "lzodefs.h"
 
-#define HAVE_IP(x, ip_end, ip) ((size_t)(ip_end - ip) < (x))
-#define HAVE_OP(x, op_end, op) ((size_t)(op_end - op) < (x))
-#define HAVE_LB(m_pos, out, op) (m_pos < out || m_pos >= op)
-
-#define COPY4(dst, src)	\
-		put_unaligned(get_unaligned((const u32 *)(src)), (u32 *)(dst))
+/*
+ * Instructions are decoded with the bounds checks hoisted to one test
+ * per instruction rather than one per byte.  Where unaligned word access
+ * is cheap, a literal run or match which has at least 15 bytes of slack
+ * left in both buffers is copied in 8-byte steps; the copy may run past
+ * the end of the run, but never past the checked slack, and the extra
+ * bytes are overwritten by the next instruction.  Near the ends of the
+ * buffers every copy falls back to the byte loop, so the decoder stays
+ * safe for untrusted input.
+ */
+#if defined(__i386__) || defined(__x86_64__) || \
+	defined(__ARM_FEATURE_UNALIGNED)
+#define LZO_FAST_COPY
+#endif
+
+#define HAVE_IP(x)	((size_t)(ip_end - ip) >= (size_t)(x))
+#define HAVE_OP(x)	((size_t)(op_end - op) >= (size_t)(x))
+#define NEED_IP(x)	if (!HAVE_IP(x)) goto input_overrun
+#define NEED_OP(x)	if (!HAVE_OP(x)) goto output_overrun
+#define TEST_LB(m_pos)	if ((m_pos) < out) goto lookbehind_overrun
+
+/* Longest run of zero length bytes which cannot overflow a size_t */
+#define MAX_255_COUNT	((((size_t)~0) / 255) - 2)
+
+#ifdef LZO_FAST_COPY
+/* -fno-builtin is in effect, so ask for the inline expansion directly */
+#define COPY4(dst, src)	__builtin_memcpy(dst, src, 4)
+#define COPY8(dst, src)	__builtin_memcpy(dst, src, 8)
+#endif
 
 static const unsigned char lzop_magic[] = {
 	0x89, 0x4c, 0x5a, 0x4f, 0x00, 0x0d, 0x0a, 0x1a, 0x0a
@@ -118,206 +155,234 @@ int lzo1x_decompress_safe(const unsigned char *in, size_t in_len,
 	unsigned char * const op_end = out + *out_len;
 	const unsigned char *ip = in, *m_pos;
 	unsigned char *op = out;
-	size_t t;
+	size_t t, next;
+	size_t state = 0;
 
 	*out_len = 0;
 
+	/*
+	 * Every path back to the top of the loop leaves at least three
+	 * input bytes: the next instruction and its offset bytes.
+	 */
+	if (in_len < 3)
+		goto input_overrun;
 	if (*ip > 17) {
 		t = *ip++ - 17;
-		if (t < 4)
+		if (t < 4) {
+			next = t;
 			goto match_next;
-		if (HAVE_OP(t, op_end, op))
-			goto output_overrun;
-		if (HAVE_IP(t + 1, ip_end, ip))
-			goto input_overrun;
-		do {
-			*op++ = *ip++;
-		} while (--t > 0);
-		goto first_literal_run;
-	}
-
-	while ((ip < ip_end)) {
-		t = *ip++;
-		if (t >= 16)
-			goto match;
-		if (t == 0) {
-			if (HAVE_IP(1, ip_end, ip))
-				goto input_overrun;
-			while (*ip == 0) {
-				t += 255;
-				ip++;
-				if (HAVE_IP(1, ip_end, ip))
-					goto input_overrun;
-			}
-			t += 15 + *ip++;
-		}
-		if (HAVE_OP(t + 3, op_end, op))
-			goto output_overrun;
-		if (HAVE_IP(t + 4, ip_end, ip))
-			goto input_overrun;
-
-		COPY4(op, ip);
-		op += 4;
-		ip += 4;
-		if (--t > 0) {
-			if (t >= 4) {
-				do {
-					COPY4(op, ip);
-					op += 4;
-					ip += 4;
-					t -= 4;
-				} while (t >= 4);
-				if (t > 0) {
-					do {
-						*op++ = *ip++;
-					} while (--t > 0);
-				}
-			} else {
-				do {
-					*op++ = *ip++;
-				} while (--t > 0);
-			}
 		}
+		goto copy_literal_run;
+	}
 
-first_literal_run:
+	for (;;) {
 		t = *ip++;
-		if (t >= 16)
-			goto match;
-		m_pos = op - (1 + M2_MAX_OFFSET);
-		m_pos -= t >> 2;
-		m_pos -= *ip++ << 2;
-
-		if (HAVE_LB(m_pos, out, op))
-			goto lookbehind_overrun;
-
-		if (HAVE_OP(3, op_end, op))
-			goto output_overrun;
-		*op++ = *m_pos++;
-		*op++ = *m_pos++;
-		*op++ = *m_pos;
-
-		goto match_done;
-
-		do {
-match:
-			if (t >= 64) {
-				m_pos = op - 1;
-				m_pos -= (t >> 2) & 7;
-				m_pos -= *ip++ << 3;
-				t = (t >> 5) - 1;
-				if (HAVE_LB(m_pos, out, op))
-					goto lookbehind_overrun;
-				if (HAVE_OP(t + 3 - 1, op_end, op))
-					goto output_overrun;
-				goto copy_match;
-			} else if (t >= 32) {
-				t &= 31;
+		if (t < 16) {
+			if (state == 0) {
+				/* literal run */
 				if (t == 0) {
-					if (HAVE_IP(1, ip_end, ip))
-						goto input_overrun;
+					const unsigned char *ip_last = ip;
+					size_t offset;
+
 					while (*ip == 0) {
-						t += 255;
 						ip++;
-						if (HAVE_IP(1, ip_end, ip))
-							goto input_overrun;
+						NEED_IP(1);
 					}
-					t += 31 + *ip++;
+					offset = ip - ip_last;
+					if (offset > MAX_255_COUNT)
+						return LZO_E_ERROR;
+					offset = (offset << 8) - offset;
+					t += offset + 15 + *ip++;
 				}
-				m_pos = op - 1;
-				m_pos -= get_unaligned_le16(ip) >> 2;
-				ip += 2;
-			} else if (t >= 16) {
-				m_pos = op;
-				m_pos -= (t & 8) << 11;
+				t += 3;
+copy_literal_run:
+				NEED_OP(t);
+				NEED_IP(t + 3);
+#ifdef LZO_FAST_COPY
+				if (HAVE_IP(t + 15) && HAVE_OP(t + 15)) {
+					const unsigned char *ie = ip + t;
+					unsigned char *oe = op + t;
 
-				t &= 7;
-				if (t == 0) {
-					if (HAVE_IP(1, ip_end, ip))
-						goto input_overrun;
-					while (*ip == 0) {
-						t += 255;
-						ip++;
-						if (HAVE_IP(1, ip_end, ip))
-							goto input_overrun;
-					}
-					t += 7 + *ip++;
+					do {
+						COPY8(op, ip);
+						COPY8(op + 8, ip + 8);
+						op += 16;
+						ip += 16;
+					} while (ip < ie);
+					ip = ie;
+					op = oe;
+					t = 0;
 				}
-				m_pos -= get_unaligned_le16(ip) >> 2;
-				ip += 2;
-				if (m_pos == op)
-					goto eof_found;
-				m_pos -= 0x4000;
-			} else {
+				for (; t >= 16; t -= 16) {
+					COPY8(op, ip);
+					COPY8(op + 8, ip + 8);
+					op += 16;
+					ip += 16;
+				}
+#endif
+				for (; t > 0; t--)
+					*op++ = *ip++;
+				state = 4;
+				continue;
+			} else if (state != 4) {
+				/* M1: two byte match after a short literal */
+				next = t & 3;
 				m_pos = op - 1;
 				m_pos -= t >> 2;
 				m_pos -= *ip++ << 2;
-
-				if (HAVE_LB(m_pos, out, op))
-					goto lookbehind_overrun;
-				if (HAVE_OP(2, op_end, op))
-					goto output_overrun;
-
-				*op++ = *m_pos++;
-				*op++ = *m_pos;
-				goto match_done;
-			}
-
-			if (HAVE_LB(m_pos, out, op))
-				goto lookbehind_overrun;
-			if (HAVE_OP(t + 3 - 1, op_end, op))
-				goto output_overrun;
-
-			if (t >= 2 * 4 - (3 - 1) && (op - m_pos) >= 4) {
-				COPY4(op, m_pos);
-				op += 4;
-				m_pos += 4;
-				t -= 4 - (3 - 1);
-				do {
-					COPY4(op, m_pos);
-					op += 4;
-					m_pos += 4;
-					t -= 4;
-				} while (t >= 4);
-				if (t > 0)
-					do {
-						*op++ = *m_pos++;
-					} while (--t > 0);
+				TEST_LB(m_pos);
+				NEED_OP(2);
+				op[0] = m_pos[0];
+				op[1] = m_pos[1];
+				op += 2;
+				goto match_next;
 			} else {
-copy_match:
-				*op++ = *m_pos++;
-				*op++ = *m_pos++;
-				do {
-					*op++ = *m_pos++;
-				} while (--t > 0);
+				/* three byte match after a long literal */
+				next = t & 3;
+				m_pos = op - (1 + M2_MAX_OFFSET);
+				m_pos -= t >> 2;
+				m_pos -= *ip++ << 2;
+				t = 3;
+			}
+		} else if (t >= 64) {
+			/* M2 */
+			next = t & 3;
+			m_pos = op - 1;
+			m_pos -= (t >> 2) & 7;
+			m_pos -= *ip++ << 3;
+			t = (t >> 5) - 1 + (3 - 1);
+		} else if (t >= 32) {
+			/* M3 */
+			t = (t & 31) + (3 - 1);
+			if (t == 2) {
+				const unsigned char *ip_last = ip;
+				size_t offset;
+
+				while (*ip == 0) {
+					ip++;
+					NEED_IP(1);
+				}
+				offset = ip - ip_last;
+				if (offset > MAX_255_COUNT)
+					return LZO_E_ERROR;
+				offset = (offset << 8) - offset;
+				t += offset + 31 + *ip++;
+				NEED_IP(2);
+			}
+			m_pos = op - 1;
+			next = get_unaligned_le16(ip);
+			ip += 2;
+			m_pos -= next >> 2;
+			next &= 3;
+		} else {
+			/* M4, or the end of stream marker */
+			m_pos = op;
+			m_pos -= (t & 8) << 11;
+			t = (t & 7) + (3 - 1);
+			if (t == 2) {
+				const unsigned char *ip_last = ip;
+				size_t offset;
+
+				while (*ip == 0) {
+					ip++;
+					NEED_IP(1);
+				}
+				offset = ip - ip_last;
+				if (offset > MAX_255_COUNT)
+					return LZO_E_ERROR;
+				offset = (offset << 8) - offset;
+				t += offset + 7 + *ip++;
+				NEED_IP(2);
+			}
+			next = get_unaligned_le16(ip);
+			ip += 2;
+			m_pos -= next >> 2;
+			next &= 3;
+			if (m_pos == op)
+				goto eof_found;
+			m_pos -= 0x4000;
+		}
+		TEST_LB(m_pos);
+		NEED_OP(t);
+		{
+			unsigned char *oe = op + t;
+#ifdef LZO_FAST_COPY
+			/* with slack the block copies may run past oe */
+			int slack = HAVE_OP(t + 15);
+
+			if (slack || t >= 16) {
+				if (op - m_pos < 8) {
+					/*
+					 * A short distance repeats a pattern.
+					 * Write whole periods of it until the
+					 * source is at least 8 bytes back, so
+					 * that the word copies below only read
+					 * bytes which are already final.
+					 */
+					size_t dist = op - m_pos;
+					size_t step = dist, i;
+
+					while (step < 8)
+						step += dist;
+					for (i = 0; i < step; i++)
+						op[i] = m_pos[i];
+					op += step;
+					m_pos = op - step;
+				}
+				if (slack) {
+					while (op < oe) {
+						COPY8(op, m_pos);
+						COPY8(op + 8, m_pos + 8);
+						op += 16;
+						m_pos += 16;
+					}
+					op = oe;
+					if (HAVE_IP(6)) {
+						state = next;
+						COPY4(op, ip);
+						op += next;
+						ip += next;
+						continue;
+					}
+				}
+				while (oe - op >= 16) {
+					COPY8(op, m_pos);
+					COPY8(op + 8, m_pos + 8);
+					op += 16;
+					m_pos += 16;
+				}
 			}
-match_done:
-			t = ip[-2] & 3;
-			if (t == 0)
-				break;
+#endif
+			while (op < oe)
+				*op++ = *m_pos++;
+		}
 match_next:
-			if (HAVE_OP(t, op_end, op))
-				goto output_overrun;
-			if (HAVE_IP(t + 1, ip_end, ip))
-				goto input_overrun;
-
-			*op++ = *ip++;
-			if (t > 1) {
+		/* up to three literals trail each match */
+		state = next;
+		t = next;
+#ifdef LZO_FAST_COPY
+		if (HAVE_IP(6) && HAVE_OP(4)) {
+			COPY4(op, ip);
+			op += t;
+			ip += t;
+		} else
+#endif
+		{
+			NEED_IP(t + 3);
+			NEED_OP(t);
+			while (t > 0) {
 				*op++ = *ip++;
-				if (t > 2)
-					*op++ = *ip++;
+				t--;
 			}
-
-			t = *ip++;
-		} while (ip < ip_end);
+		}
 	}
 
-	*out_len = op - out;
-	return LZO_E_EOF_NOT_FOUND;
-
 eof_found:
 	*out_len = op - out;
-	return (ip == ip_end ? LZO_E_OK :
-		(ip < ip_end ? LZO_E_INPUT_NOT_CONSUMED : LZO_E_INPUT_OVERRUN));
+	return (t != 3 ? LZO_E_ERROR :
+		ip == ip_end ? LZO_E_OK :
+		ip < ip_end ? LZO_E_INPUT_NOT_CONSUMED : LZO_E_INPUT_OVERRUN);
+
 input_overrun:
 	*out_len = op - out;
 	return LZO_E_INPUT_OVERRUN;
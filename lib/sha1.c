@@ -34,6 +34,7 @@
 #include <linux/string.h>
 #else
 #include <string.h>
+#include "compiler.h"
 #endif /* USE_HOSTCC */
 #include <watchdog.h>
 #include "sha1.h"
@@ -73,28 +74,32 @@ void sha1_starts (sha1_context * ctx)
 	ctx->state[4] = 0xC3D2E1F0;
 }
 
+/*
+ * Load a message block as big-endian words. Blocks are usually word
+ * aligned (e.g. an image in memory), in which case whole words are loaded
+ * and byte-swapped rather than assembled a byte at a time.
+ */
+static inline void sha1_load_block (uint32_t W[16], const unsigned char *data)
+{
+	const uint32_t *src = (const uint32_t *)data;
+	int i;
+
+	if ((unsigned long)data & 3) {
+		for (i = 0; i < 16; i++)
+			GET_UINT32_BE (W[i], data, i * 4);
+	} else {
+		for (i = 0; i < 16; i++)
+			W[i] = be32_to_cpu (src[i]);
+	}
+}
+
 static void sha1_process (sha1_context * ctx, unsigned char data[64])
 {
-	unsigned long temp, W[16], A, B, C, D, E;
-
-	GET_UINT32_BE (W[0], data, 0);
-	GET_UINT32_BE (W[1], data, 4);
-	GET_UINT32_BE (W[2], data, 8);
-	GET_UINT32_BE (W[3], data, 12);
-	GET_UINT32_BE (W[4], data, 16);
-	GET_UINT32_BE (W[5], data, 20);
-	GET_UINT32_BE (W[6], data, 24);
-	GET_UINT32_BE (W[7], data, 28);
-	GET_UINT32_BE (W[8], data, 32);
-	GET_UINT32_BE (W[9], data, 36);
-	GET_UINT32_BE (W[10], data, 40);
-	GET_UINT32_BE (W[11], data, 44);
-	GET_UINT32_BE (W[12], data, 48);
-	GET_UINT32_BE (W[13], data, 52);
-	GET_UINT32_BE (W[14], data, 56);
-	GET_UINT32_BE (W[15], data, 60);
-
-#define S(x,n)	((x << n) | ((x & 0xFFFFFFFF) >> (32 - n)))
+	uint32_t temp, W[16], A, B, C, D, E;
+
+	sha1_load_block (W, data);
+
+#define S(x,n)	((x << n) | (x >> (32 - n)))
 
 #define R(t) (						\
 	temp = W[(t -  3) & 0x0F] ^ W[(t - 8) & 0x0F] ^	\
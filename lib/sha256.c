@@ -20,6 +20,8 @@
 
 #ifndef USE_HOSTCC
 #include <common.h>
+#else
+#include "compiler.h"
 #endif /* USE_HOSTCC */
 #include <watchdog.h>
 #include <linux/string.h>
@@ -60,30 +62,33 @@ void sha256_starts(sha256_context * ctx)
 	ctx->state[7] = 0x5BE0CD19;
 }
 
+/*
+ * Load a message block as big-endian words. Blocks are usually word
+ * aligned, in which case whole words are loaded and byte-swapped.
+ */
+static inline void sha256_load_block(uint32_t W[16], const uint8_t *data)
+{
+	const uint32_t *src = (const uint32_t *)data;
+	int i;
+
+	if ((unsigned long)data & 3) {
+		for (i = 0; i < 16; i++)
+			GET_UINT32_BE(W[i], data, i * 4);
+	} else {
+		for (i = 0; i < 16; i++)
+			W[i] = be32_to_cpu(src[i]);
+	}
+}
+
 void sha256_process(sha256_context * ctx, uint8_t data[64])
 {
 	uint32_t temp1, temp2;
-	uint32_t W[64];
+	uint32_t W[16];
 	uint32_t A, B, C, D, E, F, G, H;
 
-	GET_UINT32_BE(W[0], data, 0);
-	GET_UINT32_BE(W[1], data, 4);
-	GET_UINT32_BE(W[2], data, 8);
-	GET_UINT32_BE(W[3], data, 12);
-	GET_UINT32_BE(W[4], data, 16);
-	GET_UINT32_BE(W[5], data, 20);
-	GET_UINT32_BE(W[6], data, 24);
-	GET_UINT32_BE(W[7], data, 28);
-	GET_UINT32_BE(W[8], data, 32);
-	GET_UINT32_BE(W[9], data, 36);
-	GET_UINT32_BE(W[10], data, 40);
-	GET_UINT32_BE(W[11], data, 44);
-	GET_UINT32_BE(W[12], data, 48);
-	GET_UINT32_BE(W[13], data, 52);
-	GET_UINT32_BE(W[14], data, 56);
-	GET_UINT32_BE(W[15], data, 60);
-
-#define SHR(x,n) ((x & 0xFFFFFFFF) >> n)
+	sha256_load_block(W, data);
+
+#define SHR(x,n) (x >> n)
 #define ROTR(x,n) (SHR(x,n) | (x << (32 - n)))
 
 #define S0(x) (ROTR(x, 7) ^ ROTR(x,18) ^ SHR(x, 3))
@@ -95,10 +100,11 @@ void sha256_process(sha256_context * ctx, uint8_t data[64])
 #define F0(x,y,z) ((x & y) | (z & (x | y)))
 #define F1(x,y,z) (z ^ (x & (y ^ z)))
 
-#define R(t)					\
-(						\
-	W[t] = S1(W[t - 2]) + W[t - 7] +	\
-		S0(W[t - 15]) + W[t - 16]	\
+/* The schedule only ever looks 16 words back, so keep it in a ring */
+#define R(t)						\
+(							\
+	W[(t) & 15] += S1(W[((t) - 2) & 15]) +		\
+		W[((t) - 7) & 15] + S0(W[((t) - 15) & 15])	\
 )
 
 #define P(a,b,c,d,e,f,g,h,x,K) {		\
@@ -47,7 +47,7 @@ static const char *get_dev_name(const block_dev_desc_t *dev)
 	 */
 	static const char all_disk_types[IF_TYPE_MAX][8] = {
 		"UNKNOWN", "IDE", "SCSI", "ATAPI", "USB",
-		"DOC", "MMC", "SD", "SATA"};
+		"DOC", "MMC", "SD", "SATA", "HOST"};
 
 	if (dev->if_type >= IF_TYPE_MAX) {
 		return all_disk_types[0];
@@ -34,7 +34,7 @@ typedef struct
 	uchar		bp_hlen;	/* Hardware address length		*/
 # define HWL_ETHER	6
 	uchar		bp_hops;	/* Hop count (gateway thing)		*/
-	ulong		bp_id;		/* Transaction ID			*/
+	u32		bp_id;		/* Transaction ID			*/
 	ushort		bp_secs;	/* Seconds since boot			*/
 	ushort		bp_spare1;	/* Alignment				*/
 	IPaddr_t	bp_ciaddr;	/* Client IP address			*/
@@ -56,7 +56,7 @@ typedef struct
  */
 
 /* bootp.c */
-extern ulong	BootpID;		/* ID of cur BOOTP request		*/
+extern u32	BootpID;		/* ID of cur BOOTP request		*/
 extern char	BootFile[128];		/* Boot file name			*/
 extern int	BootpTry;
 #ifdef CONFIG_BOOTP_RANDOM_DELAY
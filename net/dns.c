@@ -30,6 +30,7 @@
 
 char *NetDNSResolve;	/* The host to resolve  */
 char *NetDNSenvvar;	/* The envvar to store the answer in */
+IPaddr_t NetDNSResolvedIP;	/* The answer, for other commands */
 
 static int DnsOurPort;
 
@@ -187,6 +188,7 @@ DnsHandler(uchar *pkt, unsigned dest, unsigned src, unsigned len)
 		memcpy(&IPAddress, p, 4);
 
 		if (p + dlen <= e) {
+			NetDNSResolvedIP = IPAddress;
 			ip_to_string(IPAddress, IPStr);
 			printf("%s\n", IPStr);
 			if (NetDNSenvvar)
@@ -203,6 +205,7 @@ DnsStart(void)
 {
 	debug("%s\n", __func__);
 
+	NetDNSResolvedIP = 0;
 	NetSetTimeout(DNS_TIMEOUT, DnsTimeout);
 	NetSetHandler(DnsHandler);
 
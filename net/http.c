@@ -0,0 +1,377 @@
+/*
+ * HTTP/1.1 GET client, over the minimal TCP in tcp.c
+ *
+ * The response body is stored at load_addr. Bodies with a
+ * Content-Length, chunked ones and ones ended by the server closing the
+ * connection are all understood. Redirects are not followed.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2, or (at
+ * your option) any later version.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <net.h>
+#include <linux/ctype.h>
+#include "tcp.h"
+#include "http.h"
+
+#define HASHES_PER_LINE	65		/* Number of "loading" hashes per line	*/
+#define HTTP_HASH_BYTES	(64 * 1024)	/* Bytes per "loading" hash		*/
+
+IPaddr_t NetHttpServerIP;	/* server to get from, 0 if not resolved */
+char NetHttpHost[64];		/* its name, for the Host: header	*/
+static int HttpPort;
+static char HttpPath[128];
+
+#define STATE_HEADER		0	/* status line and header fields */
+#define STATE_BODY		1	/* body, up to HttpLength	*/
+#define STATE_CHUNK_SIZE	2	/* chunked body: size line	*/
+#define STATE_CHUNK_EXT		3	/* rest of the size line	*/
+#define STATE_CHUNK_DATA	4
+#define STATE_CHUNK_END		5	/* CRLF after the data		*/
+#define STATE_DONE		6
+
+static int HttpState;
+static char HttpHeader[1024];		/* header received so far	*/
+static int HttpHeaderLen;
+static ulong HttpLength;		/* Content-Length, ~0 if none	*/
+static ulong HttpChunkLeft;
+static ulong HttpStartTime;
+
+/*
+ * Parse "[http://]host[:port][/path]". A host given as an IP address is
+ * resolved at once, others are left to DNS (NetHttpServerIP stays 0).
+ */
+int
+HttpSetURL(const char *url)
+{
+	const char *path, *port;
+	int n;
+
+	if (strncmp(url, "http://", 7) == 0)
+		url += 7;
+
+	path = strchr(url, '/');
+	if (path == NULL)
+		path = url + strlen(url);
+	port = strchr(url, ':');
+	if (port == NULL || port > path)
+		port = path;
+
+	n = port - url;
+	if (n == 0 || n >= sizeof(NetHttpHost))
+		return -1;
+	memcpy(NetHttpHost, url, n);
+	NetHttpHost[n] = '\0';
+
+	HttpPort = HTTP_PORT;
+	if (port < path) {
+		HttpPort = simple_strtoul(port + 1, NULL, 10);
+		if (HttpPort <= 0 || HttpPort > 0xffff)
+			return -1;
+	}
+
+	if (strlen(path) >= sizeof(HttpPath))
+		return -1;
+	strcpy(HttpPath, *path ? path : "/");
+
+	NetHttpServerIP = 0;
+	if (strspn(NetHttpHost, "0123456789.") == n)
+		NetHttpServerIP = string_to_ip(NetHttpHost);
+	return 0;
+}
+
+static void
+HttpDone(int ok)
+{
+	ulong time;
+
+	HttpState = STATE_DONE;
+	NetSetRxDest(NULL, 0, 0);
+	TcpClose();
+	if (!ok) {
+		NetState = NETLOOP_FAIL;
+		return;
+	}
+
+	time = get_timer(HttpStartTime);
+	if (time > 0) {
+		puts("  ");
+		print_size(NetBootFileXferSize / time * 1000, "/s");
+	}
+	puts("\ndone\n");
+	NetState = NETLOOP_SUCCESS;
+}
+
+static void
+store_block(uchar *src, unsigned len)
+{
+	uchar *dst = (uchar *)load_addr + NetBootFileXferSize;
+	ulong before = NetBootFileXferSize / HTTP_HASH_BYTES;
+
+	/* A driver may already have received it in place */
+	if (dst != src)
+		memmove(dst, src, len);
+	NetBootFileXferSize += len;
+
+	while (before++ < NetBootFileXferSize / HTTP_HASH_BYTES) {
+		putc('#');
+		if (before % HASHES_PER_LINE == 0)
+			puts("\n\t ");
+	}
+}
+
+/* Let a driver receive the next part of the body right where it goes */
+static void
+HttpSetRxDest(void)
+{
+	if (HttpState != STATE_BODY || HttpLength == ~0UL)
+		return;
+	NetSetRxDest((void *)(load_addr + NetBootFileXferSize),
+		     TCP_HDR_SIZE - (IP_HDR_SIZE - IP_HDR_SIZE_NO_UDP),
+		     HttpLength - NetBootFileXferSize);
+}
+
+/* Case insensitive match of a lower case prefix */
+static int
+HttpMatch(const char *p, const char *prefix)
+{
+	while (*prefix)
+		if (tolower(*p++) != *prefix++)
+			return 0;
+	return 1;
+}
+
+static int
+HttpParseHeader(void)
+{
+	char *p, *end;
+	int status;
+
+	/* Status line: "HTTP/1.x NNN reason" */
+	p = strchr(HttpHeader, ' ');
+	if (strncmp(HttpHeader, "HTTP/", 5) || p == NULL)
+		return -1;
+	status = simple_strtoul(p + 1, NULL, 10);
+	if (status != 200) {
+		end = strchr(HttpHeader, '\r');
+		if (end)
+			*end = '\0';
+		printf("\nHTTP error: %s\n", HttpHeader);
+		return -1;
+	}
+
+	HttpLength = ~0UL;
+	HttpState = STATE_BODY;
+	for (p = strchr(HttpHeader, '\n'); p; p = strchr(p, '\n')) {
+		p++;
+		if (HttpMatch(p, "content-length:")) {
+			/* simple_strtoul() does not skip the blanks itself */
+			for (p += 15; *p == ' ' || *p == '\t'; p++)
+				;
+			HttpLength = simple_strtoul(p, NULL, 10);
+		} else if (HttpMatch(p, "transfer-encoding:")) {
+			end = strchr(p, '\r');
+			if (end && end - p > 18 + 7 &&
+			    HttpMatch(end - 7, "chunked"))
+				HttpState = STATE_CHUNK_SIZE;
+		}
+	}
+	if (HttpState == STATE_CHUNK_SIZE) {
+		HttpLength = ~0UL;
+		HttpChunkLeft = 0;
+	}
+	return 0;
+}
+
+static void
+HttpBody(uchar *p, unsigned len)
+{
+	unsigned n;
+	int c;
+
+	while (len && HttpState != STATE_DONE) {
+		switch (HttpState) {
+		case STATE_BODY:
+			n = len;
+			if (HttpLength != ~0UL &&
+			    n > HttpLength - NetBootFileXferSize)
+				n = HttpLength - NetBootFileXferSize;
+			store_block(p, n);
+			p += n;
+			len -= n;
+			if (NetBootFileXferSize == HttpLength)
+				HttpDone(1);
+			break;
+
+		case STATE_CHUNK_SIZE:
+			c = *p++;
+			len--;
+			if (c >= '0' && c <= '9')
+				HttpChunkLeft = HttpChunkLeft * 16 + c - '0';
+			else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+				HttpChunkLeft = HttpChunkLeft * 16 +
+						(c | 0x20) - 'a' + 10;
+			else if (c == '\n')
+				HttpState = HttpChunkLeft ?
+					    STATE_CHUNK_DATA : STATE_DONE;
+			else
+				HttpState = STATE_CHUNK_EXT;
+			/* the last chunk has size 0; its trailer is ignored */
+			if (HttpState == STATE_DONE)
+				HttpDone(1);
+			break;
+
+		case STATE_CHUNK_EXT:
+			c = *p++;
+			len--;
+			if (c != '\n')
+				break;
+			HttpState = HttpChunkLeft ?
+				    STATE_CHUNK_DATA : STATE_DONE;
+			if (HttpState == STATE_DONE)
+				HttpDone(1);
+			break;
+
+		case STATE_CHUNK_DATA:
+			n = len;
+			if (n > HttpChunkLeft)
+				n = HttpChunkLeft;
+			store_block(p, n);
+			p += n;
+			len -= n;
+			HttpChunkLeft -= n;
+			if (!HttpChunkLeft)
+				HttpState = STATE_CHUNK_END;
+			break;
+
+		case STATE_CHUNK_END:
+			c = *p++;
+			len--;
+			if (c == '\n')
+				HttpState = STATE_CHUNK_SIZE;
+			break;
+		}
+	}
+}
+
+static void
+HttpRx(uchar *data, unsigned len)
+{
+	char *end;
+	unsigned n;
+
+	if (HttpState == STATE_HEADER) {
+		n = sizeof(HttpHeader) - 1 - HttpHeaderLen;
+		if (n > len)
+			n = len;
+		memcpy(HttpHeader + HttpHeaderLen, data, n);
+		HttpHeaderLen += n;
+		HttpHeader[HttpHeaderLen] = '\0';
+
+		end = strstr(HttpHeader, "\r\n\r\n");
+		if (end == NULL) {
+			if (HttpHeaderLen == sizeof(HttpHeader) - 1) {
+				puts("\nHTTP header too long\n");
+				HttpDone(0);
+			}
+			return;
+		}
+		/* the body starts right behind the empty line */
+		n -= HttpHeaderLen - (end + 4 - HttpHeader);
+		data += n;
+		len -= n;
+		end[2] = '\0';
+		if (HttpParseHeader() < 0) {
+			HttpDone(0);
+			return;
+		}
+		if (HttpLength == 0) {
+			HttpDone(1);
+			return;
+		}
+	}
+
+	HttpBody(data, len);
+	HttpSetRxDest();
+}
+
+static void
+HttpEvent(int event)
+{
+	char req[sizeof(HttpPath) + sizeof(NetHttpHost) + 96];
+	int len;
+
+	switch (event) {
+	case TCP_EV_CONNECTED:
+		len = sprintf(req, "GET %s HTTP/1.1\r\n"
+			      "Host: %s\r\n"
+			      "User-Agent: U-Boot\r\n"
+			      "Connection: close\r\n"
+			      "\r\n", HttpPath, NetHttpHost);
+		TcpSend((uchar *)req, len);
+		break;
+
+	case TCP_EV_CLOSED:
+		/* without a length, the body ends with the connection */
+		if (HttpState == STATE_BODY && HttpLength == ~0UL) {
+			HttpDone(1);
+		} else if (HttpState != STATE_DONE) {
+			puts("\nHTTP: connection closed early\n");
+			HttpDone(0);
+		}
+		break;
+
+	case TCP_EV_FAILED:
+		NetState = NETLOOP_FAIL;
+		break;
+	}
+}
+
+/* Drop any transfer and its connection; NetLoop() calls this */
+void
+HttpReset(void)
+{
+	HttpState = STATE_DONE;
+	NetSetRxDest(NULL, 0, 0);
+	TcpReset();
+}
+
+static void
+HttpUdpHandler(uchar *pkt, unsigned dest, unsigned src, unsigned len)
+{
+	/* nothing to do with UDP */
+}
+
+void
+HttpStart(void)
+{
+	debug("%s\n", __func__);
+
+	printf("HTTP from server %pI4; our IP address is %pI4",
+	       &NetHttpServerIP, &NetOurIP);
+
+	/* Check if we need to send across this subnet */
+	if (NetOurGatewayIP && NetOurSubnetMask) {
+		IPaddr_t OurNet	    = NetOurIP	      & NetOurSubnetMask;
+		IPaddr_t ServerNet  = NetHttpServerIP & NetOurSubnetMask;
+
+		if (OurNet != ServerNet)
+			printf("; sending through gateway %pI4",
+			       &NetOurGatewayIP);
+	}
+	printf("\nFilename '%s'.\nLoad address: 0x%lx\nLoading: *\b",
+	       HttpPath, load_addr);
+
+	HttpState = STATE_HEADER;
+	HttpHeaderLen = 0;
+	HttpLength = ~0UL;
+	HttpStartTime = get_timer(0);
+	NetBootFileXferSize = 0;
+
+	NetSetHandler(HttpUdpHandler);
+	TcpConnect(NetHttpServerIP, HttpPort, HttpRx, HttpEvent);
+}
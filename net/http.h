@@ -0,0 +1,18 @@
+/*
+ * HTTP/1.1 GET client
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2, or (at
+ * your option) any later version.
+ */
+
+#ifndef __HTTP_H__
+#define __HTTP_H__
+
+#define HTTP_PORT	80
+
+extern void	HttpStart(void);	/* Begin HTTP GET */
+extern void	HttpReset(void);	/* Drop any transfer in progress */
+
+#endif /* __HTTP_H__ */
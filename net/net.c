@@ -97,6 +97,10 @@
 #if defined(CONFIG_CMD_DNS)
 #include "dns.h"
 #endif
+#if defined(CONFIG_CMD_HTTP)
+#include "tcp.h"
+#include "http.h"
+#endif
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -185,6 +189,10 @@ void NcStart(void);
 int nc_input_packet(uchar *pkt, unsigned dest, unsigned src, unsigned len);
 #endif
 
+#if defined(CONFIG_CMD_HTTP)
+static int	NetHttpActive;		/* NetLoop() is running HTTP		*/
+#endif
+
 volatile uchar	PktBuf[(PKTBUFSRX+1) * PKTSIZE_ALIGN + PKTALIGN];
 
 volatile uchar *NetRxPackets[PKTBUFSRX]; /* Receive packets			*/
@@ -195,6 +203,13 @@ static ulong	timeStart;		/* Time base value			*/
 static ulong	timeDelta;		/* Current timeout value		*/
 volatile uchar *NetTxPacket = 0;	/* THE transmit packet			*/
 
+static uchar	*NetRxDest;		/* Where the next payload belongs	*/
+static int	NetRxDestHdr;		/* Protocol header before the payload	*/
+static int	NetRxDestRoom;		/* Bytes at NetRxDest we may overwrite	*/
+static uchar	*NetRxDestSaved;	/* Frame whose headers were borrowed	*/
+static int	NetRxDestSavedLen;
+static uchar	NetRxDestSave[192];	/* What those headers overwrote		*/
+
 static int net_check_prereq (proto_t protocol);
 
 static int NetTryCount;
@@ -305,8 +320,8 @@ NetInitLoop(proto_t protocol)
  *	Main network processing loop.
  */
 
-int
-NetLoop(proto_t protocol)
+static int
+NetLoopRun(proto_t protocol)
 {
 	bd_t *bd = gd->bd;
 
@@ -440,6 +455,11 @@ restart:
 		case DNS:
 			DnsStart();
 			break;
+#endif
+#if defined(CONFIG_CMD_HTTP)
+		case HTTP:
+			HttpStart();
+			break;
 #endif
 		default:
 			break;
@@ -547,6 +567,27 @@ restart:
 	}
 }
 
+int
+NetLoop(proto_t protocol)
+{
+	int ret;
+
+#if defined(CONFIG_CMD_HTTP)
+	/*
+	 * A transfer stopped by ctrl-c or another protocol must not leave
+	 * a connection behind for the segments of a later loop.
+	 */
+	HttpReset();
+	NetHttpActive = (protocol == HTTP);
+#endif
+	ret = NetLoopRun(protocol);
+#if defined(CONFIG_CMD_HTTP)
+	NetHttpActive = 0;
+	HttpReset();
+#endif
+	return ret;
+}
+
 /**********************************************************************/
 
 static void
@@ -620,6 +661,56 @@ void
 NetSetHandler(rxhand_f * f)
 {
 	packetHandler = f;
+	NetRxDest = NULL;
+}
+
+
+void
+NetSetRxDest(void *dest, int hdrlen, int room)
+{
+	NetRxDest = dest;
+	NetRxDestHdr = hdrlen;
+	NetRxDestRoom = room;
+}
+
+
+uchar *
+NetRxFrameBuf(int prefix, int size, int align)
+{
+	uchar *frame;
+	int before;
+
+	if (NetRxDest == NULL)
+		return NULL;
+
+	/* Room for the headers, in front of the payload, is borrowed */
+	before = prefix + ETHER_HDR_SIZE + IP_HDR_SIZE + NetRxDestHdr;
+	if (before > sizeof(NetRxDestSave) ||
+	    size - before > NetRxDestRoom)
+		return NULL;
+
+	frame = NetRxDest - before;
+	/* A buffer the driver would have to bounce saves nothing */
+	if ((ulong)frame & (align - 1))
+		return NULL;
+	/* Keep the IP header at least as aligned as in NetRxPackets */
+	if ((ulong)(frame + prefix + ETHER_HDR_SIZE) & 1)
+		return NULL;
+
+	memcpy(NetRxDestSave, frame, before);
+	NetRxDestSaved = frame;
+	NetRxDestSavedLen = before;
+	return frame;
+}
+
+
+void
+NetRxFrameDone(void)
+{
+	if (NetRxDestSaved == NULL)
+		return;
+	memcpy(NetRxDestSaved, NetRxDestSave, NetRxDestSavedLen);
+	NetRxDestSaved = NULL;
 }
 
 
@@ -642,10 +733,17 @@ NetSendPacket(volatile uchar * pkt, int len)
 	(void) eth_send(pkt, len);
 }
 
-int
-NetSendUDPPacket(uchar *ether, IPaddr_t dest, int dport, int sport, int len)
+/*
+ * Send the UDP payload or the TCP segment of 'len' bytes already placed
+ * in NetTxPacket behind the headers, doing an ARP request first if the
+ * destination's MAC address is not known yet.
+ */
+static int
+NetSendIPPacket(uchar *ether, IPaddr_t dest, int proto, int dport, int sport,
+		int len)
 {
 	uchar *pkt;
+	int hdr = (proto == IPPROTO_UDP) ? IP_HDR_SIZE : IP_HDR_SIZE_NO_UDP;
 
 	/* convert to new style broadcast */
 	if (dest == 0)
@@ -666,11 +764,14 @@ NetSendUDPPacket(uchar *ether, IPaddr_t dest, int dport, int sport, int len)
 		pkt = NetArpWaitTxPacket;
 		pkt += NetSetEther (pkt, NetArpWaitPacketMAC, PROT_IP);
 
-		NetSetIP (pkt, dest, dport, sport, len);
-		memcpy(pkt + IP_HDR_SIZE, (uchar *)NetTxPacket + (pkt - (uchar *)NetArpWaitTxPacket) + IP_HDR_SIZE, len);
+		if (proto == IPPROTO_UDP)
+			NetSetIP (pkt, dest, dport, sport, len);
+		else
+			NetSetIPHdr (pkt, dest, proto, len);
+		memcpy(pkt + hdr, (uchar *)NetTxPacket + (pkt - (uchar *)NetArpWaitTxPacket) + hdr, len);
 
 		/* size of the waiting packet */
-		NetArpWaitTxPacketSize = (pkt - NetArpWaitTxPacket) + IP_HDR_SIZE + len;
+		NetArpWaitTxPacketSize = (pkt - NetArpWaitTxPacket) + hdr + len;
 
 		/* and do the ARP request */
 		NetArpWaitTry = 1;
@@ -679,16 +780,33 @@ NetSendUDPPacket(uchar *ether, IPaddr_t dest, int dport, int sport, int len)
 		return 1;	/* waiting */
 	}
 
-	debug("sending UDP to %08lx/%pM\n", dest, ether);
+	debug("sending IP proto %d to %08x/%pM\n", proto, dest, ether);
 
 	pkt = (uchar *)NetTxPacket;
 	pkt += NetSetEther (pkt, ether, PROT_IP);
-	NetSetIP (pkt, dest, dport, sport, len);
-	(void) eth_send(NetTxPacket, (pkt - NetTxPacket) + IP_HDR_SIZE + len);
+	if (proto == IPPROTO_UDP)
+		NetSetIP (pkt, dest, dport, sport, len);
+	else
+		NetSetIPHdr (pkt, dest, proto, len);
+	(void) eth_send(NetTxPacket, (pkt - NetTxPacket) + hdr + len);
 
 	return 0;	/* transmitted */
 }
 
+int
+NetSendUDPPacket(uchar *ether, IPaddr_t dest, int dport, int sport, int len)
+{
+	return NetSendIPPacket(ether, dest, IPPROTO_UDP, dport, sport, len);
+}
+
+#if defined(CONFIG_CMD_HTTP)
+int
+NetSendTCPPacket(uchar *ether, IPaddr_t dest, int len)
+{
+	return NetSendIPPacket(ether, dest, IPPROTO_TCP, 0, 0, len);
+}
+#endif
+
 #if defined(CONFIG_CMD_PING)
 static ushort PingSeqNo;
 
@@ -703,7 +821,7 @@ int PingSend(void)
 
 	memcpy(mac, NetEtherNullAddr, 6);
 
-	debug("sending ARP for %08lx\n", NetPingIP);
+	debug("sending ARP for %08x\n", NetPingIP);
 
 	NetArpWaitPacketIP = NetPingIP;
 	NetArpWaitPacketMAC = mac;
@@ -1623,6 +1741,11 @@ NetReceive(volatile uchar * inpkt, int len)
 				return;
 			}
 		} else if (ip->ip_p != IPPROTO_UDP) {	/* Only UDP packets */
+#if defined(CONFIG_CMD_HTTP)
+			/* ... and the TCP connection of the HTTP client */
+			if (ip->ip_p == IPPROTO_TCP && NetHttpActive)
+				TcpReceive(ip, len);
+#endif
 			return;
 		}
 
@@ -1716,6 +1839,14 @@ static int net_check_prereq (proto_t protocol)
 		}
 		goto common;
 #endif
+#if defined(CONFIG_CMD_HTTP)
+	case HTTP:
+		if (NetHttpServerIP == 0) {
+			puts("*** ERROR: HTTP server address not given\n");
+			return 1;
+		}
+		goto common;
+#endif
 #if defined(CONFIG_CMD_NFS)
 	case NFS:
 #endif
@@ -1725,7 +1856,8 @@ static int net_check_prereq (proto_t protocol)
 			puts ("*** ERROR: `serverip' not set\n");
 			return (1);
 		}
-#if defined(CONFIG_CMD_PING) || defined(CONFIG_CMD_SNTP)
+#if defined(CONFIG_CMD_PING) || defined(CONFIG_CMD_SNTP) || \
+    defined(CONFIG_CMD_DNS) || defined(CONFIG_CMD_HTTP)
     common:
 #endif
 
@@ -1832,6 +1964,27 @@ NetSetEther(volatile uchar * xet, uchar * addr, uint prot)
 	}
 }
 
+void
+NetSetIPHdr(volatile uchar * xip, IPaddr_t dest, int proto, int len)
+{
+	IP_t *ip = (IP_t *)xip;
+
+	/*
+	 *	Construct an IP header for 'len' bytes of 'proto' data.
+	 */
+	ip->ip_hl_v  = 0x45;		/* IP_HDR_SIZE / 4 (not including UDP) */
+	ip->ip_tos   = 0;
+	ip->ip_len   = htons(IP_HDR_SIZE_NO_UDP + len);
+	ip->ip_id    = htons(NetIPID++);
+	ip->ip_off   = htons(IP_FLAGS_DFRAG);	/* Don't fragment */
+	ip->ip_ttl   = 255;
+	ip->ip_p     = proto;
+	ip->ip_sum   = 0;
+	NetCopyIP((void*)&ip->ip_src, &NetOurIP); /* already in network byte order */
+	NetCopyIP((void*)&ip->ip_dst, &dest);	   /* - "" - */
+	ip->ip_sum   = ~NetCksum((uchar *)ip, IP_HDR_SIZE_NO_UDP / 2);
+}
+
 void
 NetSetIP(volatile uchar * xip, IPaddr_t dest, int dport, int sport, int len)
 {
@@ -1849,21 +2002,11 @@ NetSetIP(volatile uchar * xip, IPaddr_t dest, int dport, int sport, int len)
 	 *	Construct an IP and UDP header.
 	 *	(need to set no fragment bit - XXX)
 	 */
-	ip->ip_hl_v  = 0x45;		/* IP_HDR_SIZE / 4 (not including UDP) */
-	ip->ip_tos   = 0;
-	ip->ip_len   = htons(IP_HDR_SIZE + len);
-	ip->ip_id    = htons(NetIPID++);
-	ip->ip_off   = htons(IP_FLAGS_DFRAG);	/* Don't fragment */
-	ip->ip_ttl   = 255;
-	ip->ip_p     = 17;		/* UDP */
-	ip->ip_sum   = 0;
-	NetCopyIP((void*)&ip->ip_src, &NetOurIP); /* already in network byte order */
-	NetCopyIP((void*)&ip->ip_dst, &dest);	   /* - "" - */
+	NetSetIPHdr(xip, dest, IPPROTO_UDP, 8 + len);
 	ip->udp_src  = htons(sport);
 	ip->udp_dst  = htons(dport);
 	ip->udp_len  = htons(8 + len);
 	ip->udp_xsum = 0;
-	ip->ip_sum   = ~NetCksum((uchar *)ip, IP_HDR_SIZE_NO_UDP / 2);
 }
 
 void copy_filename (char *dst, const char *src, int size)
@@ -1879,7 +2022,8 @@ void copy_filename (char *dst, const char *src, int size)
 	*dst = '\0';
 }
 
-#if defined(CONFIG_CMD_NFS) || defined(CONFIG_CMD_SNTP) || defined(CONFIG_CMD_DNS)
+#if defined(CONFIG_CMD_NFS) || defined(CONFIG_CMD_SNTP) || \
+    defined(CONFIG_CMD_DNS) || defined(CONFIG_CMD_HTTP)
 /*
  * make port a little random (1024-17407)
  * This keeps the math somewhat trivial to compute, and seems to work with
@@ -35,8 +35,20 @@
 
 static int fs_mounted = 0;
 static unsigned long rpc_id = 0;
-static int nfs_offset = -1;
-static int nfs_len;
+static int nfs_offset = -1;	/* offset of the next READ to send */
+
+/* READ requests sent and not answered yet */
+#ifdef CONFIG_NFS_READ_WINDOW
+#define NFS_READ_WINDOW CONFIG_NFS_READ_WINDOW
+#else
+#define NFS_READ_WINDOW 1
+#endif
+static struct {
+	unsigned long id;	/* XID, 0 if the slot is free */
+	int offset;
+	int len;
+} nfs_reads[NFS_READ_WINDOW];
+static int nfs_read_end;	/* size of the file, -1 until known */
 
 static char dirfh[NFS_FHSIZE];	/* file handle of directory */
 static char filefh[NFS_FHSIZE]; /* file handle of kernel image */
@@ -85,7 +97,9 @@ store_block (uchar * src, unsigned offset, unsigned len)
 	} else
 #endif /* CONFIG_SYS_DIRECT_FLASH_NFS */
 	{
-		(void)memcpy ((void *)(load_addr + offset), src, len);
+		/* A driver may already have received it in place */
+		if ((uchar *)(load_addr + offset) != src)
+			(void)memmove ((void *)(load_addr + offset), src, len);
 	}
 
 	if (NetBootFileXferSize < (offset+len))
@@ -168,15 +182,14 @@ static long *rpc_add_credentials (long *p)
 RPC_LOOKUP - Lookup RPC Port numbers
 **************************************************************************/
 static void
-rpc_req (int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
+rpc_send (unsigned long id, int rpc_prog, int rpc_proc, uint32_t *data,
+	  int datalen)
 {
 	struct rpc_t pkt;
-	unsigned long id;
 	uint32_t *p;
 	int pktlen;
 	int sport;
 
-	id = ++rpc_id;
 	pkt.u.call.id = htonl(id);
 	pkt.u.call.type = htonl(MSG_CALL);
 	pkt.u.call.rpcvers = htonl(2);	/* use RPC version 2 */
@@ -202,6 +215,12 @@ rpc_req (int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
 	NetSendUDPPacket (NetServerEther, NfsServerIP, sport, NfsOurPort, pktlen);
 }
 
+static void
+rpc_req (int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
+{
+	rpc_send (++rpc_id, rpc_prog, rpc_proc, data, datalen);
+}
+
 /**************************************************************************
 RPC_LOOKUP - Lookup RPC Port numbers
 **************************************************************************/
@@ -326,7 +345,7 @@ nfs_lookup_req (char *fname)
 NFS_READ - Read File on NFS Server
 **************************************************************************/
 static void
-nfs_read_req (int offset, int readlen)
+nfs_read_req (int slot)
 {
 	uint32_t data[1024];
 	uint32_t *p;
@@ -337,13 +356,101 @@ nfs_read_req (int offset, int readlen)
 
 	memcpy (p, filefh, NFS_FHSIZE);
 	p += (NFS_FHSIZE / 4);
-	*p++ = htonl(offset);
-	*p++ = htonl(readlen);
+	*p++ = htonl(nfs_reads[slot].offset);
+	*p++ = htonl(nfs_reads[slot].len);
 	*p++ = 0;
 
 	len = (uint32_t *)p - (uint32_t *)&(data[0]);
 
-	rpc_req (PROG_NFS, NFS_READ, data, len);
+	/* A retransmission keeps its XID, the server may have it cached */
+	rpc_send (nfs_reads[slot].id, PROG_NFS, NFS_READ, data, len);
+}
+
+/**************************************************************************
+NFS_READ window - Keep up to NFS_READ_WINDOW READs in flight
+**************************************************************************/
+static void
+nfs_read_reset (void)
+{
+	memset (nfs_reads, 0, sizeof(nfs_reads));
+	nfs_read_end = -1;
+	nfs_offset = 0;
+	NetSetRxDest (NULL, 0, 0);
+}
+
+static int
+nfs_read_slot (unsigned long id)
+{
+	int i;
+
+	for (i = 0; i < NFS_READ_WINDOW; i++)
+		if (nfs_reads[i].id && nfs_reads[i].id == id)
+			return i;
+	return -1;
+}
+
+/* Send READs for the rest of the file until the window is full */
+static void
+nfs_read_fill (void)
+{
+	int i;
+
+	for (i = 0; i < NFS_READ_WINDOW; i++) {
+		if (nfs_reads[i].id)
+			continue;
+		if (nfs_read_end >= 0 && nfs_offset >= nfs_read_end)
+			break;
+		nfs_reads[i].id = ++rpc_id;
+		nfs_reads[i].offset = nfs_offset;
+		nfs_reads[i].len = NFS_READ_SIZE;
+		nfs_offset += NFS_READ_SIZE;
+		nfs_read_req (i);
+	}
+}
+
+/*
+ * Tell the stack where the reply to the oldest READ belongs, so that a
+ * driver able to do so receives it right there (see NetSetRxDest()).
+ * The reply to another READ may land there too: it is then moved to its
+ * place, so only the part of the file still to be received is offered.
+ * Return 0 when no READ is outstanding any more.
+ */
+static int
+nfs_read_pending (void)
+{
+	int i, oldest = -1;
+	int end;
+
+	for (i = 0; i < NFS_READ_WINDOW; i++)
+		if (nfs_reads[i].id && (oldest < 0 ||
+		    nfs_reads[i].offset < nfs_reads[oldest].offset))
+			oldest = i;
+	if (oldest < 0) {
+		NetSetRxDest (NULL, 0, 0);
+		return 0;
+	}
+
+#ifndef CONFIG_SYS_DIRECT_FLASH_NFS
+	/* Extend the room over the READs following it back to back */
+	end = nfs_reads[oldest].offset + nfs_reads[oldest].len;
+	for (i = 0; i < NFS_READ_WINDOW; i++) {
+		if (nfs_reads[i].id && nfs_reads[i].offset == end) {
+			end += nfs_reads[i].len;
+			i = -1;
+		}
+	}
+	if (end >= nfs_offset || end > nfs_read_end)
+		end = nfs_read_end;
+	/* Nothing past the end of the file, which the first reply tells */
+	if (end <= nfs_reads[oldest].offset) {
+		NetSetRxDest (NULL, 0, 0);
+		return 1;
+	}
+	NetSetRxDest ((void *)(load_addr + nfs_reads[oldest].offset),
+		      sizeof(((struct rpc_t *)0)->u.reply),
+		      end - nfs_reads[oldest].offset);
+#endif
+	return 1;
 }
 
 /**************************************************************************
@@ -353,6 +460,8 @@ RPC request dispatcher
 static void
 NfsSend (void)
 {
+	int i;
+
 	debug("%s\n", __func__);
 
 	switch (NfsState) {
@@ -372,7 +481,10 @@ NfsSend (void)
 		nfs_lookup_req (nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req (nfs_offset, nfs_len);
+		/* resend the READs not answered */
+		for (i = 0; i < NFS_READ_WINDOW; i++)
+			if (nfs_reads[i].id)
+				nfs_read_req (i);
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req ();
@@ -523,18 +635,16 @@ nfs_readlink_reply (uchar *pkt, unsigned len)
 }
 
 static int
-nfs_read_reply (uchar *pkt, unsigned len)
+nfs_read_reply (int slot, uchar *pkt, unsigned len)
 {
 	struct rpc_t rpc_pkt;
+	int offset = nfs_reads[slot].offset;
 	int rlen;
 
 	debug("%s\n", __func__);
 
 	memcpy ((uchar *)&rpc_pkt, pkt, sizeof(rpc_pkt.u.reply));
 
-	if (ntohl(rpc_pkt.u.reply.id) != rpc_id)
-		return -1;
-
 	if (rpc_pkt.u.reply.rstatus  ||
 	    rpc_pkt.u.reply.verifier ||
 	    rpc_pkt.u.reply.astatus  ||
@@ -548,15 +658,23 @@ nfs_read_reply (uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);;
 	}
 
-	if ((nfs_offset!=0) && !((nfs_offset) % (NFS_READ_SIZE/2*10*HASHES_PER_LINE))) {
+	if ((offset!=0) && !((offset) % (NFS_READ_SIZE/2*10*HASHES_PER_LINE))) {
 		puts ("\n\t ");
 	}
-	if (!(nfs_offset % ((NFS_READ_SIZE/2)*10))) {
+	if (!(offset % ((NFS_READ_SIZE/2)*10))) {
 		putc ('#');
 	}
 
+	/* The file attributes come with the data, size is their 6th word */
+	nfs_read_end = ntohl(rpc_pkt.u.reply.data[6]);
+
 	rlen = ntohl(rpc_pkt.u.reply.data[18]);
-	if ( store_block ((uchar *)pkt+sizeof(rpc_pkt.u.reply), nfs_offset, rlen) )
+	if (rlen > nfs_reads[slot].len ||
+	    sizeof(rpc_pkt.u.reply) + rlen > len)
+		return -9999;
+	/* READs sent before the size was known may be past the end */
+	if (rlen > 0 &&
+	    store_block ((uchar *)pkt+sizeof(rpc_pkt.u.reply), offset, rlen) )
 		return -9999;
 
 	return rlen;
@@ -582,12 +700,26 @@ NfsTimeout (void)
 static void
 NfsHandler (uchar *pkt, unsigned dest, unsigned src, unsigned len)
 {
+	uint32_t id;
 	int rlen;
+	int slot;
 
 	debug("%s\n", __func__);
 
 	if (dest != NfsOurPort) return;
 
+	/* Ignore replies to requests no longer outstanding */
+	if (len < sizeof(id))
+		return;
+	memcpy (&id, pkt, sizeof(id));
+	id = ntohl(id);
+	if (NfsState == STATE_READ_REQ)
+		slot = nfs_read_slot (id);
+	else
+		slot = (id == rpc_id) ? 0 : -1;
+	if (slot < 0)
+		return;
+
 	switch (NfsState) {
 	case STATE_PRCLOOKUP_PROG_MOUNT_REQ:
 		rpc_lookup_reply (PROG_MOUNT, pkt, len);
@@ -630,9 +762,9 @@ NfsHandler (uchar *pkt, unsigned dest, unsigned src, unsigned len)
 			NfsSend ();
 		} else {
 			NfsState = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
-			NfsSend ();
+			nfs_read_reset ();
+			nfs_read_fill ();
+			nfs_read_pending ();
 		}
 		break;
 
@@ -652,18 +784,35 @@ NfsHandler (uchar *pkt, unsigned dest, unsigned src, unsigned len)
 		break;
 
 	case STATE_READ_REQ:
-		rlen = nfs_read_reply (pkt, len);
+		rlen = nfs_read_reply (slot, pkt, len);
 		NetSetTimeout (NFS_TIMEOUT, NfsTimeout);
-		if (rlen > 0) {
-			nfs_offset += rlen;
+		if (rlen >= 0) {
+			NfsTimeoutCount = 0;
+			nfs_reads[slot].offset += rlen;
+			nfs_reads[slot].len -= rlen;
+			if (rlen > 0 && nfs_reads[slot].len > 0 &&
+			    nfs_reads[slot].offset < nfs_read_end) {
+				/* short read, ask for the rest */
+				nfs_reads[slot].id = ++rpc_id;
+				nfs_read_req (slot);
+			} else {
+				nfs_reads[slot].id = 0;
+				nfs_read_fill ();
+			}
+			if (nfs_read_pending ())
+				break;
+			/* all READs answered up to the end of the file */
+			NfsDownloadState = NETLOOP_SUCCESS;
+			NfsState = STATE_UMOUNT_REQ;
 			NfsSend ();
 		}
 		else if ((rlen == -NFSERR_ISDIR)||(rlen == -NFSERR_INVAL)) {
 			/* symbolic link */
+			nfs_read_reset ();
 			NfsState = STATE_READLINK_REQ;
 			NfsSend ();
 		} else {
-			if ( ! rlen ) NfsDownloadState = NETLOOP_SUCCESS;
+			nfs_read_reset ();
 			NfsState = STATE_UMOUNT_REQ;
 			NfsSend ();
 		}
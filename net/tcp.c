@@ -0,0 +1,460 @@
+/*
+ * Minimal TCP client
+ *
+ * One connection, opened actively, that mostly receives: enough for a
+ * request/response protocol like HTTP. Data is handed to the owner as
+ * soon as it arrives in order. A segment arriving out of order is kept
+ * and answered at once with a duplicate ACK, so that the peer resends
+ * the missing one after three of them (fast retransmit) instead of
+ * waiting for its timeout; no SACK is needed since everything after
+ * the hole is already here once it is filled. The window is no larger
+ * than what can be kept that way. In-order data is acknowledged every
+ * second segment or after TCP_DELACK_TIMEOUT (delayed ACK). Our own
+ * data, one segment at most, is resent on timeout or on three
+ * duplicate ACKs.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2, or (at
+ * your option) any later version.
+ */
+
+#include <common.h>
+#include <net.h>
+#include "tcp.h"
+
+#define TCP_TIMEOUT		2000UL	/* ms before resending		*/
+#define TCP_RETRY_COUNT		10	/* timeouts in a row before giving up */
+#define TCP_DELACK_TIMEOUT	100UL	/* ms an ACK may be delayed	*/
+
+/* Receive window, in full sized segments */
+#ifdef CONFIG_TCP_WINDOW
+#define TCP_WINDOW	CONFIG_TCP_WINDOW
+#else
+#define TCP_WINDOW	32
+#endif
+
+/* The window field is 16 bits and we do not use window scaling */
+#if TCP_WINDOW < 1 || TCP_WINDOW * TCP_MSS > 0xffff
+#error "CONFIG_TCP_WINDOW must be from 1 to 44"
+#endif
+
+/* Sequence number comparisons, modulo 2^32 */
+#define SEQ_LT(a, b)	((int)((a) - (b)) < 0)
+#define SEQ_GT(a, b)	((int)((a) - (b)) > 0)
+
+#define STATE_CLOSED		0
+#define STATE_SYN_SENT		1
+#define STATE_ESTABLISHED	2
+#define STATE_CLOSE_WAIT	3	/* peer is done sending		*/
+
+static int TcpState = STATE_CLOSED;
+static IPaddr_t TcpServerIP;
+static uchar TcpServerEther[6];
+static int TcpServerPort;
+static int TcpOurPort;
+
+static u32 TcpSndUna;		/* oldest sequence number not acked	*/
+static u32 TcpSndNxt;		/* next sequence number to send		*/
+static u32 TcpRcvNxt;		/* next sequence number expected	*/
+static uchar TcpTxData[TCP_MSS];	/* our data not acked yet	*/
+static int TcpTxLen;
+static int TcpAckPending;	/* segments received and not acked	*/
+static struct {
+	u32 seq;
+	int len;			/* 0 if the slot is free	*/
+	int fin;
+	uchar data[TCP_MSS];
+} TcpRxQueue[TCP_WINDOW - 1];		/* segments after a hole	*/
+static int TcpDupAcks;
+static int TcpTimeoutCount;
+
+static tcp_rxhand_f *TcpRxHandler;
+static tcp_evhand_f *TcpEvHandler;
+
+/*
+ * Checksum of a segment and its pseudo header. The segment must start
+ * at an even address; an odd length is handled without writing past it.
+ */
+static unsigned
+TcpCksum(IPaddr_t src, IPaddr_t dst, uchar *seg, unsigned len)
+{
+	ushort pseudo[6];
+	ushort last = 0;
+	ulong xsum;
+
+	NetCopyIP(&pseudo[0], &src);
+	NetCopyIP(&pseudo[2], &dst);
+	pseudo[4] = htons(IPPROTO_TCP);
+	pseudo[5] = htons(len);
+
+	xsum = NetCksum((uchar *)pseudo, 6) + NetCksum(seg, len / 2);
+	if (len & 1) {
+		*(uchar *)&last = seg[len - 1];
+		xsum += last;
+	}
+	xsum = (xsum & 0xffff) + (xsum >> 16);
+	xsum = (xsum & 0xffff) + (xsum >> 16);
+	return xsum;
+}
+
+static void
+TcpSendSegment(int flags, u32 seq, const uchar *data, int len)
+{
+	TCP_t *tcp;
+	uchar *opt;
+	u32 tmp;
+	int hlen = TCP_HDR_SIZE;
+
+	tcp = (TCP_t *)(NetTxPacket + NetEthHdrSize() + IP_HDR_SIZE_NO_UDP);
+
+	if (flags & TCP_SYN) {
+		/* tell the largest segment we take */
+		opt = (uchar *)tcp + TCP_HDR_SIZE;
+		opt[0] = 2;
+		opt[1] = 4;
+		opt[2] = TCP_MSS >> 8;
+		opt[3] = TCP_MSS & 0xff;
+		hlen += 4;
+	}
+	if (len)
+		memcpy((uchar *)tcp + hlen, data, len);
+
+	tcp->tcp_src = htons(TcpOurPort);
+	tcp->tcp_dst = htons(TcpServerPort);
+	tmp = htonl(seq);
+	memcpy(&tcp->tcp_seq, &tmp, sizeof(tmp));
+	tmp = (flags & TCP_ACK) ? htonl(TcpRcvNxt) : 0;
+	memcpy(&tcp->tcp_ack, &tmp, sizeof(tmp));
+	tcp->tcp_off = (hlen / 4) << 4;
+	tcp->tcp_flags = flags;
+	tcp->tcp_win = htons(TCP_WINDOW * TCP_MSS);
+	tcp->tcp_sum = 0;
+	tcp->tcp_urp = 0;
+	tcp->tcp_sum = ~TcpCksum(NetOurIP, TcpServerIP, (uchar *)tcp,
+				 hlen + len);
+
+	if (flags & TCP_ACK)
+		TcpAckPending = 0;
+
+	NetSendTCPPacket(TcpServerEther, TcpServerIP, hlen + len);
+}
+
+static void
+TcpSendAck(void)
+{
+	TcpSendSegment(TCP_ACK, TcpSndNxt, NULL, 0);
+}
+
+static void
+TcpRetransmit(void)
+{
+	if (TcpState == STATE_SYN_SENT)
+		TcpSendSegment(TCP_SYN, TcpSndUna, NULL, 0);
+	else if (TcpTxLen)
+		TcpSendSegment(TCP_ACK | TCP_PSH, TcpSndUna, TcpTxData,
+			       TcpTxLen);
+}
+
+static void TcpTimeout(void);
+
+static void
+TcpSetTimer(void)
+{
+	if (TcpState == STATE_CLOSED)
+		return;
+	NetSetTimeout(TcpAckPending ? TCP_DELACK_TIMEOUT : TCP_TIMEOUT,
+		      TcpTimeout);
+}
+
+static void
+TcpFail(const char *why)
+{
+	printf("\nTCP: %s\n", why);
+	TcpState = STATE_CLOSED;
+	(*TcpEvHandler)(TCP_EV_FAILED);
+}
+
+static void
+TcpTimeout(void)
+{
+	if (TcpState == STATE_CLOSED)
+		return;
+
+	if (TcpAckPending) {
+		/* delayed ACK */
+		TcpSendAck();
+	} else if (++TcpTimeoutCount > TCP_RETRY_COUNT) {
+		TcpFail("retry count exceeded");
+		return;
+	} else if (TcpSndUna != TcpSndNxt) {
+		TcpRetransmit();
+	}
+	/*
+	 * Else wait for the peer to resend: ACKs repeated for nothing would
+	 * look like duplicate ACKs to it.
+	 */
+	TcpSetTimer();
+}
+
+/**************************************************************************
+Interface for the owner of the connection
+**************************************************************************/
+void
+TcpConnect(IPaddr_t dest, int dport, tcp_rxhand_f *rx, tcp_evhand_f *ev)
+{
+	TcpServerIP = dest;
+	TcpServerPort = dport;
+	TcpOurPort = random_port();
+	memset(TcpServerEther, 0, 6);
+	TcpRxHandler = rx;
+	TcpEvHandler = ev;
+
+	TcpSndUna = get_timer(0) << 12;		/* initial sequence number */
+	TcpSndNxt = TcpSndUna + 1;		/* the SYN takes one */
+	TcpRcvNxt = 0;
+	TcpTxLen = 0;
+	TcpAckPending = 0;
+	TcpDupAcks = 0;
+	TcpTimeoutCount = 0;
+	memset(TcpRxQueue, 0, sizeof(TcpRxQueue));
+
+	TcpState = STATE_SYN_SENT;
+	TcpSendSegment(TCP_SYN, TcpSndUna, NULL, 0);
+	TcpSetTimer();
+}
+
+/* Send up to TCP_MSS bytes; only one such send may be unacknowledged */
+int
+TcpSend(const uchar *data, int len)
+{
+	if (TcpState != STATE_ESTABLISHED && TcpState != STATE_CLOSE_WAIT)
+		return -1;
+	if (TcpTxLen || len > TCP_MSS)
+		return -1;
+
+	memcpy(TcpTxData, data, len);
+	TcpTxLen = len;
+	TcpSendSegment(TCP_ACK | TCP_PSH, TcpSndNxt, TcpTxData, len);
+	TcpSndNxt += len;
+	TcpSetTimer();
+	return 0;
+}
+
+/*
+ * Send our FIN and forget the connection: the caller is about to stop
+ * the network, so nothing would answer the peer's last ACK anyway.
+ */
+void
+TcpClose(void)
+{
+	if (TcpState == STATE_ESTABLISHED || TcpState == STATE_CLOSE_WAIT)
+		TcpSendSegment(TCP_FIN | TCP_ACK, TcpSndNxt, NULL, 0);
+	TcpState = STATE_CLOSED;
+}
+
+/* Forget the connection without a word to the peer, e.g. after ctrl-c */
+void
+TcpReset(void)
+{
+	TcpState = STATE_CLOSED;
+}
+
+/**************************************************************************
+Incoming segments
+**************************************************************************/
+static void
+TcpQueue(u32 seq, uchar *data, unsigned len, int fin)
+{
+	int i, free = -1;
+
+	if (len > TCP_MSS ||
+	    SEQ_GT(seq + len, TcpRcvNxt + TCP_WINDOW * TCP_MSS))
+		return;
+	for (i = 0; i < ARRAY_SIZE(TcpRxQueue); i++) {
+		if (TcpRxQueue[i].len && TcpRxQueue[i].seq == seq)
+			return;			/* have it already */
+		if (!TcpRxQueue[i].len && free < 0)
+			free = i;
+	}
+	if (free < 0 || !len)
+		return;
+	TcpRxQueue[free].seq = seq;
+	TcpRxQueue[free].len = len;
+	TcpRxQueue[free].fin = fin;
+	memcpy(TcpRxQueue[free].data, data, len);
+}
+
+/*
+ * Hand over the part of a segment starting at or before TcpRcvNxt that
+ * is new, and its FIN. Return -1 if the connection is gone since.
+ */
+static int
+TcpDeliver(u32 seq, uchar *data, unsigned dlen, int fin)
+{
+	unsigned skip = TcpRcvNxt - seq;
+
+	if (skip > dlen || (skip == dlen && !fin)) {
+		/* nothing new: it is our ACK the peer missed */
+		TcpSendAck();
+		return 0;
+	}
+	data += skip;
+	dlen -= skip;
+
+	if (dlen) {
+		TcpRcvNxt += dlen;
+		TcpTimeoutCount = 0;
+		TcpAckPending++;
+		(*TcpRxHandler)(data, dlen);
+		if (TcpState == STATE_CLOSED)
+			return -1;
+	}
+
+	if (fin && TcpState == STATE_ESTABLISHED) {
+		TcpRcvNxt++;
+		TcpSendAck();
+		TcpState = STATE_CLOSE_WAIT;
+		(*TcpEvHandler)(TCP_EV_CLOSED);
+		if (TcpState == STATE_CLOSED)
+			return -1;
+	}
+	return 0;
+}
+
+/* Hand over the segments kept that are now in order */
+static int
+TcpQueueDeliver(void)
+{
+	int i, found, filled = 0;
+	u32 seq, end;
+
+	do {
+		found = 0;
+		for (i = 0; i < ARRAY_SIZE(TcpRxQueue); i++) {
+			seq = TcpRxQueue[i].seq;
+			end = seq + TcpRxQueue[i].len;
+			if (!TcpRxQueue[i].len || SEQ_GT(seq, TcpRcvNxt))
+				continue;
+			TcpRxQueue[i].len = 0;
+			if (!SEQ_GT(end, TcpRcvNxt) &&
+			    !(TcpRxQueue[i].fin && end == TcpRcvNxt))
+				continue;		/* nothing new */
+			if (TcpDeliver(seq, TcpRxQueue[i].data, end - seq,
+				       TcpRxQueue[i].fin) < 0)
+				return -1;
+			filled = found = 1;
+		}
+	} while (found);
+
+	/*
+	 * A hole was filled: acknowledge all that follows it at once, and
+	 * only that, as the peer would take each smaller ACK for a new loss.
+	 */
+	if (filled && TcpAckPending)
+		TcpSendAck();
+	return 0;
+}
+
+/* Called by NetReceive() for every TCP packet addressed to us */
+void
+TcpReceive(IP_t *ip, unsigned len)
+{
+	TCP_t *tcp = (TCP_t *)&ip->udp_src;
+	IPaddr_t src;
+	uchar *data;
+	u32 seq, ack;
+	int hlen, flags;
+	unsigned dlen;
+
+	if (TcpState == STATE_CLOSED ||
+	    len < IP_HDR_SIZE_NO_UDP + TCP_HDR_SIZE)
+		return;
+	len -= IP_HDR_SIZE_NO_UDP;
+
+	src = NetReadIP(&ip->ip_src);
+	if (src != TcpServerIP ||
+	    ntohs(tcp->tcp_src) != TcpServerPort ||
+	    ntohs(tcp->tcp_dst) != TcpOurPort)
+		return;
+
+	hlen = (tcp->tcp_off >> 4) * 4;
+	if (hlen < TCP_HDR_SIZE || hlen > len)
+		return;
+	if (TcpCksum(src, NetOurIP, (uchar *)tcp, len) != 0xffff) {
+		debug("TCP: bad checksum\n");
+		return;
+	}
+
+	memcpy(&seq, &tcp->tcp_seq, sizeof(seq));
+	seq = ntohl(seq);
+	memcpy(&ack, &tcp->tcp_ack, sizeof(ack));
+	ack = ntohl(ack);
+	flags = tcp->tcp_flags;
+	data = (uchar *)tcp + hlen;
+	dlen = len - hlen;
+
+	if (TcpState == STATE_SYN_SENT) {
+		if (!(flags & TCP_ACK) || ack != TcpSndNxt)
+			return;
+		if (flags & TCP_RST) {
+			TcpFail("connection refused");
+			return;
+		}
+		if (!(flags & TCP_SYN))
+			return;
+		TcpRcvNxt = seq + 1;
+		TcpSndUna = ack;
+		TcpTimeoutCount = 0;
+		TcpState = STATE_ESTABLISHED;
+		/* the owner's first data, if any, carries the ACK */
+		TcpAckPending = 1;
+		(*TcpEvHandler)(TCP_EV_CONNECTED);
+		if (TcpState != STATE_CLOSED && TcpAckPending)
+			TcpSendAck();
+		TcpSetTimer();
+		return;
+	}
+
+	if (flags & TCP_RST) {
+		if (seq == TcpRcvNxt)
+			TcpFail("connection reset");
+		return;
+	}
+
+	/* What the peer acknowledges of ours */
+	if (flags & TCP_ACK) {
+		if (SEQ_GT(ack, TcpSndUna) && !SEQ_GT(ack, TcpSndNxt)) {
+			TcpSndUna = ack;
+			TcpDupAcks = 0;
+			TcpTimeoutCount = 0;
+			if (TcpSndUna == TcpSndNxt)
+				TcpTxLen = 0;
+		} else if (ack == TcpSndUna && TcpTxLen && !dlen &&
+			   !(flags & (TCP_SYN | TCP_FIN))) {
+			if (++TcpDupAcks == 3)
+				TcpRetransmit();
+		}
+	}
+
+	if (!dlen && !(flags & TCP_FIN)) {
+		TcpSetTimer();
+		return;
+	}
+
+	if (SEQ_GT(seq, TcpRcvNxt)) {
+		/* out of order: keep it, and say at once what we miss */
+		TcpQueue(seq, data, dlen, flags & TCP_FIN);
+		TcpSendAck();
+		TcpSetTimer();
+		return;
+	}
+
+	if (TcpDeliver(seq, data, dlen, flags & TCP_FIN) < 0)
+		return;
+	if (TcpQueueDeliver() < 0)
+		return;
+	if (TcpAckPending >= 2)
+		TcpSendAck();
+	TcpSetTimer();
+}
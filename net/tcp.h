@@ -0,0 +1,56 @@
+/*
+ * Minimal TCP client: one active connection at a time
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2, or (at
+ * your option) any later version.
+ */
+
+#ifndef __TCP_H__
+#define __TCP_H__
+
+/*
+ *	TCP header, following a 20 byte IP header.
+ */
+typedef struct {
+	ushort		tcp_src;	/* source port			*/
+	ushort		tcp_dst;	/* destination port		*/
+	u32		tcp_seq;	/* sequence number		*/
+	u32		tcp_ack;	/* acknowledgment number	*/
+	uchar		tcp_off;	/* data offset (words) << 4	*/
+	uchar		tcp_flags;	/* control bits			*/
+	ushort		tcp_win;	/* receive window		*/
+	ushort		tcp_sum;	/* checksum			*/
+	ushort		tcp_urp;	/* urgent pointer		*/
+} TCP_t;
+
+#define TCP_HDR_SIZE	20		/* TCP header without options	*/
+
+#define TCP_FIN		0x01
+#define TCP_SYN		0x02
+#define TCP_RST		0x04
+#define TCP_PSH		0x08
+#define TCP_ACK		0x10
+
+#define TCP_MSS		1460		/* largest segment we accept	*/
+
+/* Events reported to the connection's owner */
+#define TCP_EV_CONNECTED	1	/* handshake done, may send	*/
+#define TCP_EV_CLOSED		2	/* peer sent all its data (FIN)	*/
+#define TCP_EV_FAILED		3	/* reset, or no answer		*/
+
+/* In-order data received on the connection */
+typedef void	tcp_rxhand_f(uchar *data, unsigned len);
+typedef void	tcp_evhand_f(int event);
+
+extern void	TcpConnect(IPaddr_t dest, int dport,
+			   tcp_rxhand_f *rx, tcp_evhand_f *ev);
+extern int	TcpSend(const uchar *data, int len);
+extern void	TcpClose(void);
+extern void	TcpReset(void);
+
+/* Called by NetReceive() for every TCP packet addressed to us */
+extern void	TcpReceive(IP_t *ip, unsigned len);
+
+#endif /* __TCP_H__ */
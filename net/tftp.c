@@ -68,6 +68,9 @@ static ulong	TftpLastBlock;		/* last packet sequence number received */
 static ulong	TftpBlockWrap;		/* count of sequence number wraparounds */
 static ulong	TftpBlockWrapOffset;	/* memory offset due to wrapping	*/
 static int	TftpState;
+static int	TftpWindowSize;		/* blocks sent by the server per ACK	*/
+static int	TftpWindowCount;	/* blocks received since our last ACK	*/
+static int	TftpWindowGap;		/* lost block already reported		*/
 #ifdef CONFIG_TFTP_TSIZE
 static int	TftpTsize;		/* The file size reported by the server */
 static short	TftpNumchars;		/* The number of hashes we printed      */
@@ -108,9 +111,33 @@ extern flash_info_t flash_info[];
 #define TFTP_MTU_BLOCKSIZE 1468
 #endif
 
+/* The largest block that fits in one (reassembled) datagram */
+#ifdef CONFIG_IP_DEFRAG
+# ifdef CONFIG_NET_MAXDEFRAG
+#  define TFTP_MAX_BLOCKSIZE	CONFIG_NET_MAXDEFRAG
+# else
+#  define TFTP_MAX_BLOCKSIZE	16384
+# endif
+#else
+# define TFTP_MAX_BLOCKSIZE	1468
+#endif
+
 static unsigned short TftpBlkSize=TFTP_BLOCK_SIZE;
 static unsigned short TftpBlkSizeOption=TFTP_MTU_BLOCKSIZE;
 
+/*
+ * Number of blocks the server may send before waiting for an ACK
+ * (RFC 7440). 1 is the classic lock-step protocol and sends no option.
+ */
+#ifdef CONFIG_TFTP_WINDOWSIZE
+#define TFTP_WINDOWSIZE CONFIG_TFTP_WINDOWSIZE
+#else
+#define TFTP_WINDOWSIZE 1
+#endif
+#define TFTP_MAX_WINDOWSIZE	64
+
+static unsigned short TftpWindowSizeOption=TFTP_WINDOWSIZE;
+
 #ifdef CONFIG_MCAST_TFTP
 #include <malloc.h>
 #define MTFTP_BITMAPSIZE	0x1000
@@ -136,6 +163,24 @@ mcast_cleanup(void)
 
 #endif	/* CONFIG_MCAST_TFTP */
 
+/*
+ * The transfer is over, or starts again from the top: either way, stop
+ * drivers receiving into the load area.
+ */
+static void
+TftpDone (int state)
+{
+	NetSetRxDest(NULL, 0, 0);
+	NetState = state;
+}
+
+static void
+TftpRestart (void)
+{
+	NetSetRxDest(NULL, 0, 0);
+	NetStartAgain();
+}
+
 static __inline__ void
 store_block (unsigned block, uchar * src, unsigned len)
 {
@@ -158,14 +203,16 @@ store_block (unsigned block, uchar * src, unsigned len)
 		rc = flash_write ((char *)src, (ulong)(load_addr+offset), len);
 		if (rc) {
 			flash_perror (rc);
-			NetState = NETLOOP_FAIL;
+			TftpDone(NETLOOP_FAIL);
 			return;
 		}
 	}
 	else
 #endif /* CONFIG_SYS_DIRECT_FLASH_TFTP */
 	{
-		(void)memcpy((void *)(load_addr + offset), src, len);
+		/* A driver may already have received it in place */
+		if ((uchar *)(load_addr + offset) != src)
+			(void)memmove((void *)(load_addr + offset), src, len);
 	}
 #ifdef CONFIG_MCAST_TFTP
 	if (Multicast)
@@ -176,6 +223,30 @@ store_block (unsigned block, uchar * src, unsigned len)
 		NetBootFileXferSize = newsize;
 }
 
+/*
+ * Tell the stack where the next block in sequence belongs, so that a
+ * driver able to do so receives it right there (see NetSetRxDest()).
+ */
+static void
+TftpSetRxDest (void)
+{
+#ifndef CONFIG_SYS_DIRECT_FLASH_TFTP
+	ulong offset = TftpLastBlock * TftpBlkSize + TftpBlockWrapOffset;
+	int room = TftpBlkSize;
+
+#ifdef CONFIG_MCAST_TFTP
+	if (Multicast)
+		return;
+#endif
+#ifdef CONFIG_TFTP_TSIZE
+	/* The rest of the file may be scribbled on before it arrives */
+	if (TftpTsize > offset + TftpBlkSize)
+		room = TftpTsize - offset;
+#endif
+	NetSetRxDest((void *)(load_addr + offset), 4, room);
+#endif
+}
+
 static void TftpSend (void);
 static void TftpTimeout (void);
 
@@ -225,6 +296,9 @@ TftpSend (void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt,"blksize%c%d%c",
 				0,TftpBlkSizeOption,0);
+		if (TftpWindowSizeOption > 1)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, TftpWindowSizeOption, 0);
 #ifdef CONFIG_MCAST_TFTP
 		/* Check all preconditions before even trying the option */
 		if (!ProhibitMcast
@@ -252,6 +326,8 @@ TftpSend (void)
 		*s++ = htons(TftpBlock);
 		pkt = (uchar *)s;
 		len = pkt - xp;
+		/* the server starts a new window after each ACK */
+		TftpWindowCount = 0;
 		break;
 
 	case STATE_TOO_LARGE:
@@ -334,6 +410,14 @@ TftpHandler (uchar * pkt, unsigned dest, unsigned src, unsigned len)
 				debug("Blocksize ack: %s, %d\n",
 					(char*)pkt+i+8,TftpBlkSize);
 			}
+			if (i + 11 < len &&
+			    strcmp ((char *)pkt + i, "windowsize") == 0) {
+				TftpWindowSize =
+					simple_strtoul((char *)pkt + i + 11,
+						       NULL, 10);
+				debug("Windowsize ack: %s, %d\n",
+					(char *)pkt + i + 11, TftpWindowSize);
+			}
 #ifdef CONFIG_TFTP_TSIZE
 			if (strcmp ((char*)pkt+i,"tsize") == 0) {
 				TftpTsize = simple_strtoul((char*)pkt+i+6,NULL,10);
@@ -342,13 +426,28 @@ TftpHandler (uchar * pkt, unsigned dest, unsigned src, unsigned len)
 			}
 #endif
 		}
+		/* A server may lower the options we asked for, not raise them */
+		if ((TftpBlkSize != TFTP_BLOCK_SIZE &&
+		     (TftpBlkSize < 8 || TftpBlkSize > TftpBlkSizeOption)) ||
+		    TftpWindowSize < 1 ||
+		    TftpWindowSize > TftpWindowSizeOption) {
+			printf("\nTFTP error: bad options from server "
+				"(blksize %d, windowsize %d)\n",
+				TftpBlkSize, TftpWindowSize);
+			eth_halt();
+			TftpDone(NETLOOP_FAIL);
+			break;
+		}
 #ifdef CONFIG_MCAST_TFTP
 		parse_multicast_oack((char *)pkt,len-1);
 		if ((Multicast) && (!MasterClient))
 			TftpState = STATE_DATA;	/* passive.. */
 		else
 #endif
-		TftpSend (); /* Send ACK */
+		{
+			TftpSend (); /* Send ACK */
+			TftpSetRxDest ();
+		}
 		break;
 	case TFTP_DATA:
 		if (len < 2)
@@ -357,31 +456,25 @@ TftpHandler (uchar * pkt, unsigned dest, unsigned src, unsigned len)
 		TftpBlock = ntohs(*(ushort *)pkt);
 
 		/*
-		 * RFC1350 specifies that the first data packet will
-		 * have sequence number 1. If we receive a sequence
-		 * number of 0 this means that there was a wrap
-		 * around of the (16 bit) counter.
+		 * With a window of blocks in flight, a block out of
+		 * sequence means one was lost. ACK the last block received
+		 * in sequence, once, so that the server sends the window
+		 * again from there (RFC 7440).
 		 */
-		if (TftpBlock == 0) {
-			TftpBlockWrap++;
-			TftpBlockWrapOffset += TftpBlkSize * TFTP_SEQUENCE_SIZE;
-			printf ("\n\t %lu MB received\n\t ", TftpBlockWrapOffset>>20);
-		}
-#ifdef CONFIG_TFTP_TSIZE
-		else if (TftpTsize) {
-			while (TftpNumchars < NetBootFileXferSize * 50 / TftpTsize) {
-				putc('#');
-				TftpNumchars++;
-			}
-		}
+		if (TftpWindowSize > 1 && TftpBlock != TftpLastBlock &&
+		    TftpBlock != ((TftpLastBlock + 1) & 0xffff)
+#ifdef CONFIG_MCAST_TFTP
+		    && !Multicast
 #endif
-		else {
-			if (((TftpBlock - 1) % 10) == 0) {
-				putc ('#');
-			} else if ((TftpBlock % (10 * HASHES_PER_LINE)) == 0) {
-				puts ("\n\t ");
+		    ) {
+			TftpBlock = TftpLastBlock;
+			if (!TftpWindowGap) {
+				TftpWindowGap = 1;
+				TftpSend ();
 			}
+			break;
 		}
+		TftpWindowGap = 0;
 
 		if (TftpState == STATE_RRQ)
 			debug("Server did not acknowledge timeout option!\n");
@@ -404,7 +497,7 @@ TftpHandler (uchar * pkt, unsigned dest, unsigned src, unsigned len)
 					"First block is not block 1 (%ld)\n"
 					"Starting again\n\n",
 					TftpBlock);
-				NetStartAgain ();
+				TftpRestart();
 				break;
 			}
 		}
@@ -416,11 +509,40 @@ TftpHandler (uchar * pkt, unsigned dest, unsigned src, unsigned len)
 			break;
 		}
 
+		/*
+		 * RFC1350 specifies that the first data packet will
+		 * have sequence number 1. If we receive a sequence
+		 * number of 0 this means that there was a wrap
+		 * around of the (16 bit) counter.
+		 */
+		if (TftpBlock == 0) {
+			TftpBlockWrap++;
+			TftpBlockWrapOffset += TftpBlkSize * TFTP_SEQUENCE_SIZE;
+			printf ("\n\t %lu MB received\n\t ", TftpBlockWrapOffset>>20);
+		}
+#ifdef CONFIG_TFTP_TSIZE
+		else if (TftpTsize) {
+			while (TftpNumchars < NetBootFileXferSize * 50 / TftpTsize) {
+				putc('#');
+				TftpNumchars++;
+			}
+		}
+#endif
+		else {
+			if (((TftpBlock - 1) % 10) == 0) {
+				putc ('#');
+			} else if ((TftpBlock % (10 * HASHES_PER_LINE)) == 0) {
+				puts ("\n\t ");
+			}
+		}
+
 		TftpLastBlock = TftpBlock;
+		TftpTimeoutCount = 0;
 		TftpTimeoutCountMax = TIMEOUT_COUNT;
 		NetSetTimeout (TftpTimeoutMSecs, TftpTimeout);
 
 		store_block (TftpBlock - 1, pkt + 2, len);
+		TftpSetRxDest ();
 
 		/*
 		 *	Acknoledge the block just received, which will prompt
@@ -444,21 +566,26 @@ TftpHandler (uchar * pkt, unsigned dest, unsigned src, unsigned len)
 					/* try to double it and retry */
 					Mapsize<<=1;
 					mcast_cleanup();
-					NetStartAgain ();
+					TftpRestart();
 					return;
 				}
 				TftpLastBlock = TftpBlock;
 			}
 		}
 #endif
-		TftpSend ();
+		/*
+		 * Only the last block of a window, or of the file, is
+		 * acknowledged.
+		 */
+		if (++TftpWindowCount >= TftpWindowSize || len < TftpBlkSize)
+			TftpSend ();
 
 #ifdef CONFIG_MCAST_TFTP
 		if (Multicast) {
 			if (MasterClient && (TftpBlock >= TftpEndingBlock)) {
 				puts ("\nMulticast tftp done\n");
 				mcast_cleanup();
-				NetState = NETLOOP_SUCCESS;
+				TftpDone(NETLOOP_SUCCESS);
 			}
 		}
 		else
@@ -484,7 +611,7 @@ TftpHandler (uchar * pkt, unsigned dest, unsigned src, unsigned len)
 			}
 #endif
 			puts ("\ndone\n");
-			NetState = NETLOOP_SUCCESS;
+			TftpDone(NETLOOP_SUCCESS);
 		}
 		break;
 
@@ -497,7 +624,7 @@ TftpHandler (uchar * pkt, unsigned dest, unsigned src, unsigned len)
 		case TFTP_ERR_ACCESS_DENIED:
 			puts("Not retrying...\n");
 			eth_halt();
-			NetState = NETLOOP_FAIL;
+			TftpDone(NETLOOP_FAIL);
 			break;
 		case TFTP_ERR_UNDEFINED:
 		case TFTP_ERR_DISK_FULL:
@@ -509,7 +636,7 @@ TftpHandler (uchar * pkt, unsigned dest, unsigned src, unsigned len)
 #ifdef CONFIG_MCAST_TFTP
 			mcast_cleanup();
 #endif
-			NetStartAgain();
+			TftpRestart();
 			break;
 		}
 		break;
@@ -525,7 +652,7 @@ TftpTimeout (void)
 #ifdef CONFIG_MCAST_TFTP
 		mcast_cleanup();
 #endif
-		NetStartAgain ();
+		TftpRestart();
 	} else {
 		puts ("T ");
 		NetSetTimeout (TftpTimeoutMSecs, TftpTimeout);
@@ -546,6 +673,23 @@ TftpStart (void)
 	if ((ep = getenv("tftpblocksize")) != NULL)
 		TftpBlkSizeOption = simple_strtol(ep, NULL, 10);
 
+	if (TftpBlkSizeOption < 8 ||
+	    TftpBlkSizeOption > TFTP_MAX_BLOCKSIZE) {
+		printf("TFTP blocksize (%d) out of range, using %d\n",
+			TftpBlkSizeOption, TFTP_MAX_BLOCKSIZE);
+		TftpBlkSizeOption = TFTP_MAX_BLOCKSIZE;
+	}
+
+	if ((ep = getenv("tftpwindowsize")) != NULL)
+		TftpWindowSizeOption = simple_strtol(ep, NULL, 10);
+
+	if (TftpWindowSizeOption < 1 ||
+	    TftpWindowSizeOption > TFTP_MAX_WINDOWSIZE) {
+		printf("TFTP windowsize (%d) out of range, using 1\n",
+			TftpWindowSizeOption);
+		TftpWindowSizeOption = 1;
+	}
+
 	if ((ep = getenv("tftptimeout")) != NULL)
 		TftpTimeoutMSecs = simple_strtol(ep, NULL, 10);
 
@@ -556,12 +700,12 @@ TftpStart (void)
 		TftpTimeoutMSecs = 1000;
 	}
 
-	debug("TFTP blocksize = %i, timeout = %ld ms\n",
-		TftpBlkSizeOption, TftpTimeoutMSecs);
+	debug("TFTP blocksize = %i, windowsize = %i, timeout = %ld ms\n",
+		TftpBlkSizeOption, TftpWindowSizeOption, TftpTimeoutMSecs);
 
 	TftpServerIP = NetServerIP;
 	if (BootFile[0] == '\0') {
-		sprintf(default_filename, "%02lX%02lX%02lX%02lX.img",
+		sprintf(default_filename, "%02X%02X%02X%02X.img",
 			NetOurIP & 0xFF,
 			(NetOurIP >>  8) & 0xFF,
 			(NetOurIP >> 16) & 0xFF,
@@ -637,11 +781,15 @@ TftpStart (void)
 	}
 #endif
 	TftpBlock = 0;
+	TftpLastBlock = 0;
 
 	/* zero out server ether in case the server ip has changed */
 	memset(NetServerEther, 0, 6);
-	/* Revert TftpBlkSize to dflt */
+	/* Revert TftpBlkSize and TftpWindowSize to dflt */
 	TftpBlkSize = TFTP_BLOCK_SIZE;
+	TftpWindowSize = 1;
+	TftpWindowCount = 0;
+	TftpWindowGap = 0;
 #ifdef CONFIG_MCAST_TFTP
 	mcast_cleanup();
 #endif
@@ -732,7 +880,7 @@ static void parse_multicast_oack(char *pkt, int len)
 			printf ("Fail to set mcast, revert to TFTP\n");
 			ProhibitMcast=1;
 			mcast_cleanup();
-			NetStartAgain();
+			TftpRestart();
 		}
 	}
 	MasterClient = (unsigned char)simple_strtoul((char *)mc,NULL,10);
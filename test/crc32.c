@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * CRC32 test and benchmark
+ *
+ * Checks every CRC32 variant in lib/crc32.c against a bit-at-a-time
+ * reference for all alignments and short lengths, then reports the
+ * throughput of each variant across a range of buffer sizes.
+ *
+ * Usage: crc32 [-q]	(-q skips the benchmark)
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define CRC32_ALL_VARIANTS
+#include "../lib/crc32.c"
+
+#define BUF_SIZE	(1 << 20)
+
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(x)	(sizeof(x) / sizeof((x)[0]))
+#endif
+
+struct crc_variant {
+	const char *name;
+	uint32_t (*func)(uint32_t crc, const Bytef *buf, uInt len);
+};
+
+static struct crc_variant variants[] = {
+	{ "word", crc32_word },
+#ifdef CRC32_SLICE8
+	{ "slice8", crc32_slice8 },
+#endif
+};
+
+static int test_count;
+static int fail_count;
+
+static unsigned char buf[BUF_SIZE + 8];
+
+static uint32_t crc32_bitwise(uint32_t crc, const unsigned char *p,
+			      unsigned len)
+{
+	int k;
+
+	while (len--) {
+		crc ^= *p++;
+		for (k = 0; k < 8; k++)
+			crc = crc & 1 ? 0xedb88320 ^ (crc >> 1) : crc >> 1;
+	}
+
+	return crc;
+}
+
+static void check(const char *name, unsigned align, unsigned len,
+		  uint32_t got, uint32_t expect)
+{
+	test_count++;
+	if (got != expect) {
+		printf("%s: align %u len %u: got %#08x, expected %#08x\n",
+		       name, align, len, got, expect);
+		fail_count++;
+	}
+}
+
+static void test_variants(void)
+{
+	struct crc_variant *var;
+	unsigned align, len;
+	uint32_t expect;
+
+	/* "123456789" is the standard check value for CRC-32 */
+	check("crc32", 0, 9, crc32(0, (const Bytef *)"123456789", 9),
+	      0xcbf43926);
+
+	for (var = variants; var < variants + ARRAY_SIZE(variants); var++) {
+		for (align = 0; align < 8; align++) {
+			for (len = 0; len < 64; len++) {
+				expect = crc32_bitwise(0x12345678, buf + align,
+						       len);
+				check(var->name, align, len,
+				      var->func(0x12345678, buf + align, len),
+				      expect);
+			}
+		}
+
+		/* A long run, split at an odd offset */
+		expect = crc32_bitwise(~0U, buf + 3, 65536);
+		check(var->name, 3, 65536,
+		      var->func(var->func(~0U, buf + 3, 1001),
+				buf + 1004, 65536 - 1001), expect);
+	}
+}
+
+static unsigned long time_us(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000000UL + tv.tv_usec;
+}
+
+static void bench_variants(void)
+{
+	static const unsigned sizes[] = { 64, 512, 4096, 65536, BUF_SIZE };
+	struct crc_variant *var;
+	unsigned long start, us, total;
+	unsigned i, size;
+	uint32_t crc = 0;
+
+	printf("%-8s", "size");
+	for (var = variants; var < variants + ARRAY_SIZE(variants); var++)
+		printf("%12s", var->name);
+	printf("   (MB/s)\n");
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		size = sizes[i];
+		printf("%-8u", size);
+		for (var = variants; var < variants + ARRAY_SIZE(variants);
+				var++) {
+			start = time_us();
+			for (total = 0; total < 64 * BUF_SIZE; total += size)
+				crc = var->func(crc, buf, size);
+			us = time_us() - start;
+			printf("%12lu", us ? total / us : 0);
+		}
+		printf("\n");
+	}
+	/* Keep the compiler from discarding the loop */
+	if (crc == 0x12345678)
+		printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned i;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = (i * 2654435761U) >> 24;
+
+	test_variants();
+	printf("%d tests run, %d failed\n", test_count, fail_count);
+	if (!(argc > 1 && !strcmp(argv[1], "-q")))
+		bench_variants();
+
+	return fail_count ? 1 : 0;
+}
@@ -0,0 +1,405 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Host test for common/fdt_index.c
+ *
+ * The host build of libfdt does not consult the index, so every lookup
+ * can be made both ways and the results compared: each node by path,
+ * with and without its unit address, each possible subnode name under
+ * each node, every alias, every phandle up to one past the largest, and
+ * every compatible string from every start offset.
+ *
+ * This is done on a tree of edge cases (duplicate node names, "name" next
+ * to "name@unit", several and repeated compatible properties, an alias
+ * of an alias, a second aliases node, bad phandles) and on trees made
+ * at random from a small set of names so that names collide often. The
+ * random trees give the root node properties after its aliases node,
+ * which libfdt does not see.
+ *
+ * Then an index is checked to survive fdt_index_recheck() while its blob
+ * is unchanged, and to be dropped once a different blob of the same size
+ * is copied over it.
+ *
+ * Usage: fdt_index [-v]	(-v prints each tree's size)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libfdt_env.h"
+#include "fdt_host.h"
+#include <fdt_index.h>
+
+#define TREE_SIZE	65536
+#define RANDOM_TREES	20
+#define MAX_DEPTH	6
+
+static const char *const names[] = {
+	"bus", "bus@1", "bus@2", "uart", "uart@70006000", "uart@70006040",
+	"i2c@1", "i2c", "dev", "dev@0", "dev@1", "a", "a@b@c",
+};
+
+static const char *const compats[] = {
+	"nvidia,tegra250-uart", "ns16550", "nvidia,tegra250-i2c",
+	"simple-bus", "ns16550a", "x",
+};
+
+#define NAMES		(sizeof(names) / sizeof(names[0]))
+#define COMPATS		(sizeof(compats) / sizeof(compats[0]))
+
+static int test_count;
+static int fail_count;
+static const char *tree_name;
+
+static void check(int ok, const char *what, const char *arg, int got,
+		  int want)
+{
+	test_count++;
+	if (!ok) {
+		printf("%s: %s: failed for \"%s\": index %d, libfdt %d\n",
+		       tree_name, what, arg ? arg : "", got, want);
+		fail_count++;
+	}
+}
+
+static void check_path(const void *fdt, const char *path)
+{
+	int got = -1, want = fdt_path_offset(fdt, path);
+
+	check(fdt_index_path_offset(fdt, path, &got), "indexed", path, 0, 1);
+	check(got == want, "path", path, got, want);
+}
+
+static void check_subnode(const void *fdt, int parent, const char *name,
+			  int len)
+{
+	int got = parent, want;
+	char buf[64];
+
+	want = fdt_subnode_offset_namelen(fdt, parent, name, len);
+	fdt_index_subnode_offset(fdt, &got, name, len);
+	snprintf(buf, sizeof(buf), "%d:%.*s", parent, len, name);
+	check(got == want, "subnode", buf, got, want);
+}
+
+static void check_alias(const void *fdt, const char *name)
+{
+	const char *got = NULL, *want;
+
+	want = fdt_get_alias_namelen(fdt, name, strlen(name));
+	fdt_index_get_alias(fdt, name, strlen(name), &got);
+	check(got == want, "alias", name, got != NULL, want != NULL);
+}
+
+static void check_compat(const void *fdt, int start, const char *compat)
+{
+	int got = -1, want;
+	char buf[64];
+
+	want = fdt_node_offset_by_compatible(fdt, start, compat);
+	fdt_index_node_by_compatible(fdt, start, compat, &got);
+	snprintf(buf, sizeof(buf), "%d:%s", start, compat);
+	check(got == want, "compatible", buf, got, want);
+}
+
+/* Each property of the aliases node, as an alias and at a path's start */
+static void check_aliases(const void *fdt)
+{
+	const struct fdt_property *prop;
+	int offset, next, depth = 0;
+	char path[256];
+	const char *name;
+	uint32_t tag;
+
+	offset = fdt_path_offset(fdt, "/aliases");
+	if (offset < 0)
+		return;
+	fdt_next_tag(fdt, offset, &next);
+	do {
+		offset = next;
+		tag = fdt_next_tag(fdt, offset, &next);
+		if (tag == FDT_BEGIN_NODE) {
+			depth++;
+		} else if (tag == FDT_END_NODE) {
+			depth--;
+		} else if (tag == FDT_PROP && !depth) {
+			prop = fdt_offset_ptr(fdt, offset, sizeof(*prop));
+			name = fdt_string(fdt, fdt32_to_cpu(prop->nameoff));
+			check_alias(fdt, name);
+			check_path(fdt, name);
+			snprintf(path, sizeof(path), "%s/dev", name);
+			check_path(fdt, path);
+		}
+	} while (depth >= 0 && tag != FDT_END);
+}
+
+/* Every lookup, made through the index and by libfdt */
+static void check_tree(const void *fdt)
+{
+	uint32_t phandle, max_phandle = 0;
+	const char *name, *at;
+	char path[256];
+	int offset, depth = 0, len, i, start;
+
+	check(fdt_index_build(fdt) == 0, "build", NULL, 0, 0);
+
+	for (offset = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(fdt, offset, &depth)) {
+		if (fdt_get_path(fdt, offset, path, sizeof(path)))
+			continue;
+		check_path(fdt, path);
+		len = strlen(path);
+		strcat(path, "/");
+		check_path(fdt, path);
+		at = strrchr(path, '@');
+		if (at && !strchr(at, '/'))
+			path[at - path] = '\0';
+		else
+			path[len] = '\0';
+		check_path(fdt, path);
+
+		/* Each name, and each name cut short at an '@' */
+		for (i = 0; i < NAMES; i++) {
+			check_subnode(fdt, offset, names[i],
+				      strlen(names[i]));
+			for (at = names[i]; (at = strchr(at, '@')); at++)
+				check_subnode(fdt, offset, names[i],
+					      at - names[i]);
+		}
+		/* A prefix of a name is not a match */
+		check_subnode(fdt, offset, "uart@7000", 9);
+
+		name = fdt_get_name(fdt, offset, &len);
+		if (name && len)
+			check_path(fdt, name);	/* not an absolute path */
+		phandle = fdt_get_phandle(fdt, offset);
+		if (phandle > max_phandle && phandle != -1)
+			max_phandle = phandle;
+	}
+	check_subnode(fdt, 4, "bus", 3);	/* not a node */
+	check_path(fdt, "/no/such/node");
+	check_path(fdt, "//bus//dev@1");
+
+	check_aliases(fdt);
+	check_alias(fdt, "nosuchalias");
+	check_path(fdt, "nosuchalias/dev");
+
+	for (phandle = 1; phandle <= max_phandle + 1; phandle++) {
+		int got = -1, want = fdt_node_offset_by_phandle(fdt, phandle);
+
+		fdt_index_node_by_phandle(fdt, phandle, &got);
+		sprintf(path, "%u", phandle);
+		check(got == want, "phandle", path, got, want);
+	}
+
+	for (i = 0; i < COMPATS; i++) {
+		start = -1;
+		do {
+			check_compat(fdt, start, compats[i]);
+			start = fdt_node_offset_by_compatible(fdt, start,
+							      compats[i]);
+		} while (start >= 0);
+		/* From every node, and from somewhere that is not a node */
+		for (offset = 0, depth = 0; offset >= 0 && depth >= 0;
+		     offset = fdt_next_node(fdt, offset, &depth))
+			check_compat(fdt, offset, compats[i]);
+		check_compat(fdt, 4, compats[i]);
+	}
+	check_compat(fdt, -1, "no-such-device");
+	check_compat(fdt, -1, "ns1655");	/* a prefix */
+}
+
+/* Duplicate and awkward names and properties that libfdt has rules for */
+static void make_edge_tree(void *fdt)
+{
+	static const char compat_list[] = "ns16550a\0ns16550\0x";
+	static const char unterminated[] = { 'n', 's', '1', '6', '5', '5',
+					     '0', 'a' };
+
+	fdt_create(fdt, TREE_SIZE);
+	fdt_finish_reservemap(fdt);
+	fdt_begin_node(fdt, "");
+	fdt_property_string(fdt, "compatible", "nvidia,tegra250");
+
+	fdt_begin_node(fdt, "aliases");
+	fdt_property_string(fdt, "serial0", "/uart@70006000");
+	fdt_property_string(fdt, "console", "serial0");	/* alias of alias */
+	fdt_property_string(fdt, "bus", "/bus@1");
+	fdt_property_string(fdt, "serial0", "/uart");	/* second, unused */
+	fdt_property_string(fdt, "missing", "/no/such/node");
+	fdt_end_node(fdt);
+
+	fdt_begin_node(fdt, "uart");
+	fdt_property_string(fdt, "compatible", "ns16550");
+	fdt_property_cell(fdt, "linux,phandle", 3);
+	fdt_end_node(fdt);
+
+	fdt_begin_node(fdt, "uart@70006000");
+	fdt_property(fdt, "compatible", compat_list, sizeof(compat_list));
+	fdt_property_string(fdt, "compatible", "simple-bus"); /* ignored */
+	fdt_property_cell(fdt, "linux,phandle", 1);
+	fdt_property_cell(fdt, "linux,phandle", 7);	/* ignored */
+	fdt_end_node(fdt);
+
+	fdt_begin_node(fdt, "uart@70006000");	/* duplicate */
+	fdt_property_string(fdt, "compatible", "nvidia,tegra250-uart");
+	fdt_property_cell(fdt, "linux,phandle", 1);	/* duplicate phandle */
+	fdt_end_node(fdt);
+
+	fdt_begin_node(fdt, "bus@1");
+	fdt_property_string(fdt, "compatible", "simple-bus");
+	fdt_property(fdt, "linux,phandle", "\0\0\0\0\x05", 5); /* bad size */
+	fdt_begin_node(fdt, "dev@1");
+	fdt_property(fdt, "compatible", unterminated, sizeof(unterminated));
+	fdt_end_node(fdt);
+	fdt_begin_node(fdt, "dev@0");
+	fdt_property_string(fdt, "compatible", "x");
+	fdt_begin_node(fdt, "dev");
+	fdt_property_string(fdt, "compatible", "x");
+	fdt_property_cell(fdt, "linux,phandle", 2);
+	fdt_end_node(fdt);
+	fdt_end_node(fdt);
+	fdt_begin_node(fdt, "dev");
+	fdt_end_node(fdt);
+	fdt_end_node(fdt);
+
+	fdt_begin_node(fdt, "bus");
+	fdt_begin_node(fdt, "a@b@c");
+	fdt_property(fdt, "compatible", "", 0);
+	fdt_end_node(fdt);
+	fdt_end_node(fdt);
+
+	fdt_begin_node(fdt, "aliases");		/* second, unused */
+	fdt_property_string(fdt, "other", "/bus");
+	fdt_end_node(fdt);
+
+	fdt_end_node(fdt);
+	fdt_finish(fdt);
+}
+
+static void make_random_node(void *fdt, int depth, unsigned *seed)
+{
+	int i, count;
+
+	*seed = *seed * 1103515245 + 12345;
+	if ((*seed >> 8) % 3)
+		fdt_property_string(fdt, "compatible",
+				    compats[(*seed >> 12) % COMPATS]);
+	*seed = *seed * 1103515245 + 12345;
+	if ((*seed >> 8) % 2)
+		fdt_property_cell(fdt, "linux,phandle", 1 + (*seed >> 12) % 40);
+
+	*seed = *seed * 1103515245 + 12345;
+	count = depth < MAX_DEPTH ? (*seed >> 8) % (6 - depth) : 0;
+	for (i = 0; i < count; i++) {
+		*seed = *seed * 1103515245 + 12345;
+		fdt_begin_node(fdt, names[(*seed >> 8) % NAMES]);
+		make_random_node(fdt, depth + 1, seed);
+		fdt_end_node(fdt);
+	}
+}
+
+static void make_random_tree(void *fdt, unsigned seed)
+{
+	char path[64];
+	int i;
+
+	fdt_create(fdt, TREE_SIZE);
+	fdt_finish_reservemap(fdt);
+	fdt_begin_node(fdt, "");
+	fdt_begin_node(fdt, "aliases");
+	for (i = 0; i < 6; i++) {
+		seed = seed * 1103515245 + 12345;
+		snprintf(path, sizeof(path), "/%s/%s", names[(seed >> 8) %
+			 NAMES], names[(seed >> 16) % NAMES]);
+		fdt_property_string(fdt, names[i], path);
+	}
+	fdt_end_node(fdt);
+	make_random_node(fdt, 0, &seed);
+	fdt_end_node(fdt);
+	fdt_finish(fdt);
+}
+
+/* A blob loaded over an indexed one must not be looked up in its index */
+static void check_recheck(void *fdt, void *other)
+{
+	char *name;
+	int offset;
+
+	tree_name = "recheck";
+	make_edge_tree(fdt);
+	/* The same tree with "/uart" renamed to "/uarx" */
+	memcpy(other, fdt, fdt_totalsize(fdt));
+	name = (char *)fdt_get_name(other, fdt_path_offset(other, "/uart"),
+				    NULL);
+	name[3] = 'x';
+	check(fdt_totalsize(fdt) == fdt_totalsize(other), "same size", NULL,
+	      fdt_totalsize(other), fdt_totalsize(fdt));
+
+	check(fdt_index_build(fdt) == 0, "build", NULL, 0, 0);
+	fdt_index_recheck();
+	check(fdt_index_path_offset(fdt, "/uart", &offset), "unchanged",
+	      NULL, 0, 1);
+
+	memcpy(fdt, other, fdt_totalsize(other));
+	fdt_index_recheck();
+	check(!fdt_index_path_offset(fdt, "/uart", &offset), "changed",
+	      NULL, 1, 0);
+	check(fdt_index_build(fdt) == 0, "rebuild", NULL, 0, 0);
+	check_tree(fdt);
+	fdt_index_invalidate(fdt);
+}
+
+int main(int argc, char *argv[])
+{
+	int verbose = argc > 1 && !strcmp(argv[1], "-v");
+	static char name[20];
+	void *fdt = malloc(TREE_SIZE);
+	void *other = malloc(TREE_SIZE);
+	int i;
+
+	tree_name = "edge";
+	make_edge_tree(fdt);
+	check(fdt_check_header(fdt) == 0, "header", NULL, 0, 0);
+	check_tree(fdt);
+	fdt_index_invalidate(fdt);
+
+	for (i = 0; i < RANDOM_TREES; i++) {
+		snprintf(name, sizeof(name), "random %d", i);
+		tree_name = name;
+		make_random_tree(fdt, i);
+		check(fdt_check_header(fdt) == 0, "header", NULL, 0, 0);
+		if (verbose)
+			printf("%s: %d bytes\n", name, fdt_totalsize(fdt));
+		check_tree(fdt);
+		fdt_index_invalidate(fdt);
+	}
+
+	check_recheck(fdt, other);
+	free(fdt);
+	free(other);
+
+	printf("%d tests run, %d failed\n", test_count, fail_count);
+
+	return fail_count ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Hash API test and benchmark
+ *
+ * Checks each algorithm behind include/hash.h against known digests
+ * (including the FIPS 180-2 SHA vectors) at several alignments, checks
+ * that feeding data in pieces gives the same result as a single update, then
+ * reports the throughput of each algorithm.
+ *
+ * Usage: hash [-q]	(-q skips the benchmark)
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <hash.h>
+
+#define BUF_SIZE	(1 << 20)
+
+struct hash_vector {
+	enum hash_algo algo;
+	const char *input;
+	int repeat;		/* number of times input is repeated */
+	const char *digest;	/* hex */
+};
+
+#define FIPS_448	"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"
+#define FIPS_448_SHA1	"84983e441c3bd26ebaae4aa1f95129e5e54670f1"
+#define FIPS_448_SHA256	"248d6a61d20638b8e5c026930c3e6039" \
+			"a33ce45964ff2167f6ecedd419db06c1"
+
+/* SHA vectors are from FIPS 180-2 appendices A and B */
+static const struct hash_vector vectors[] = {
+	{ HASH_ALGO_CRC32, "123456789", 1, "cbf43926" },
+	{ HASH_ALGO_MD5, "", 1, "d41d8cd98f00b204e9800998ecf8427e" },
+	{ HASH_ALGO_MD5, "abc", 1, "900150983cd24fb0d6963f7d28e17f72" },
+	{ HASH_ALGO_SHA1, "", 1, "da39a3ee5e6b4b0d3255bfef95601890afd80709" },
+	{ HASH_ALGO_SHA1, "abc", 1,
+		"a9993e364706816aba3e25717850c26c9cd0d89d" },
+	{ HASH_ALGO_SHA1, FIPS_448, 1, FIPS_448_SHA1 },
+	{ HASH_ALGO_SHA1, "a", 1000000,
+		"34aa973cd4c4daa4f61eeb2bdbad27316534016f" },
+	{ HASH_ALGO_SHA256, "", 1,
+		"e3b0c44298fc1c149afbf4c8996fb924"
+		"27ae41e4649b934ca495991b7852b855" },
+	{ HASH_ALGO_SHA256, "abc", 1,
+		"ba7816bf8f01cfea414140de5dae2223"
+		"b00361a396177a9cb410ff61f20015ad" },
+	{ HASH_ALGO_SHA256, FIPS_448, 1, FIPS_448_SHA256 },
+	{ HASH_ALGO_SHA256, "a", 1000000,
+		"cdc76e5c9914fb9281a1c7e284d73e67"
+		"f1809a48a497200e046d39ccc7112cd0" },
+};
+
+static int test_count;
+static int fail_count;
+
+static unsigned char buf[BUF_SIZE];
+
+static void check_digest(const char *what, enum hash_algo algo,
+			 const uint8_t *digest, const char *expect)
+{
+	char hex[HASH_MAX_DIGEST_SIZE * 2 + 1];
+	int i, size;
+
+	size = hash_digest_size(algo);
+	for (i = 0; i < size; i++)
+		sprintf(hex + i * 2, "%02x", digest[i]);
+	test_count++;
+	if (strcmp(hex, expect)) {
+		printf("%s %s: got %s, expected %s\n", hash_algo_name(algo),
+		       what, hex, expect);
+		fail_count++;
+	}
+}
+
+static void test_vectors(void)
+{
+	uint8_t digest[HASH_MAX_DIGEST_SIZE];
+	const struct hash_vector *vec;
+
+	struct hash_ctx ctx;
+	int i, rep;
+
+	for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+		vec = &vectors[i];
+		hash_init(&ctx, vec->algo);
+		for (rep = 0; rep < vec->repeat; rep++)
+			hash_update(&ctx, vec->input, strlen(vec->input));
+		hash_finish(&ctx, digest);
+		check_digest("vector", vec->algo, digest, vec->digest);
+	}
+
+	/* The same block must hash the same at every alignment */
+	for (i = 0; i < 4; i++) {
+		memcpy(buf + i, FIPS_448, strlen(FIPS_448));
+		hash_block(HASH_ALGO_SHA1, buf + i, strlen(FIPS_448), digest);
+		check_digest("unaligned", HASH_ALGO_SHA1, digest,
+			     FIPS_448_SHA1);
+		hash_block(HASH_ALGO_SHA256, buf + i, strlen(FIPS_448),
+			   digest);
+		check_digest("unaligned", HASH_ALGO_SHA256, digest,
+			     FIPS_448_SHA256);
+	}
+}
+
+static void test_streaming(void)
+{
+	uint8_t whole[HASH_MAX_DIGEST_SIZE], digest[HASH_MAX_DIGEST_SIZE];
+	char expect[HASH_MAX_DIGEST_SIZE * 2 + 1];
+	struct hash_ctx ctx;
+	unsigned done, chunk;
+	int algo, i, size;
+
+	for (algo = 0; algo < HASH_ALGO_COUNT; algo++) {
+		size = hash_block(algo, buf, BUF_SIZE, whole);
+		for (i = 0; i < size; i++)
+			sprintf(expect + i * 2, "%02x", whole[i]);
+
+		/* Odd-sized pieces, so that block boundaries are crossed */
+		hash_init(&ctx, algo);
+		for (done = 0; done < BUF_SIZE; done += chunk) {
+			chunk = (done * 7 + 13) % 4099;
+			if (chunk > BUF_SIZE - done)
+				chunk = BUF_SIZE - done;
+			hash_update(&ctx, buf + done, chunk);
+		}
+		hash_finish(&ctx, digest);
+		check_digest("streaming", algo, digest, expect);
+
+		hash_init(&ctx, algo);
+		hash_memmove(&ctx, buf, buf, BUF_SIZE);
+		hash_finish(&ctx, digest);
+		check_digest("memmove", algo, digest, expect);
+	}
+}
+
+static unsigned long time_us(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000000UL + tv.tv_usec;
+}
+
+static void bench_algos(void)
+{
+	uint8_t digest[HASH_MAX_DIGEST_SIZE];
+	unsigned long start, us;
+	int algo, pass;
+
+	printf("%-8s%12s\n", "algo", "MB/s");
+	for (algo = 0; algo < HASH_ALGO_COUNT; algo++) {
+		start = time_us();
+		for (pass = 0; pass < 16; pass++)
+			hash_block(algo, buf, BUF_SIZE, digest);
+		us = time_us() - start;
+		printf("%-8s%12lu\n", hash_algo_name(algo),
+		       us ? 16UL * BUF_SIZE / us : 0);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned i;
+
+	test_vectors();
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = (i * 2654435761U) >> 24;
+	test_streaming();
+	printf("%d tests run, %d failed\n", test_count, fail_count);
+	if (!(argc > 1 && !strcmp(argv[1], "-q")))
+		bench_algos();
+
+	return fail_count ? 1 : 0;
+}
@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Environment hash table test and benchmark
+ *
+ * Checks lib/hashtable.c as the environment code uses it: entering,
+ * updating and deleting variables well past the size the table was
+ * created for, prefix matching, and import/export in both the stored
+ * ('\0' separated) and text form. Then times getenv/setenv-like lookups
+ * and imports of a large environment.
+ *
+ * Usage: hashtable [-q]	(-q skips the benchmark)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "search.h"
+
+#define NKEYS		2000
+
+static int test_count;
+static int fail_count;
+
+static void check(int ok, const char *what, const char *key)
+{
+	test_count++;
+	if (!ok) {
+		printf("%s: failed for \"%s\"\n", what, key ? key : "");
+		fail_count++;
+	}
+}
+
+static char *get(struct hsearch_data *htab, const char *key)
+{
+	ENTRY e, *ep;
+
+	e.key = (char *)key;
+	e.data = NULL;
+	hsearch_r(e, FIND, &ep, htab);
+	return ep ? ep->data : NULL;
+}
+
+static int set(struct hsearch_data *htab, const char *key, const char *val)
+{
+	ENTRY e, *ep;
+
+	e.key = (char *)key;
+	e.data = (char *)val;
+	return hsearch_r(e, ENTER, &ep, htab) != 0 && ep != NULL;
+}
+
+static void key_name(char *buf, int i)
+{
+	sprintf(buf, "var%d", i);
+}
+
+static void value_of(char *buf, int i, int gen)
+{
+	/* lengths vary, so that updates both shrink and grow values */
+	sprintf(buf, "%d-%.*s", i * 7 + gen, (i + gen) % 23,
+		"abcdefghijklmnopqrstuvwxyz");
+}
+
+static void test_basic(void)
+{
+	struct hsearch_data htab = { NULL };
+	char key[32], val[64];
+	char *data;
+	int i, gen, ok;
+
+	/* Created for far fewer entries than entered: it has to grow */
+	check(hcreate_r(16, &htab), "hcreate", NULL);
+
+	for (gen = 0; gen < 3; gen++) {
+		for (i = 0; i < NKEYS; i++) {
+			key_name(key, i);
+			value_of(val, i, gen);
+			if (!set(&htab, key, val))
+				check(0, "enter", key);
+		}
+		for (i = 0, ok = 1; i < NKEYS; i++) {
+			key_name(key, i);
+			value_of(val, i, gen);
+			data = get(&htab, key);
+			if (data == NULL || strcmp(data, val)) {
+				check(0, "find", key);
+				ok = 0;
+			}
+		}
+		check(ok, "find all", NULL);
+		check(htab.filled == NKEYS, "filled", NULL);
+	}
+
+	/* Delete the odd ones; the even ones must still be found */
+	for (i = 1; i < NKEYS; i += 2) {
+		key_name(key, i);
+		if (!hdelete_r(key, &htab))
+			check(0, "delete", key);
+	}
+	for (i = 0, ok = 1; i < NKEYS; i++) {
+		key_name(key, i);
+		data = get(&htab, key);
+		if ((data != NULL) != !(i & 1)) {
+			check(0, "find after delete", key);
+			ok = 0;
+		}
+	}
+	check(ok, "find after delete", NULL);
+	check(!hdelete_r("var1", &htab), "delete twice", "var1");
+	check(htab.filled == NKEYS / 2, "filled after delete", NULL);
+
+	/* Prefix match, as done for command line completion */
+	i = 0;
+	ok = 0;
+	while ((i = hmatch_r("var1", i, (ENTRY **)&data, &htab)))
+		ok++;
+	/* var10, var12, ... var1998: even numbers starting with 1 */
+	check(ok == 5 + 50 + 500, "hmatch", "var1");
+
+	/*
+	 * Many variables set and deleted in turn: deleted slots must not
+	 * make the table grow forever.
+	 */
+	for (i = 0; i < 100000; i++) {
+		sprintf(key, "tmp%d", i);
+		set(&htab, key, "x");
+		if (i >= 16) {
+			sprintf(key, "tmp%d", i - 16);
+			hdelete_r(key, &htab);
+		}
+	}
+	check(htab.size <= 4 * NKEYS, "size after churn", NULL);
+	check(get(&htab, "var0") != NULL, "find after churn", "var0");
+
+	hdestroy_r(&htab);
+	check(htab.table == NULL, "hdestroy", NULL);
+}
+
+static void test_import_export(void)
+{
+	static const char env[] =
+		"bootcmd=run boot_a\0bootdelay=3\0"
+		"multi=a\nb\0ipaddr=10.0.0.2\0\0";
+	static const char text[] =
+		"  # a comment\n"
+		"bootdelay=5\n"
+		"serverip=10.0.0.1\n"
+		"ipaddr=\n"
+		"multi=x\\\ny\n";
+	struct hsearch_data htab = { NULL };
+	char *res = NULL;
+	char *data;
+	ssize_t len;
+
+	check(himport_r(&htab, env, sizeof(env), '\0', 0), "import", NULL);
+	data = get(&htab, "multi");
+	check(data && !strcmp(data, "a\nb"), "import value", "multi");
+	check(htab.filled == 4, "import count", NULL);
+
+	/* Text form: comments, deletion, escaped separator */
+	check(himport_r(&htab, text, sizeof(text) - 1, '\n', H_NOCLEAR),
+	      "import text", NULL);
+	data = get(&htab, "bootdelay");
+	check(data && !strcmp(data, "5"), "import update", "bootdelay");
+	check(get(&htab, "ipaddr") == NULL, "import delete", "ipaddr");
+	data = get(&htab, "multi");
+	check(data && !strcmp(data, "x\ny"), "import escape", "multi");
+	data = get(&htab, "bootcmd");
+	check(data && !strcmp(data, "run boot_a"), "import keep", "bootcmd");
+
+	/* Export is sorted, and escapes the separator in text form */
+	len = hexport_r(&htab, '\n', &res, 0);
+	check(len > 0 && !strcmp(res, "bootcmd=run boot_a\nbootdelay=5\n"
+				 "multi=x\\\ny\nserverip=10.0.0.1\n"),
+	      "export text", res);
+	free(res);
+
+	/* Without H_NOCLEAR, an import replaces everything */
+	check(himport_r(&htab, env, sizeof(env), '\0', 0), "reimport", NULL);
+	check(get(&htab, "serverip") == NULL, "reimport clear", "serverip");
+	check(htab.filled == 4, "reimport count", NULL);
+
+	res = NULL;
+	len = hexport_r(&htab, '\0', &res, 0);
+	check(len >= sizeof(env) - 1 &&
+	      !memcmp(res, "bootcmd=run boot_a\0bootdelay=3\0"
+		      "ipaddr=10.0.0.2\0multi=a\nb\0", sizeof(env) - 1),
+	      "export", NULL);
+	free(res);
+
+	hdestroy_r(&htab);
+}
+
+static unsigned long time_us(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000000UL + tv.tv_usec;
+}
+
+/* An environment of N typical looking variables, '\0' separated */
+static char *make_env(int n, size_t *size)
+{
+	char *env, *p;
+	int i;
+
+	env = p = malloc(n * 64 + 1);
+	for (i = 0; i < n; i++)
+		p += sprintf(p, "script_%d_addr=0x%08x", i, i * 0x1000) + 1;
+	*p++ = '\0';
+	*size = p - env;
+	return env;
+}
+
+static void bench(void)
+{
+	struct hsearch_data htab = { NULL };
+	unsigned long start, us;
+	static char key[200][32];
+	char val[2][16];
+	size_t size;
+	char *env;
+	int i, pass, n;
+
+	printf("%-24s%12s\n", "operation", "ns/op");
+
+	/* Lookups and updates in a small environment, as scripts do */
+	env = make_env(200, &size);
+	himport_r(&htab, env, size, '\0', 0);
+	for (i = 0; i < 200; i++)
+		sprintf(key[i], "script_%d_addr", (i * 37) % 200);
+	n = 0;
+	start = time_us();
+	for (pass = 0; pass < 5000; pass++)
+		for (i = 0; i < 200; i++, n++)
+			get(&htab, key[i]);
+	us = time_us() - start;
+	printf("%-24s%12lu\n", "getenv (200 vars)", us * 1000 / n);
+
+	strcpy(val[0], "0x00100000");
+	strcpy(val[1], "0x0");
+	n = 0;
+	start = time_us();
+	for (pass = 0; pass < 5000; pass++)
+		for (i = 0; i < 200; i++, n++)
+			set(&htab, key[i], val[(pass + i) & 1]);
+	us = time_us() - start;
+	printf("%-24s%12lu\n", "setenv (200 vars)", us * 1000 / n);
+	hdestroy_r(&htab);
+	free(env);
+
+	/* Importing a large environment, over an existing one */
+	env = make_env(4000, &size);
+	himport_r(&htab, env, size, '\0', 0);
+	start = time_us();
+	for (pass = 0; pass < 50; pass++)
+		himport_r(&htab, env, size, '\0', 0);
+	us = time_us() - start;
+	printf("%-24s%12lu\n", "import (per var)", us * 1000 / (50 * 4000));
+	hdestroy_r(&htab);
+	free(env);
+}
+
+int main(int argc, char *argv[])
+{
+	test_basic();
+	test_import_export();
+	printf("%d tests run, %d failed\n", test_count, fail_count);
+	if (!(argc > 1 && !strcmp(argv[1], "-q")))
+		bench();
+
+	return fail_count ? 1 : 0;
+}
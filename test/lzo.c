@@ -0,0 +1,490 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * LZO1X decompressor test, fuzzer and benchmark
+ *
+ * U-Boot has no LZO compressor, so a copy of the LZO1X-1 compressor from
+ * Linux is included here to build the corpus.  Each corpus entry is
+ * compressed and decompressed into a buffer of exactly the right size,
+ * and must round-trip.  The compressed streams are then truncated and
+ * corrupted; the decompressor may reject them but must never read or
+ * write outside its buffers.  Both buffers are placed against a
+ * PROT_NONE guard page so that a stray access faults.
+ *
+ * Usage: lzo [-q]	(-q skips the benchmark)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+#include <linux/lzo.h>
+#include "../lib/lzo/lzodefs.h"
+
+#define MAX_SIZE	(1 << 20)
+#define FUZZ_ROUNDS	200
+
+static int test_count;
+static int fail_count;
+
+/* LZO1X-1 compressor, from lib/lzo/lzo1x_compress.c in Linux */
+static size_t lzo1x_1_do_compress(const unsigned char *in, size_t in_len,
+		unsigned char *out, size_t *out_len, void *wrkmem)
+{
+	const unsigned char * const in_end = in + in_len;
+	const unsigned char * const ip_end = in + in_len - M2_MAX_LEN - 5;
+	const unsigned char ** const dict = wrkmem;
+	const unsigned char *ip = in, *ii = ip;
+	const unsigned char *end, *m, *m_pos;
+	size_t m_off, m_len, dindex;
+	unsigned char *op = out;
+
+	ip += 4;
+
+	for (;;) {
+		dindex = ((size_t)(0x21 * DX3(ip, 5, 5, 6)) >> 5) & D_MASK;
+		m_pos = dict[dindex];
+
+		if (m_pos < in)
+			goto literal;
+
+		if (ip == m_pos || ((size_t)(ip - m_pos) > M4_MAX_OFFSET))
+			goto literal;
+
+		m_off = ip - m_pos;
+		if (m_off <= M2_MAX_OFFSET || m_pos[3] == ip[3])
+			goto try_match;
+
+		dindex = (dindex & (D_MASK & 0x7ff)) ^ (D_HIGH | 0x1f);
+		m_pos = dict[dindex];
+
+		if (m_pos < in)
+			goto literal;
+
+		if (ip == m_pos || ((size_t)(ip - m_pos) > M4_MAX_OFFSET))
+			goto literal;
+
+		m_off = ip - m_pos;
+		if (m_off <= M2_MAX_OFFSET || m_pos[3] == ip[3])
+			goto try_match;
+
+		goto literal;
+
+try_match:
+		if (m_pos[0] == ip[0] && m_pos[1] == ip[1] &&
+		    m_pos[2] == ip[2])
+			goto match;
+
+literal:
+		dict[dindex] = ip;
+		++ip;
+		if (ip >= ip_end)
+			break;
+		continue;
+
+match:
+		dict[dindex] = ip;
+		if (ip != ii) {
+			size_t t = ip - ii;
+
+			if (t <= 3) {
+				op[-2] |= t;
+			} else if (t <= 18) {
+				*op++ = (t - 3);
+			} else {
+				size_t tt = t - 18;
+
+				*op++ = 0;
+				while (tt > 255) {
+					tt -= 255;
+					*op++ = 0;
+				}
+				*op++ = tt;
+			}
+			do {
+				*op++ = *ii++;
+			} while (--t > 0);
+		}
+
+		ip += 3;
+		if (m_pos[3] != *ip++ || m_pos[4] != *ip++
+				|| m_pos[5] != *ip++ || m_pos[6] != *ip++
+				|| m_pos[7] != *ip++ || m_pos[8] != *ip++) {
+			--ip;
+			m_len = ip - ii;
+
+			if (m_off <= M2_MAX_OFFSET) {
+				m_off -= 1;
+				*op++ = (((m_len - 1) << 5)
+						| ((m_off & 7) << 2));
+				*op++ = (m_off >> 3);
+			} else if (m_off <= M3_MAX_OFFSET) {
+				m_off -= 1;
+				*op++ = (M3_MARKER | (m_len - 2));
+				goto m3_m4_offset;
+			} else {
+				m_off -= 0x4000;
+
+				*op++ = (M4_MARKER | ((m_off & 0x4000) >> 11)
+						| (m_len - 2));
+				goto m3_m4_offset;
+			}
+		} else {
+			end = in_end;
+			m = m_pos + M2_MAX_LEN + 1;
+
+			while (ip < end && *m == *ip) {
+				m++;
+				ip++;
+			}
+			m_len = ip - ii;
+
+			if (m_off <= M3_MAX_OFFSET) {
+				m_off -= 1;
+				if (m_len <= 33) {
+					*op++ = (M3_MARKER | (m_len - 2));
+				} else {
+					m_len -= 33;
+					*op++ = M3_MARKER | 0;
+					goto m3_m4_len;
+				}
+			} else {
+				m_off -= 0x4000;
+				if (m_len <= M4_MAX_LEN) {
+					*op++ = (M4_MARKER
+						| ((m_off & 0x4000) >> 11)
+						| (m_len - 2));
+				} else {
+					m_len -= M4_MAX_LEN;
+					*op++ = (M4_MARKER
+						| ((m_off & 0x4000) >> 11));
+m3_m4_len:
+					while (m_len > 255) {
+						m_len -= 255;
+						*op++ = 0;
+					}
+
+					*op++ = (m_len);
+				}
+			}
+m3_m4_offset:
+			*op++ = ((m_off & 63) << 2);
+			*op++ = (m_off >> 6);
+		}
+
+		ii = ip;
+		if (ip >= ip_end)
+			break;
+	}
+
+	*out_len = op - out;
+	return in_end - ii;
+}
+
+int lzo1x_1_compress(const unsigned char *in, size_t in_len,
+		     unsigned char *out, size_t *out_len, void *wrkmem)
+{
+	const unsigned char *ii;
+	unsigned char *op = out;
+	size_t t;
+
+	memset(wrkmem, '\0', LZO1X_1_MEM_COMPRESS);
+	if (in_len <= M2_MAX_LEN + 5) {
+		t = in_len;
+	} else {
+		t = lzo1x_1_do_compress(in, in_len, op, out_len, wrkmem);
+		op += *out_len;
+	}
+
+	if (t > 0) {
+		ii = in + in_len - t;
+
+		if (op == out && t <= 238) {
+			*op++ = (17 + t);
+		} else if (t <= 3) {
+			op[-2] |= t;
+		} else if (t <= 18) {
+			*op++ = (t - 3);
+		} else {
+			size_t tt = t - 18;
+
+			*op++ = 0;
+			while (tt > 255) {
+				tt -= 255;
+				*op++ = 0;
+			}
+
+			*op++ = tt;
+		}
+		do {
+			*op++ = *ii++;
+		} while (--t > 0);
+	}
+
+	*op++ = M4_MARKER | 1;
+	*op++ = 0;
+	*op++ = 0;
+
+	*out_len = op - out;
+	return LZO_E_OK;
+}
+
+/* Small deterministic generator so that failures can be reproduced */
+static uint32_t rand_state = 1;
+
+static uint32_t next_rand(void)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+	return rand_state >> 8;
+}
+
+/*
+ * A region of at least size bytes whose end touches an inaccessible
+ * page. Data placed with place_at_end() ends exactly at the guard page.
+ */
+struct guarded {
+	unsigned char *base;
+	size_t size;
+};
+
+static void guarded_alloc(struct guarded *g, size_t size)
+{
+	size_t page = sysconf(_SC_PAGESIZE);
+
+	g->size = (size + page - 1) & ~(page - 1);
+	g->base = mmap(NULL, g->size + page, PROT_READ | PROT_WRITE,
+		       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (g->base == MAP_FAILED) {
+		perror("mmap");
+		exit(2);
+	}
+	mprotect(g->base + g->size, page, PROT_NONE);
+}
+
+static unsigned char *place_at_end(struct guarded *g, size_t len)
+{
+	return g->base + g->size - len;
+}
+
+/* Fill buf with one of several kinds of data, selected by kind */
+static void make_data(unsigned char *buf, size_t len, int kind)
+{
+	static const char *const words[] = {
+		"bootm ", "setenv ", "0x", "kernel", "\n", "fdt ", "usb ",
+		"mmc read ", "ramdisk", "console=ttyS0,115200 ",
+	};
+	size_t i, n;
+
+	switch (kind) {
+	case 0:		/* zeroes, long M3/M4 runs */
+		memset(buf, '\0', len);
+		break;
+	case 1:		/* incompressible, long literal runs */
+		for (i = 0; i < len; i++)
+			buf[i] = next_rand();
+		break;
+	case 2:		/* text made of a small dictionary */
+		for (i = 0; i < len; i += n) {
+			const char *w = words[next_rand() % 10];
+
+			n = strlen(w);
+			if (n > len - i)
+				n = len - i;
+			memcpy(buf + i, w, n);
+		}
+		break;
+	case 3:		/* short-period repeats, overlapping matches */
+		for (i = 0; i < len; i++)
+			buf[i] = "abcdefg"[i % (1 + (len & 7) % 7)];
+		break;
+	default:	/* a mixture of short literals and matches */
+		for (i = 0; i < len; i++) {
+			if (i > 64 && (next_rand() & 3))
+				buf[i] = buf[i - 1 - next_rand() % 64];
+			else
+				buf[i] = next_rand();
+		}
+		break;
+	}
+}
+
+static void check(int ok, const char *what, size_t len, int kind)
+{
+	test_count++;
+	if (!ok) {
+		fail_count++;
+		printf("FAIL: %s (len %zu, kind %d)\n", what, len, kind);
+	}
+}
+
+static unsigned char *orig, *comp, *damaged;
+static struct guarded in_buf, out_buf;
+static void *wrkmem;
+
+/* Compress len bytes of the given kind into comp, returning its size */
+static size_t make_stream(size_t len, int kind)
+{
+	size_t comp_len;
+
+	make_data(orig, len, kind);
+	lzo1x_1_compress(orig, len, comp, &comp_len, wrkmem);
+
+	return comp_len;
+}
+
+static int decompress(const unsigned char *src, size_t src_len,
+		      size_t dst_len, size_t *out_len)
+{
+	unsigned char *in = place_at_end(&in_buf, src_len);
+
+	memcpy(in, src, src_len);
+	*out_len = dst_len;
+
+	return lzo1x_decompress_safe(in, src_len,
+				     place_at_end(&out_buf, dst_len), out_len);
+}
+
+static void test_round_trip(size_t len, int kind)
+{
+	size_t comp_len, out_len;
+	int ret;
+
+	comp_len = make_stream(len, kind);
+	ret = decompress(comp, comp_len, len, &out_len);
+	check(ret == LZO_E_OK && out_len == len &&
+	      !memcmp(place_at_end(&out_buf, len), orig, len),
+	      "round trip", len, kind);
+
+	/* one byte too little output space must be refused */
+	if (len) {
+		ret = decompress(comp, comp_len, len - 1, &out_len);
+		check(ret == LZO_E_OUTPUT_OVERRUN, "short output", len, kind);
+	}
+}
+
+static void test_corrupt(size_t len, int kind)
+{
+	size_t comp_len, cut, out_len;
+	int i, ret;
+
+	comp_len = make_stream(len, kind);
+	memcpy(damaged, comp, comp_len);
+
+	/* every truncation must be rejected */
+	for (cut = 0; cut < comp_len; cut += 1 + comp_len / 64) {
+		ret = decompress(comp, cut, len, &out_len);
+		check(ret != LZO_E_OK && out_len <= len, "truncated", len,
+		      kind);
+	}
+
+	/* random damage may decode, but only within bounds */
+	for (i = 0; i < 16; i++) {
+		int flips = 1 + next_rand() % 4;
+
+		while (flips--)
+			damaged[next_rand() % comp_len] = next_rand();
+		ret = decompress(damaged, comp_len, len, &out_len);
+		memcpy(damaged, comp, comp_len);
+		check(out_len <= len, "corrupted", len, kind);
+	}
+}
+
+static void test_fuzz_random(void)
+{
+	size_t len, out_len;
+	int i;
+
+	/* streams of noise, mostly with a plausible first byte */
+	for (i = 0; i < FUZZ_ROUNDS * 16; i++) {
+		len = next_rand() % 256;
+		make_data(comp, len, 1);
+		if (len && (i & 1))
+			comp[0] = next_rand() % 18;
+		decompress(comp, len, 4096, &out_len);
+		check(out_len <= 4096, "random", len, 1);
+	}
+}
+
+static unsigned long time_us(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000000UL + tv.tv_usec;
+}
+
+static void bench(void)
+{
+	static const char *const names[] = {
+		"zeroes", "random", "text", "repeat", "mixed"
+	};
+	unsigned long start, us;
+	size_t comp_len, out_len;
+	int kind, pass;
+
+	printf("%-8s%10s%12s\n", "data", "ratio%", "MB/s");
+	for (kind = 0; kind < 5; kind++) {
+		comp_len = make_stream(MAX_SIZE, kind);
+		start = time_us();
+		for (pass = 0; pass < 32; pass++)
+			decompress(comp, comp_len, MAX_SIZE, &out_len);
+		us = time_us() - start;
+		printf("%-8s%10zu%12lu\n", names[kind],
+		       comp_len * 100 / MAX_SIZE,
+		       us ? 32UL * MAX_SIZE / us : 0);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	size_t len;
+	int kind, i;
+
+	orig = malloc(MAX_SIZE);
+	comp = malloc(lzo1x_worst_compress(MAX_SIZE));
+	damaged = malloc(lzo1x_worst_compress(MAX_SIZE));
+	wrkmem = malloc(LZO1X_1_MEM_COMPRESS);
+	guarded_alloc(&in_buf, lzo1x_worst_compress(MAX_SIZE));
+	guarded_alloc(&out_buf, MAX_SIZE);
+
+	for (kind = 0; kind < 5; kind++) {
+		/* every short length exercises the buffer-end paths */
+		for (len = 0; len < 300; len++)
+			test_round_trip(len, kind);
+		for (i = 0; i < 20; i++)
+			test_round_trip(next_rand() % MAX_SIZE, kind);
+		test_round_trip(MAX_SIZE, kind);
+	}
+	for (i = 0; i < FUZZ_ROUNDS; i++)
+		test_corrupt(next_rand() % 4096, i % 5);
+	test_fuzz_random();
+
+	printf("%d tests run, %d failed\n", test_count, fail_count);
+	if (!(argc > 1 && !strcmp(argv[1], "-q")))
+		bench();
+
+	return fail_count ? 1 : 0;
+}
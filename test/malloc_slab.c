@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Host test for common/malloc_slab.c
+ *
+ * The allocator is built into this file, with its malloc() and friends
+ * renamed to slab_test_...() and the dlmalloc entry points served by the
+ * C library, so that its pages, classes and counters can be checked
+ * directly. The tests cover every size class, pages going back to the
+ * pool and on to another class, realloc() within the slab, between the
+ * slab and dlmalloc and when it fails, calloc() overflow and clearing,
+ * and the byte count of memalign(), valloc() and pvalloc() blocks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <malloc.h>
+
+/* When set, the dlmalloc stand-ins below fail as if the pool were full */
+static int dl_fail;
+
+void *dlmalloc(size_t bytes)
+{
+	return dl_fail ? NULL : malloc(bytes);
+}
+
+void dlfree(void *mem)
+{
+	free(mem);
+}
+
+void *dlrealloc(void *oldmem, size_t bytes)
+{
+	return dl_fail ? NULL : realloc(oldmem, bytes);
+}
+
+void *dlcalloc(size_t n, size_t elem_size)
+{
+	return dl_fail ? NULL : calloc(n, elem_size);
+}
+
+void *dlmemalign(size_t alignment, size_t bytes)
+{
+	void *mem;
+
+	if (dl_fail || posix_memalign(&mem, alignment, bytes))
+		return NULL;
+
+	return mem;
+}
+
+void *dlvalloc(size_t bytes)
+{
+	return dlmemalign(getpagesize(), bytes);
+}
+
+void *dlpvalloc(size_t bytes)
+{
+	size_t page = getpagesize();
+
+	return dlmemalign(page, (bytes + page - 1) & ~(page - 1));
+}
+
+#define malloc		slab_test_malloc
+#define free		slab_test_free
+#define realloc		slab_test_realloc
+#define calloc		slab_test_calloc
+#define memalign	slab_test_memalign
+#define valloc		slab_test_valloc
+#define pvalloc		slab_test_pvalloc
+
+#include "../common/malloc_slab.c"
+
+void malloc_pool_info(struct malloc_pool_info *info)
+{
+	memset(info, '\0', sizeof(*info));
+}
+
+#define OBJS_MAX	(SLAB_LEN / 16)
+
+static void *obj[OBJS_MAX];
+static int test_count;
+static int fail_count;
+
+static void check(int ok, const char *what, long arg)
+{
+	test_count++;
+	if (!ok) {
+		printf("%s: failed for %ld\n", what, arg);
+		fail_count++;
+	}
+}
+
+static int pool_pages(void)
+{
+	int idx, count = 0;
+
+	for (idx = slab_pool; idx != NO_PAGE; idx = slab_page[idx].next)
+		count++;
+
+	return count;
+}
+
+static int class_pages(void)
+{
+	int i, count = 0;
+
+	for (i = 0; i < SLAB_CLASSES; i++)
+		count += slab_class[i].pages;
+
+	return count;
+}
+
+/* Nothing allocated, and every page either in the pool or in a class */
+static void check_empty(const char *what)
+{
+	int i;
+
+	check(heap.in_use == 0, what, heap.in_use);
+	check(heap.allocs == heap.frees, what, heap.allocs - heap.frees);
+	for (i = 0; i < SLAB_CLASSES; i++)
+		check(slab_class[i].in_use == 0, what, i);
+	check(pool_pages() + class_pages() == SLAB_PAGES, what,
+	      pool_pages());
+}
+
+static void test_classes(void)
+{
+	size_t n;
+	int i;
+
+	for (n = 0; n <= SLAB_MAX; n++) {
+		void *p = malloc(n);
+
+		check(in_slab(p), "small in slab", n);
+		for (i = 0; slab_size[i] < n; i++)
+			;
+		check(heap_size(p) == slab_size[i], "size class", n);
+		check(heap.in_use == slab_size[i], "in use", n);
+		memset(p, 0xaa, n);
+		free(p);
+	}
+	check(!in_slab(obj[0] = malloc(SLAB_MAX + 1)), "large", 0);
+	free(obj[0]);
+	check_empty("classes");
+}
+
+/* Fill the slab with objects of one size and return how many fitted */
+static int fill(size_t size)
+{
+	int count;
+
+	for (count = 0; count < OBJS_MAX; count++) {
+		obj[count] = malloc(size);
+		if (!in_slab(obj[count]))
+			break;
+	}
+	free(obj[count]);
+
+	return count;
+}
+
+static void test_recycle(void)
+{
+	ulong full = heap.slab_full;
+	int count, i, idx, pages;
+
+	/*
+	 * Every page but the empty ones the other classes kept goes to the
+	 * first class
+	 */
+	pages = pool_pages() + slab_class[0].pages;
+	count = fill(16);
+	check(count == pages * (SLAB_PAGE_SIZE / 16), "fill 16", count);
+	check(heap.slab_full == full + 1, "slab full", heap.slab_full);
+	check(pool_pages() == 0, "pool empty", pool_pages());
+
+	/* Every other object first, so that pages go from full to partial */
+	for (i = 0; i < count; i += 2)
+		free(obj[i]);
+	check(pool_pages() == 0, "half free", pool_pages());
+	for (i = 1; i < count; i += 2)
+		free(obj[i]);
+
+	/* One empty page is kept, the rest are back in the pool */
+	check(slab_class[0].pages == 1, "page kept", slab_class[0].pages);
+	check(pool_pages() == pages - 1, "pages back", pool_pages());
+	check_empty("recycle 16");
+
+	/* Another class can now have them */
+	pages = pool_pages() + slab_class[SLAB_CLASSES - 1].pages;
+	count = fill(SLAB_MAX);
+	check(count == pages * (SLAB_PAGE_SIZE / SLAB_MAX), "fill 256", count);
+	for (i = count - 1; i >= 0; i--)
+		free(obj[i]);
+	check_empty("recycle 256");
+
+	/* Allocating and freeing one object does not churn pages */
+	idx = slab_class[0].partial;
+	for (i = 0; i < 100; i++) {
+		obj[0] = malloc(16);
+		check(page_of(obj[0]) == idx, "same page", i);
+		free(obj[0]);
+	}
+	check(slab_class[0].pages == 1, "no churn", slab_class[0].pages);
+	check_empty("churn");
+}
+
+static int check_pattern(const unsigned char *p, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if (p[i] != (unsigned char)(i * 7))
+			return 0;
+	}
+
+	return 1;
+}
+
+static void *alloc_pattern(size_t len)
+{
+	unsigned char *p = malloc(len);
+	size_t i;
+
+	for (i = 0; p && i < len; i++)
+		p[i] = i * 7;
+
+	return p;
+}
+
+static void test_realloc(void)
+{
+	void *p, *q;
+
+	/* Within the slab */
+	p = alloc_pattern(10);
+	q = realloc(p, 16);
+	check(q == p, "realloc same class", 16);
+	q = realloc(p, 5);
+	check(q == p, "realloc shrink", 5);
+	q = realloc(p, 40);
+	check(q != p && in_slab(q) && heap_size(q) == 48, "realloc grow", 40);
+	check(check_pattern(q, 10), "realloc grow data", 40);
+	check(heap.in_use == 48, "realloc grow in use", heap.in_use);
+
+	/* Slab to dlmalloc */
+	p = realloc(q, 1000);
+	check(!in_slab(p), "realloc to dl", 1000);
+	check(check_pattern(p, 10), "realloc to dl data", 1000);
+	check(heap.in_use == malloc_usable_size(p), "realloc to dl in use",
+	      heap.in_use);
+
+	/* dlmalloc to dlmalloc, also when the new size is small */
+	free(p);
+	p = alloc_pattern(1000);
+	q = realloc(p, 5000);
+	check(q && !in_slab(q) && check_pattern(q, 1000), "realloc dl", 5000);
+	p = realloc(q, 20);
+	check(p && !in_slab(p) && check_pattern(p, 20), "realloc dl small",
+	      20);
+	check(heap.in_use == malloc_usable_size(p), "realloc dl in use",
+	      heap.in_use);
+	free(p);
+
+	/* realloc(NULL) is malloc() */
+	p = realloc(NULL, 30);
+	check(in_slab(p) && heap_size(p) == 32, "realloc NULL", 30);
+	free(p);
+	check_empty("realloc");
+
+	/* A failed move leaves the old block alone */
+	p = alloc_pattern(100);
+	q = alloc_pattern(1000);
+	dl_fail = 1;
+	check(!realloc(p, 1000) && check_pattern(p, 100),
+	      "realloc slab fail", 1000);
+	check(!realloc(q, 5000) && check_pattern(q, 1000), "realloc dl fail",
+	      5000);
+	dl_fail = 0;
+	free(p);
+	free(q);
+	check_empty("realloc fail");
+}
+
+static void test_calloc(void)
+{
+	ulong failed = heap.failed;
+	unsigned char *p;
+	int i, ok;
+
+	p = calloc(SIZE_MAX / 2 + 2, 2);
+	check(!p, "calloc overflow", 2);
+	p = calloc(2, SIZE_MAX / 2 + 2);
+	check(!p, "calloc overflow", SIZE_MAX / 2 + 2);
+	check(heap.failed == failed + 2, "calloc overflow failed",
+	      heap.failed - failed);
+
+	p = calloc(0, SIZE_MAX);
+	check(p && in_slab(p), "calloc 0", 0);
+	free(p);
+
+	/* A slab object that was used before comes back clear */
+	p = malloc(64);
+	memset(p, 0xff, 64);
+	free(p);
+	p = calloc(16, 4);
+	check(in_slab(p), "calloc small", 64);
+	for (i = 0, ok = 1; i < 64; i++)
+		ok &= !p[i];
+	check(ok, "calloc clear", 64);
+	free(p);
+
+	p = calloc(100, 100);
+	check(p && !in_slab(p), "calloc large", 10000);
+	for (i = 0, ok = 1; i < 10000; i++)
+		ok &= !p[i];
+	check(ok, "calloc large clear", 10000);
+	free(p);
+	check_empty("calloc");
+}
+
+static void test_aligned(void)
+{
+	long page = getpagesize();
+	void *p;
+
+	p = memalign(64, 100);
+	check(p && !((uintptr_t)p & 63), "memalign", 64);
+	check(heap.in_use == malloc_usable_size(p), "memalign in use",
+	      heap.in_use);
+	free(p);
+
+	p = valloc(100);
+	check(p && !((uintptr_t)p & (page - 1)), "valloc", 100);
+	check(heap.in_use == malloc_usable_size(p), "valloc in use",
+	      heap.in_use);
+	free(p);
+
+	p = pvalloc(100);
+	check(p && !((uintptr_t)p & (page - 1)), "pvalloc", 100);
+	check(malloc_usable_size(p) >= page, "pvalloc size", page);
+	check(heap.in_use == malloc_usable_size(p), "pvalloc in use",
+	      heap.in_use);
+	free(p);
+	check_empty("aligned");
+}
+
+int main(int argc, char *argv[])
+{
+	malloc_slab_init();
+	check(slab_base != NULL, "init", 0);
+	check(pool_pages() == SLAB_PAGES, "init pool", pool_pages());
+
+	test_classes();
+	test_recycle();
+	test_realloc();
+	test_calloc();
+	test_aligned();
+
+	printf("%d tests run, %d failed\n", test_count, fail_count);
+
+	return fail_count ? 1 : 0;
+}
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2011 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * memcpy/memmove/memset test
+ *
+ * Every length up to MAX_LEN is tried at every source and destination
+ * alignment within a 16-byte window, and memmove() at every overlap
+ * distance up to MAX_OVERLAP in both directions. The result is compared
+ * with a byte-at-a-time copy, and the bytes around the destination must
+ * be left alone. The buffers sit between PROT_NONE guard pages, and
+ * sources are placed against both of them, so that reading or writing
+ * outside the buffers faults.
+ *
+ * On an ARM host, or when cross-compiled and run under qemu-arm, the
+ * routines under test are the ones in arch/arm/lib, built as
+ * test_memcpy() and so on. Elsewhere the test runs against the C library,
+ * which only checks the test itself.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#ifdef TEST_LIBC
+#define TEST_WHAT	"C library"
+#define test_memcpy	memcpy
+#define test_memmove	memmove
+#define test_memset	memset
+#else
+#define TEST_WHAT	"arch/arm/lib"
+void *test_memcpy(void *dest, const void *src, size_t count);
+void *test_memmove(void *dest, const void *src, size_t count);
+void *test_memset(void *s, int c, size_t count);
+#endif
+
+#define MAX_LEN		320	/* several times the largest unrolled loop */
+#define MAX_ALIGN	16
+#define MAX_OVERLAP	72
+#define CANARY		0xee
+
+static int test_count;
+static int fail_count;
+
+/* Small deterministic generator so that failures can be reproduced */
+static uint32_t rand_state = 1;
+
+static uint32_t next_rand(void)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+	return rand_state >> 8;
+}
+
+/* A page-sized region with an inaccessible page on either side */
+static unsigned char *guarded_alloc(size_t *sizep)
+{
+	size_t page = sysconf(_SC_PAGESIZE);
+	unsigned char *base;
+
+	base = mmap(NULL, 3 * page, PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED) {
+		perror("mmap");
+		exit(2);
+	}
+	mprotect(base, page, PROT_NONE);
+	mprotect(base + 2 * page, page, PROT_NONE);
+	*sizep = page;
+
+	return base + page;
+}
+
+static void check(int ok, const char *what, size_t len, int a, int b)
+{
+	test_count++;
+	if (!ok) {
+		fail_count++;
+		printf("FAIL: %s (len %zu, %d, %d)\n", what, len, a, b);
+	}
+}
+
+static unsigned char *src_buf, *dst_buf, *expect;
+static size_t buf_size;
+
+static void fill_random(unsigned char *buf, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = next_rand();
+}
+
+/* Check that dst_buf matches expect, which has the canary around dst */
+static int dst_ok(void)
+{
+	return !memcmp(dst_buf, expect, buf_size);
+}
+
+static void test_memcpy_at(unsigned char *src, size_t len, int sa, int da)
+{
+	unsigned char *dst = dst_buf + da;
+	size_t i;
+
+	memset(dst_buf, CANARY, buf_size);
+	memset(expect, CANARY, buf_size);
+	fill_random(src, len);
+	for (i = 0; i < len; i++)
+		expect[da + i] = src[i];
+
+	check(test_memcpy(dst, src, len) == dst, "memcpy return", len, sa,
+	      da);
+	check(dst_ok(), "memcpy", len, sa, da);
+}
+
+static void test_memmove_at(size_t len, int sa, int delta)
+{
+	unsigned char *src = dst_buf + MAX_OVERLAP + sa;
+	unsigned char *dst = src + delta;
+	size_t i;
+
+	fill_random(dst_buf, buf_size);
+	memcpy(expect, dst_buf, buf_size);
+	if (delta > 0) {
+		for (i = len; i > 0; i--)
+			expect[MAX_OVERLAP + sa + delta + i - 1] =
+				expect[MAX_OVERLAP + sa + i - 1];
+	} else {
+		for (i = 0; i < len; i++)
+			expect[MAX_OVERLAP + sa + delta + i] =
+				expect[MAX_OVERLAP + sa + i];
+	}
+
+	check(test_memmove(dst, src, len) == dst, "memmove return", len, sa,
+	      delta);
+	check(dst_ok(), "memmove", len, sa, delta);
+}
+
+static void test_memset_at(size_t len, int da, int c)
+{
+	unsigned char *dst = dst_buf + da;
+
+	memset(dst_buf, CANARY, buf_size);
+	memset(expect, CANARY, buf_size);
+	memset(expect + da, c, len);
+
+	check(test_memset(dst, c, len) == dst, "memset return", len, da, c);
+	check(dst_ok(), "memset", len, da, c);
+}
+
+int main(int argc, char *argv[])
+{
+	static const int values[] = { 0, 0x5a, 0xff, 0x1a5, -1 };
+	size_t len;
+	int sa, da, i;
+
+	src_buf = guarded_alloc(&buf_size);
+	dst_buf = guarded_alloc(&buf_size);
+	expect = malloc(buf_size);
+
+	for (len = 0; len <= MAX_LEN; len++) {
+		for (sa = 0; sa < MAX_ALIGN; sa++) {
+			for (da = 0; da < MAX_ALIGN; da++) {
+				/* against the lower and the upper guard */
+				test_memcpy_at(src_buf + sa, len, sa, da);
+				test_memcpy_at(src_buf + buf_size - len - sa,
+					       len, sa, da);
+			}
+		}
+	}
+
+	/* memmove() within one buffer, overlapping either way */
+	for (len = 0; len <= MAX_LEN; len++) {
+		for (sa = 0; sa < MAX_ALIGN; sa++) {
+			for (da = -MAX_OVERLAP; da <= MAX_OVERLAP; da++)
+				test_memmove_at(len, sa, da);
+		}
+	}
+
+	for (len = 0; len <= MAX_LEN; len++) {
+		for (da = 0; da < MAX_ALIGN; da++) {
+			for (i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+				test_memset_at(len, da, values[i]);
+			/* ending against the upper guard */
+			test_memset_at(len, buf_size - len - da, 0x5a);
+		}
+	}
+
+	printf("%s: %d tests run, %d failed\n", TEST_WHAT, test_count,
+	       fail_count);
+
+	return fail_count ? 1 : 0;
+}